@@ -0,0 +1,138 @@
+#ifndef CSLIBS_NDT_BACKEND_ARENA_HPP
+#define CSLIBS_NDT_BACKEND_ARENA_HPP
+
+#include <new>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#include <Eigen/Core>
+
+namespace cslibs_ndt {
+namespace backend {
+
+/**
+ * @brief Slab allocator for objects of one type, which are only released all at once.
+ *        Objects are placed into blocks of growing capacity, so creating an object
+ *        is a pointer bump and clear() hands back all memory with one call per block.
+ *        Addresses of created objects stay valid until clear().
+ */
+template <typename T,
+          std::size_t MinBlockSize = 64,
+          std::size_t MaxBlockSize = 4096>
+class Arena
+{
+public:
+    inline Arena() = default;
+
+    inline Arena(const Arena &) = delete;
+    inline Arena& operator = (const Arena &) = delete;
+
+    inline Arena(Arena &&other) :
+        blocks_(std::move(other.blocks_)),
+        size_(other.size_)
+    {
+        other.blocks_.clear();
+        other.size_ = 0;
+    }
+
+    inline ~Arena()
+    {
+        clear();
+    }
+
+    template <typename... Args>
+    inline T* create(Args&&... args)
+    {
+        if (blocks_.empty() || blocks_.back().size == blocks_.back().capacity)
+            allocateBlock();
+
+        Block &block = blocks_.back();
+        T *t = new (block.data + block.size) T(std::forward<Args>(args)...);
+        ++block.size;
+        ++size_;
+        return t;
+    }
+
+    /**
+     * @brief Destroy all objects and release all blocks.
+     */
+    inline void clear()
+    {
+        for (Block &block : blocks_) {
+            destroy(block);
+            allocator_t().deallocate(block.data, block.capacity);
+        }
+        std::vector<Block>().swap(blocks_);
+        size_ = 0;
+    }
+
+    template <typename Fn>
+    inline void apply(const Fn &function)
+    {
+        for (Block &block : blocks_)
+            for (std::size_t i = 0 ; i < block.size ; ++i)
+                function(*reinterpret_cast<T*>(block.data + i));
+    }
+
+    template <typename Fn>
+    inline void apply(const Fn &function) const
+    {
+        for (const Block &block : blocks_)
+            for (std::size_t i = 0 ; i < block.size ; ++i)
+                function(*reinterpret_cast<const T*>(block.data + i));
+    }
+
+    /**
+     * @brief Number of created objects.
+     */
+    inline std::size_t size() const
+    {
+        return size_;
+    }
+
+    /**
+     * @brief Memory reserved by the blocks, including unused slots.
+     */
+    inline std::size_t byte_size() const
+    {
+        std::size_t bytes = blocks_.capacity() * sizeof(Block);
+        for (const Block &block : blocks_)
+            bytes += block.capacity * sizeof(storage_t);
+        return bytes;
+    }
+
+private:
+    using storage_t   = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+    using allocator_t = Eigen::aligned_allocator<storage_t>;
+
+    struct Block {
+        storage_t   *data;
+        std::size_t  capacity;
+        std::size_t  size;
+    };
+
+    std::vector<Block> blocks_;
+    std::size_t        size_ = 0;
+
+    inline void allocateBlock()
+    {
+        const std::size_t capacity = blocks_.empty() ?
+                    MinBlockSize : std::min(blocks_.back().capacity * 2ul, MaxBlockSize);
+        blocks_.emplace_back(Block{allocator_t().allocate(capacity), capacity, 0ul});
+    }
+
+    inline static void destroy(Block &block)
+    {
+        if (!std::is_trivially_destructible<T>::value)
+            for (std::size_t i = 0 ; i < block.size ; ++i)
+                reinterpret_cast<T*>(block.data + i)->~T();
+        block.size = 0;
+    }
+};
+
+}
+}
+
+#endif // CSLIBS_NDT_BACKEND_ARENA_HPP
@@ -0,0 +1,277 @@
+#ifndef CSLIBS_NDT_BACKEND_BLOCK_HASH_HPP
+#define CSLIBS_NDT_BACKEND_BLOCK_HASH_HPP
+
+#include <cslibs_indexed_storage/backend/tags.hpp>
+#include <cslibs_indexed_storage/backend/backend_traits.hpp>
+#include <cslibs_indexed_storage/interface/data/data_interface.hpp>
+
+#include <cslibs_ndt/backend/arena.hpp>
+
+#include <array>
+#include <bitset>
+#include <unordered_map>
+
+namespace cslibs_indexed_storage { namespace backend {
+struct block_hash_tag {};
+}}
+
+namespace cis = cslibs_indexed_storage;
+
+namespace cslibs_ndt {
+namespace backend {
+
+/**
+ * @brief Block-sparse storage in the spirit of VDB leaf nodes:
+ *        indices are grouped into dense blocks of 64 cells (8x8 in 2D, 4x4x4 in 3D),
+ *        which are looked up by their block coordinate in a hash map.
+ *        get and insert are one hash lookup plus an offset computation,
+ *        traverse walks block by block and there is no bound on the extent.
+ */
+template<typename data_interface_t_, typename index_interface_t_, typename... options_ts_>
+class BlockHash
+{
+public:
+    using tag = cis::backend::block_hash_tag;
+
+    using data_if = data_interface_t_;
+    using data_storage_t = typename data_if::storage_type;
+    using data_output_t = typename data_if::output_type;
+
+    using index_if = index_interface_t_;
+    using index_t = typename index_if::type;
+
+    static constexpr auto on_duplicate_index_strategy =
+            cis::option::get_option<cis::option::merge_strategy_opt, options_ts_...>::value;
+
+    static constexpr std::size_t dimensions  = index_if::dimensions;
+    static constexpr int         block_bits  = dimensions > 2 ? 2 : 3;
+    static constexpr int         block_width = 1 << block_bits;
+    static constexpr int         block_mask  = block_width - 1;
+    static constexpr std::size_t block_cells = std::size_t(1) << (block_bits * dimensions);
+
+protected:
+    using cell_t = typename std::aligned_storage<sizeof(data_storage_t), alignof(data_storage_t)>::type;
+
+    struct Block
+    {
+        inline explicit Block(const index_t &index) :
+            index(index)
+        {
+        }
+
+        inline data_storage_t& at(const std::size_t offset)
+        {
+            return *reinterpret_cast<data_storage_t*>(&cells[offset]);
+        }
+
+        inline const data_storage_t& at(const std::size_t offset) const
+        {
+            return *reinterpret_cast<const data_storage_t*>(&cells[offset]);
+        }
+
+        index_t                   index;
+        std::bitset<block_cells>  occupied;
+        cell_t                    cells[block_cells];
+    };
+
+    struct Hash
+    {
+        inline std::size_t operator()(const index_t &index) const
+        {
+            static constexpr std::size_t primes[] = {73856093ul, 19349663ul, 83492791ul, 2654435761ul};
+            std::size_t h = 0;
+            for (std::size_t i = 0 ; i < dimensions ; ++i)
+                h ^= static_cast<std::size_t>(index[i]) * primes[i % 4];
+            return h;
+        }
+    };
+
+    using block_arena_t = Arena<Block, 4, 64>;
+    using block_map_t   = std::unordered_map<index_t, Block*, Hash>;
+
+public:
+    inline BlockHash() = default;
+
+    inline BlockHash(const BlockHash &other)
+    {
+        other.traverse([this](const index_t &index, const data_output_t &data) {
+            insert(index, data);
+        });
+    }
+
+    inline BlockHash(BlockHash &&other) :
+        block_arena_(std::move(other.block_arena_)),
+        blocks_(std::move(other.blocks_)),
+        size_(other.size_)
+    {
+        other.blocks_.clear();
+        other.size_ = 0;
+    }
+
+    inline virtual ~BlockHash()
+    {
+        clear();
+    }
+
+    template<typename... Args>
+    inline data_output_t& insert(const index_t& index, Args&&... args)
+    {
+        index_t block_index;
+        const std::size_t offset = split(index, block_index);
+
+        Block *block = nullptr;
+        const auto it = blocks_.find(block_index);
+        if (it == blocks_.end()) {
+            block = block_arena_.create(block_index);
+            blocks_.emplace(block_index, block);
+        } else {
+            block = it->second;
+        }
+
+        data_storage_t &value = block->at(offset);
+        if (!block->occupied.test(offset)) {
+            new (&value) data_storage_t(data_if::create(std::forward<Args>(args)...));
+            block->occupied.set(offset);
+            ++size_;
+        } else {
+            data_if::template merge<on_duplicate_index_strategy>(value, std::forward<Args>(args)...);
+        }
+        return data_if::expose(value);
+    }
+
+    inline data_output_t* get(const index_t& index)
+    {
+        index_t block_index;
+        const std::size_t offset = split(index, block_index);
+
+        const auto it = blocks_.find(block_index);
+        if (it == blocks_.end() || !it->second->occupied.test(offset))
+            return nullptr;
+
+        return &data_if::expose(it->second->at(offset));
+    }
+
+    inline const data_output_t* get(const index_t& index) const
+    {
+        index_t block_index;
+        const std::size_t offset = split(index, block_index);
+
+        const auto it = blocks_.find(block_index);
+        if (it == blocks_.end() || !it->second->occupied.test(offset))
+            return nullptr;
+
+        return &data_if::expose(it->second->at(offset));
+    }
+
+    /**
+     * @brief Visit all entries block by block, in order of block creation.
+     */
+    template<typename Fn>
+    inline void traverse(const Fn& function)
+    {
+        block_arena_.apply([&function](Block &block) {
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                if (block.occupied.test(offset))
+                    function(merge(block.index, offset), data_if::expose(block.at(offset)));
+            }
+        });
+    }
+
+    template<typename Fn>
+    inline void traverse(const Fn& function) const
+    {
+        block_arena_.apply([&function](const Block &block) {
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                if (block.occupied.test(offset))
+                    function(merge(block.index, offset), data_if::expose(block.at(offset)));
+            }
+        });
+    }
+
+    /**
+     * @brief Release all blocks at once.
+     */
+    inline void clear()
+    {
+        block_arena_.apply([](Block &block) {
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                if (block.occupied.test(offset)) {
+                    data_storage_t &value = block.at(offset);
+                    data_if::deallocate(value);
+                    value.~data_storage_t();
+                }
+            }
+        });
+        block_arena_.clear();
+        blocks_.clear();
+        size_ = 0;
+    }
+
+    /**
+     * @brief Memory held by the blocks, the hash table and the data itself.
+     */
+    virtual inline std::size_t byte_size() const
+    {
+        std::size_t bytes = sizeof(*this) + block_arena_.byte_size() +
+                blocks_.bucket_count() * sizeof(void*) +
+                blocks_.size() * (sizeof(typename block_map_t::value_type) + sizeof(void*));
+        block_arena_.apply([&bytes](const Block &block) {
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                if (block.occupied.test(offset)) {
+                    const std::size_t size = data_if::byte_size(block.at(offset));
+                    if (size > sizeof(data_storage_t))
+                        bytes += size - sizeof(data_storage_t);
+                }
+            }
+        });
+        return bytes;
+    }
+
+    inline std::size_t size() const
+    {
+        return size_;
+    }
+
+    inline std::size_t blockCount() const
+    {
+        return blocks_.size();
+    }
+
+private:
+    /**
+     * @brief Split an index into its block coordinate and the offset inside the block.
+     *        Arithmetic shifts round towards negative infinity, so negative indices
+     *        are handled without any offset.
+     */
+    inline static std::size_t split(const index_t &index, index_t &block_index)
+    {
+        block_index = index;
+        std::size_t offset = 0;
+        for (std::size_t i = 0 ; i < dimensions ; ++i) {
+            const int v = index[i];
+            block_index[i] = v >> block_bits;
+            offset |= static_cast<std::size_t>(v & block_mask) << (block_bits * i);
+        }
+        return offset;
+    }
+
+    inline static index_t merge(const index_t &block_index, const std::size_t offset)
+    {
+        index_t index = block_index;
+        for (std::size_t i = 0 ; i < dimensions ; ++i) {
+            const int v = static_cast<int>((offset >> (block_bits * i)) & block_mask);
+            index[i] = block_index[i] * block_width + v;
+        }
+        return index;
+    }
+
+protected:
+    block_arena_t block_arena_;
+    block_map_t   blocks_;
+    std::size_t   size_ = 0;
+};
+
+}
+}
+
+#endif // CSLIBS_NDT_BACKEND_BLOCK_HASH_HPP
@@ -0,0 +1,428 @@
+#ifndef CSLIBS_NDT_BACKEND_COPY_ON_WRITE_HPP
+#define CSLIBS_NDT_BACKEND_COPY_ON_WRITE_HPP
+
+#include <cslibs_indexed_storage/backend/tags.hpp>
+#include <cslibs_indexed_storage/backend/backend_traits.hpp>
+#include <cslibs_indexed_storage/interface/data/data_interface.hpp>
+
+#include <Eigen/Core>
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <memory>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+
+namespace cslibs_indexed_storage { namespace backend {
+struct copy_on_write_tag {};
+}}
+
+namespace cis = cslibs_indexed_storage;
+
+namespace cslibs_ndt {
+namespace backend {
+namespace tags {
+/**
+ * @brief Option of CopyOnWrite, set<tags::on_copy>(fn) registers fn(index, data) which is
+ *        called for every entry of a block copied on write, with the entry's new address.
+ */
+struct on_copy {};
+}
+
+/**
+ * @brief Block-sparse storage like BlockHash, whose blocks are shared between copies.
+ *        Copying the storage is O(1): both copies reference the same blocks, and whichever
+ *        of them writes to a shared block first copies that block, so all other blocks
+ *        stay shared. Blocks are found through a fixed number of hash shards, which are
+ *        shared and copied on write in the same way.
+ *        Only non-const access counts as a write, read through a const reference to never copy.
+ */
+template<typename data_interface_t_, typename index_interface_t_, typename... options_ts_>
+class CopyOnWrite
+{
+public:
+    using tag = cis::backend::copy_on_write_tag;
+
+    using data_if = data_interface_t_;
+    using data_storage_t = typename data_if::storage_type;
+    using data_output_t = typename data_if::output_type;
+
+    using index_if = index_interface_t_;
+    using index_t = typename index_if::type;
+
+    using on_copy_t = std::function<void(const index_t&, data_output_t&)>;
+
+    static constexpr auto on_duplicate_index_strategy =
+            cis::option::get_option<cis::option::merge_strategy_opt, options_ts_...>::value;
+
+    static constexpr std::size_t dimensions  = index_if::dimensions;
+    static constexpr int         block_bits  = dimensions > 2 ? 2 : 3;
+    static constexpr int         block_width = 1 << block_bits;
+    static constexpr int         block_mask  = block_width - 1;
+    static constexpr std::size_t block_cells = std::size_t(1) << (block_bits * dimensions);
+    static constexpr std::size_t shard_bits  = 6;
+    static constexpr std::size_t shard_count = std::size_t(1) << shard_bits;
+
+protected:
+    using cell_t = typename std::aligned_storage<sizeof(data_storage_t), alignof(data_storage_t)>::type;
+
+    struct Block
+    {
+        inline explicit Block(const index_t &index) :
+            index(index)
+        {
+        }
+
+        /**
+         * @brief Copies the entries of other, which readers of the other copies may be sampling
+         *        meanwhile. This only reads as long as the shared entries are settled, i.e. their
+         *        lazily cached matrices are filled, see map::snapshot.
+         */
+        inline Block(const Block &other) :
+            index(other.index),
+            occupied(other.occupied)
+        {
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset)
+                if (occupied.test(offset))
+                    new (&cells[offset]) data_storage_t(data_if::create(data_if::expose(other.at(offset))));
+        }
+
+        inline Block& operator = (const Block &) = delete;
+
+        inline ~Block()
+        {
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                if (occupied.test(offset)) {
+                    data_storage_t &value = at(offset);
+                    data_if::deallocate(value);
+                    value.~data_storage_t();
+                }
+            }
+        }
+
+        inline data_storage_t& at(const std::size_t offset)
+        {
+            return *reinterpret_cast<data_storage_t*>(&cells[offset]);
+        }
+
+        inline const data_storage_t& at(const std::size_t offset) const
+        {
+            return *reinterpret_cast<const data_storage_t*>(&cells[offset]);
+        }
+
+        index_t                   index;
+        std::bitset<block_cells>  occupied;
+        cell_t                    cells[block_cells];
+    };
+
+    struct Hash
+    {
+        inline std::size_t operator()(const index_t &index) const
+        {
+            static constexpr std::size_t primes[] = {73856093ul, 19349663ul, 83492791ul, 2654435761ul};
+            std::size_t h = 0;
+            for (std::size_t i = 0 ; i < dimensions ; ++i)
+                h ^= static_cast<std::size_t>(index[i]) * primes[i % 4];
+            return h;
+        }
+    };
+
+    using block_ptr_t = std::shared_ptr<Block>;
+    using shard_t     = std::unordered_map<index_t, block_ptr_t, Hash>;
+    using shard_ptr_t = std::shared_ptr<shard_t>;
+    using shards_t    = std::array<shard_ptr_t, shard_count>;
+
+public:
+    inline CopyOnWrite() :
+        shards_(std::make_shared<shards_t>())
+    {
+    }
+
+    /**
+     * @brief Shares all blocks with other. The on_copy callback is not taken over,
+     *        it usually refers to the owner of the other storage.
+     */
+    inline CopyOnWrite(const CopyOnWrite &other) :
+        shards_(other.shards_),
+        size_(other.size_)
+    {
+    }
+
+    inline CopyOnWrite(CopyOnWrite &&other) :
+        shards_(std::move(other.shards_)),
+        size_(other.size_),
+        on_copy_(std::move(other.on_copy_))
+    {
+        other.shards_ = std::make_shared<shards_t>();
+        other.size_   = 0;
+    }
+
+    inline virtual ~CopyOnWrite() = default;
+
+    template<typename option_t>
+    inline void set(const on_copy_t &on_copy)
+    {
+        static_assert(std::is_same<option_t, tags::on_copy>::value, "CopyOnWrite: unknown option");
+        on_copy_ = on_copy;
+    }
+
+    template<typename... Args>
+    inline data_output_t& insert(const index_t& index, Args&&... args)
+    {
+        index_t block_index;
+        const std::size_t offset = split(index, block_index);
+
+        Block *block = writable(block_index, true);
+        data_storage_t &value = block->at(offset);
+        if (!block->occupied.test(offset)) {
+            new (&value) data_storage_t(data_if::create(std::forward<Args>(args)...));
+            block->occupied.set(offset);
+            ++size_;
+        } else {
+            data_if::template merge<on_duplicate_index_strategy>(value, std::forward<Args>(args)...);
+        }
+        return data_if::expose(value);
+    }
+
+    /**
+     * @brief Write access, copies the block of index if it is shared.
+     */
+    inline data_output_t* get(const index_t& index)
+    {
+        index_t block_index;
+        const std::size_t offset = split(index, block_index);
+
+        const Block *shared = find(block_index);
+        if (!shared || !shared->occupied.test(offset))
+            return nullptr;
+
+        return &data_if::expose(writable(block_index, false)->at(offset));
+    }
+
+    inline const data_output_t* get(const index_t& index) const
+    {
+        index_t block_index;
+        const std::size_t offset = split(index, block_index);
+
+        const Block *block = find(block_index);
+        if (!block || !block->occupied.test(offset))
+            return nullptr;
+
+        return &data_if::expose(block->at(offset));
+    }
+
+    /**
+     * @brief Visit all entries with write access, copies every shared block.
+     */
+    template<typename Fn>
+    inline void traverse(const Fn& function)
+    {
+        for (std::size_t s = 0 ; s < shard_count ; ++s) {
+            if (!(*shards_)[s])
+                continue;
+            for (auto &entry : writableShard(s)) {
+                Block &block = writable(entry.second);
+                for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                    if (block.occupied.test(offset))
+                        function(merge(block.index, offset), data_if::expose(block.at(offset)));
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Visit all entries shard by shard, in no particular order.
+     */
+    template<typename Fn>
+    inline void traverse(const Fn& function) const
+    {
+        for (const shard_ptr_t &shard : *shards_) {
+            if (!shard)
+                continue;
+            for (const auto &entry : *shard) {
+                const Block &block = *entry.second;
+                for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                    if (block.occupied.test(offset))
+                        function(merge(block.index, offset), data_if::expose(block.at(offset)));
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Drop all references, shared blocks live on in the other copies.
+     */
+    inline void clear()
+    {
+        shards_ = std::make_shared<shards_t>();
+        size_   = 0;
+    }
+
+    /**
+     * @brief Memory held by the shards, the blocks and the data itself,
+     *        blocks shared with other copies are included.
+     */
+    virtual inline std::size_t byte_size() const
+    {
+        std::size_t bytes = sizeof(*this) + sizeof(shards_t);
+        for (const shard_ptr_t &shard : *shards_) {
+            if (!shard)
+                continue;
+            bytes += sizeof(shard_t) + shard->bucket_count() * sizeof(void*) +
+                     shard->size() * (sizeof(typename shard_t::value_type) + sizeof(void*));
+            for (const auto &entry : *shard) {
+                const Block &block = *entry.second;
+                bytes += sizeof(Block);
+                for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                    if (block.occupied.test(offset)) {
+                        const std::size_t size = data_if::byte_size(block.at(offset));
+                        if (size > sizeof(data_storage_t))
+                            bytes += size - sizeof(data_storage_t);
+                    }
+                }
+            }
+        }
+        return bytes;
+    }
+
+    inline std::size_t size() const
+    {
+        return size_;
+    }
+
+    inline std::size_t blockCount() const
+    {
+        std::size_t count = 0;
+        for (const shard_ptr_t &shard : *shards_)
+            count += shard ? shard->size() : 0ul;
+        return count;
+    }
+
+    /**
+     * @brief Number of blocks also referenced by another copy.
+     */
+    inline std::size_t sharedBlockCount() const
+    {
+        std::size_t count = 0;
+        for (const shard_ptr_t &shard : *shards_) {
+            if (!shard)
+                continue;
+            for (const auto &entry : *shard)
+                count += entry.second.use_count() > 1 ? 1ul : 0ul;
+        }
+        return count;
+    }
+
+private:
+    /**
+     * @brief True if p is the only reference. The fence orders all reads of the copies which
+     *        released their references before the caller starts writing.
+     */
+    template <typename ptr_t>
+    inline static bool unique(const ptr_t &p)
+    {
+        if (p.use_count() != 1)
+            return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    inline static std::size_t shardOf(const index_t &block_index)
+    {
+        return (Hash()(block_index) * 0x9E3779B97F4A7C15ull) >> (64 - shard_bits);
+    }
+
+    inline const Block* find(const index_t &block_index) const
+    {
+        const shard_ptr_t &shard = (*shards_)[shardOf(block_index)];
+        if (!shard)
+            return nullptr;
+        const auto it = shard->find(block_index);
+        return it != shard->end() ? it->second.get() : nullptr;
+    }
+
+    inline shard_t& writableShard(const std::size_t s)
+    {
+        if (!unique(shards_))
+            shards_ = std::make_shared<shards_t>(*shards_);
+        shard_ptr_t &shard = (*shards_)[s];
+        if (!shard)
+            shard = std::make_shared<shard_t>();
+        else if (!unique(shard))
+            shard = std::make_shared<shard_t>(*shard);
+        return *shard;
+    }
+
+    inline Block& writable(block_ptr_t &block)
+    {
+        if (!unique(block)) {
+            block = std::allocate_shared<Block>(Eigen::aligned_allocator<Block>(), *block);
+            if (on_copy_) {
+                for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                    if (block->occupied.test(offset))
+                        on_copy_(merge(block->index, offset), data_if::expose(block->at(offset)));
+                }
+            }
+        }
+        return *block;
+    }
+
+    inline Block* writable(const index_t &block_index, const bool create)
+    {
+        shard_t &shard = writableShard(shardOf(block_index));
+        auto it = shard.find(block_index);
+        if (it == shard.end()) {
+            if (!create)
+                return nullptr;
+            it = shard.emplace(block_index, std::allocate_shared<Block>(Eigen::aligned_allocator<Block>(), block_index)).first;
+            return it->second.get();
+        }
+        return &writable(it->second);
+    }
+
+    /**
+     * @brief Split an index into its block coordinate and the offset inside the block.
+     */
+    inline static std::size_t split(const index_t &index, index_t &block_index)
+    {
+        block_index = index;
+        std::size_t offset = 0;
+        for (std::size_t i = 0 ; i < dimensions ; ++i) {
+            const int v = index[i];
+            block_index[i] = v >> block_bits;
+            offset |= static_cast<std::size_t>(v & block_mask) << (block_bits * i);
+        }
+        return offset;
+    }
+
+    inline static index_t merge(const index_t &block_index, const std::size_t offset)
+    {
+        index_t index = block_index;
+        for (std::size_t i = 0 ; i < dimensions ; ++i) {
+            const int v = static_cast<int>((offset >> (block_bits * i)) & block_mask);
+            index[i] = block_index[i] * block_width + v;
+        }
+        return index;
+    }
+
+    std::shared_ptr<shards_t> shards_;
+    std::size_t               size_ = 0;
+    on_copy_t                 on_copy_;
+};
+
+/**
+ * @brief Whether a backend shares blocks between copies, maps then keep their
+ *        distribution pointers up to date when a block is copied on write.
+ */
+template <template <typename, typename, typename...> class backend_t>
+struct is_copy_on_write : std::false_type {};
+
+template <>
+struct is_copy_on_write<CopyOnWrite> : std::true_type {};
+
+}
+}
+
+#endif // CSLIBS_NDT_BACKEND_COPY_ON_WRITE_HPP
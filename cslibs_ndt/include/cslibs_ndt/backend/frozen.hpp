@@ -0,0 +1,18 @@
+#ifndef CSLIBS_NDT_BACKEND_FROZEN_HPP
+#define CSLIBS_NDT_BACKEND_FROZEN_HPP
+
+namespace cslibs_ndt {
+namespace backend {
+
+/**
+ * @brief Layout tag selecting the read-only map compiled from another map, e.g.
+ *        Map<tags::dynamic_map,3,Distribution,double,backend::Frozen>,
+ *        it is never instantiated itself.
+ */
+template<typename data_interface_t_, typename index_interface_t_, typename... options_ts_>
+class Frozen;
+
+}
+}
+
+#endif // CSLIBS_NDT_BACKEND_FROZEN_HPP
@@ -6,6 +6,10 @@
 #include <cslibs_indexed_storage/interface/data/data_interface.hpp>
 #include <cslibs_indexed_storage/interface/data/align/aligned_allocator.hpp>
 
+#include <cslibs_ndt/backend/arena.hpp>
+
+#include <array>
+
 namespace cslibs_indexed_storage { namespace backend {
 struct octree_tag {};
 }}
@@ -39,6 +43,12 @@ protected:
         data_storage_t data;
     };
 
+    union Node;
+    using children_t       = std::array<Node*, dimension>;
+    using node_arena_t     = Arena<Node, 256, 65536>;
+    using children_arena_t = Arena<children_t, 64, 8192>;
+    using data_arena_t     = Arena<Data, 16, 1024>;
+
     union Node {
         inline bool childExists(const unsigned int pos) const
         {
@@ -58,16 +68,18 @@ protected:
             return false;
         }
 
-        inline Node* createChild(const unsigned int pos)
+        inline Node* createChild(const unsigned int pos,
+                                 node_arena_t &nodes,
+                                 children_arena_t &children)
         {
             assert (pos < dimension);
             // allocate children pointers
             if (!children_)
-                allocateChildren();
+                children_ = children.create()->data();
 
             // create children
             assert (!children_[pos]);
-            children_[pos] = new Node();
+            children_[pos] = nodes.create();
 
             return children_[pos];
         }
@@ -86,19 +98,13 @@ protected:
             return children_[pos];
         }
 
-        inline void allocateChildren()
-        {
-            children_ = new Node*[dimension];
-            for (unsigned int i=0; i<dimension; ++i)
-                children_[i] = nullptr;
-        }
-
         template<typename... Args>
-        inline data_output_t& insert(const bool node_just_created, const index_t& index, Args&&... args)
+        inline data_output_t& insert(const bool node_just_created, const index_t& index,
+                                     data_arena_t &data, Args&&... args)
         {
             // in new node, create new data, set index
             if (node_just_created) {
-                data_ptr_ = new Data();
+                data_ptr_ = data.create();
 
                 auto& value = data_ptr_->data;
                 value = data_if::create(std::forward<Args>(args)...);
@@ -118,6 +124,11 @@ protected:
             return data_ptr_ ? &data_if::expose(data_ptr_->data) : nullptr;
         }
 
+        inline const data_storage_t* get() const
+        {
+            return data_ptr_ ? &data_if::expose(data_ptr_->data) : nullptr;
+        }
+
         template<typename Fn>
         inline void apply(const Fn& function)
         {
@@ -132,47 +143,47 @@ protected:
                 function(data_ptr_->index, data_if::expose(data_ptr_->data));
         }
 
-        inline void deleteChildren()
-        {
-            if (children_) {
-                for (unsigned int i=0; i<dimension; ++i) {
-                    if (children_[i]) {
-                        delete children_[i];
-                    }
-                }
-                delete children_;
-            }
-        }
-
-        inline void deleteData()
-        {
-            if (data_ptr_) {
-                data_ptr_->index = index;
-                data_if::deallocate(data_ptr_->data);
-                delete data_ptr_;
-            }
-        }
-
-        inline std::size_t byte_size() const
-        {
-            if (data_ptr_) {
-                return sizeof(index_t) + data_if::byte_size(data_ptr_->data);
-            }
-            return 0;
-        }
-
     private:
         Node** children_;
         Data*  data_ptr_ = nullptr;
     };
 
 public:
+    inline OcTree() = default;
+
+    inline OcTree(const OcTree &other) :
+        tree_depth_(other.tree_depth_),
+        tree_max_val_(other.tree_max_val_)
+    {
+        other.traverse([this](const index_t &index, const data_output_t &data) {
+            insert(index, data);
+        });
+    }
+
+    inline OcTree(OcTree &&other) :
+        node_arena_(std::move(other.node_arena_)),
+        children_arena_(std::move(other.children_arena_)),
+        data_arena_(std::move(other.data_arena_)),
+        root_(other.root_),
+        tree_size_(other.tree_size_),
+        tree_depth_(other.tree_depth_),
+        tree_max_val_(other.tree_max_val_)
+    {
+        other.root_      = nullptr;
+        other.tree_size_ = 0;
+    }
+
+    inline virtual ~OcTree()
+    {
+        clear();
+    }
+
     template<typename... Args>
     inline data_output_t& insert(const index_t& index, Args&&... args)
     {
         bool created_root = false;
         if (root_ == nullptr) {
-            root_ = new Node();
+            root_ = node_arena_.create();
             ++tree_size_;
             created_root = true;
         }
@@ -210,18 +221,35 @@ public:
             traverse(root_, function, 0);
     }
 
+    /**
+     * @brief Release all nodes, child arrays and data records at once.
+     */
     inline void clear()
     {
-        if (root_) {
-            clear(root_, 0);
-            delete root_;
-        }
+        data_arena_.apply([](Data &d) {
+            data_if::deallocate(d.data);
+        });
+        data_arena_.clear();
+        children_arena_.clear();
+        node_arena_.clear();
+
+        root_      = nullptr;
         tree_size_ = 0;
     }
 
+    /**
+     * @brief Memory held by the arenas plus memory owned by the data itself.
+     */
     virtual inline std::size_t byte_size() const
     {
-        return root_ ? (sizeof(*this) + byte_size(root_,0,0)) : sizeof(*this);
+        std::size_t bytes = sizeof(*this) +
+                node_arena_.byte_size() + children_arena_.byte_size() + data_arena_.byte_size();
+        data_arena_.apply([&bytes](const Data &d) {
+            const std::size_t size = data_if::byte_size(d.data);
+            if (size > sizeof(data_storage_t))
+                bytes += size - sizeof(data_storage_t);
+        });
+        return bytes;
     }
 
     inline std::size_t size() const
@@ -241,7 +269,7 @@ private:
         if (depth < tree_depth_) {
             const unsigned int pos = computeChildIdx(index, tree_depth_ -1 - depth);
             if (!node->childExists(pos)) {
-                node->createChild(pos);
+                node->createChild(pos, node_arena_, children_arena_);
                 ++tree_size_;
                 created_node = true;
             }
@@ -249,7 +277,7 @@ private:
         }
 
         // at last level, update node, end of recursion
-        return node->insert(node_just_created, index, args...);
+        return node->insert(node_just_created, index, data_arena_, args...);
     }
 
     inline data_output_t* get(Node* node, const index_t& index, const unsigned int depth)
@@ -269,7 +297,7 @@ private:
         return node->get();
     }
 
-    inline data_output_t* get(const Node* node, const index_t& index, const unsigned int depth) const
+    inline const data_output_t* get(const Node* node, const index_t& index, const unsigned int depth) const
     {
         assert (node);
 
@@ -322,52 +350,7 @@ private:
             node->apply(function);
     }
 
-    template<typename Fn>
-    inline void clear(Node* node, const unsigned int depth)
-    {
-        assert (node);
-
-        // recurse down to last level
-        if (depth < tree_depth_) {
-            for (std::size_t i = 0; i < dimension; ++i) {
-                if (node->childExists(i)) {
-                    clear(node->getChild(i), depth + 1);
-                    node->deleteChildren();
-                }
-            }
-        }
-
-        // at last level, clear data, end of recursion
-        else {
-            node->clear();
-            node->deleteData();
-        }
-    }
-
-    inline std::size_t byte_size(const Node* node, const unsigned int depth, std::size_t bytes) const
-    {
-        assert (node);
-        bytes += sizeof(Node);
-
-        // recurse down to last level
-        if (depth < tree_depth_) {
-            if (node->hasChildren()) {
-                bytes += dimension * sizeof(Node*);
-
-                for (std::size_t i = 0; i < dimension; ++i) {
-                    if (node->childExists(i)) {
-                        bytes += byte_size(node->getChild(i), depth +1, 0);
-                    }
-                }
-            }
-            return bytes;
-        }
-
-        // at last level, get byte size of data, end of recursion
-        return bytes + node->byte_size();
-    }
-
-    inline unsigned int computeChildIdx(const index_t& index, const unsigned int depth)
+    inline unsigned int computeChildIdx(const index_t& index, const unsigned int depth) const
     {
         unsigned int pos = 0;
         for (std::size_t i = 0; i < index_if::dimensions; ++i) {
@@ -380,8 +363,12 @@ private:
     }
 
 protected:
+    node_arena_t       node_arena_;
+    children_arena_t   children_arena_;
+    data_arena_t       data_arena_;
+
     Node*              root_ = nullptr;
-    std::size_t        tree_size_;
+    std::size_t        tree_size_ = 0;
     const unsigned int tree_depth_ = 16;         //TODO???
     const int          tree_max_val_ = 32768;    // = 2^15 = (1 << (tree_depth_ - 1))
 };
@@ -0,0 +1,474 @@
+#ifndef CSLIBS_NDT_BACKEND_ROLLING_WINDOW_HPP
+#define CSLIBS_NDT_BACKEND_ROLLING_WINDOW_HPP
+
+#include <cslibs_indexed_storage/backend/tags.hpp>
+#include <cslibs_indexed_storage/backend/backend_traits.hpp>
+#include <cslibs_indexed_storage/interface/data/data_interface.hpp>
+
+#include <Eigen/Core>
+
+#include <array>
+#include <bitset>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+namespace cslibs_indexed_storage { namespace backend {
+struct rolling_window_tag {};
+}}
+
+namespace cis = cslibs_indexed_storage;
+
+namespace cslibs_ndt {
+namespace backend {
+namespace tags {
+/**
+ * @brief Options of RollingWindow:
+ *        set<tags::window_capacity>(size) is the largest window extent per dimension, drops all entries,
+ *        set<tags::window>(min, max) moves the window to [min, max], evicting all entries outside,
+ *        set<tags::on_evict>(fn) registers fn(index, data) which is called for every evicted entry.
+ */
+struct window_capacity {};
+struct window {};
+struct on_evict {};
+}
+
+/**
+ * @brief Storage of a bounded window [min, max] of indices, which can be moved around.
+ *        Indices are grouped into blocks like in BlockHash, the blocks are kept in a ring buffer
+ *        which covers the window capacity, so lookups are an offset computation and no hash.
+ *        Blocks are allocated on the first insert and freed once all of their entries have been
+ *        evicted, memory is bounded by the capacity and not by the extent ever visited.
+ *        Moving the window only touches the cells which leave it, which is amortized O(1)
+ *        per evicted cell. Inserting outside of the window throws std::out_of_range.
+ *        Data addresses are stable until the entry is evicted.
+ */
+template<typename data_interface_t_, typename index_interface_t_, typename... options_ts_>
+class RollingWindow
+{
+public:
+    using tag = cis::backend::rolling_window_tag;
+
+    using data_if = data_interface_t_;
+    using data_storage_t = typename data_if::storage_type;
+    using data_output_t = typename data_if::output_type;
+
+    using index_if = index_interface_t_;
+    using index_t = typename index_if::type;
+
+    static constexpr auto on_duplicate_index_strategy =
+            cis::option::get_option<cis::option::merge_strategy_opt, options_ts_...>::value;
+
+    static constexpr std::size_t dimensions  = index_if::dimensions;
+    static constexpr int         block_bits  = dimensions > 2 ? 2 : 3;
+    static constexpr int         block_width = 1 << block_bits;
+    static constexpr int         block_mask  = block_width - 1;
+    static constexpr std::size_t block_cells = std::size_t(1) << (block_bits * dimensions);
+
+    using capacity_t = std::array<std::size_t, dimensions>;
+    using on_evict_t = std::function<void(const index_t&, data_output_t&)>;
+
+protected:
+    using cell_t = typename std::aligned_storage<sizeof(data_storage_t), alignof(data_storage_t)>::type;
+
+    struct Block
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        inline explicit Block(const index_t &index) :
+            index(index)
+        {
+        }
+
+        inline data_storage_t& at(const std::size_t offset)
+        {
+            return *reinterpret_cast<data_storage_t*>(&cells[offset]);
+        }
+
+        inline const data_storage_t& at(const std::size_t offset) const
+        {
+            return *reinterpret_cast<const data_storage_t*>(&cells[offset]);
+        }
+
+        index_t                   index;
+        std::bitset<block_cells>  occupied;
+        cell_t                    cells[block_cells];
+    };
+
+    using block_ptr_t = std::unique_ptr<Block>;
+
+public:
+    inline RollingWindow()
+    {
+        min_.fill(0);
+        max_.fill(-1);
+        capacity_.fill(0ul);
+        ring_size_.fill(0ul);
+    }
+
+    /**
+     * @brief Copies window and entries. The on_evict callback is not taken over,
+     *        it usually refers to the owner of the other storage.
+     */
+    inline RollingWindow(const RollingWindow &other) :
+        RollingWindow()
+    {
+        set<tags::window_capacity>(other.capacity_);
+        min_ = other.min_;
+        max_ = other.max_;
+        other.traverse([this](const index_t &index, const data_output_t &data) {
+            insert(index, data);
+        });
+    }
+
+    inline RollingWindow(RollingWindow &&other) :
+        min_(other.min_),
+        max_(other.max_),
+        capacity_(other.capacity_),
+        ring_size_(other.ring_size_),
+        ring_(std::move(other.ring_)),
+        size_(other.size_),
+        on_evict_(std::move(other.on_evict_))
+    {
+        other.ring_.clear();
+        other.size_ = 0;
+    }
+
+    inline virtual ~RollingWindow()
+    {
+        clear();
+    }
+
+    template<typename option_t>
+    inline void set(const capacity_t &capacity)
+    {
+        static_assert(std::is_same<option_t, tags::window_capacity>::value, "RollingWindow: unknown option");
+        clear();
+        capacity_ = capacity;
+        // a window of capacity cells overlaps at most this many blocks per dimension
+        std::size_t blocks = 1;
+        for (std::size_t i = 0 ; i < dimensions ; ++i) {
+            ring_size_[i] = capacity_[i] > 0ul ? (capacity_[i] + block_width - 2) / block_width + 1 : 0ul;
+            blocks *= ring_size_[i];
+        }
+        ring_.clear();
+        ring_.resize(blocks);
+        min_.fill(0);
+        max_.fill(-1);
+    }
+
+    template<typename option_t>
+    inline void set(const index_t &min, const index_t &max)
+    {
+        static_assert(std::is_same<option_t, tags::window>::value, "RollingWindow: unknown option");
+        for (std::size_t i = 0 ; i < dimensions ; ++i) {
+            if (max[i] < min[i] || static_cast<std::size_t>(max[i] - min[i]) >= capacity_[i])
+                throw std::invalid_argument("RollingWindow: window exceeds the capacity");
+        }
+
+        /// step one: evict what is in the old window but not in the new one
+        forEachOutside(min_, max_, min, max, [this](const index_t &index) {
+            evict(index);
+        });
+
+        /// step two: nothing outside is left, the ring slots are free for the new window
+        min_ = min;
+        max_ = max;
+    }
+
+    template<typename option_t>
+    inline void set(const on_evict_t &on_evict)
+    {
+        static_assert(std::is_same<option_t, tags::on_evict>::value, "RollingWindow: unknown option");
+        on_evict_ = on_evict;
+    }
+
+    template<typename... Args>
+    inline data_output_t& insert(const index_t& index, Args&&... args)
+    {
+        if (!inside(index))
+            throw std::out_of_range("RollingWindow: index outside of the window");
+
+        index_t block_index;
+        const std::size_t offset = split(index, block_index);
+
+        block_ptr_t &block = ring_[slot(block_index)];
+        if (!block)
+            block.reset(new Block(block_index));
+
+        data_storage_t &value = block->at(offset);
+        if (!block->occupied.test(offset)) {
+            new (&value) data_storage_t(data_if::create(std::forward<Args>(args)...));
+            block->occupied.set(offset);
+            ++size_;
+        } else {
+            data_if::template merge<on_duplicate_index_strategy>(value, std::forward<Args>(args)...);
+        }
+        return data_if::expose(value);
+    }
+
+    inline data_output_t* get(const index_t& index)
+    {
+        Block *block = nullptr;
+        const std::size_t offset = find(index, block);
+        return block ? &data_if::expose(block->at(offset)) : nullptr;
+    }
+
+    inline const data_output_t* get(const index_t& index) const
+    {
+        Block *block = nullptr;
+        const std::size_t offset = find(index, block);
+        return block ? &data_if::expose(block->at(offset)) : nullptr;
+    }
+
+    /**
+     * @brief Visit all entries block by block, in ring buffer order.
+     */
+    template<typename Fn>
+    inline void traverse(const Fn& function)
+    {
+        for (block_ptr_t &block : ring_) {
+            if (!block)
+                continue;
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                if (block->occupied.test(offset))
+                    function(merge(block->index, offset), data_if::expose(block->at(offset)));
+            }
+        }
+    }
+
+    template<typename Fn>
+    inline void traverse(const Fn& function) const
+    {
+        for (const block_ptr_t &block : ring_) {
+            if (!block)
+                continue;
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                if (block->occupied.test(offset))
+                    function(merge(block->index, offset), data_if::expose(static_cast<const Block&>(*block).at(offset)));
+            }
+        }
+    }
+
+    /**
+     * @brief Drop all entries without evicting them, the window stays where it is.
+     */
+    inline void clear()
+    {
+        for (block_ptr_t &block : ring_) {
+            if (!block)
+                continue;
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                if (block->occupied.test(offset)) {
+                    data_storage_t &value = block->at(offset);
+                    data_if::deallocate(value);
+                    value.~data_storage_t();
+                }
+            }
+            block.reset();
+        }
+        size_ = 0;
+    }
+
+    /**
+     * @brief Memory held by the ring buffer, the blocks and the data itself.
+     */
+    virtual inline std::size_t byte_size() const
+    {
+        std::size_t bytes = sizeof(*this) + ring_.capacity() * sizeof(block_ptr_t);
+        for (const block_ptr_t &block : ring_) {
+            if (!block)
+                continue;
+            bytes += sizeof(Block);
+            for (std::size_t offset = 0 ; offset < block_cells ; ++offset) {
+                if (block->occupied.test(offset)) {
+                    const std::size_t size = data_if::byte_size(block->at(offset));
+                    if (size > sizeof(data_storage_t))
+                        bytes += size - sizeof(data_storage_t);
+                }
+            }
+        }
+        return bytes;
+    }
+
+    inline std::size_t size() const
+    {
+        return size_;
+    }
+
+    inline std::size_t blockCount() const
+    {
+        return static_cast<std::size_t>(std::count_if(ring_.begin(), ring_.end(), [](const block_ptr_t &block) {
+            return static_cast<bool>(block);
+        }));
+    }
+
+    inline const index_t& windowMin() const
+    {
+        return min_;
+    }
+
+    inline const index_t& windowMax() const
+    {
+        return max_;
+    }
+
+private:
+    inline bool inside(const index_t &index) const
+    {
+        for (std::size_t i = 0 ; i < dimensions ; ++i)
+            if (index[i] < min_[i] || index[i] > max_[i])
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Ring buffer slot of a block, blocks which are ring_size_ apart share a slot,
+     *        but never overlap the window at the same time.
+     */
+    inline std::size_t slot(const index_t &block_index) const
+    {
+        std::size_t s = 0;
+        for (std::size_t i = dimensions ; i-- > 0 ;) {
+            const long n = static_cast<long>(ring_size_[i]);
+            const long r = ((static_cast<long>(block_index[i]) % n) + n) % n;
+            s = s * ring_size_[i] + static_cast<std::size_t>(r);
+        }
+        return s;
+    }
+
+    inline std::size_t find(const index_t &index, Block *&block) const
+    {
+        block = nullptr;
+        if (!inside(index))
+            return 0ul;
+
+        index_t block_index;
+        const std::size_t offset = split(index, block_index);
+        Block *b = ring_[slot(block_index)].get();
+        if (b && b->index == block_index && b->occupied.test(offset))
+            block = b;
+        return offset;
+    }
+
+    inline void evict(const index_t &index)
+    {
+        index_t block_index;
+        const std::size_t offset = split(index, block_index);
+        block_ptr_t &block = ring_[slot(block_index)];
+        if (!block || block->index != block_index || !block->occupied.test(offset))
+            return;
+
+        data_storage_t &value = block->at(offset);
+        if (on_evict_)
+            on_evict_(index, data_if::expose(value));
+        data_if::deallocate(value);
+        value.~data_storage_t();
+        block->occupied.reset(offset);
+        --size_;
+
+        if (block->occupied.none())
+            block.reset();
+    }
+
+    /**
+     * @brief Visit all indices of the box [old_min, old_max] outside of [new_min, new_max]
+     *        exactly once, as slabs which are inside the new box in the dimensions before
+     *        the k-th and outside in the k-th.
+     */
+    template <typename Fn>
+    inline static void forEachOutside(const index_t &old_min, const index_t &old_max,
+                                      const index_t &new_min, const index_t &new_max,
+                                      const Fn &function)
+    {
+        for (std::size_t k = 0 ; k < dimensions ; ++k) {
+            index_t min = old_min;
+            index_t max = old_max;
+            for (std::size_t d = 0 ; d < k ; ++d) {
+                min[d] = std::max(old_min[d], new_min[d]);
+                max[d] = std::min(old_max[d], new_max[d]);
+                if (min[d] > max[d])
+                    return;
+            }
+
+            index_t below_max = max;
+            below_max[k] = std::min(old_max[k], new_min[k] - 1);
+            forEach(min, below_max, function);
+
+            index_t above_min = min;
+            above_min[k] = std::max(old_min[k], new_max[k] + 1);
+            forEach(above_min, max, function);
+        }
+    }
+
+    template <typename Fn>
+    inline static void forEach(const index_t &min, const index_t &max, const Fn &function)
+    {
+        for (std::size_t i = 0 ; i < dimensions ; ++i)
+            if (min[i] > max[i])
+                return;
+
+        index_t index = min;
+        while (true) {
+            function(index);
+            std::size_t i = 0;
+            for (; i < dimensions ; ++i) {
+                if (++index[i] <= max[i])
+                    break;
+                index[i] = min[i];
+            }
+            if (i == dimensions)
+                return;
+        }
+    }
+
+    /**
+     * @brief Split an index into its block coordinate and the offset inside the block.
+     */
+    inline static std::size_t split(const index_t &index, index_t &block_index)
+    {
+        block_index = index;
+        std::size_t offset = 0;
+        for (std::size_t i = 0 ; i < dimensions ; ++i) {
+            const int v = index[i];
+            block_index[i] = v >> block_bits;
+            offset |= static_cast<std::size_t>(v & block_mask) << (block_bits * i);
+        }
+        return offset;
+    }
+
+    inline static index_t merge(const index_t &block_index, const std::size_t offset)
+    {
+        index_t index = block_index;
+        for (std::size_t i = 0 ; i < dimensions ; ++i) {
+            const int v = static_cast<int>((offset >> (block_bits * i)) & block_mask);
+            index[i] = block_index[i] * block_width + v;
+        }
+        return index;
+    }
+
+    index_t                  min_;
+    index_t                  max_;
+    capacity_t               capacity_;
+    capacity_t               ring_size_;
+    std::vector<block_ptr_t> ring_;
+    std::size_t              size_ = 0;
+    on_evict_t               on_evict_;
+};
+
+/**
+ * @brief Whether a backend keeps a bounded window, maps then only accept indices inside it.
+ */
+template <template <typename, typename, typename...> class backend_t>
+struct is_rolling_window : std::false_type {};
+
+template <>
+struct is_rolling_window<RollingWindow> : std::true_type {};
+
+}
+}
+
+#endif // CSLIBS_NDT_BACKEND_ROLLING_WINDOW_HPP
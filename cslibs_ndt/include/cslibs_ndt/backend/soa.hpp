@@ -0,0 +1,19 @@
+#ifndef CSLIBS_NDT_BACKEND_SOA_HPP
+#define CSLIBS_NDT_BACKEND_SOA_HPP
+
+namespace cslibs_ndt {
+namespace backend {
+
+/**
+ * @brief Layout tag selecting the contiguous structure-of-arrays map.
+ *        Passed in place of an indexed storage backend, e.g.
+ *        Map<tags::static_map,3,Distribution,double,backend::SoA>,
+ *        it is never instantiated itself.
+ */
+template<typename data_interface_t_, typename index_interface_t_, typename... options_ts_>
+class SoA;
+
+}
+}
+
+#endif // CSLIBS_NDT_BACKEND_SOA_HPP
@@ -0,0 +1,285 @@
+#ifndef CSLIBS_NDT_COMMON_DECAYING_OCCUPANCY_DISTRIBUTION_HPP
+#define CSLIBS_NDT_COMMON_DECAYING_OCCUPANCY_DISTRIBUTION_HPP
+
+#include <cslibs_math/statistics/distribution.hpp>
+#include <cslibs_math/statistics/stable_distribution.hpp>
+#include <cslibs_gridmaps/utility/inverse_model.hpp>
+
+#include <cslibs_indexed_storage/storage.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace cslibs_ndt {
+/**
+ * @brief Current time and half-life shared by all distributions of a decaying occupancy map.
+ *        Evidence which is half_life old counts half. The default half-life is infinite,
+ *        i.e. nothing decays. Time is in arbitrary units, e.g. seconds, and must not go back.
+ */
+template <typename T>
+class DecayClock
+{
+public:
+    using Ptr      = std::shared_ptr<DecayClock<T>>;
+    using ConstPtr = std::shared_ptr<const DecayClock<T>>;
+
+    inline explicit DecayClock(const T half_life = std::numeric_limits<T>::infinity(),
+                               const T time      = T()) :
+        time_(time)
+    {
+        setHalfLife(half_life);
+    }
+
+    inline void setTime(const T time)
+    {
+        time_ = time;
+    }
+
+    inline T getTime() const
+    {
+        return time_;
+    }
+
+    inline void setHalfLife(const T half_life)
+    {
+        half_life_inv_ = std::isinf(half_life) ? T() : T(1) / half_life;
+    }
+
+    inline T getHalfLife() const
+    {
+        return half_life_inv_ > T() ? T(1) / half_life_inv_ : std::numeric_limits<T>::infinity();
+    }
+
+    /**
+     * @brief Factor evidence stamped with stamp has decayed by until now.
+     */
+    inline T factor(const T stamp) const
+    {
+        return half_life_inv_ > T() && time_ > stamp ? std::exp2(-(time_ - stamp) * half_life_inv_) : T(1);
+    }
+
+private:
+    T time_;
+    T half_life_inv_;
+};
+
+/**
+ * @brief Occupancy distribution like OccupancyDistribution, whose free and occupied evidence
+ *        fades out over time, so the occupancy of cells which are not observed anymore returns
+ *        to the prior and long runs do not saturate it. Instead of sweeping the map, every
+ *        distribution keeps the stamp of its last update: reads apply the decay since then
+ *        on the fly, the next update applies it to the stored weights and moves the stamp.
+ *        The clock is set by the map on every update, see DecayClock. Without a clock
+ *        nothing decays. The shape of the occupied Gaussian does not decay, only its weight,
+ *        it is estimated anew once less than a single sample of its evidence is left.
+ */
+template<typename T, std::size_t Dim>
+class DecayingOccupancyDistribution
+{
+public:
+    using Ptr                       = std::shared_ptr<DecayingOccupancyDistribution<T,Dim>>;
+    using distribution_container_t  = DecayingOccupancyDistribution<T, Dim>;
+    using distribution_t            = cslibs_math::statistics::StableDistribution<T,Dim,3>;
+    using distribution_ptr_t        = typename distribution_t::Ptr;
+    using point_t                   = typename distribution_t::sample_t;
+    using ivm_t                     = cslibs_gridmaps::utility::InverseModel<T>;
+    using clock_t                   = DecayClock<T>;
+    using clock_ptr_t               = typename clock_t::ConstPtr;
+
+    inline DecayingOccupancyDistribution() = default;
+
+    inline DecayingOccupancyDistribution(const T weight_free,
+                                         const T weight_occupied = T(),
+                                         const T stamp           = T()) :
+        weight_free_(weight_free),
+        weight_occupied_(weight_occupied),
+        stamp_(stamp)
+    {
+    }
+
+    inline DecayingOccupancyDistribution(const T weight_free,
+                                         const T weight_occupied,
+                                         const T stamp,
+                                         const distribution_t &data) :
+        weight_free_(weight_free),
+        weight_occupied_(weight_occupied),
+        stamp_(stamp),
+        distribution_(new distribution_t(data))
+    {
+    }
+
+    inline DecayingOccupancyDistribution(const DecayingOccupancyDistribution &other) :
+        weight_free_(other.weight_free_),
+        weight_occupied_(other.weight_occupied_),
+        stamp_(other.stamp_),
+        distribution_(other.distribution_ ? new distribution_t(*(other.distribution_)) : nullptr),
+        clock_(other.clock_)
+    {
+    }
+
+    inline DecayingOccupancyDistribution& operator = (const DecayingOccupancyDistribution &other)
+    {
+        weight_free_     = other.weight_free_;
+        weight_occupied_ = other.weight_occupied_;
+        stamp_           = other.stamp_;
+        clock_           = other.clock_;
+        if (other.distribution_)
+            distribution_.reset(new distribution_t(*(other.distribution_)));
+        else
+            distribution_.reset();
+        return *this;
+    }
+
+    inline void setClock(const clock_ptr_t &clock)
+    {
+        if (clock_ != clock)
+            clock_ = clock;
+    }
+
+    inline const clock_ptr_t& getClock() const
+    {
+        return clock_;
+    }
+
+    inline T getStamp() const
+    {
+        return stamp_;
+    }
+
+    inline void updateFree()
+    {
+        updateFree(1ul);
+    }
+
+    inline void updateFree(const std::size_t &n)
+    {
+        decay();
+        weight_free_ += static_cast<T>(n);
+    }
+
+    inline void updateOccupied(const point_t &p)
+    {
+        decay();
+        if (!distribution_ || weight_occupied_ < T(1))
+            distribution_.reset(new distribution_t());
+
+        *distribution_ += p;
+        weight_occupied_ += T(1);
+    }
+
+    inline void updateOccupied(const distribution_t &d)
+    {
+        decay();
+        if (!distribution_ || weight_occupied_ < T(1))
+            distribution_.reset(new distribution_t(d));
+        else
+            *distribution_ += d;
+        weight_occupied_ += static_cast<T>(d.getN());
+    }
+
+    /**
+     * @brief Free evidence, decayed until now.
+     */
+    inline T weightFree() const
+    {
+        return weight_free_ * factor();
+    }
+
+    /**
+     * @brief Occupied evidence, decayed until now.
+     */
+    inline T weightOccupied() const
+    {
+        return weight_occupied_ * factor();
+    }
+
+    /**
+     * @brief Number of occupied samples the Gaussian was estimated from, this does not decay.
+     */
+    inline std::size_t numOccupied() const
+    {
+        return distribution_ ? distribution_->getN() : 0ul;
+    }
+
+    inline T getOccupancy(const typename ivm_t::Ptr &inverse_model) const
+    {
+        if (!inverse_model)
+            throw std::runtime_error("inverse model not set!");
+
+        return getOccupancy(*inverse_model);
+    }
+
+    inline T getOccupancy(const ivm_t &inverse_model) const
+    {
+        if (!distribution_)
+            return T(0.0);
+
+        const T f = factor();
+        const T weight_free     = weight_free_ * f;
+        const T weight_occupied = weight_occupied_ * f;
+        return cslibs_math::common::LogOdds<T>::from(
+                    weight_free * inverse_model.getLogOddsFree() +
+                    weight_occupied * inverse_model.getLogOddsOccupied() -
+                    (weight_free + weight_occupied - 1) * inverse_model.getLogOddsPrior());
+    }
+
+    inline const distribution_ptr_t &getDistribution() const
+    {
+        return distribution_;
+    }
+
+    inline distribution_ptr_t &getDistribution()
+    {
+        return distribution_;
+    }
+
+    inline void merge(const DecayingOccupancyDistribution &other)
+    {
+        decay();
+        const T f = other.clock_ ? other.clock_->factor(other.stamp_) : T(1);
+        weight_free_     += other.weight_free_ * f;
+        weight_occupied_ += other.weight_occupied_ * f;
+        if (other.distribution_) {
+            if (distribution_)
+                *distribution_ += *(other.distribution_);
+            else
+                distribution_.reset(new distribution_t(*(other.distribution_)));
+        }
+    }
+
+    inline std::size_t byte_size() const
+    {
+        return distribution_ ? (sizeof(*this) + sizeof(distribution_t)) : sizeof(*this);
+    }
+
+private:
+    T                  weight_free_     = T();
+    T                  weight_occupied_ = T();
+    T                  stamp_           = T();
+    distribution_ptr_t distribution_    = nullptr;
+    clock_ptr_t        clock_;
+
+    inline T factor() const
+    {
+        return clock_ ? clock_->factor(stamp_) : T(1);
+    }
+
+    /**
+     * @brief Applies the decay since the last update to the stored weights.
+     */
+    inline void decay()
+    {
+        if (!clock_)
+            return;
+
+        const T f = clock_->factor(stamp_);
+        weight_free_     *= f;
+        weight_occupied_ *= f;
+        stamp_ = std::max(stamp_, clock_->getTime());
+    }
+};
+}
+
+#endif // CSLIBS_NDT_COMMON_DECAYING_OCCUPANCY_DISTRIBUTION_HPP
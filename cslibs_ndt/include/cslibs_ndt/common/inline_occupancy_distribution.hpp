@@ -0,0 +1,151 @@
+#ifndef CSLIBS_NDT_COMMON_INLINE_OCCUPANCY_DISTRIBUTION_HPP
+#define CSLIBS_NDT_COMMON_INLINE_OCCUPANCY_DISTRIBUTION_HPP
+
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include <cslibs_math/statistics/distribution.hpp>
+#include <cslibs_math/statistics/stable_distribution.hpp>
+#include <cslibs_gridmaps/utility/inverse_model.hpp>
+
+#include <cslibs_indexed_storage/storage.hpp>
+
+namespace cslibs_ndt {
+/**
+ * @brief Occupancy distribution with the same interface as OccupancyDistribution,
+ *        but the occupied statistics are stored inline instead of behind a shared_ptr.
+ *        Updates, copies and assignments never allocate, getDistribution() returns
+ *        a plain pointer which is null as long as no occupied update happened.
+ *        The valid flag of the distribution is the top bit of the free count, so
+ *        a cell is the distribution plus one word. Cells which only see free updates
+ *        carry the unused distribution as well, OccupancyDistribution is smaller for
+ *        maps dominated by free space.
+ */
+template<typename T, std::size_t Dim>
+class EIGEN_ALIGN16 InlineOccupancyDistribution
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using allocator_t               = Eigen::aligned_allocator<InlineOccupancyDistribution<T,Dim>>;
+
+    using Ptr                       = std::shared_ptr<InlineOccupancyDistribution<T,Dim>>;
+    using distribution_container_t  = InlineOccupancyDistribution<T, Dim>;
+    using distribution_t            = cslibs_math::statistics::StableDistribution<T,Dim,3>;
+    using point_t                   = typename distribution_t::sample_t;
+    using ivm_t                     = cslibs_gridmaps::utility::InverseModel<T>;
+
+    inline InlineOccupancyDistribution() = default;
+
+    inline InlineOccupancyDistribution(const std::size_t num_free)
+    {
+        updateFree(num_free);
+    }
+
+    inline InlineOccupancyDistribution(const std::size_t     num_free,
+                                       const distribution_t &data) :
+        distribution_(data),
+        state_(occupied_bit)
+    {
+        updateFree(num_free);
+    }
+
+    inline void updateFree()
+    {
+        updateFree(1ul);
+    }
+
+    inline void updateFree(const std::size_t &n)
+    {
+        const std::uint64_t free = std::min(max_free, (state_ & max_free) + std::min(max_free, static_cast<std::uint64_t>(n)));
+        state_ = (state_ & occupied_bit) | free;
+    }
+
+    inline void updateOccupied(const point_t &p)
+    {
+        distribution_ += p;
+        state_ |= occupied_bit;
+    }
+
+    inline void updateOccupied(const distribution_t &d)
+    {
+        if (!occupied())
+            distribution_ = d;
+        else
+            distribution_ += d;
+        state_ |= occupied_bit;
+    }
+
+    inline std::size_t numFree() const
+    {
+        return static_cast<std::size_t>(state_ & max_free);
+    }
+
+    inline std::size_t numOccupied() const
+    {
+        return occupied() ? distribution_.getN() : 0ul;
+    }
+
+    inline T getOccupancy(const typename ivm_t::Ptr &inverse_model) const
+    {
+        if (!inverse_model)
+            throw std::runtime_error("inverse model not set!");
+
+        return getOccupancy(*inverse_model);
+    }
+
+    inline T getOccupancy(const ivm_t &inverse_model) const
+    {
+        if (!occupied())
+            return T(0.0);
+
+        const std::size_t num_free     = numFree();
+        const std::size_t num_occupied = distribution_.getN();
+        return cslibs_math::common::LogOdds<T>::from(
+                    num_free * inverse_model.getLogOddsFree() +
+                    num_occupied * inverse_model.getLogOddsOccupied() -
+                    (num_free + num_occupied - 1) * inverse_model.getLogOddsPrior());
+    }
+
+    inline const distribution_t* getDistribution() const
+    {
+        return occupied() ? &distribution_ : nullptr;
+    }
+
+    inline distribution_t* getDistribution()
+    {
+        return occupied() ? &distribution_ : nullptr;
+    }
+
+    inline void merge(const InlineOccupancyDistribution &other)
+    {
+        updateFree(other.numFree());
+        if (other.occupied())
+            updateOccupied(other.distribution_);
+    }
+
+    inline std::size_t byte_size() const
+    {
+        return sizeof(*this);
+    }
+
+private:
+    static constexpr std::uint64_t occupied_bit = std::uint64_t(1) << 63;
+    static constexpr std::uint64_t max_free     = occupied_bit - 1;
+
+    distribution_t distribution_;
+    std::uint64_t  state_ = 0;
+
+    inline bool occupied() const
+    {
+        return (state_ & occupied_bit) != 0;
+    }
+};
+
+template<typename T, std::size_t Dim>
+constexpr std::uint64_t InlineOccupancyDistribution<T,Dim>::occupied_bit;
+template<typename T, std::size_t Dim>
+constexpr std::uint64_t InlineOccupancyDistribution<T,Dim>::max_free;
+}
+
+#endif // CSLIBS_NDT_COMMON_INLINE_OCCUPANCY_DISTRIBUTION_HPP
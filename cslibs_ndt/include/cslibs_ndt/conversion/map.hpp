@@ -4,6 +4,8 @@
 #include <cslibs_ndt/map/map.hpp>
 #include <cslibs_ndt/common/distribution.hpp>
 #include <cslibs_ndt/common/occupancy_distribution.hpp>
+#include <cslibs_ndt/common/inline_occupancy_distribution.hpp>
+#include <cslibs_ndt/common/decaying_occupancy_distribution.hpp>
 
 namespace cslibs_ndt {
 namespace conversion {
@@ -28,6 +30,40 @@ struct convert<OccupancyDistribution,T,Dim> {
             *t = *f;
     }
 };
+
+template <typename T, std::size_t Dim>
+struct convert<InlineOccupancyDistribution,T,Dim> {
+    static inline void from(const InlineOccupancyDistribution<T,Dim>* const& f, InlineOccupancyDistribution<T,Dim>* const& t)
+    {
+        if (f && (f->numFree() > 0 || f->numOccupied() > 0))
+            *t = *f;
+    }
+};
+
+template <typename T, std::size_t Dim>
+struct convert<DecayingOccupancyDistribution,T,Dim> {
+    static inline void from(const DecayingOccupancyDistribution<T,Dim>* const& f, DecayingOccupancyDistribution<T,Dim>* const& t)
+    {
+        if (f && (f->weightFree() > T() || f->numOccupied() > 0))
+            *t = *f;
+    }
+};
+
+/**
+ * @brief Maps of decaying distributions get a copy of the clock of their source,
+ *        which the copied distributions are pointed to.
+ */
+template <typename src_map_t, typename dst_map_t>
+inline auto copy_clock(const src_map_t &src, dst_map_t &dst, int) -> decltype(dst.setClock(src.getClock()), void())
+{
+    using clock_t = typename dst_map_t::clock_t;
+    dst.setClock(std::make_shared<clock_t>(*src.getClock()));
+}
+
+template <typename src_map_t, typename dst_map_t>
+inline void copy_clock(const src_map_t &, dst_map_t &, long)
+{
+}
 }
 
 template <map::tags::option option_to_t,
@@ -66,6 +102,7 @@ struct convert<map::tags::dynamic_map,option_from_t,Dim,data_t,T,backend_to_t,ba
                     impl::convert<data_t,T,Dim>::from(b.at(i), b_dst->at(i));
             }
         });
+        impl::copy_clock(*src, *dst, 0);
 
         return dst;
     }
@@ -108,6 +145,43 @@ struct convert<map::tags::static_map,option_from_t,Dim,data_t,T,backend_to_t,bac
                     impl::convert<data_t,T,Dim>::from(b.at(i), b_dst->at(i));
             }
         });
+        impl::copy_clock(*src, *dst, 0);
+
+        return dst;
+    }
+};
+
+template <map::tags::option option_from_t,
+          std::size_t Dim,
+          typename T,
+          template <typename, typename, typename...> class backend_from_t>
+struct convert<map::tags::static_map,option_from_t,Dim,Distribution,T,backend::SoA,backend_from_t> {
+    using src_map_t = map::Map<option_from_t,Dim,Distribution,T,backend_from_t>;
+    using dst_map_t = map::Map<map::tags::static_map,Dim,Distribution,T,backend::SoA>;
+
+    static inline typename dst_map_t::Ptr from(const typename src_map_t::Ptr& src)
+    {
+        if (!src)
+            return nullptr;
+
+        using index_t = typename src_map_t::index_t;
+        const index_t min_distribution_index =
+                cslibs_math::common::cast<int>(std::floor(cslibs_math::common::cast<T>(src->getMinBundleIndex()) / 2.0) * 2.0);
+        const index_t max_distribution_index =
+                cslibs_math::common::cast<int>( std::ceil(cslibs_math::common::cast<T>(src->getMaxBundleIndex()) / 2.0) * 2.0 + 1.0);
+
+        const typename dst_map_t::size_t size =
+                cslibs_math::common::cast<std::size_t>(std::ceil(cslibs_math::common::cast<T>(max_distribution_index - min_distribution_index) / 2.0));
+
+        typename dst_map_t::Ptr dst(new dst_map_t(src->getInitialOrigin(),
+                                                  src->getResolution(),
+                                                  size,
+                                                  min_distribution_index));
+
+        using bundle_t = typename src_map_t::distribution_bundle_t;
+        src->traverse([&dst](const index_t &bi, const bundle_t &b) {
+            dst->set(bi, b);
+        });
 
         return dst;
     }
@@ -5,10 +5,13 @@
 #include <vector>
 #include <cmath>
 #include <memory>
+#include <algorithm>
+#include <unordered_set>
 
 #include <cslibs_ndt/map/traits.hpp>
 #include <cslibs_ndt/common/bundle.hpp>
 #include <cslibs_ndt/utility/utility.hpp>
+#include <cslibs_ndt/utility/batch_sample.hpp>
 
 #include <cslibs_math/common/array.hpp>
 
@@ -42,6 +45,7 @@ public:
 
     static constexpr std::size_t bin_count  = utility::two_pow(Dim);
     static constexpr T div_count = 1.0 / static_cast<T>(bin_count);
+    static constexpr bool copy_on_write = backend::is_copy_on_write<backend_t>::value;
 
     template <typename type>
     using data_if                           = typename tags::interface_types<option_t>::template data_if<type>;
@@ -51,6 +55,7 @@ public:
     using distribution_storage_t            = cis::Storage<data_if<distribution_t>, index_t, backend_t>;
     using distribution_storage_ptr_t        = std::shared_ptr<distribution_storage_t>;
     using distribution_storage_array_t      = std::array<distribution_storage_ptr_t, bin_count>;
+    using distribution_const_storage_array_t = std::array<std::shared_ptr<const distribution_storage_t>, bin_count>;
     using distribution_bundle_t             = cslibs_ndt::Bundle<distribution_t*, bin_count>;
     using distribution_const_bundle_t       = cslibs_ndt::Bundle<const distribution_t*, bin_count>;
     using distribution_bundle_storage_t     = cis::Storage<data_if<distribution_bundle_t>, index_t, backend_t>;
@@ -72,6 +77,7 @@ public:
         storage_(utility::create<distribution_storage_t,bin_count>()),
         bundle_storage_(new distribution_bundle_storage_t)
     {
+        bind();
     }
 
     inline AbstractMap(const pose_t  &origin,
@@ -90,8 +96,13 @@ public:
         storage_(storage),
         bundle_storage_(bundles)
     {
+        bind();
     }
 
+    /**
+     * @brief Copies other. With a copy-on-write backend this is O(1), both maps share all
+     *        storage blocks until one of them writes to a block. Must not overlap with writes to other.
+     */
     inline AbstractMap(const AbstractMap &other) :
         resolution_(other.resolution_),
         bundle_resolution_(other.bundle_resolution_),
@@ -101,8 +112,14 @@ public:
         min_bundle_index_(other.min_bundle_index_),
         max_bundle_index_(other.max_bundle_index_),
         storage_(utility::create<distribution_storage_t,bin_count>(other.storage_)),
-        bundle_storage_(new distribution_bundle_storage_t(*other.bundle_storage_))
+        bundle_storage_(new distribution_bundle_storage_t(*other.bundle_storage_)),
+        generation_(other.generation_),
+        tracking_(other.tracking_),
+        changes_(other.changes_)
     {
+        bind();
+        if (!copy_on_write)
+            rebind();
     }
 
     inline AbstractMap(AbstractMap &&other) :
@@ -114,8 +131,14 @@ public:
         min_bundle_index_(other.min_bundle_index_),
         max_bundle_index_(other.max_bundle_index_),
         storage_(other.storage_),
-        bundle_storage_(other.bundle_storage_)
+        bundle_storage_(other.bundle_storage_),
+        generation_(other.generation_),
+        tracking_(other.tracking_),
+        changes_(std::move(other.changes_)),
+        settle_tracking_(other.settle_tracking_),
+        unsettled_(std::move(other.unsettled_))
     {
+        bind();
     }
 
     inline virtual ~AbstractMap() = default;
@@ -192,21 +215,34 @@ public:
         return (max_bundle_index_[0] - min_bundle_index_[0] + 1) * bundle_resolution_;
     }
 
+    /**
+     * @brief Bundle at bi, allocated if missing. The const overloads write to the map as well,
+     *        readers running concurrently use get() instead, see ReadView.
+     */
     inline const distribution_bundle_t* getDistributionBundle(const index_t &bi) const;
     inline distribution_bundle_t* getDistributionBundle(const index_t &bi);
     inline const distribution_bundle_t* getDistributionBundle(const point_t &p) const;
+
+    /**
+     * @brief Bundle at p or bi if allocated, never allocates.
+     */
     inline const distribution_bundle_t* get(const point_t &p) const;
     inline const distribution_bundle_t* get(const index_t &bi) const;
 
-    inline distribution_storage_array_t const & getStorages() const
+    /**
+     * @brief Read-only access to the distribution storages.
+     */
+    inline distribution_const_storage_array_t getStorages() const
     {
-        return storage_;
+        distribution_const_storage_array_t storages;
+        std::copy(storage_.begin(), storage_.end(), storages.begin());
+        return storages;
     }
 
     template <typename Fn>
     inline void traverse(const Fn& function) const
     {
-        return bundle_storage_->traverse(function);
+        return bundles().traverse(function);
     }
 
     inline void getBundleIndices(std::vector<index_t> &indices) const
@@ -214,7 +250,7 @@ public:
         auto add_index = [&indices](const index_t &i, const distribution_bundle_t &b) {
             indices.emplace_back(i);
         };
-        bundle_storage_->traverse(add_index);
+        bundles().traverse(add_index);
     }
 
     inline void getBundles(std::vector<std::pair<const index_t,const distribution_bundle_t*>> &bundles) const
@@ -222,7 +258,7 @@ public:
         auto add_bundle = [&bundles](const index_t &i, const distribution_bundle_t &b) {
             bundles.emplace_back(std::pair<const index_t,const distribution_bundle_t*>(i,&b));
         };
-        bundle_storage_->traverse(add_bundle);
+        this->bundles().traverse(add_bundle);
     }
 
     inline virtual bool validate(const pose_2d_t &p_w_2d) const
@@ -244,10 +280,15 @@ public:
                 if (valid(ii))
                     getAllocate(ii);
             });
-            bundle->setExpanded();
+            // the flag is written, a shared bundle is copied first
+            (copy_on_write ? bundle_storage_->get(bi) : bundle)->setExpanded();
         }
     }
 
+    /**
+     * @brief Allocates the neighbors of all bundles holding a valid distribution, which
+     *        writes to the map despite being const.
+     */
     inline void allocatePartiallyAllocatedBundles() const
     {
         std::vector<std::pair<const index_t,const distribution_bundle_t*>> bis;
@@ -259,6 +300,87 @@ public:
         return;
     }
 
+    /**
+     * @brief Enables recording of the bundles changed by updates, which is off by default.
+     *        Disabling it drops the changes recorded so far.
+     */
+    inline void setChangeTracking(const bool enabled)
+    {
+        tracking_ = enabled;
+        if (!enabled)
+            changes_.clear();
+    }
+
+    inline bool getChangeTracking() const
+    {
+        return tracking_;
+    }
+
+    /**
+     * @brief Generation of the map, increased by every bundle update, also without change tracking.
+     *        Consumers compare it to the generation they saw last to find out if the map changed.
+     */
+    inline std::size_t getGeneration() const
+    {
+        return generation_;
+    }
+
+    inline bool hasChanges() const
+    {
+        return !changes_.empty();
+    }
+
+    /**
+     * @brief Hands out the bundles updated since the last call and clears the record, unsorted and
+     *        without their neighbors, i.e. the bundles whose distributions have to be settled again,
+     *        see map::snapshot. The record starts with the first call, which returns false, then the
+     *        caller settles the whole map instead. Copies start without a record. Must not overlap
+     *        with updates.
+     * @param indices updated bundles, replaced
+     * @return whether indices covers all updates since the last call
+     */
+    inline bool consumeUnsettled(std::vector<index_t> &indices) const
+    {
+        indices.assign(unsettled_.begin(), unsettled_.end());
+        unsettled_.clear();
+
+        const bool recorded = settle_tracking_;
+        settle_tracking_ = true;
+        return recorded;
+    }
+
+    /**
+     * @brief Hands out the bundles changed since the last call, sorted, and clears the record.
+     *        Distributions are shared by neighboring bundles, so next to the updated bundles all
+     *        allocated bundles sharing a distribution with them are reported, i.e. every bundle
+     *        whose samples may have changed. Dropped bundles, e.g. evicted by a rolling window,
+     *        are reported as well, get(bi) returns null for them. Must not overlap with updates.
+     * @param indices changed bundles, replaced
+     * @return the generation of the map the changes are complete up to
+     */
+    inline std::size_t consumeChanges(std::vector<index_t> &indices)
+    {
+        static constexpr neighborhood_t grid{};
+
+        indices.clear();
+        for (const index_t &bi : changes_) {
+            indices.emplace_back(bi);
+            grid.visit([this, &bi, &indices](typename neighborhood_t::offset_t o) {
+                index_t ii;
+                utility::for_each<Dim>([&ii,&bi,&o](const std::size_t &i) {
+                    ii[i] = bi[i] + o[i];
+                });
+                if (valid(ii) && bundles().get(ii))
+                    indices.emplace_back(ii);
+            });
+        }
+        changes_.clear();
+
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+        return generation_;
+    }
+
     inline std::size_t getByteSize() const
     {
         std::size_t size = bundle_storage_->byte_size();
@@ -279,6 +401,24 @@ protected:
     mutable distribution_storage_array_t       storage_;
     mutable distribution_bundle_storage_ptr_t  bundle_storage_;
 
+    mutable std::size_t                        generation_ = 0;
+    bool                                       tracking_   = false;
+    mutable std::unordered_set<index_t>        changes_;
+    mutable bool                               settle_tracking_ = false;
+    mutable std::unordered_set<index_t>        unsettled_;
+
+    /**
+     * @brief To be called for every bundle whose distributions are written to.
+     */
+    inline void markChanged(const index_t &bi) const
+    {
+        ++generation_;
+        if (tracking_)
+            changes_.insert(bi);
+        if (settle_tracking_)
+            unsettled_.insert(bi);
+    }
+
     template <typename content_t, typename storage_t>
     inline content_t* getAllocate(const storage_t &s,
                                   const index_t &i) const
@@ -291,8 +431,14 @@ protected:
     {
 
         distribution_bundle_t *bundle = bundle_storage_->get(bi);
-        if (bundle)
+        if (bundle) {
+            // the distributions are written to, shared ones are copied and the bundles repointed
+            if (copy_on_write)
+                utility::apply_indices<bin_count,Dim>(bi, [this,&bundle](const std::size_t& i, const index_t& index) {
+                    bundle->at(i) = getAllocate<distribution_t>(storage_[i], index);
+                });
             return bundle;
+        }
 
         bundle = &(bundle_storage_->insert(bi, distribution_bundle_t()));
         utility::apply_indices<bin_count,Dim>(bi, [this,&bundle](const std::size_t& i, const index_t& index) {
@@ -305,6 +451,64 @@ protected:
         return bundle;
     }
 
+    /**
+     * @brief Read access to the bundle storage, which never allocates and never
+     *        copies a block shared with another map.
+     */
+    inline const distribution_bundle_storage_t& bundles() const
+    {
+        return *bundle_storage_;
+    }
+
+    /**
+     * @brief Distribution j of storage i was copied to d, because its block was shared with
+     *        another map. Points the bundles referencing it to the copy, which are the
+     *        bundles bi with generate_index(bi, i) == j.
+     */
+    inline void repoint(const std::size_t i, const index_t &j, distribution_t &d) const
+    {
+        for (std::size_t n = 0 ; n < bin_count ; ++n) {
+            index_t bi;
+            for (std::size_t k = 0 ; k < Dim ; ++k)
+                bi[k] = 2 * j[k] - static_cast<int>((i >> k) & 1ul) + static_cast<int>((n >> k) & 1ul);
+            if (!bundles().get(bi))
+                continue;
+            distribution_bundle_t *bundle = bundle_storage_->get(bi);
+            if (bundle->at(i))
+                bundle->at(i) = &d;
+        }
+    }
+
+    inline void bind()
+    {
+        bind(std::integral_constant<bool, copy_on_write>());
+    }
+
+    inline void bind(std::true_type)
+    {
+        for (std::size_t i = 0 ; i < bin_count ; ++i)
+            storage_[i]->template set<backend::tags::on_copy>([this, i](const index_t &j, distribution_t &d) {
+                repoint(i, j, d);
+            });
+    }
+
+    inline void bind(std::false_type)
+    {
+    }
+
+    /**
+     * @brief Points the copied bundles to the copied distributions instead of the ones of the source.
+     */
+    inline void rebind()
+    {
+        bundle_storage_->traverse([this](const index_t &bi, distribution_bundle_t &bundle) {
+            utility::apply_indices<bin_count,Dim>(bi, [this,&bundle](const std::size_t& i, const index_t& index) {
+                if (bundle.at(i))
+                    bundle.at(i) = storage_[i]->get(index);
+            });
+        });
+    }
+
     virtual void updateIndices(const index_t &chunk_index) const = 0;
     virtual bool valid(const index_t &index) const = 0;
 
@@ -320,6 +524,32 @@ protected:
         return false;
     }
 
+    /**
+     * @brief Shared part of the batch sampling entry points of the map specializations.
+     *        Points are binned by bundle, so every distribution is looked up once per
+     *        bundle and evaluated for all of its points in one go.
+     *        term(bundle, i, mean, information) returns the weight of the i-th
+     *        distribution of a bundle and fills in its parameters, zero skips it.
+     *        With several poses the point set is transformed by each of them and
+     *        all transformed points are binned together, outputs are ordered pose major.
+     */
+    template <typename point_in_t, typename term_fn_t>
+    inline void sampleBatch(const point_in_t  *points,
+                            const std::size_t  size,
+                            const pose_t      *poses,
+                            const std::size_t  num_poses,
+                            T                 *scores,
+                            T                 *gradients,
+                            const term_fn_t   &term) const
+    {
+        utility::sample_batch<Dim,point_t,index_t>(points, size, poses, num_poses, w_T_m_, scores, gradients,
+                                                   [this](const point_t &p_w, point_t &p_m, index_t &bi) {
+            return toBundleIndex(p_w, p_m, bi);
+        }, [this](const index_t &bi) {
+            return bundles().get(bi);
+        }, term);
+    }
+
     inline index_t toBundleIndex(const point_t &p_w,
                                  point_t &p_m) const
     {
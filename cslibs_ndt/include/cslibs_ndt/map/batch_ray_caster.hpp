@@ -0,0 +1,175 @@
+#ifndef CSLIBS_NDT_MAP_BATCH_RAY_CASTER_HPP
+#define CSLIBS_NDT_MAP_BATCH_RAY_CASTER_HPP
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+
+#include <cslibs_ndt/map/traits.hpp>
+#include <cslibs_ndt/utility/parallel.hpp>
+
+#include <cslibs_math/common/array.hpp>
+
+namespace cslibs_ndt {
+namespace map {
+/**
+ * @brief Free space traversal for all rays of one scan at once.
+ *        Every ray is walked by its own line iterator, the rays are split among the
+ *        threads. Paths of neighbouring rays do not coincide exactly, so the walks
+ *        are not shared. What is shared is the counting: the cells around the sensor
+ *        origin, which nearly all rays pass, are counted in a dense window per thread
+ *        instead of a hash map, only cells outside of it are hashed. The result is a
+ *        sorted, deduplicated list of free counts which can be applied in a single pass.
+ */
+template <std::size_t Dim,
+          typename T,
+          typename line_iterator_t = typename traits<Dim,T>::default_iterator_t>
+class BatchRayCaster
+{
+public:
+    using index_t        = std::array<int,Dim>;
+    using point_t        = typename traits<Dim,T>::point_t;
+    using free_update_t  = std::pair<index_t, std::size_t>;
+    using free_updates_t = std::vector<free_update_t>;
+
+    /**
+     * @param bundle_resolution resolution of the traversed bundle grid
+     * @param num_threads       worker threads, 0 uses the hardware concurrency
+     * @param window_size       cells per dimension of the densely counted window around the origin
+     */
+    inline explicit BatchRayCaster(const T &bundle_resolution,
+                                   const std::size_t num_threads = 0ul,
+                                   const std::size_t window_size = Dim > 2 ? 32ul : 256ul) :
+        bundle_resolution_(bundle_resolution),
+        num_threads_(num_threads),
+        window_size_(std::max<std::size_t>(1ul, window_size))
+    {
+    }
+
+    /**
+     * @brief Add a ray ending at end (map coordinates), each visited cell is counted n times.
+     */
+    inline void add(const point_t &end,
+                    const std::size_t n = 1ul)
+    {
+        rays_.emplace_back(Ray{end, n});
+    }
+
+    inline void clear()
+    {
+        rays_.clear();
+    }
+
+    inline std::size_t size() const
+    {
+        return rays_.size();
+    }
+
+    /**
+     * @brief Traverse all rays from start, only cells for which valid(index) holds are counted.
+     * @param start     sensor origin in map coordinates
+     * @param valid     index filter, has to be thread-safe
+     * @param updates   sorted list of (bundle index, free count), every index is unique
+     */
+    template <typename valid_t>
+    inline void cast(const point_t        &start,
+                     const valid_t        &valid,
+                     free_updates_t       &updates) const
+    {
+        updates.clear();
+        if (rays_.empty())
+            return;
+
+        /// step one: window of densely counted cells centered at the origin
+        const int window_size = static_cast<int>(window_size_);
+        index_t window_min;
+        std::size_t window_cells = 1ul;
+        for (std::size_t k = 0 ; k < Dim ; ++k) {
+            window_min[k] = static_cast<int>(std::floor(start(k) / bundle_resolution_)) - window_size / 2;
+            window_cells *= window_size_;
+        }
+
+        /// step two: traverse the rays in parallel, each thread counts into its own window and hash map
+        const std::size_t num_threads = num_threads_ > 0ul ?
+                    std::min(num_threads_, rays_.size()) : utility::num_threads(rays_.size());
+        std::vector<free_updates_t> partial_updates(num_threads);
+        utility::parallel_for(rays_.size(), num_threads,
+                              [this, &start, &valid, &window_min, window_size, window_cells, &partial_updates]
+                              (const std::size_t thread_id, const std::size_t begin, const std::size_t end) {
+            std::vector<std::size_t> dense(window_cells, 0ul);
+            std::unordered_map<index_t, std::size_t> sparse;
+
+            for (std::size_t i = begin ; i < end ; ++i) {
+                const Ray &ray = rays_[i];
+                line_iterator_t it(start, ray.end, bundle_resolution_);
+                while (!it.done()) {
+                    const index_t &bi = it();
+                    std::size_t offset = 0ul;
+                    bool inside = true;
+                    for (std::size_t k = Dim ; inside && k-- > 0 ; ) {
+                        const int o = bi[k] - window_min[k];
+                        inside = o >= 0 && o < window_size;
+                        offset = offset * window_size_ + static_cast<std::size_t>(o);
+                    }
+                    if (inside)
+                        dense[offset] += ray.n;
+                    else
+                        sparse[bi] += ray.n;
+                    ++it;
+                }
+            }
+
+            // the filter is applied once per distinct cell
+            free_updates_t &partial = partial_updates[thread_id];
+            for (std::size_t offset = 0 ; offset < window_cells ; ++offset) {
+                if (dense[offset] == 0ul)
+                    continue;
+                index_t bi;
+                std::size_t o = offset;
+                for (std::size_t k = 0 ; k < Dim ; ++k, o /= window_size_)
+                    bi[k] = window_min[k] + static_cast<int>(o % window_size_);
+                if (valid(bi))
+                    partial.emplace_back(bi, dense[offset]);
+            }
+            for (const auto &pair : sparse) {
+                if (valid(pair.first))
+                    partial.emplace_back(pair);
+            }
+        });
+
+        /// step three: merge and deduplicate
+        for (const free_updates_t &p : partial_updates)
+            updates.insert(updates.end(), p.begin(), p.end());
+        if (updates.empty())
+            return;
+        std::sort(updates.begin(), updates.end(), [](const free_update_t &a, const free_update_t &b) {
+            return a.first < b.first;
+        });
+
+        std::size_t last = 0ul;
+        for (std::size_t i = 1 ; i < updates.size() ; ++i) {
+            if (updates[i].first == updates[last].first)
+                updates[last].second += updates[i].second;
+            else
+                updates[++last] = updates[i];
+        }
+        updates.resize(last + 1ul);
+    }
+
+private:
+    struct Ray {
+        point_t     end;
+        std::size_t n;
+    };
+
+    const T                                          bundle_resolution_;
+    const std::size_t                                num_threads_;
+    const std::size_t                                window_size_;
+    std::vector<Ray, Eigen::aligned_allocator<Ray>>  rays_;
+};
+}
+}
+
+#endif // CSLIBS_NDT_MAP_BATCH_RAY_CASTER_HPP
@@ -3,6 +3,8 @@
 
 #include <cslibs_ndt/map/abstract_map.hpp>
 
+#include <functional>
+
 namespace cis = cslibs_indexed_storage;
 
 namespace cslibs_ndt {
@@ -132,12 +134,12 @@ public:
         if (!this->toBundleIndex(p, bi))
             return nullptr;
 
-        return this->bundle_storage_->get(bi);
+        return this->bundles().get(bi);
     }
 
     inline const distribution_bundle_t* get(const index_t &bi) const
     {
-        return valid(bi) ? this->bundle_storage_->get(bi) : nullptr;
+        return valid(bi) ? this->bundles().get(bi) : nullptr;
     }
 
     inline size_m_t getSizeM() const
@@ -208,6 +210,9 @@ public:
 
     using size_t   = std::array<std::size_t,Dim>;
     using size_m_t = std::array<T,Dim>;
+    using spill_t  = std::function<void(const std::size_t, const index_t&, const distribution_t&)>;
+
+    static constexpr bool rolling_window = backend::is_rolling_window<backend_t>::value;
 
     inline GenericMap(const T resolution) :
         GenericMap(pose_t::identity(), resolution)
@@ -232,8 +237,55 @@ public:
     {
     }
 
-    inline GenericMap(const GenericMap &other) : base_t(other) { }
-    inline GenericMap(GenericMap &&other) : base_t(other) { }
+    /**
+     * @brief Rolling window map, requires the backend::RollingWindow backend, e.g.
+     *        Map<tags::dynamic_map,3,Distribution,double,backend::RollingWindow>.
+     *        Only the window of window_size meters centred on origin, later on the point
+     *        passed to moveWindow, is kept, all points outside of it are ignored.
+     *        Memory is bounded by the window size, not by the distance travelled.
+     * @param origin      initial origin of the map, the window is centred on its translation
+     * @param resolution  resolution of the map
+     * @param window_size side lengths of the window in meters
+     */
+    inline GenericMap(const pose_t   &origin,
+                      const T        &resolution,
+                      const size_m_t &window_size) :
+        GenericMap(origin, resolution)
+    {
+        static_assert(rolling_window, "GenericMap: a window size requires the RollingWindow backend");
+
+        for (std::size_t i = 0 ; i < Dim ; ++i)
+            window_size_[i] = 2 * static_cast<int>(std::ceil(window_size[i] / resolution));
+
+        size_t capacity_bundles, capacity_distributions;
+        for (std::size_t i = 0 ; i < Dim ; ++i) {
+            capacity_bundles[i]       = static_cast<std::size_t>(window_size_[i]);
+            capacity_distributions[i] = static_cast<std::size_t>(window_size_[i] / 2 + 1);
+        }
+        this->bundle_storage_->template set<backend::tags::window_capacity>(capacity_bundles);
+        for (auto &storage : this->storage_)
+            storage->template set<backend::tags::window_capacity>(capacity_distributions);
+
+        bindWindow(std::integral_constant<bool, rolling_window>());
+        moveWindow(origin.translation());
+    }
+
+    /**
+     * @brief Copies other including its window. The spill callback is not taken over.
+     */
+    inline GenericMap(const GenericMap &other) :
+        base_t(other),
+        window_size_(other.window_size_),
+        window_min_(other.window_min_),
+        window_max_(other.window_max_)
+    {
+        bindWindow(std::integral_constant<bool, rolling_window>());
+    }
+
+    inline GenericMap(GenericMap &&other) :
+        GenericMap(static_cast<const GenericMap&>(other))
+    {
+    }
 
     inline bool empty() const
     {
@@ -242,29 +294,29 @@ public:
 
     inline const distribution_bundle_t* getDistributionBundle(const index_t &bi) const
     {
-        return this->getAllocate(bi);
+        return valid(bi) ? this->getAllocate(bi) : nullptr;
     }
 
     inline distribution_bundle_t* getDistributionBundle(const index_t &bi)
     {
-        return this->getAllocate(bi);
+        return valid(bi) ? this->getAllocate(bi) : nullptr;
     }
 
     inline const distribution_bundle_t* getDistributionBundle(const point_t &p) const
     {
         const index_t bi = this->toBundleIndex(p);
-        return this->getAllocate(bi);
+        return valid(bi) ? this->getAllocate(bi) : nullptr;
     }
 
     inline const distribution_bundle_t* get(const point_t &p) const
     {
         const index_t bi = this->toBundleIndex(p);
-        return this->bundle_storage_->get(bi);
+        return this->bundles().get(bi);
     }
 
     inline const distribution_bundle_t* get(const index_t &bi) const
     {
-        return this->bundle_storage_->get(bi);
+        return this->bundles().get(bi);
     }    
 
     inline size_m_t getSizeM() const
@@ -283,7 +335,78 @@ public:
         return result;
     }
 
+    /**
+     * @brief Centres the window of a rolling window map on center, given in world coordinates.
+     *        Bundles and distributions which leave the window are dropped, distributions are
+     *        handed to the spill callback first. The cost is linear in the number of cells
+     *        leaving the window, i.e. amortized O(1) per evicted cell.
+     */
+    inline void moveWindow(const point_t &center)
+    {
+        static_assert(rolling_window, "GenericMap: moveWindow requires the RollingWindow backend");
+
+        const index_t c = this->toBundleIndex(center);
+        index_t min, max;
+        for (std::size_t k = 0 ; k < Dim ; ++k) {
+            min[k] = c[k] - window_size_[k] / 2;
+            max[k] = min[k] + window_size_[k] - 1;
+        }
+
+        /// step one: drop the bundles first, they point into the distribution storages
+        this->bundle_storage_->template set<backend::tags::window>(min, max);
+
+        /// step two: storage i holds the distributions generate_index maps the window to
+        for (std::size_t i = 0 ; i < this->bin_count ; ++i) {
+            index_t min_i, max_i;
+            for (std::size_t k = 0 ; k < Dim ; ++k) {
+                const int bit = static_cast<int>((i >> k) & 1ul);
+                min_i[k] = (min[k] + bit) >> 1;
+                max_i[k] = (max[k] + bit) >> 1;
+            }
+            this->storage_[i]->template set<backend::tags::window>(min_i, max_i);
+        }
+        window_min_ = min;
+        window_max_ = max;
+
+        /// step three: the extent of the map shrinks to what is left inside the window
+        if (empty())
+            return;
+        for (std::size_t k = 0 ; k < Dim ; ++k) {
+            this->min_bundle_index_[k] = std::max(this->min_bundle_index_[k], min[k]);
+            this->max_bundle_index_[k] = std::min(this->max_bundle_index_[k], max[k]);
+            if (this->min_bundle_index_[k] > this->max_bundle_index_[k]) {
+                this->min_bundle_index_ = utility::create<int,Dim>(std::numeric_limits<int>::max());
+                this->max_bundle_index_ = utility::create<int,Dim>(std::numeric_limits<int>::min());
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Registers spill(storage, index, distribution), which is called for every distribution
+     *        leaving the window of a rolling window map, e.g. to write it to disk.
+     */
+    inline void setSpill(const spill_t &spill)
+    {
+        spill_ = spill;
+    }
+
+    inline const index_t& getWindowMinIndex() const
+    {
+        return window_min_;
+    }
+
+    inline const index_t& getWindowMaxIndex() const
+    {
+        return window_max_;
+    }
+
 protected:
+    index_t window_size_ = utility::create<int,Dim>(0);
+    index_t window_min_  = utility::create<int,Dim>(std::numeric_limits<int>::min());
+    index_t window_max_  = utility::create<int,Dim>(std::numeric_limits<int>::max());
+    spill_t spill_;
+
     virtual inline void updateIndices(const index_t &chunk_index) const override
     {
         this->min_bundle_index_ = std::min(this->min_bundle_index_, chunk_index);
@@ -292,9 +415,30 @@ protected:
 
     virtual inline bool valid(const index_t &index) const override
     {
+        if (!rolling_window)
+            return true;
+        for (std::size_t i = 0 ; i < Dim ; ++i)
+            if (index[i] < window_min_[i] || index[i] > window_max_[i])
+                return false;
         return true;
     }
 
+    inline void bindWindow(std::true_type)
+    {
+        this->bundle_storage_->template set<backend::tags::on_evict>([this](const index_t &bi, distribution_bundle_t &) {
+            this->markChanged(bi);
+        });
+        for (std::size_t i = 0 ; i < this->bin_count ; ++i)
+            this->storage_[i]->template set<backend::tags::on_evict>([this, i](const index_t &j, distribution_t &d) {
+                if (spill_)
+                    spill_(i, j, d);
+            });
+    }
+
+    inline void bindWindow(std::false_type)
+    {
+    }
+
 };
 }
 }
@@ -0,0 +1,884 @@
+#ifndef CSLIBS_NDT_MAP_FROZEN_GRIDMAP_HPP
+#define CSLIBS_NDT_MAP_FROZEN_GRIDMAP_HPP
+
+#include <cslibs_ndt/map/traits.hpp>
+#include <cslibs_ndt/backend/frozen.hpp>
+#include <cslibs_ndt/common/distribution.hpp>
+#include <cslibs_ndt/common/occupancy_distribution.hpp>
+#include <cslibs_ndt/common/inline_occupancy_distribution.hpp>
+#include <cslibs_ndt/common/decaying_occupancy_distribution.hpp>
+#include <cslibs_ndt/utility/utility.hpp>
+#include <cslibs_ndt/utility/parallel.hpp>
+#include <cslibs_ndt/utility/bilinear_interpolation.hpp>
+#include <cslibs_ndt/utility/batch_sample.hpp>
+
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace cslibs_ndt {
+namespace map {
+namespace impl {
+/**
+ * @brief Read-only map compiled once from a bundle storage map.
+ *        Only what sampling needs is kept: mean, information matrix and a weight per
+ *        distribution, which is one for Distribution maps and the occupancy under the
+ *        inverse model given at construction for occupancy maps.
+ *        Distributions shared by neighbouring bundles are stored once. Bundles are found
+ *        through a block-sparse lattice over the bounding box of the source, a dense array
+ *        of blocks of 64 bundles each of which is only allocated if it holds any bundle.
+ */
+template <tags::option option_t,
+          std::size_t Dim,
+          template <typename, std::size_t> class data_t,
+          typename T>
+class EIGEN_ALIGN16 FrozenGridmap
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using allocator_t = Eigen::aligned_allocator<Map<option_t,Dim,data_t,T,backend::Frozen>>;
+
+    using ConstPtr = std::shared_ptr<const Map<option_t,Dim,data_t,T,backend::Frozen>>;
+    using Ptr      = std::shared_ptr<Map<option_t,Dim,data_t,T,backend::Frozen>>;
+
+    using pose_2d_t     = typename traits<Dim,T>::pose_2d_t;
+    using pose_t        = typename traits<Dim,T>::pose_t;
+    using transform_t   = typename traits<Dim,T>::transform_t;
+    using point_t       = typename traits<Dim,T>::point_t;
+    using pointcloud_t  = typename traits<Dim,T>::pointcloud_t;
+    using index_t       = std::array<int,Dim>;
+
+    static constexpr std::size_t bin_count  = utility::two_pow(Dim);
+    static constexpr T div_count = 1.0 / static_cast<T>(bin_count);
+
+    using mean_t         = Eigen::Matrix<T,Dim,1>;
+    using information_t  = Eigen::Matrix<T,Dim,Dim>;
+
+    /**
+     * @brief Read-only view on one distribution, behaves like the distribution pointers
+     *        of a bundle, for occupancy maps also like the occupied part of the distribution.
+     */
+    class DistributionView
+    {
+    public:
+        inline DistributionView(const FrozenGridmap *map,
+                                const std::uint32_t  id) :
+            map_(map),
+            id_(id)
+        {
+        }
+
+        inline explicit operator bool() const
+        {
+            return id_ != npos;
+        }
+
+        inline const DistributionView* operator -> () const
+        {
+            return this;
+        }
+
+        inline bool valid() const
+        {
+            return map_->flags_[id_] & valid_flag;
+        }
+
+        inline Eigen::Map<const mean_t> getMean() const
+        {
+            return Eigen::Map<const mean_t>(map_->means_.data() + id_ * Dim);
+        }
+
+        inline Eigen::Map<const information_t> getInformationMatrix() const
+        {
+            return Eigen::Map<const information_t>(map_->informations_.data() + id_ * Dim * Dim);
+        }
+
+        inline T sampleNonNormalized(const point_t &p) const
+        {
+            return map_->sampleDistribution(id_, p);
+        }
+
+        /**
+         * @brief Occupancy precomputed at construction, the given model is not evaluated
+         *        and has to be the one the map was compiled with.
+         */
+        template <typename ivm_t>
+        inline T getOccupancy(const ivm_t &ivm) const
+        {
+            map_->checkModel(ivm);
+            return map_->weights_[id_];
+        }
+
+        /**
+         * @brief Occupied part of an occupancy distribution, null if there never was an occupied update.
+         */
+        inline const DistributionView* getDistribution() const
+        {
+            return (map_->flags_[id_] & distribution_flag) ? this : nullptr;
+        }
+
+    private:
+        const FrozenGridmap *map_;
+        std::uint32_t        id_;
+    };
+
+    class BundleView
+    {
+    public:
+        inline static std::size_t size()
+        {
+            return bin_count;
+        }
+
+        inline DistributionView operator [] (const std::size_t i) const
+        {
+            return at(i);
+        }
+
+        inline DistributionView at(const std::size_t i) const
+        {
+            return DistributionView(map_, ids_[i]);
+        }
+
+        inline std::uint32_t id(const std::size_t i) const
+        {
+            return ids_[i];
+        }
+
+    private:
+        friend class FrozenGridmap;
+
+        const FrozenGridmap                    *map_ = nullptr;
+        std::array<std::uint32_t, bin_count>    ids_;
+    };
+
+    using distribution_bundle_t       = BundleView;
+    using distribution_const_bundle_t = BundleView;
+
+    inline FrozenGridmap(const FrozenGridmap &other) :
+        resolution_(other.resolution_),
+        bundle_resolution_(other.bundle_resolution_),
+        bundle_resolution_inv_(other.bundle_resolution_inv_),
+        w_T_m_(other.w_T_m_),
+        m_T_w_(other.m_T_w_),
+        min_bundle_index_(other.min_bundle_index_),
+        max_bundle_index_(other.max_bundle_index_),
+        block_strides_(other.block_strides_),
+        means_(other.means_),
+        informations_(other.informations_),
+        weights_(other.weights_),
+        flags_(other.flags_),
+        bundles_(other.bundles_),
+        bundle_indices_(other.bundle_indices_),
+        blocks_(other.blocks_),
+        block_slots_(other.block_slots_),
+        model_(other.model_)
+    {
+        rebind();
+    }
+
+    inline FrozenGridmap(FrozenGridmap &&other) :
+        resolution_(other.resolution_),
+        bundle_resolution_(other.bundle_resolution_),
+        bundle_resolution_inv_(other.bundle_resolution_inv_),
+        w_T_m_(std::move(other.w_T_m_)),
+        m_T_w_(std::move(other.m_T_w_)),
+        min_bundle_index_(other.min_bundle_index_),
+        max_bundle_index_(other.max_bundle_index_),
+        block_strides_(other.block_strides_),
+        means_(std::move(other.means_)),
+        informations_(std::move(other.informations_)),
+        weights_(std::move(other.weights_)),
+        flags_(std::move(other.flags_)),
+        bundles_(std::move(other.bundles_)),
+        bundle_indices_(std::move(other.bundle_indices_)),
+        blocks_(std::move(other.blocks_)),
+        block_slots_(std::move(other.block_slots_)),
+        model_(other.model_)
+    {
+        rebind();
+    }
+
+    inline virtual ~FrozenGridmap() = default;
+
+    /**
+     * @brief Get minimum in map coordinates.
+     * @return the minimum
+     */
+    inline point_t getMin() const
+    {
+        return utility::to_point<point_t>([this](const std::size_t& i) {
+            return min_bundle_index_[i] * bundle_resolution_;
+        });
+    }
+
+    /**
+     * @brief Get maximum in map coordinates.
+     * @return the maximum
+     */
+    inline point_t getMax() const
+    {
+        return utility::to_point<point_t>([this](const std::size_t& i) {
+            return (max_bundle_index_[i]+1) * bundle_resolution_;
+        });
+    }
+
+    /**
+     * @brief Get the origin.
+     * @return the origin
+     */
+    inline pose_t getOrigin() const
+    {
+        pose_t origin = w_T_m_;
+        origin.translation() += getMin();
+        return origin;
+    }
+
+    /**
+     * @brief Get the initial origin of the map.
+     * @return the inital origin
+     */
+    inline pose_t getInitialOrigin() const
+    {
+        return w_T_m_;
+    }
+
+    inline index_t getMinBundleIndex() const
+    {
+        return min_bundle_index_;
+    }
+
+    inline index_t getMaxBundleIndex() const
+    {
+        return max_bundle_index_;
+    }
+
+    inline T getBundleResolution() const
+    {
+        return bundle_resolution_;
+    }
+
+    inline T getResolution() const
+    {
+        return resolution_;
+    }
+
+    inline bool empty() const
+    {
+        return bundles_.empty();
+    }
+
+    inline const distribution_bundle_t* get(const point_t &p) const
+    {
+        index_t bi;
+        if (!toBundleIndex(p, bi))
+            return nullptr;
+
+        return getAllocated(bi);
+    }
+
+    inline const distribution_bundle_t* get(const index_t &bi) const
+    {
+        return valid(bi) ? getAllocated(bi) : nullptr;
+    }
+
+    inline const distribution_bundle_t* getDistributionBundle(const index_t &bi) const
+    {
+        return get(bi);
+    }
+
+    template <typename Fn>
+    inline void traverse(const Fn& function) const
+    {
+        for (std::size_t b=0; b<bundles_.size(); ++b)
+            function(bundle_indices_[b], bundles_[b]);
+    }
+
+    inline void getBundleIndices(std::vector<index_t> &indices) const
+    {
+        indices.insert(indices.end(), bundle_indices_.begin(), bundle_indices_.end());
+    }
+
+    inline void getBundles(std::vector<std::pair<const index_t,const distribution_bundle_t*>> &bundles) const
+    {
+        for (std::size_t b=0; b<bundles_.size(); ++b)
+            bundles.emplace_back(std::pair<const index_t,const distribution_bundle_t*>(bundle_indices_[b], &bundles_[b]));
+    }
+
+    inline virtual bool validate(const pose_2d_t &p_w_2d) const
+    {
+        const point_t p_w = utility::to_point<point_t>(p_w_2d.translation());
+        return valid(toBundleIndex(p_w));
+    }
+
+    inline std::size_t getByteSize() const
+    {
+        return sizeof(*this) +
+                means_.capacity()          * sizeof(T) +
+                informations_.capacity()   * sizeof(T) +
+                weights_.capacity()        * sizeof(T) +
+                flags_.capacity()          * sizeof(std::uint8_t) +
+                bundles_.capacity()        * sizeof(BundleView) +
+                bundle_indices_.capacity() * sizeof(index_t) +
+                blocks_.capacity()         * sizeof(std::uint32_t) +
+                block_slots_.capacity()    * sizeof(std::uint32_t);
+    }
+
+protected:
+    static constexpr std::uint32_t npos              = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint8_t  valid_flag        = 1u;
+    static constexpr std::uint8_t  distribution_flag = 2u;
+    static constexpr int           block_bits        = Dim > 2 ? 2 : 3;
+    static constexpr int           block_mask        = (1 << block_bits) - 1;
+    static constexpr std::size_t   block_cells       = std::size_t(1) << (block_bits * Dim);
+
+    const T                                                    resolution_;
+    const T                                                    bundle_resolution_;
+    const T                                                    bundle_resolution_inv_;
+    const transform_t                                          w_T_m_;
+    const transform_t                                          m_T_w_;
+    index_t                                                    min_bundle_index_;
+    index_t                                                    max_bundle_index_;
+    std::array<std::size_t,Dim>                                block_strides_;
+
+    std::vector<T>                                             means_;
+    std::vector<T>                                             informations_;
+    std::vector<T>                                             weights_;
+    std::vector<std::uint8_t>                                  flags_;
+    std::vector<BundleView>                                    bundles_;
+    std::vector<index_t>                                       bundle_indices_;
+    std::vector<std::uint32_t>                                 blocks_;         /// first slot of the block, npos if empty
+    std::vector<std::uint32_t>                                 block_slots_;    /// bundle id, npos if not allocated
+    const void                                                *model_ = nullptr; /// inverse model of the weights, null for Distribution maps
+
+    /**
+     * @brief Compile the map, the weight function is called per source distribution.
+     * @param src           map to compile, has to provide traverse and getInitialOrigin
+     * @param weight        weight of a source distribution, e.g. its occupancy
+     * @param num_threads   worker threads for the distribution math, 0 for all
+     */
+    template <typename src_map_t, typename weight_fn_t>
+    inline FrozenGridmap(const src_map_t   &src,
+                         const weight_fn_t &weight,
+                         const std::size_t  num_threads) :
+        resolution_(src.getResolution()),
+        bundle_resolution_(0.5 * resolution_),
+        bundle_resolution_inv_(1.0 / bundle_resolution_),
+        w_T_m_(src.getInitialOrigin()),
+        m_T_w_(w_T_m_.inverse())
+    {
+        using src_distribution_t = typename src_map_t::distribution_t;
+        using src_bundle_t       = typename src_map_t::distribution_bundle_t;
+
+        /// step one: collect the bundles and number the distributions, shared ones only once
+        std::vector<const src_distribution_t*> sources;
+        std::unordered_map<const src_distribution_t*, std::uint32_t> source_ids;
+        min_bundle_index_.fill(std::numeric_limits<int>::max());
+        max_bundle_index_.fill(std::numeric_limits<int>::min());
+        src.traverse([this, &sources, &source_ids](const index_t &bi, const src_bundle_t &b) {
+            BundleView bundle;
+            for (std::size_t i=0; i<bin_count; ++i) {
+                const src_distribution_t *d = b.at(i);
+                if (!d) {
+                    bundle.ids_[i] = npos;
+                    continue;
+                }
+                const auto it = source_ids.emplace(d, static_cast<std::uint32_t>(sources.size()));
+                if (it.second)
+                    sources.emplace_back(d);
+                bundle.ids_[i] = it.first->second;
+            }
+            for (std::size_t d=0; d<Dim; ++d) {
+                min_bundle_index_[d] = std::min(min_bundle_index_[d], bi[d]);
+                max_bundle_index_[d] = std::max(max_bundle_index_[d], bi[d]);
+            }
+            bundles_.emplace_back(bundle);
+            bundle_indices_.emplace_back(bi);
+        });
+        if (bundles_.empty()) {
+            min_bundle_index_.fill(0);
+            max_bundle_index_.fill(-1);
+        }
+
+        /// step two: precompute mean, information matrix and weight in parallel
+        const std::size_t num_distributions = sources.size();
+        means_.resize(num_distributions * Dim, T());
+        informations_.resize(num_distributions * Dim * Dim, T());
+        weights_.resize(num_distributions, T());
+        flags_.resize(num_distributions, 0u);
+
+        const std::size_t threads = num_threads > 0ul ? std::min(num_threads, std::max<std::size_t>(1ul, num_distributions)) :
+                                                        utility::num_threads(num_distributions);
+        utility::parallel_for(num_distributions, threads,
+                              [this, &sources, &weight](const std::size_t, const std::size_t begin, const std::size_t end) {
+            for (std::size_t id = begin ; id < end ; ++id) {
+                const src_distribution_t &s = *sources[id];
+                weights_[id] = weight(s);
+
+                const auto *d = distribution(s);
+                if (!d)
+                    continue;
+                flags_[id] |= distribution_flag;
+                Eigen::Map<mean_t>(means_.data() + id * Dim) = d->getMean();
+                if (d->valid()) {
+                    Eigen::Map<information_t>(informations_.data() + id * Dim * Dim) = d->getInformationMatrix();
+                    flags_[id] |= valid_flag;
+                }
+            }
+        });
+
+        /// step three: block-sparse lattice, only blocks holding bundles get slots
+        std::size_t num_blocks = 1ul;
+        for (std::size_t d=0; d<Dim; ++d) {
+            block_strides_[d] = num_blocks;
+            num_blocks *= static_cast<std::size_t>(((max_bundle_index_[d] - min_bundle_index_[d] + 1) >> block_bits) + 1);
+        }
+        blocks_.resize(bundles_.empty() ? 0ul : num_blocks, npos);
+        for (std::size_t b=0; b<bundles_.size(); ++b) {
+            std::size_t block, slot;
+            toBlock(bundle_indices_[b], block, slot);
+            std::uint32_t &first = blocks_[block];
+            if (first == npos) {
+                first = static_cast<std::uint32_t>(block_slots_.size());
+                block_slots_.resize(block_slots_.size() + block_cells, npos);
+            }
+            block_slots_[first + slot] = static_cast<std::uint32_t>(b);
+        }
+        rebind();
+    }
+
+    /**
+     * @brief Throws if ivm is not set or not the inverse model the weights were compiled with.
+     */
+    template <typename ivm_ptr_t>
+    inline void checkModel(const ivm_ptr_t &ivm) const
+    {
+        if (!ivm)
+            throw std::runtime_error("[FrozenGridmap]: inverse model not set");
+        if (static_cast<const void*>(ivm.get()) != model_)
+            throw std::runtime_error("[FrozenGridmap]: inverse model differs from the one the map was compiled with");
+    }
+
+    inline void rebind()
+    {
+        for (BundleView &bundle : bundles_)
+            bundle.map_ = this;
+    }
+
+    template <std::size_t D>
+    inline static const cslibs_math::statistics::StableDistribution<T,D,3>* distribution(const Distribution<T,D> &d)
+    {
+        return &d;
+    }
+
+    template <std::size_t D>
+    inline static const cslibs_math::statistics::StableDistribution<T,D,3>* distribution(const OccupancyDistribution<T,D> &d)
+    {
+        return d.getDistribution().get();
+    }
+
+    template <std::size_t D>
+    inline static const cslibs_math::statistics::StableDistribution<T,D,3>* distribution(const InlineOccupancyDistribution<T,D> &d)
+    {
+        return d.getDistribution();
+    }
+
+    template <std::size_t D>
+    inline static const cslibs_math::statistics::StableDistribution<T,D,3>* distribution(const DecayingOccupancyDistribution<T,D> &d)
+    {
+        return d.getDistribution().get();
+    }
+
+    inline void toBlock(const index_t &bi,
+                        std::size_t &block,
+                        std::size_t &slot) const
+    {
+        block = 0ul;
+        slot  = 0ul;
+        for (std::size_t d=0; d<Dim; ++d) {
+            const std::size_t o = static_cast<std::size_t>(bi[d] - min_bundle_index_[d]);
+            block += (o >> block_bits) * block_strides_[d];
+            slot  |= (o & block_mask) << (block_bits * d);
+        }
+    }
+
+    inline const BundleView* getAllocated(const index_t &bi) const
+    {
+        std::size_t block, slot;
+        toBlock(bi, block, slot);
+        const std::uint32_t first = blocks_[block];
+        if (first == npos)
+            return nullptr;
+
+        const std::uint32_t id = block_slots_[first + slot];
+        return id == npos ? nullptr : &bundles_[id];
+    }
+
+    inline T sampleDistribution(const std::uint32_t id,
+                                const point_t &p) const
+    {
+        if (id == npos || !(flags_[id] & valid_flag))
+            return T();
+
+        const mean_t q = p.data() - Eigen::Map<const mean_t>(means_.data() + id * Dim);
+        const T exponent = -0.5 * static_cast<T>(q.transpose() * Eigen::Map<const information_t>(informations_.data() + id * Dim * Dim) * q);
+        return std::exp(exponent);
+    }
+
+    inline T sampleNonNormalized(const std::uint32_t id,
+                                 const point_t &p) const
+    {
+        return id == npos ? T() : weights_[id] * sampleDistribution(id, p);
+    }
+
+    inline T sampleNonNormalized(const point_t &p,
+                                 const distribution_bundle_t *bundle) const
+    {
+        auto evaluate = [this, &p, &bundle]() {
+            T retval = T();
+            for (std::size_t i=0; i<bin_count; ++i)
+                retval += div_count * sampleNonNormalized(bundle->id(i), p);
+            return retval;
+        };
+        return bundle ? evaluate() : T();
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p,
+                                         const std::array<T,Dim> &weights,
+                                         const distribution_bundle_t *bundle) const
+    {
+        auto evaluate = [this, &p, &weights, &bundle]() {
+            T retval = T();
+            for (std::size_t i=0; i<bin_count; ++i)
+                retval += utility::to_bilinear_interpolation_weight(weights,i) * sampleNonNormalized(bundle->id(i), p);
+            return retval;
+        };
+        return bundle ? evaluate() : T();
+    }
+
+    /**
+     * @brief Batch sampling of a point set under num_poses transformations, see utility::sample_batch.
+     */
+    template <typename point_in_t>
+    inline void sampleBatch(const point_in_t  *points,
+                            const std::size_t  size,
+                            const pose_t      *poses,
+                            const std::size_t  num_poses,
+                            T                 *scores,
+                            T                 *gradients) const
+    {
+        utility::sample_batch<Dim,point_t,index_t>(points, size, poses, num_poses, w_T_m_, scores, gradients,
+                                                   [this](const point_t &p_w, point_t &p_m, index_t &bi) {
+            return toBundleIndex(p_w, p_m, bi);
+        }, [this](const index_t &bi) {
+            return getAllocated(bi);
+        }, [this](const BundleView *bundle, const std::size_t i, mean_t &mean, information_t &information) {
+            const std::uint32_t id = bundle->id(i);
+            if (id == npos || !(flags_[id] & valid_flag))
+                return T();
+            mean        = Eigen::Map<const mean_t>(means_.data() + id * Dim);
+            information = Eigen::Map<const information_t>(informations_.data() + id * Dim * Dim);
+            return div_count * weights_[id];
+        });
+    }
+
+    inline bool valid(const index_t &index) const
+    {
+        for (std::size_t i=0; i<Dim; ++i)
+            if (index[i] < min_bundle_index_[i] || index[i] > max_bundle_index_[i])
+                return false;
+        return true;
+    }
+
+    inline index_t toBundleIndex(const point_t &p_w,
+                                 point_t &p_m) const
+    {
+        p_m = m_T_w_ * p_w;
+        return utility::to_index<Dim>([this,&p_m](const std::size_t& i) {
+            return static_cast<int>(std::floor(p_m(i) * bundle_resolution_inv_));
+        });
+    }
+
+    inline index_t toBundleIndex(const point_t &p_w) const
+    {
+        point_t p_m;
+        return toBundleIndex(p_w, p_m);
+    }
+
+    inline bool toBundleIndex(const point_t &p_w,
+                              index_t &index) const
+    {
+        index = toBundleIndex(p_w);
+        return valid(index);
+    }
+
+    inline bool toBundleIndex(const point_t &p_w,
+                              point_t &p_m,
+                              index_t &index) const
+    {
+        index = toBundleIndex(p_w, p_m);
+        return valid(index);
+    }
+};
+
+template <tags::option option_t, std::size_t Dim, template <typename, std::size_t> class data_t, typename T>
+constexpr std::uint32_t FrozenGridmap<option_t,Dim,data_t,T>::npos;
+}
+
+/**
+ * @brief Frozen Distribution map, sampled like Map<option_t,Dim,Distribution,T>.
+ */
+template <tags::option option_t,
+          std::size_t Dim,
+          typename T>
+class EIGEN_ALIGN16 Map<option_t,Dim,Distribution,T,backend::Frozen> :
+        public impl::FrozenGridmap<option_t,Dim,Distribution,T>
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using base_t = impl::FrozenGridmap<option_t,Dim,Distribution,T>;
+    using typename base_t::pose_t;
+    using typename base_t::point_t;
+    using typename base_t::index_t;
+    using typename base_t::distribution_bundle_t;
+
+    /**
+     * @brief Compile a frozen copy of a Distribution map.
+     * @param src           source map, static or dynamic with any backend
+     * @param num_threads   worker threads for the build, 0 for all available
+     */
+    template <tags::option option_from_t,
+              template <typename, typename, typename...> class backend_from_t>
+    explicit inline Map(const Map<option_from_t,Dim,Distribution,T,backend_from_t> &src,
+                        const std::size_t num_threads = 0ul) :
+        base_t(src, [](const Distribution<T,Dim> &) { return T(1.0); }, num_threads)
+    {
+    }
+
+    inline T sampleNonNormalized(const point_t &p) const
+    {
+        point_t pm;
+        const index_t& i = this->toBundleIndex(p, pm);
+        return sampleNonNormalized(pm, i);
+    }
+
+    inline T sampleNonNormalized(const point_t &p,
+                                 const index_t &bi) const
+    {
+        return this->valid(bi) ? sampleNonNormalized(p, this->getAllocated(bi)) : T();
+    }
+
+    inline T sampleNonNormalized(const point_t &p,
+                                 const distribution_bundle_t *bundle) const
+    {
+        return base_t::sampleNonNormalized(p, bundle);
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p) const
+    {
+        point_t pm;
+        const index_t& i = this->toBundleIndex(p, pm);
+        return sampleNonNormalizedBilinear(pm, i);
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p,
+                                         const index_t &bi) const
+    {
+        if (!this->valid(bi))
+            return T();
+
+        const auto& weights = utility::get_bilinear_interpolation_weights(bi,p,this->bundle_resolution_inv_);
+        return sampleNonNormalizedBilinear(p, weights, this->getAllocated(bi));
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p,
+                                         const std::array<T,Dim> &weights,
+                                         const distribution_bundle_t *bundle) const
+    {
+        return base_t::sampleNonNormalizedBilinear(p, weights, bundle);
+    }
+
+    /**
+     * @brief Sample a whole point set at once, like Map<option_t,Dim,Distribution,T>.
+     */
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      &pose,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        this->sampleBatch(points, size, &pose, 1ul, scores, gradients);
+    }
+
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      *poses,
+                                    const std::size_t  num_poses,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        this->sampleBatch(points, size, poses, num_poses, scores, gradients);
+    }
+};
+
+/**
+ * @brief Frozen occupancy map, sampled like Map<option_t,Dim,OccupancyDistribution,T>.
+ *        Occupancies are evaluated once with the inverse model given at construction, which
+ *        the map keeps. The sample functions and getOccupancy do not evaluate the model they
+ *        are given, they only check that it is that same instance (see getInverseModel) and
+ *        throw otherwise. Compile a new map to sample under a different model.
+ */
+template <tags::option option_t,
+          std::size_t Dim,
+          typename T>
+class EIGEN_ALIGN16 Map<option_t,Dim,OccupancyDistribution,T,backend::Frozen> :
+        public impl::FrozenGridmap<option_t,Dim,OccupancyDistribution,T>
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using base_t = impl::FrozenGridmap<option_t,Dim,OccupancyDistribution,T>;
+    using typename base_t::pose_t;
+    using typename base_t::point_t;
+    using typename base_t::index_t;
+    using typename base_t::distribution_bundle_t;
+
+    using inverse_sensor_model_t = cslibs_gridmaps::utility::InverseModel<T>;
+
+    /**
+     * @brief Compile a frozen copy of an occupancy map.
+     * @param src           source map with OccupancyDistribution, InlineOccupancyDistribution or
+     *                      DecayingOccupancyDistribution, the latter is frozen at the time of its clock
+     * @param ivm           inverse model the occupancies are evaluated with
+     * @param num_threads   worker threads for the build, 0 for all available
+     */
+    template <typename src_map_t>
+    explicit inline Map(const src_map_t &src,
+                        const typename inverse_sensor_model_t::Ptr &ivm,
+                        const std::size_t num_threads = 0ul) :
+        base_t(src, occupancy<typename src_map_t::distribution_t>(ivm), num_threads),
+        ivm_(ivm)
+    {
+        this->model_ = ivm_.get();
+    }
+
+    /**
+     * @brief Inverse model the occupancies were compiled with, the only one the sample functions accept.
+     */
+    inline const typename inverse_sensor_model_t::Ptr& getInverseModel() const
+    {
+        return ivm_;
+    }
+
+    inline T sampleNonNormalized(const point_t &p,
+                                 const typename inverse_sensor_model_t::Ptr &ivm) const
+    {
+        point_t pm;
+        const index_t& i = this->toBundleIndex(p, pm);
+        return sampleNonNormalized(pm, i, ivm);
+    }
+
+    inline T sampleNonNormalized(const point_t &p,
+                                 const index_t &bi,
+                                 const typename inverse_sensor_model_t::Ptr &ivm) const
+    {
+        this->checkModel(ivm);
+
+        return this->valid(bi) ? base_t::sampleNonNormalized(p, this->getAllocated(bi)) : T();
+    }
+
+    inline T sampleNonNormalized(const point_t &p,
+                                 const distribution_bundle_t* bundle,
+                                 const typename inverse_sensor_model_t::Ptr &ivm) const
+    {
+        this->checkModel(ivm);
+
+        return base_t::sampleNonNormalized(p, bundle);
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p,
+                                         const typename inverse_sensor_model_t::Ptr &ivm) const
+    {
+        point_t pm;
+        const index_t& i = this->toBundleIndex(p, pm);
+        return sampleNonNormalizedBilinear(pm, i, ivm);
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p,
+                                         const index_t &bi,
+                                         const typename inverse_sensor_model_t::Ptr &ivm) const
+    {
+        this->checkModel(ivm);
+
+        if (!this->valid(bi))
+            return T();
+
+        const auto& weights = utility::get_bilinear_interpolation_weights(bi,p,this->bundle_resolution_inv_);
+        return base_t::sampleNonNormalizedBilinear(p, weights, this->getAllocated(bi));
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p,
+                                         const std::array<T,Dim> &weights,
+                                         const distribution_bundle_t* bundle,
+                                         const typename inverse_sensor_model_t::Ptr &ivm) const
+    {
+        this->checkModel(ivm);
+
+        return base_t::sampleNonNormalizedBilinear(p, weights, bundle);
+    }
+
+    /**
+     * @brief Sample a whole point set at once, like Map<option_t,Dim,OccupancyDistribution,T>.
+     */
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      &pose,
+                                    const typename inverse_sensor_model_t::Ptr &ivm,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        sampleNonNormalized(points, size, &pose, 1ul, ivm, scores, gradients);
+    }
+
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      *poses,
+                                    const std::size_t  num_poses,
+                                    const typename inverse_sensor_model_t::Ptr &ivm,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        this->checkModel(ivm);
+
+        this->sampleBatch(points, size, poses, num_poses, scores, gradients);
+    }
+
+private:
+    template <typename src_distribution_t>
+    inline static std::function<T(const src_distribution_t&)> occupancy(const typename inverse_sensor_model_t::Ptr &ivm)
+    {
+        if (!ivm)
+            throw std::runtime_error("[FrozenOccupancyGridMap]: inverse model not set");
+
+        return [ivm](const src_distribution_t &d) {
+            return d.getOccupancy(ivm);
+        };
+    }
+
+    typename inverse_sensor_model_t::Ptr ivm_;
+};
+
+template <tags::option option_t,
+          std::size_t Dim,
+          template <typename, std::size_t> class data_t,
+          typename T>
+using FrozenMap = Map<option_t,Dim,data_t,T,backend::Frozen>;
+}
+}
+
+#endif // CSLIBS_NDT_MAP_FROZEN_GRIDMAP_HPP
@@ -6,6 +6,10 @@
 
 #include <cslibs_ndt/utility/bilinear_interpolation.hpp>
 
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+
 namespace cslibs_ndt {
 namespace map {
 template <tags::option option_t,
@@ -43,16 +47,21 @@ public:
     inline Map(base_t &&other) : base_t(other) { }
 
     inline void insert(const typename pointcloud_t::ConstPtr &points,
-                       const pose_t &points_origin = pose_t())
+                       const pose_t &points_origin = pose_t(),
+                       const tags::insert_option insert_option = tags::serial_insert)
     {
-        return insert(points->begin(), points->end(), points_origin);
+        return insert(points->begin(), points->end(), points_origin, insert_option);
     }
 
     template<typename iterator_t>
     inline void insert(const iterator_t &points_begin,
                        const iterator_t &points_end,
-                       const pose_t &points_origin = pose_t())
+                       const pose_t &points_origin = pose_t(),
+                       const tags::insert_option insert_option = tags::serial_insert)
     {
+        if (insert_option == tags::parallel_insert)
+            return insertParallel(points_begin, points_end, points_origin);
+
         std::map<index_t, typename distribution_t::distribution_t> updates;
         for (auto p = points_begin; p != points_end; ++p) {
             const point_t pw = points_origin * *p;
@@ -67,6 +76,22 @@ public:
         for (const auto& pair : updates)
             update(pair.first, pair.second);
     }
+
+    /**
+     * @brief Adds the statistics d to all distributions of bundle bi, as inserting the points
+     *        d was accumulated from would. Bundles outside of the map are skipped.
+     *        Counts as a change of bi, see setChangeTracking.
+     */
+    inline void update(const index_t &bi,
+                       const typename distribution_t::distribution_t &d)
+    {
+        if (!this->valid(bi))
+            return;
+        const distribution_bundle_t *bundle = this->getAllocate(bi);
+        this->markChanged(bi);
+        for (std::size_t i=0; i<this->bin_count; ++i)
+            *bundle->at(i) += d;//->update(d);//->data() += d;
+    }
 /*
     inline T sample(const point_t &p) const
     {
@@ -81,7 +106,7 @@ public:
         if (!this->valid(bi))
             return T();
 
-        distribution_bundle_t *bundle  = this->bundle_storage_->get(bi);
+        const distribution_bundle_t *bundle  = this->bundles().get(bi);
         return sample(p, bundle);
     }
 
@@ -110,7 +135,7 @@ public:
         if (!this->valid(bi))
             return T();
 
-        distribution_bundle_t *bundle = this->bundle_storage_->get(bi);
+        const distribution_bundle_t *bundle = this->bundles().get(bi);
         return sampleNonNormalized(p, bundle);
     }
 
@@ -136,6 +161,56 @@ public:
         return bundle ? evaluate() : T();
     }
 
+    /**
+     * @brief Sample a whole point set at once, equivalent to calling
+     *        sampleNonNormalized(pose * points[i]) for every point.
+     * @param points    contiguous input points
+     * @param size      number of points
+     * @param pose      transformation applied to all points
+     * @param scores    output, one score per point
+     * @param gradients optional output, Dim entries per point, derivative of the
+     *                  score w.r.t. the transformed point
+     */
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      &pose,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        sampleNonNormalized(points, size, &pose, 1ul, scores, gradients);
+    }
+
+    /**
+     * @brief Sample a point set under several transformations at once, e.g. one per
+     *        particle. The transformed points of all poses are binned by bundle together.
+     * @param poses     num_poses transformations
+     * @param scores    output, size entries per pose, pose major
+     * @param gradients optional output, size * Dim entries per pose
+     */
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      *poses,
+                                    const std::size_t  num_poses,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        using mean_t        = typename utility::GaussianBatch<T,Dim>::mean_t;
+        using information_t = typename utility::GaussianBatch<T,Dim>::information_t;
+
+        this->sampleBatch(points, size, poses, num_poses, scores, gradients,
+                          [](const distribution_bundle_t *bundle, const std::size_t i,
+                             mean_t &mean, information_t &information) {
+            const distribution_t *d = bundle->at(i);
+            if (!d || !d->valid())
+                return T(0.0);
+            mean        = d->getMean();
+            information = d->getInformationMatrix();
+            return base_t::div_count;
+        });
+    }
+
     inline T sampleNonNormalizedBilinear(const point_t &p) const
     {
         point_t pm;
@@ -149,7 +224,7 @@ public:
         if (!this->valid(bi))
             return T();
 
-        distribution_bundle_t *bundle = this->bundle_storage_->get(bi);
+        const distribution_bundle_t *bundle = this->bundles().get(bi);
         const auto& weights = utility::get_bilinear_interpolation_weights(bi,p,this->bundle_resolution_inv_);
         return sampleNonNormalizedBilinear(p, weights, bundle);
     }
@@ -183,12 +258,83 @@ protected:
         return d && d->valid();//d->getDistribution() && d->getDistribution()->valid();//d->data().valid();
     }
 
-    inline void update(const index_t &bi,
-                       const typename distribution_t::distribution_t &d) const
+    /**
+     * @brief Multi-threaded insertion, yields exactly the same map as the serial path.
+     *        Points are bucketed by hash shard while they are transformed and aggregated
+     *        by the thread owning their shard, so every bundle sees its points in input
+     *        order and every point is visited once per step. The sorted bundle updates are then
+     *        applied by one thread per distribution storage, which keeps the update
+     *        order of every single distribution identical to the serial std::map walk.
+     */
+    template<typename iterator_t>
+    inline void insertParallel(const iterator_t &points_begin,
+                               const iterator_t &points_end,
+                               const pose_t &points_origin)
     {
-        const distribution_bundle_t *bundle = this->getAllocate(bi);
-        for (std::size_t i=0; i<this->bin_count; ++i)
-            *bundle->at(i) += d;//->update(d);//->data() += d;
+        using dist_t   = typename distribution_t::distribution_t;
+        using shard_t  = std::unordered_map<index_t, dist_t, std::hash<index_t>, std::equal_to<index_t>,
+                                            Eigen::aligned_allocator<std::pair<const index_t, dist_t>>>;
+        using update_t = std::pair<index_t, dist_t>;
+
+        const std::size_t size = static_cast<std::size_t>(std::distance(points_begin, points_end));
+        if (size == 0ul)
+            return;
+        const std::size_t num_threads = utility::num_threads(size);
+
+        /// step one: transform points and compute bundle indices, bucket them per thread and shard
+        using bucket_t = std::vector<std::size_t>;
+        std::vector<point_t, Eigen::aligned_allocator<point_t>> points_m(size);
+        std::vector<index_t>               indices(size);
+        std::vector<std::vector<bucket_t>> buckets(num_threads, std::vector<bucket_t>(num_threads));
+        utility::parallel_for(size, num_threads,
+                              [this, &points_begin, &points_origin, &points_m, &indices, &buckets, num_threads]
+                              (const std::size_t thread_id, const std::size_t begin, const std::size_t end) {
+            const std::hash<index_t> hash;
+            std::vector<bucket_t> &thread_buckets = buckets[thread_id];
+            iterator_t p = points_begin;
+            std::advance(p, begin);
+            for (std::size_t i = begin ; i < end ; ++i, ++p) {
+                const point_t pw = points_origin * *p;
+                if (pw.isNormal() && this->toBundleIndex(pw, points_m[i], indices[i]))
+                    thread_buckets[hash(indices[i]) % num_threads].emplace_back(i);
+            }
+        });
+
+        /// step two: aggregate points per bundle, each thread owns one shard and only visits its points,
+        ///           the buckets of consecutive threads concatenate to input order
+        std::vector<shard_t> shards(num_threads);
+        utility::parallel_for(num_threads, num_threads,
+                              [&points_m, &indices, &buckets, &shards]
+                              (const std::size_t shard_id, const std::size_t, const std::size_t) {
+            shard_t &shard = shards[shard_id];
+            for (const std::vector<bucket_t> &thread_buckets : buckets)
+                for (const std::size_t i : thread_buckets[shard_id])
+                    shard[indices[i]] += points_m[i];
+        });
+
+        /// step three: bring bundle updates into the order of the serial path
+        std::vector<update_t, Eigen::aligned_allocator<update_t>> updates;
+        for (const shard_t &shard : shards)
+            updates.insert(updates.end(), shard.begin(), shard.end());
+        std::sort(updates.begin(), updates.end(),
+                  [](const update_t &a, const update_t &b) { return a.first < b.first; });
+
+        /// step four: allocation modifies the shared storages, thus done serially
+        std::vector<const distribution_bundle_t*> bundles(updates.size());
+        for (std::size_t i = 0 ; i < updates.size() ; ++i) {
+            bundles[i] = this->getAllocate(updates[i].first);
+            this->markChanged(updates[i].first);
+        }
+
+        /// step five: storages are disjoint, update them in parallel
+        std::array<std::thread, base_t::bin_count> threads;
+        for (std::size_t i = 0 ; i < base_t::bin_count ; ++i)
+            threads[i] = std::thread([&updates, &bundles, i]() {
+                for (std::size_t j = 0 ; j < updates.size() ; ++j)
+                    *bundles[j]->at(i) += updates[j].second;
+            });
+        for (std::size_t i = 0 ; i < base_t::bin_count ; ++i)
+            threads[i].join();
     }
 };
 }
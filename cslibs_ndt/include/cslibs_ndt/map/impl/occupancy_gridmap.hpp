@@ -2,7 +2,10 @@
 #define CSLIBS_NDT_MAP_OCCUPANCY_GRIDMAP_HPP
 
 #include <cslibs_ndt/map/generic_map.hpp>
+#include <cslibs_ndt/map/batch_ray_caster.hpp>
 #include <cslibs_ndt/common/occupancy_distribution.hpp>
+#include <cslibs_ndt/common/inline_occupancy_distribution.hpp>
+#include <cslibs_ndt/common/decaying_occupancy_distribution.hpp>
 #include <cslibs_math/statistics/mean.hpp>
 
 #include <cslibs_indexed_storage/operations/clustering/grid_neighborhood.hpp>
@@ -10,21 +13,27 @@
 
 namespace cslibs_ndt {
 namespace map {
+namespace impl {
+/**
+ * @brief Occupancy map implementation shared by all occupancy distribution types
+ *        with the OccupancyDistribution interface.
+ */
 template <tags::option option_t,
           std::size_t Dim,
+          template <typename, std::size_t> class data_t,
           typename T,
           template <typename, typename, typename...> class backend_t>
-class EIGEN_ALIGN16 Map<option_t,Dim,OccupancyDistribution,T,backend_t> :
-        public GenericMap<option_t,Dim,OccupancyDistribution,T,backend_t>
+class EIGEN_ALIGN16 OccupancyGridmap :
+        public GenericMap<option_t,Dim,data_t,T,backend_t>
 {
 public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-    using allocator_t = Eigen::aligned_allocator<Map<option_t,Dim,OccupancyDistribution,T,backend_t>>;
+    using allocator_t = Eigen::aligned_allocator<Map<option_t,Dim,data_t,T,backend_t>>;
 
-    using ConstPtr = std::shared_ptr<const Map<option_t,Dim,OccupancyDistribution,T,backend_t>>;
-    using Ptr      = std::shared_ptr<Map<option_t,Dim,OccupancyDistribution,T,backend_t>>;
+    using ConstPtr = std::shared_ptr<const Map<option_t,Dim,data_t,T,backend_t>>;
+    using Ptr      = std::shared_ptr<Map<option_t,Dim,data_t,T,backend_t>>;
 
-    using base_t = GenericMap<option_t,Dim,OccupancyDistribution,T,backend_t>;
+    using base_t = GenericMap<option_t,Dim,data_t,T,backend_t>;
     using typename base_t::pose_t;
     using typename base_t::transform_t;
     using typename base_t::point_t;
@@ -44,20 +53,40 @@ public:
     using default_iterator_t     = typename map::traits<Dim,T>::default_iterator_t;
 
     using base_t::base_t;
-    inline Map(const base_t &other) : base_t(other) { }
-    inline Map(base_t &&other) : base_t(other) { }
+    inline OccupancyGridmap(const base_t &other) : base_t(other) { reattach<distribution_t>(0); }
+    inline OccupancyGridmap(base_t &&other) : base_t(other) { reattach<distribution_t>(0); }
+
+    /**
+     * @brief Copies get a clock of their own, set to the time and half-life of the source's,
+     *        and their distributions are pointed to it. Copying a decaying map thus writes to
+     *        all of its distributions, copy on write backends copy every block.
+     */
+    inline OccupancyGridmap(const OccupancyGridmap &other) :
+        base_t(other),
+        clock_(other.clock_ ? std::make_shared<DecayClock<T>>(*other.clock_) : nullptr)
+    {
+        reattach<distribution_t>(0);
+    }
+
+    inline OccupancyGridmap(OccupancyGridmap &&other) :
+        base_t(std::move(other)),
+        clock_(std::move(other.clock_))
+    {
+    }
 
     template <typename line_iterator_t = default_iterator_t>
     inline void insert(const typename pointcloud_t::ConstPtr &points,
-                       const pose_t &points_origin = pose_t())
+                       const pose_t &points_origin = pose_t(),
+                       const tags::insert_option insert_option = tags::serial_insert)
     {
-        return insert<line_iterator_t>(points->begin(), points->end(), points_origin);
+        return insert<line_iterator_t>(points->begin(), points->end(), points_origin, insert_option);
     }
 
     template <typename line_iterator_t = default_iterator_t, typename iterator_t>
     inline void insert(const iterator_t &points_begin,
                        const iterator_t &points_end,
-                       const pose_t &points_origin = pose_t())
+                       const pose_t &points_origin = pose_t(),
+                       const tags::insert_option insert_option = tags::serial_insert)
     {
         using dist_t = typename distribution_t::distribution_t;
         std::map<index_t, dist_t> updates;
@@ -73,8 +102,11 @@ public:
             }
         }
 
-        std::unordered_map<index_t,std::size_t> updates_free;
         const auto& start = this->m_T_w_ * points_origin.translation();
+        if (insert_option == tags::parallel_insert)
+            return insertBatch<line_iterator_t>(updates, start);
+
+        std::unordered_map<index_t,std::size_t> updates_free;
         for (const auto& pair : updates) {
             const index_t& i = pair.first;
             const dist_t&  d = pair.second;
@@ -211,7 +243,7 @@ public:
         if (!this->valid(bi))
             return T();
 
-        distribution_bundle_t *bundle = this->bundle_storage_->get(bi);
+        const distribution_bundle_t *bundle = this->bundles().get(bi);
         return sample(p, bundle, ivm);
     }
 
@@ -258,7 +290,7 @@ public:
         if (!this->valid(bi))
             return T();
 
-        distribution_bundle_t *bundle  = this->bundle_storage_->get(bi);
+        const distribution_bundle_t *bundle  = this->bundles().get(bi);
         return sampleNonNormalized(p, bundle, ivm);
     }
 
@@ -287,6 +319,62 @@ public:
         return bundle ? evaluate() : T();
     }
 
+    /**
+     * @brief Sample a whole point set at once, equivalent to calling
+     *        sampleNonNormalized(pose * points[i], ivm) for every point.
+     * @param points    contiguous input points
+     * @param size      number of points
+     * @param pose      transformation applied to all points
+     * @param ivm       inverse sensor model for the occupancy weights
+     * @param scores    output, one score per point
+     * @param gradients optional output, Dim entries per point, derivative of the
+     *                  score w.r.t. the transformed point
+     */
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      &pose,
+                                    const typename inverse_sensor_model_t::Ptr &ivm,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        sampleNonNormalized(points, size, &pose, 1ul, ivm, scores, gradients);
+    }
+
+    /**
+     * @brief Sample a point set under several transformations at once, e.g. one per
+     *        particle. The transformed points of all poses are binned by bundle together.
+     * @param poses     num_poses transformations
+     * @param scores    output, size entries per pose, pose major
+     * @param gradients optional output, size * Dim entries per pose
+     */
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      *poses,
+                                    const std::size_t  num_poses,
+                                    const typename inverse_sensor_model_t::Ptr &ivm,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        if (!ivm)
+            throw std::runtime_error("[OccupancyGridMap]: inverse model not set");
+
+        using mean_t        = typename utility::GaussianBatch<T,Dim>::mean_t;
+        using information_t = typename utility::GaussianBatch<T,Dim>::information_t;
+
+        this->sampleBatch(points, size, poses, num_poses, scores, gradients,
+                          [&ivm](const distribution_bundle_t *bundle, const std::size_t i,
+                                 mean_t &mean, information_t &information) {
+            const distribution_t *d = bundle->at(i);
+            if (!d || !d->getDistribution() || !d->getDistribution()->valid())
+                return T(0.0);
+            mean        = d->getDistribution()->getMean();
+            information = d->getDistribution()->getInformationMatrix();
+            return base_t::div_count * d->getOccupancy(ivm);
+        });
+    }
+
     inline T sampleNonNormalizedBilinear(const point_t &p,
                                          const typename inverse_sensor_model_t::Ptr &ivm) const
     {
@@ -305,7 +393,7 @@ public:
         if (!this->valid(bi))
             return T();
 
-        distribution_bundle_t *bundle  = this->bundle_storage_->get(bi);
+        const distribution_bundle_t *bundle  = this->bundles().get(bi);
         const auto& weights = utility::get_bilinear_interpolation_weights(bi,p,this->bundle_resolution_inv_);
         return sampleNonNormalizedBilinear(p, weights, bundle, ivm);
     }
@@ -342,20 +430,183 @@ protected:
         return d && d->getDistribution() && d->getDistribution()->valid();
     }
 
+    /**
+     * @brief Clock of maps with decaying distributions, null for all others. Copies own a copy of it.
+     */
+    typename DecayClock<T>::Ptr clock_ = makeClock<distribution_t>(0);
+
+    template <typename d_t>
+    inline static auto makeClock(int) -> decltype(std::declval<d_t&>().getClock(), typename DecayClock<T>::Ptr())
+    {
+        return std::make_shared<DecayClock<T>>();
+    }
+
+    template <typename d_t>
+    inline static typename DecayClock<T>::Ptr makeClock(long)
+    {
+        return nullptr;
+    }
+
+    /**
+     * @brief Distributions which decay are stamped with the time of the map clock.
+     */
+    template <typename d_t>
+    inline auto attach(d_t *d, int) const -> decltype(d->setClock(clock_), void())
+    {
+        d->setClock(clock_);
+    }
+
+    template <typename d_t>
+    inline void attach(d_t *, long) const
+    {
+    }
+
+    /**
+     * @brief Points all distributions to the map clock, including those no update reached yet.
+     */
+    template <typename d_t>
+    inline auto reattach(int) -> decltype(std::declval<d_t&>().getClock(), void())
+    {
+        for (std::size_t i = 0 ; i < this->bin_count ; ++i)
+            this->storage_[i]->traverse([this](const index_t &, distribution_t &d) {
+                attach(&d, 0);
+            });
+    }
+
+    template <typename d_t>
+    inline void reattach(long)
+    {
+    }
+
     inline void updateFree(const index_t &bi,
                            const std::size_t &n) const
     {
         const distribution_bundle_t *bundle = this->getAllocate(bi);
-        for (std::size_t i=0; i<this->bin_count; ++i)
+        this->markChanged(bi);
+        for (std::size_t i=0; i<this->bin_count; ++i) {
+            attach(bundle->at(i), 0);
             bundle->at(i)->updateFree(n);
+        }
     }
 
     inline void updateOccupied(const index_t &bi,
                                const typename distribution_t::distribution_t &d) const
     {
         const distribution_bundle_t* bundle = this->getAllocate(bi);
-        for (std::size_t i=0; i<this->bin_count; ++i)
+        this->markChanged(bi);
+        for (std::size_t i=0; i<this->bin_count; ++i) {
+            attach(bundle->at(i), 0);
             bundle->at(i)->updateOccupied(d);
+        }
+    }
+
+    template <typename line_iterator_t, typename updates_t>
+    inline void insertBatch(const updates_t &updates,
+                            const point_t   &start)
+    {
+        using ray_caster_t = BatchRayCaster<Dim,T,line_iterator_t>;
+
+        /// step one: occupied updates in index order, collect one ray per bundle
+        ray_caster_t caster(this->bundle_resolution_);
+        for (const auto& pair : updates) {
+            const index_t& i = pair.first;
+            const auto&    d = pair.second;
+
+            if (this->valid(i))
+                updateOccupied(i, d);
+            caster.add(point_t(d.getMean()), d.getN());
+        }
+
+        /// step two: traverse all rays at once, free counts are integral and thus order independent
+        typename ray_caster_t::free_updates_t updates_free;
+        caster.cast(start, [this](const index_t &bi) { return this->valid(bi); }, updates_free);
+
+        /// step three: apply the deduplicated free counts in one pass
+        for (const auto& pair : updates_free)
+            updateFree(pair.first, pair.second);
+    }
+};
+}
+
+template <tags::option option_t,
+          std::size_t Dim,
+          typename T,
+          template <typename, typename, typename...> class backend_t>
+class EIGEN_ALIGN16 Map<option_t,Dim,OccupancyDistribution,T,backend_t> :
+        public impl::OccupancyGridmap<option_t,Dim,OccupancyDistribution,T,backend_t>
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using base_t = impl::OccupancyGridmap<option_t,Dim,OccupancyDistribution,T,backend_t>;
+    using base_t::base_t;
+};
+
+template <tags::option option_t,
+          std::size_t Dim,
+          typename T,
+          template <typename, typename, typename...> class backend_t>
+class EIGEN_ALIGN16 Map<option_t,Dim,InlineOccupancyDistribution,T,backend_t> :
+        public impl::OccupancyGridmap<option_t,Dim,InlineOccupancyDistribution,T,backend_t>
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using base_t = impl::OccupancyGridmap<option_t,Dim,InlineOccupancyDistribution,T,backend_t>;
+    using base_t::base_t;
+};
+
+/**
+ * @brief Occupancy map whose evidence decays over time, see DecayingOccupancyDistribution.
+ *        Set the time before each insert, reads evaluate the occupancy at the time set last.
+ *        Copies and conversions start with a copy of the clock of their source, setting the
+ *        time of one does not affect the other.
+ */
+template <tags::option option_t,
+          std::size_t Dim,
+          typename T,
+          template <typename, typename, typename...> class backend_t>
+class EIGEN_ALIGN16 Map<option_t,Dim,DecayingOccupancyDistribution,T,backend_t> :
+        public impl::OccupancyGridmap<option_t,Dim,DecayingOccupancyDistribution,T,backend_t>
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using base_t  = impl::OccupancyGridmap<option_t,Dim,DecayingOccupancyDistribution,T,backend_t>;
+    using clock_t = DecayClock<T>;
+    using base_t::base_t;
+
+    inline void setTime(const T time)
+    {
+        this->clock_->setTime(time);
+    }
+
+    inline T getTime() const
+    {
+        return this->clock_->getTime();
+    }
+
+    inline void setHalfLife(const T half_life)
+    {
+        this->clock_->setHalfLife(half_life);
+    }
+
+    inline T getHalfLife() const
+    {
+        return this->clock_->getHalfLife();
+    }
+
+    inline const typename clock_t::Ptr& getClock() const
+    {
+        return this->clock_;
+    }
+
+    /**
+     * @brief Replaces the clock and points all distributions to it.
+     */
+    inline void setClock(const typename clock_t::Ptr &clock)
+    {
+        if (clock) {
+            this->clock_ = clock;
+            this->template reattach<DecayingOccupancyDistribution<T,Dim>>(0);
+        }
     }
 };
 }
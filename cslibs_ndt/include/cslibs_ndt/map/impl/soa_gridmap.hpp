@@ -0,0 +1,800 @@
+#ifndef CSLIBS_NDT_MAP_SOA_GRIDMAP_HPP
+#define CSLIBS_NDT_MAP_SOA_GRIDMAP_HPP
+
+#include <cslibs_ndt/map/traits.hpp>
+#include <cslibs_ndt/backend/soa.hpp>
+#include <cslibs_ndt/common/distribution.hpp>
+#include <cslibs_ndt/utility/utility.hpp>
+#include <cslibs_ndt/utility/bilinear_interpolation.hpp>
+#include <cslibs_ndt/utility/batch_sample.hpp>
+
+#include <cslibs_math/common/array.hpp>
+
+#include <cslibs_indexed_storage/operations/clustering.hpp>
+
+#include <map>
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace cslibs_ndt {
+namespace map {
+/**
+ * @brief Static Distribution map in one contiguous structure-of-arrays block.
+ *        The 2^Dim overlapping distribution lattices are interleaved into a single
+ *        lattice at bundle resolution. Distribution c covers the bundles c and c+1 in
+ *        every dimension, so bundle bi consists of the distributions bi-1 and bi per
+ *        dimension and is addressed by index arithmetic only, there are no pointer bundles.
+ *        Mean, information matrix and sample count are separate arrays used for sampling,
+ *        the incremental estimates are kept in a contiguous pool which is only touched on insertion.
+ *        Storage level access (getStorages, serialization) is not provided by this layout.
+ */
+template <std::size_t Dim,
+          typename T>
+class EIGEN_ALIGN16 Map<tags::static_map,Dim,Distribution,T,backend::SoA>
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using allocator_t = Eigen::aligned_allocator<Map<tags::static_map,Dim,Distribution,T,backend::SoA>>;
+
+    using ConstPtr = std::shared_ptr<const Map<tags::static_map,Dim,Distribution,T,backend::SoA>>;
+    using Ptr      = std::shared_ptr<Map<tags::static_map,Dim,Distribution,T,backend::SoA>>;
+
+    using pose_2d_t     = typename traits<Dim,T>::pose_2d_t;
+    using pose_t        = typename traits<Dim,T>::pose_t;
+    using transform_t   = typename traits<Dim,T>::transform_t;
+    using point_t       = typename traits<Dim,T>::point_t;
+    using pointcloud_t  = typename traits<Dim,T>::pointcloud_t;
+    using index_t       = std::array<int,Dim>;
+    using size_t        = std::array<std::size_t,Dim>;
+    using size_m_t      = std::array<T,Dim>;
+
+    static constexpr std::size_t bin_count  = utility::two_pow(Dim);
+    static constexpr T div_count = 1.0 / static_cast<T>(bin_count);
+
+    using distribution_t = Distribution<T,Dim>;
+    using mean_t         = Eigen::Matrix<T,Dim,1>;
+    using information_t  = Eigen::Matrix<T,Dim,Dim>;
+
+    using neighborhood_t = cis::operations::clustering::GridNeighborhoodStatic<Dim, 3>;
+
+    /**
+     * @brief Read-only view on one distribution, behaves like the distribution pointers
+     *        of a bundle. Views are only valid as long as the map is not modified.
+     */
+    class DistributionView
+    {
+    public:
+        inline DistributionView(const Map *map,
+                                const std::size_t id) :
+            map_(map),
+            id_(id)
+        {
+        }
+
+        inline explicit operator bool() const
+        {
+            return map_->distribution_ids_[id_] != npos;
+        }
+
+        inline const DistributionView* operator -> () const
+        {
+            return this;
+        }
+
+        inline bool valid() const
+        {
+            return map_->counts_[id_] > 0ul;
+        }
+
+        inline std::size_t getN() const
+        {
+            return *this ? data().getN() : 0ul;
+        }
+
+        inline Eigen::Map<const mean_t> getMean() const
+        {
+            return Eigen::Map<const mean_t>(map_->means_.data() + id_ * Dim);
+        }
+
+        inline Eigen::Map<const information_t> getInformationMatrix() const
+        {
+            return Eigen::Map<const information_t>(map_->informations_.data() + id_ * Dim * Dim);
+        }
+
+        inline T sampleNonNormalized(const point_t &p) const
+        {
+            return map_->sampleNonNormalized(id_, p);
+        }
+
+        inline const distribution_t& data() const
+        {
+            return map_->distributions_[map_->distribution_ids_[id_]];
+        }
+
+    private:
+        const Map         *map_;
+        const std::size_t  id_;
+    };
+
+    /**
+     * @brief Bundle of the 2^Dim overlapping distributions, resolved by index arithmetic.
+     */
+    class BundleView
+    {
+    public:
+        inline BundleView() :
+            map_(nullptr),
+            corner_(0u),
+            parity_(0u),
+            allocated_(false),
+            expand_(true)
+        {
+        }
+
+        inline static std::size_t size()
+        {
+            return bin_count;
+        }
+
+        inline DistributionView operator [] (const std::size_t i) const
+        {
+            return at(i);
+        }
+
+        inline DistributionView at(const std::size_t i) const
+        {
+            return DistributionView(map_, id(i));
+        }
+
+        inline std::size_t id(const std::size_t i) const
+        {
+            return corner_ + map_->bin_offsets_[parity_][i];
+        }
+
+        inline bool expand() const
+        {
+            return expand_;
+        }
+
+        inline void setExpanded() const
+        {
+            expand_ = false;
+        }
+
+        inline std::size_t byte_size() const
+        {
+            return sizeof(*this);
+        }
+
+    private:
+        friend class Map;
+
+        const Map     *map_;
+        std::uint32_t  corner_;
+        std::uint8_t   parity_;
+        bool           allocated_;
+        mutable bool   expand_;
+    };
+
+    using distribution_bundle_t       = BundleView;
+    using distribution_const_bundle_t = BundleView;
+
+    inline Map(const pose_t  &origin,
+               const T       &resolution,
+               const size_t  &size,
+               const index_t &min_bundle_index) :
+        resolution_(resolution),
+        bundle_resolution_(0.5 * resolution_),
+        bundle_resolution_inv_(1.0 / bundle_resolution_),
+        w_T_m_(origin),
+        m_T_w_(w_T_m_.inverse()),
+        size_(size),
+        size_m_(cslibs_math::common::cast<T>(size + 1ul) * resolution),
+        min_bundle_index_(min_bundle_index),
+        max_bundle_index_(min_bundle_index + cslibs_math::common::cast<int>(size * 2ul) - 1)
+    {
+        /// step one: strides of the distribution and the bundle lattice
+        std::size_t num_distributions = 1ul;
+        std::size_t num_bundles       = 1ul;
+        for (std::size_t d=0; d<Dim; ++d) {
+            distribution_strides_[d] = num_distributions;
+            bundle_strides_[d]       = num_bundles;
+            num_distributions *= 2ul * size_[d];
+            num_bundles       *= 2ul * size_[d] - 1ul;
+        }
+
+        /// step two: offsets of the bins relative to the lower bundle corner, depending on the bundle parity
+        for (std::size_t parity=0; parity<bin_count; ++parity) {
+            for (std::size_t i=0; i<bin_count; ++i) {
+                std::size_t offset = 0ul;
+                for (std::size_t d=0; d<Dim; ++d)
+                    if (((i >> d) & 1ul) == ((parity >> d) & 1ul))
+                        offset += distribution_strides_[d];
+                bin_offsets_[parity][i] = offset;
+            }
+        }
+
+        /// step three: allocate the arrays
+        means_.resize(num_distributions * Dim, T());
+        informations_.resize(num_distributions * Dim * Dim, T());
+        counts_.resize(num_distributions, 0ul);
+        distribution_ids_.resize(num_distributions, npos);
+
+        bundles_.resize(num_bundles);
+        for (std::size_t b=0; b<num_bundles; ++b) {
+            const index_t bi = fromBundleId(b);
+            BundleView &bundle = bundles_[b];
+            bundle.corner_ = static_cast<std::uint32_t>(toDistributionId(bi));
+            for (std::size_t d=0; d<Dim; ++d)
+                bundle.parity_ |= static_cast<std::uint8_t>((bi[d] & 1) << d);
+        }
+        rebind();
+    }
+
+    inline Map(const Map &other) :
+        resolution_(other.resolution_),
+        bundle_resolution_(other.bundle_resolution_),
+        bundle_resolution_inv_(other.bundle_resolution_inv_),
+        w_T_m_(other.w_T_m_),
+        m_T_w_(other.m_T_w_),
+        size_(other.size_),
+        size_m_(other.size_m_),
+        min_bundle_index_(other.min_bundle_index_),
+        max_bundle_index_(other.max_bundle_index_),
+        distribution_strides_(other.distribution_strides_),
+        bundle_strides_(other.bundle_strides_),
+        bin_offsets_(other.bin_offsets_),
+        means_(other.means_),
+        informations_(other.informations_),
+        counts_(other.counts_),
+        distribution_ids_(other.distribution_ids_),
+        distributions_(other.distributions_),
+        bundles_(other.bundles_)
+    {
+        rebind();
+    }
+
+    inline Map(Map &&other) :
+        resolution_(other.resolution_),
+        bundle_resolution_(other.bundle_resolution_),
+        bundle_resolution_inv_(other.bundle_resolution_inv_),
+        w_T_m_(std::move(other.w_T_m_)),
+        m_T_w_(std::move(other.m_T_w_)),
+        size_(other.size_),
+        size_m_(other.size_m_),
+        min_bundle_index_(other.min_bundle_index_),
+        max_bundle_index_(other.max_bundle_index_),
+        distribution_strides_(other.distribution_strides_),
+        bundle_strides_(other.bundle_strides_),
+        bin_offsets_(other.bin_offsets_),
+        means_(std::move(other.means_)),
+        informations_(std::move(other.informations_)),
+        counts_(std::move(other.counts_)),
+        distribution_ids_(std::move(other.distribution_ids_)),
+        distributions_(std::move(other.distributions_)),
+        bundles_(std::move(other.bundles_))
+    {
+        rebind();
+    }
+
+    inline virtual ~Map() = default;
+
+    /**
+     * @brief Get minimum in map coordinates.
+     * @return the minimum
+     */
+    inline point_t getMin() const
+    {
+        return utility::to_point<point_t>([this](const std::size_t& i) {
+            return min_bundle_index_[i] * bundle_resolution_;
+        });
+    }
+
+    /**
+     * @brief Get maximum in map coordinates.
+     * @return the maximum
+     */
+    inline point_t getMax() const
+    {
+        return utility::to_point<point_t>([this](const std::size_t& i) {
+            return (max_bundle_index_[i]+1) * bundle_resolution_;
+        });
+    }
+
+    /**
+     * @brief Get the origin.
+     * @return the origin
+     */
+    inline pose_t getOrigin() const
+    {
+        pose_t origin = w_T_m_;
+        origin.translation() += getMin();
+        return origin;
+    }
+
+    /**
+     * @brief Get the initial origin of the map.
+     * @return the inital origin
+     */
+    inline pose_t getInitialOrigin() const
+    {
+        return w_T_m_;
+    }
+
+    inline index_t getMinBundleIndex() const
+    {
+        return min_bundle_index_;
+    }
+
+    inline index_t getMaxBundleIndex() const
+    {
+        return max_bundle_index_;
+    }
+
+    inline T getBundleResolution() const
+    {
+        return bundle_resolution_;
+    }
+
+    inline T getResolution() const
+    {
+        return resolution_;
+    }
+
+    inline T getHeight() const
+    {
+        return (max_bundle_index_[1] - min_bundle_index_[1] + 1) * bundle_resolution_;
+    }
+
+    inline T getWidth() const
+    {
+        return (max_bundle_index_[0] - min_bundle_index_[0] + 1) * bundle_resolution_;
+    }
+
+    inline size_m_t getSizeM() const
+    {
+        return size_m_;
+    }
+
+    inline size_t getSize() const
+    {
+        return size_;
+    }
+
+    inline size_t getBundleSize() const
+    {
+        return size_ * 2ul;
+    }
+
+    inline bool empty() const
+    {
+        return false;
+    }
+
+    inline void insert(const typename pointcloud_t::ConstPtr &points,
+                       const pose_t &points_origin = pose_t(),
+                       const tags::insert_option insert_option = tags::serial_insert)
+    {
+        return insert(points->begin(), points->end(), points_origin, insert_option);
+    }
+
+    /**
+     * @brief Insert points, yields the same distributions as the bundle storage map.
+     *        The parallel option refreshes the sampling arrays in parallel.
+     */
+    template<typename iterator_t>
+    inline void insert(const iterator_t &points_begin,
+                       const iterator_t &points_end,
+                       const pose_t &points_origin = pose_t(),
+                       const tags::insert_option insert_option = tags::serial_insert)
+    {
+        std::map<index_t, typename distribution_t::distribution_t> updates;
+        for (auto p = points_begin; p != points_end; ++p) {
+            const point_t pw = points_origin * *p;
+            if (pw.isNormal()) {
+                point_t pm;
+                index_t bi;
+                if (toBundleIndex(pw, pm, bi))
+                    updates[bi] += pm;
+            }
+        }
+
+        std::vector<std::size_t> changed;
+        changed.reserve(updates.size() * bin_count);
+        for (const auto& pair : updates) {
+            const BundleView *bundle = getAllocate(pair.first);
+            for (std::size_t i=0; i<bin_count; ++i) {
+                const std::size_t id = bundle->id(i);
+                distributions_[distribution_ids_[id]] += pair.second;
+                changed.emplace_back(id);
+            }
+        }
+
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+        const std::size_t num_threads = insert_option == tags::parallel_insert ?
+                    utility::num_threads(changed.size()) : 1ul;
+        utility::parallel_for(changed.size(), num_threads,
+                              [this, &changed](const std::size_t, const std::size_t begin, const std::size_t end) {
+            for (std::size_t j = begin ; j < end ; ++j)
+                refresh(changed[j]);
+        });
+    }
+
+    /**
+     * @brief Overwrite the distributions of a bundle, used for conversion from bundle storage maps.
+     * @param bi        bundle index
+     * @param bundle    bundle with distribution pointers, null entries are skipped
+     */
+    template <typename bundle_t>
+    inline void set(const index_t &bi,
+                    const bundle_t &bundle)
+    {
+        if (!valid(bi))
+            return;
+
+        const BundleView *b = getAllocate(bi);
+        for (std::size_t i=0; i<bin_count; ++i) {
+            if (bundle.at(i)) {
+                const std::size_t id = b->id(i);
+                distributions_[distribution_ids_[id]] = *bundle.at(i);
+                refresh(id);
+            }
+        }
+    }
+
+    inline T sampleNonNormalized(const point_t &p) const
+    {
+        point_t pm;
+        const index_t& i = toBundleIndex(p, pm);
+        return sampleNonNormalized(pm, i);
+    }
+
+    inline T sampleNonNormalized(const point_t &p,
+                                 const index_t &bi) const
+    {
+        if (!valid(bi))
+            return T();
+
+        return sampleNonNormalized(p, getAllocated(bi));
+    }
+
+    inline T sampleNonNormalized(const point_t &p,
+                                 const distribution_bundle_t *bundle) const
+    {
+        auto evaluate = [this, &p, &bundle]() {
+            T retval = T();
+            for (std::size_t i=0; i<bin_count; ++i)
+                retval += div_count * sampleNonNormalized(bundle->id(i), p);
+            return retval;
+        };
+        return bundle ? evaluate() : T();
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p) const
+    {
+        point_t pm;
+        const index_t& i = toBundleIndex(p, pm);
+        return sampleNonNormalizedBilinear(pm, i);
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p,
+                                         const index_t &bi) const
+    {
+        if (!valid(bi))
+            return T();
+
+        const auto& weights = utility::get_bilinear_interpolation_weights(bi,p,bundle_resolution_inv_);
+        return sampleNonNormalizedBilinear(p, weights, getAllocated(bi));
+    }
+
+    inline T sampleNonNormalizedBilinear(const point_t &p,
+                                         const std::array<T,Dim> &weights,
+                                         const distribution_bundle_t *bundle) const
+    {
+        auto evaluate = [this, &p, &weights, &bundle]() {
+            T retval = T();
+            for (std::size_t i=0; i<bin_count; ++i)
+                retval += utility::to_bilinear_interpolation_weight(weights,i) * sampleNonNormalized(bundle->id(i), p);
+            return retval;
+        };
+        return bundle ? evaluate() : T();
+    }
+
+    /**
+     * @brief Sample a whole point set at once, like Map<option_t,Dim,Distribution,T>.
+     */
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      &pose,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        sampleNonNormalized(points, size, &pose, 1ul, scores, gradients);
+    }
+
+    template <typename point_in_t>
+    inline void sampleNonNormalized(const point_in_t  *points,
+                                    const std::size_t  size,
+                                    const pose_t      *poses,
+                                    const std::size_t  num_poses,
+                                    T                 *scores,
+                                    T                 *gradients = nullptr) const
+    {
+        utility::sample_batch<Dim,point_t,index_t>(points, size, poses, num_poses, w_T_m_, scores, gradients,
+                                                   [this](const point_t &p_w, point_t &p_m, index_t &bi) {
+            return toBundleIndex(p_w, p_m, bi);
+        }, [this](const index_t &bi) {
+            return getAllocated(bi);
+        }, [this](const BundleView *bundle, const std::size_t i, mean_t &mean, information_t &information) {
+            const std::size_t id = bundle->id(i);
+            if (counts_[id] == 0ul)
+                return T();
+            mean        = Eigen::Map<const mean_t>(means_.data() + id * Dim);
+            information = Eigen::Map<const information_t>(informations_.data() + id * Dim * Dim);
+            return div_count;
+        });
+    }
+
+    inline const distribution_bundle_t* getDistributionBundle(const index_t &bi) const
+    {
+        return valid(bi) ? getAllocate(bi) : nullptr;
+    }
+
+    inline const distribution_bundle_t* getDistributionBundle(const point_t &p) const
+    {
+        index_t bi;
+        if (!toBundleIndex(p, bi))
+            return nullptr;
+
+        return getAllocate(bi);
+    }
+
+    inline const distribution_bundle_t* get(const point_t &p) const
+    {
+        index_t bi;
+        if (!toBundleIndex(p, bi))
+            return nullptr;
+
+        return getAllocated(bi);
+    }
+
+    inline const distribution_bundle_t* get(const index_t &bi) const
+    {
+        return valid(bi) ? getAllocated(bi) : nullptr;
+    }
+
+    template <typename Fn>
+    inline void traverse(const Fn& function) const
+    {
+        for (std::size_t b=0; b<bundles_.size(); ++b) {
+            if (bundles_[b].allocated_)
+                function(fromBundleId(b), bundles_[b]);
+        }
+    }
+
+    inline void getBundleIndices(std::vector<index_t> &indices) const
+    {
+        auto add_index = [&indices](const index_t &i, const distribution_bundle_t &) {
+            indices.emplace_back(i);
+        };
+        traverse(add_index);
+    }
+
+    inline void getBundles(std::vector<std::pair<const index_t,const distribution_bundle_t*>> &bundles) const
+    {
+        auto add_bundle = [&bundles](const index_t &i, const distribution_bundle_t &b) {
+            bundles.emplace_back(std::pair<const index_t,const distribution_bundle_t*>(i,&b));
+        };
+        traverse(add_bundle);
+    }
+
+    inline virtual bool validate(const pose_2d_t &p_w_2d) const
+    {
+        const point_t p_w = utility::to_point<point_t>(p_w_2d.translation());
+        return valid(toBundleIndex(p_w));
+    }
+
+    inline void allocatePartiallyAllocatedBundle(const index_t& bi, const distribution_bundle_t* bundle) const
+    {
+        static constexpr neighborhood_t grid{};
+
+        if (bundle->expand() && expandBundle(bundle)) {
+            grid.visit([this, &bi](typename neighborhood_t::offset_t o) {
+                index_t ii;
+                utility::for_each<Dim>([&ii,&bi,&o](const std::size_t &i) {
+                    ii[i] = bi[i] + o[i];
+                });
+                if (valid(ii))
+                    getAllocate(ii);
+            });
+            bundle->setExpanded();
+        }
+    }
+
+    inline void allocatePartiallyAllocatedBundles() const
+    {
+        std::vector<std::pair<const index_t,const distribution_bundle_t*>> bis;
+        getBundles(bis);
+
+        for (const auto &pair : bis)
+            allocatePartiallyAllocatedBundle(pair.first, pair.second);
+    }
+
+    inline std::size_t getByteSize() const
+    {
+        return sizeof(*this) +
+                means_.capacity()            * sizeof(T) +
+                informations_.capacity()     * sizeof(T) +
+                counts_.capacity()           * sizeof(std::size_t) +
+                distribution_ids_.capacity() * sizeof(std::size_t) +
+                distributions_.capacity()    * sizeof(distribution_t) +
+                bundles_.capacity()          * sizeof(BundleView);
+    }
+
+protected:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    using distribution_pool_t = std::vector<distribution_t, typename distribution_t::allocator_t>;
+
+    const T                                                    resolution_;
+    const T                                                    bundle_resolution_;
+    const T                                                    bundle_resolution_inv_;
+    const transform_t                                          w_T_m_;
+    const transform_t                                          m_T_w_;
+    const size_t                                               size_;
+    const size_m_t                                             size_m_;
+    const index_t                                              min_bundle_index_;
+    const index_t                                              max_bundle_index_;
+
+    std::array<std::size_t,Dim>                                distribution_strides_;
+    std::array<std::size_t,Dim>                                bundle_strides_;
+    std::array<std::array<std::size_t,bin_count>,bin_count>    bin_offsets_;
+
+    mutable std::vector<T>                                     means_;
+    mutable std::vector<T>                                     informations_;
+    mutable std::vector<std::size_t>                           counts_;             /// zero while not valid
+    mutable std::vector<std::size_t>                           distribution_ids_;   /// position in the pool, npos if not allocated
+    mutable distribution_pool_t                                distributions_;
+    mutable std::vector<BundleView>                            bundles_;
+
+    inline void rebind()
+    {
+        for (BundleView &bundle : bundles_)
+            bundle.map_ = this;
+    }
+
+    inline std::size_t toBundleId(const index_t &bi) const
+    {
+        std::size_t id = 0ul;
+        for (std::size_t d=0; d<Dim; ++d)
+            id += static_cast<std::size_t>(bi[d] - min_bundle_index_[d]) * bundle_strides_[d];
+        return id;
+    }
+
+    inline index_t fromBundleId(std::size_t id) const
+    {
+        index_t bi;
+        for (std::size_t d=Dim; d-- > 0;) {
+            bi[d] = min_bundle_index_[d] + static_cast<int>(id / bundle_strides_[d]);
+            id %= bundle_strides_[d];
+        }
+        return bi;
+    }
+
+    /**
+     * @brief Lower corner bi-1 of a bundle in the distribution lattice, which starts at min_bundle_index-1.
+     */
+    inline std::size_t toDistributionId(const index_t &bi) const
+    {
+        std::size_t id = 0ul;
+        for (std::size_t d=0; d<Dim; ++d)
+            id += static_cast<std::size_t>(bi[d] - min_bundle_index_[d]) * distribution_strides_[d];
+        return id;
+    }
+
+    inline const BundleView* getAllocated(const index_t &bi) const
+    {
+        const BundleView &bundle = bundles_[toBundleId(bi)];
+        return bundle.allocated_ ? &bundle : nullptr;
+    }
+
+    inline const BundleView* getAllocate(const index_t &bi) const
+    {
+        BundleView &bundle = bundles_[toBundleId(bi)];
+        if (bundle.allocated_)
+            return &bundle;
+
+        for (std::size_t i=0; i<bin_count; ++i) {
+            std::size_t &pos = distribution_ids_[bundle.id(i)];
+            if (pos == npos) {
+                pos = distributions_.size();
+                distributions_.emplace_back();
+            }
+        }
+        bundle.allocated_ = true;
+        return &bundle;
+    }
+
+    inline void refresh(const std::size_t id) const
+    {
+        const distribution_t &d = distributions_[distribution_ids_[id]];
+        Eigen::Map<mean_t>(means_.data() + id * Dim) = d.getMean();
+        if (d.valid()) {
+            Eigen::Map<information_t>(informations_.data() + id * Dim * Dim) = d.getInformationMatrix();
+            counts_[id] = d.getN();
+        } else {
+            counts_[id] = 0ul;
+        }
+    }
+
+    inline T sampleNonNormalized(const std::size_t id,
+                                 const point_t &p) const
+    {
+        if (counts_[id] == 0ul)
+            return T();
+
+        const mean_t q = p.data() - Eigen::Map<const mean_t>(means_.data() + id * Dim);
+        const T exponent = -0.5 * static_cast<T>(q.transpose() * Eigen::Map<const information_t>(informations_.data() + id * Dim * Dim) * q);
+        return std::exp(exponent);
+    }
+
+    inline bool expandBundle(const distribution_bundle_t *bundle) const
+    {
+        if (!bundle)
+            return false;
+        for (std::size_t i=0; i<bin_count; ++i)
+            if (counts_[bundle->id(i)] > 0ul)
+                return true;
+        return false;
+    }
+
+    inline bool valid(const index_t &index) const
+    {
+        for (std::size_t i=0; i<Dim; ++i)
+            if (index[i] < min_bundle_index_[i] || index[i] >= max_bundle_index_[i])
+                return false;
+        return true;
+    }
+
+    inline index_t toBundleIndex(const point_t &p_w,
+                                 point_t &p_m) const
+    {
+        p_m = m_T_w_ * p_w;
+        return utility::to_index<Dim>([this,&p_m](const std::size_t& i) {
+            return static_cast<int>(std::floor(p_m(i) * bundle_resolution_inv_));
+        });
+    }
+
+    inline index_t toBundleIndex(const point_t &p_w) const
+    {
+        point_t p_m;
+        return toBundleIndex(p_w, p_m);
+    }
+
+    inline bool toBundleIndex(const point_t &p_w,
+                              index_t &index) const
+    {
+        index = toBundleIndex(p_w);
+        return valid(index);
+    }
+
+    inline bool toBundleIndex(const point_t &p_w,
+                              point_t &p_m,
+                              index_t &index) const
+    {
+        index = toBundleIndex(p_w, p_m);
+        return valid(index);
+    }
+};
+
+template <std::size_t Dim, typename T>
+constexpr std::size_t Map<tags::static_map,Dim,Distribution,T,backend::SoA>::npos;
+}
+}
+
+#endif // CSLIBS_NDT_MAP_SOA_GRIDMAP_HPP
@@ -210,7 +210,7 @@ public:
         if (!this->valid(bi))
             return T();
 
-        distribution_bundle_t *bundle = this->bundle_storage_->get(bi);
+        const distribution_bundle_t *bundle = this->bundles().get(bi);
         return sample(p, bundle, ivm);
     }
 
@@ -256,7 +256,7 @@ public:
         if (!this->valid(bi))
             return T();
 
-        distribution_bundle_t *bundle = this->bundle_storage_->get(bi);
+        const distribution_bundle_t *bundle = this->bundles().get(bi);
         return sampleNonNormalized(p, bundle, ivm);
     }
 
@@ -302,7 +302,7 @@ public:
         if (!this->valid(bi))
             return T();
 
-        distribution_bundle_t *bundle  = this->bundle_storage_->get(bi);
+        const distribution_bundle_t *bundle  = this->bundles().get(bi);
         const auto& weights = utility::get_bilinear_interpolation_weights(bi,p,this->bundle_resolution_inv_);
         return sampleNonNormalizedBilinear(p, weights, bundle, ivm);
     }
@@ -343,6 +343,7 @@ protected:
                            const T       &w) const
     {
         distribution_bundle_t *bundle = this->getAllocate(bi);
+        this->markChanged(bi);
         for (std::size_t i=0; i<this->bin_count; ++i)
             bundle->at(i)->updateFree(w);
     }
@@ -351,6 +352,7 @@ protected:
                                const typename distribution_t::distribution_t &d) const
     {
         distribution_bundle_t *bundle = this->getAllocate(bi);
+        this->markChanged(bi);
         for (std::size_t i=0; i<this->bin_count; ++i)
             bundle->at(i)->updateOccupied(d);
     }
@@ -0,0 +1,163 @@
+#ifndef CSLIBS_NDT_MAP_LIKELIHOOD_HPP
+#define CSLIBS_NDT_MAP_LIKELIHOOD_HPP
+
+#include <cslibs_ndt/map/read_view.hpp>
+#include <cslibs_ndt/utility/parallel.hpp>
+#include <cslibs_ndt/utility/bilinear_interpolation.hpp>
+
+#include <Eigen/StdVector>
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+namespace cslibs_ndt {
+namespace map {
+/**
+ * @brief Point model of the batched likelihood, each point contributes
+ *        log(hit * score + random), where score is sampleNonNormalized or
+ *        sampleNonNormalizedBilinear at the transformed point. The uniform part keeps
+ *        points the map does not explain from dominating the sum.
+ */
+struct LikelihoodModel
+{
+    double      hit        = 1.0;
+    double      random     = 1e-3;
+    bool        bilinear   = false;
+    std::size_t block_size = 1ul << 18;     // (particle, point) pairs sorted at once per thread
+};
+
+/**
+ * @brief Measurement model of a particle filter, the log-likelihoods of one point set for
+ *        many particle poses. Threads take contiguous blocks of particles, transform the points
+ *        of a whole block into the map frame and sort them by bundle index, so that every bundle
+ *        is looked up once per block and its distributions stay in cache for all particles
+ *        hitting it. Non-finite points are dropped. The map is only read, from several threads,
+ *        so it has to be settled once when it is handed over, see settle, e.g. by passing
+ *        ReadView::map(), a frozen map or a map settled after its last update. Unless num_threads
+ *        is 1, sampling an unsettled map fills its cached matrices concurrently.
+ * @param map         settled distribution or occupancy map
+ * @param points      the measurement, in the frame of the particle poses
+ * @param poses       one pose per particle
+ * @param model       point model, see LikelihoodModel
+ * @param num_threads 0 uses all hardware threads
+ * @param args        additional map arguments, i.e. the inverse sensor model for occupancy maps
+ * @return one log-likelihood per pose, in the order of the poses
+ */
+template <typename map_t, typename points_t, typename ... args_t>
+inline std::vector<double> logLikelihoods(const map_t                                   &map,
+                                          const points_t                                &points,
+                                          const std::vector<typename map_t::pose_t>     &poses,
+                                          const LikelihoodModel                         &model,
+                                          const std::size_t                              num_threads,
+                                          const args_t                                  &...args)
+{
+    using T          = typename std::decay<decltype(map.getBundleResolution())>::type;
+    using index_t    = typename map_t::index_t;
+    using pose_t     = typename map_t::pose_t;
+    using point_t    = typename map_t::point_t;
+    using points_m_t = std::vector<point_t, Eigen::aligned_allocator<point_t>>;
+    static constexpr std::size_t Dim = std::tuple_size<index_t>::value;
+
+    std::vector<double> log_likelihoods(poses.size(), 0.0);
+
+    /// step one: finite points, once for all particles
+    points_m_t data;
+    for (const auto &p : points) {
+        bool finite = true;
+        for (std::size_t k = 0 ; k < Dim ; ++k)
+            finite &= std::isfinite(static_cast<double>(p(k)));
+        if (finite)
+            data.emplace_back(p);
+    }
+    if (data.empty() || poses.empty())
+        return log_likelihoods;
+
+    const pose_t      m_T_w   = map.getInitialOrigin().inverse();
+    const T           res_inv = T(1.0) / map.getBundleResolution();
+    const std::size_t size    = data.size();
+    const std::size_t block   = std::max<std::size_t>(1ul, model.block_size / size);
+    const std::size_t threads = num_threads > 0ul ?
+                std::min(num_threads, poses.size()) : utility::num_threads(poses.size());
+
+    auto log_likelihood = [&model](const double score) {
+        return std::log(model.hit * score + model.random);
+    };
+
+    /// step two: packed Gaussian terms, the map bins the points of all particles in a block by bundle
+    auto batch = [&](const std::size_t first, const std::size_t last, std::vector<T> &scores) {
+        scores.resize((last - first) * size);
+        map.sampleNonNormalized(data.data(), size, &poses[first], last - first, args..., scores.data());
+        for (std::size_t j = 0 ; j < scores.size() ; ++j)
+            log_likelihoods[first + j / size] += log_likelihood(static_cast<double>(scores[j]));
+    };
+
+    /// step two, bilinear: same binning, one lookup per bundle and interpolated per point
+    auto bilinear = [&](const std::size_t first, const std::size_t last,
+                        points_m_t &points_m, std::vector<std::pair<index_t, std::size_t>> &order) {
+        const std::size_t count = (last - first) * size;
+        points_m.resize(count);
+        order.resize(count);
+        for (std::size_t k = first ; k < last ; ++k) {
+            const pose_t      m_T_p  = m_T_w * poses[k];
+            const std::size_t offset = (k - first) * size;
+            for (std::size_t i = 0 ; i < size ; ++i) {
+                point_t &p_m = points_m[offset + i];
+                p_m = m_T_p * data[i];
+                order[offset + i].second = offset + i;
+                for (std::size_t d = 0 ; d < Dim ; ++d)
+                    order[offset + i].first[d] = static_cast<int>(std::floor(p_m(d) * res_inv));
+            }
+        }
+        std::sort(order.begin(), order.end());
+
+        for (std::size_t b = 0, e = 0 ; b < count ; b = e) {
+            const index_t &bi = order[b].first;
+            for (e = b + 1 ; e < count && order[e].first == bi ; ++e);
+
+            const auto *bundle = map.get(bi);
+            for (std::size_t j = b ; j < e ; ++j) {
+                const point_t     &p_m = points_m[order[j].second];
+                const std::size_t  k   = first + order[j].second / size;
+                if (!bundle) {
+                    log_likelihoods[k] += log_likelihood(0.0);
+                    continue;
+                }
+                const std::array<T,Dim> weights = utility::get_bilinear_interpolation_weights(bi, p_m, res_inv);
+                log_likelihoods[k] += log_likelihood(static_cast<double>(
+                                          map.sampleNonNormalizedBilinear(p_m, weights, bundle, args...)));
+            }
+        }
+    };
+
+    /// step three: contiguous blocks of particles per thread, sums only go to owned particles
+    utility::parallel_for(poses.size(), threads, [&](const std::size_t, const std::size_t begin, const std::size_t end) {
+        std::vector<T>                               scores;
+        points_m_t                                   points_m;
+        std::vector<std::pair<index_t, std::size_t>> order;
+        for (std::size_t first = begin ; first < end ; first += block) {
+            const std::size_t last = std::min(end, first + block);
+            if (model.bilinear)
+                bilinear(first, last, points_m, order);
+            else
+                batch(first, last, scores);
+        }
+    });
+
+    return log_likelihoods;
+}
+
+template <typename map_t, typename points_t>
+inline std::vector<double> logLikelihoods(const map_t                                   &map,
+                                          const points_t                                &points,
+                                          const std::vector<typename map_t::pose_t>     &poses)
+{
+    return logLikelihoods(map, points, poses, LikelihoodModel(), 0ul);
+}
+}
+}
+
+#endif // CSLIBS_NDT_MAP_LIKELIHOOD_HPP
@@ -20,5 +20,7 @@ class EIGEN_ALIGN16 Map : public GenericMap<option_t,Dim,data_t,T,backend_t> {};
 #include <cslibs_ndt/map/impl/gridmap.hpp>
 #include <cslibs_ndt/map/impl/occupancy_gridmap.hpp>
 #include <cslibs_ndt/map/impl/weighted_occupancy_gridmap.hpp>
+#include <cslibs_ndt/map/impl/soa_gridmap.hpp>
+#include <cslibs_ndt/map/impl/frozen_gridmap.hpp>
 
 #endif // CSLIBS_NDT_MAP_MAP_HPP
@@ -0,0 +1,215 @@
+#ifndef CSLIBS_NDT_MAP_PYRAMID_HPP
+#define CSLIBS_NDT_MAP_PYRAMID_HPP
+
+#include <cslibs_ndt/map/map.hpp>
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+namespace cslibs_ndt {
+namespace map {
+namespace impl {
+/**
+ * @brief Keeps the levels of a pyramid up to date, in general by inserting the same
+ *        scans into every level, which also gives every level its own ray casting.
+ */
+template <typename map_t>
+struct PyramidUpdate
+{
+    using map_ptr_t = typename map_t::Ptr;
+
+    template <typename ... args_t>
+    static inline void insert(const std::vector<map_ptr_t> &levels,
+                              const args_t &...args)
+    {
+        for (const map_ptr_t &level : levels)
+            level->insert(args...);
+    }
+};
+
+/**
+ * @brief Distribution maps are merged: the distribution with index j of the first storage
+ *        of a level covers exactly the bundle with index j of the next coarser level,
+ *        and a coarse bundle receives the sum of these like it would receive the points.
+ *        Coarse levels are written through Gridmap::update, so they track changes like the base.
+ */
+template <std::size_t Dim,
+          typename T,
+          template <typename, typename, typename...> class backend_t>
+struct PyramidUpdate<Map<tags::dynamic_map,Dim,Distribution,T,backend_t>>
+{
+    using map_t      = Map<tags::dynamic_map,Dim,Distribution,T,backend_t>;
+    using map_ptr_t  = typename map_t::Ptr;
+    using index_t    = typename map_t::index_t;
+    using pose_t     = typename map_t::pose_t;
+    using point_t    = typename map_t::point_t;
+    using dist_t     = typename map_t::distribution_t::distribution_t;
+    using updates_t  = std::map<index_t, dist_t, std::less<index_t>,
+                                Eigen::aligned_allocator<std::pair<const index_t, dist_t>>>;
+
+    /**
+     * @brief Only the base level sees the points, coarser levels receive the per bundle
+     *        statistics, which are merged from level to level.
+     */
+    template <typename iterator_t>
+    static inline void insert(const std::vector<map_ptr_t> &levels,
+                              const iterator_t             &points_begin,
+                              const iterator_t             &points_end,
+                              const pose_t                 &points_origin = pose_t(),
+                              const tags::insert_option     insert_option = tags::serial_insert)
+    {
+        levels.front()->insert(points_begin, points_end, points_origin, insert_option);
+        if (levels.size() < 2ul)
+            return;
+
+        /// step one: aggregate the points per bundle of the first coarse level
+        const pose_t m_T_w = levels.front()->getInitialOrigin().inverse();
+        const T resolution_inv = 1.0 / levels[1]->getBundleResolution();
+        updates_t updates;
+        for (auto p = points_begin ; p != points_end ; ++p) {
+            const point_t pw = points_origin * *p;
+            if (pw.isNormal()) {
+                const point_t pm = m_T_w * pw;
+                updates[utility::to_index<Dim>([&pm, resolution_inv](const std::size_t &i) {
+                    return static_cast<int>(std::floor(pm(i) * resolution_inv));
+                })] += pm;
+            }
+        }
+
+        /// step two: apply and coarsen level by level
+        for (std::size_t l = 1 ; l < levels.size() ; ++l) {
+            for (const auto &pair : updates)
+                levels[l]->update(pair.first, pair.second);
+            updates = coarsen(updates);
+        }
+    }
+
+    static inline void insert(const std::vector<map_ptr_t>                 &levels,
+                              const typename map_t::pointcloud_t::ConstPtr &points,
+                              const pose_t                                 &points_origin = pose_t(),
+                              const tags::insert_option                     insert_option = tags::serial_insert)
+    {
+        insert(levels, points->begin(), points->end(), points_origin, insert_option);
+    }
+
+    /**
+     * @brief Rebuild coarse from fine, coarse is expected to be empty.
+     */
+    static inline void merge(const map_t &fine,
+                             map_t       &coarse)
+    {
+        fine.getStorages()[0]->traverse([&coarse](const index_t &j, const typename map_t::distribution_t &d) {
+            if (d.getN() > 0)
+                coarse.update(j, d);
+        });
+    }
+
+private:
+    static inline updates_t coarsen(const updates_t &updates)
+    {
+        updates_t coarse;
+        for (const auto &pair : updates) {
+            const index_t &bi = pair.first;
+            coarse[utility::to_index<Dim>([&bi](const std::size_t &i) {
+                return bi[i] >> 1;
+            })] += pair.second;
+        }
+        return coarse;
+    }
+};
+}
+
+/**
+ * @brief Maps of the same area at decreasing resolution for coarse-to-fine matching.
+ *        Level 0 is the base map, level l has 2^l times its resolution, all levels share
+ *        the initial origin of the base. Only dynamic maps can be used as levels.
+ *        Scans inserted through the pyramid update all levels incrementally.
+ */
+template <typename map_t>
+class Pyramid
+{
+public:
+    using Ptr       = std::shared_ptr<Pyramid<map_t>>;
+    using ConstPtr  = std::shared_ptr<const Pyramid<map_t>>;
+
+    using map_ptr_t = typename map_t::Ptr;
+    using pose_t    = typename map_t::pose_t;
+    using update_t  = impl::PyramidUpdate<map_t>;
+
+    /**
+     * @brief Empty pyramid, filled by insert.
+     * @param origin     initial origin of all levels
+     * @param resolution resolution of the base level
+     * @param levels     number of levels including the base
+     */
+    template <typename T>
+    inline Pyramid(const pose_t      &origin,
+                   const T            resolution,
+                   const std::size_t  levels)
+    {
+        if (levels == 0ul)
+            throw std::runtime_error("[Pyramid]: at least one level required");
+
+        T r = resolution;
+        for (std::size_t l = 0 ; l < levels ; ++l, r *= 2)
+            levels_.emplace_back(new map_t(origin, r));
+    }
+
+    /**
+     * @brief Pyramid over an existing map, coarser levels are merged from the base.
+     *        Only available for Distribution maps. The base is shared, not copied.
+     */
+    inline Pyramid(const map_ptr_t    &base,
+                   const std::size_t   levels)
+    {
+        if (!base)
+            throw std::runtime_error("[Pyramid]: base map not set");
+        if (levels == 0ul)
+            throw std::runtime_error("[Pyramid]: at least one level required");
+
+        levels_.emplace_back(base);
+        for (std::size_t l = 1 ; l < levels ; ++l) {
+            levels_.emplace_back(new map_t(base->getInitialOrigin(), 2 * levels_.back()->getResolution()));
+            update_t::merge(*levels_[l - 1], *levels_[l]);
+        }
+    }
+
+    inline std::size_t levels() const
+    {
+        return levels_.size();
+    }
+
+    inline const map_ptr_t& at(const std::size_t level) const
+    {
+        return levels_.at(level);
+    }
+
+    inline const map_ptr_t& base() const
+    {
+        return levels_.front();
+    }
+
+    inline const map_ptr_t& coarsest() const
+    {
+        return levels_.back();
+    }
+
+    /**
+     * @brief Insert a scan into all levels, takes the arguments of the insert of the base map.
+     *        Levels must not be modified other than through the pyramid to stay consistent.
+     */
+    template <typename ... args_t>
+    inline void insert(const args_t &...args)
+    {
+        update_t::insert(levels_, args...);
+    }
+
+private:
+    std::vector<map_ptr_t> levels_;
+};
+}
+}
+
+#endif // CSLIBS_NDT_MAP_PYRAMID_HPP
@@ -0,0 +1,202 @@
+#ifndef CSLIBS_NDT_MAP_READ_VIEW_HPP
+#define CSLIBS_NDT_MAP_READ_VIEW_HPP
+
+#include <cslibs_ndt/utility/parallel.hpp>
+
+#include <memory>
+#include <utility>
+#include <algorithm>
+
+namespace cslibs_ndt {
+namespace map {
+namespace detail {
+/**
+ * @brief Computes the lazily cached covariance and information matrix of a distribution,
+ *        occupancy distributions keep their Gaussian behind getDistribution().
+ */
+template <typename distribution_t>
+inline auto settle(const distribution_t &d, int) -> decltype(d.getDistribution(), void())
+{
+    if (d.getDistribution())
+        d.getDistribution()->getInformationMatrix();
+}
+
+template <typename distribution_t>
+inline void settle(const distribution_t &d, long)
+{
+    d.getInformationMatrix();
+}
+
+template <typename map_t>
+inline auto settleMap(const map_t &map, const std::size_t num_threads, int) -> decltype(map.getStorages(), void())
+{
+    using index_t        = typename map_t::index_t;
+    using distribution_t = typename map_t::distribution_t;
+
+    const auto storages = map.getStorages();
+    const std::size_t threads = num_threads > 0ul ?
+                std::min(num_threads, storages.size()) : utility::num_threads(storages.size());
+
+    // every distribution lives in exactly one storage, threads never share one
+    utility::parallel_for(storages.size(), threads, [&storages](const std::size_t, const std::size_t begin, const std::size_t end) {
+        for (std::size_t i = begin ; i < end ; ++i)
+            storages[i]->traverse([](const index_t &, const distribution_t &d) {
+                settle(d, 0);
+            });
+    });
+}
+
+template <typename map_t>
+inline void settleMap(const map_t &, const std::size_t, long)
+{
+}
+
+template <typename map_t, typename iterator_t>
+inline auto settleBundles(const map_t &map, const iterator_t &bundles_begin, const iterator_t &bundles_end, int)
+    -> decltype(map.getStorages(), void())
+{
+    for (iterator_t it = bundles_begin ; it != bundles_end ; ++it) {
+        if (const auto *bundle = map.get(*it)) {
+            for (std::size_t i = 0 ; i < map_t::bin_count ; ++i) {
+                if (bundle->at(i))
+                    settle(*bundle->at(i), 0);
+            }
+        }
+    }
+}
+
+template <typename map_t, typename iterator_t>
+inline void settleBundles(const map_t &, const iterator_t &, const iterator_t &, long)
+{
+}
+}
+
+/**
+ * @brief Fills the lazily cached covariance and information matrix of all distributions of a map,
+ *        afterwards sampling it only reads and it may be sampled from any number of threads.
+ *        Call it while no one else reads or writes the map. Maps without getStorages(), i.e. the
+ *        frozen and SoA maps or a ReadView, sample precomputed values and are left untouched.
+ * @param num_threads 0 uses all hardware threads
+ */
+template <typename map_t>
+inline void settle(const map_t &map,
+                   const std::size_t num_threads = 0ul)
+{
+    detail::settleMap(map, num_threads, 0);
+}
+
+/**
+ * @brief Settles the distributions of the bundles in [bundles_begin, bundles_end) only, e.g. of the
+ *        changes handed out by AbstractMap::consumeChanges, which keeps a settled map settled after
+ *        an update at the cost of the update. Bundles which are not allocated are skipped.
+ */
+template <typename map_t, typename iterator_t>
+inline void settle(const map_t      &map,
+                   const iterator_t &bundles_begin,
+                   const iterator_t &bundles_end)
+{
+    detail::settleBundles(map, bundles_begin, bundles_end, 0);
+}
+
+/**
+ * @brief Query interface of a map for any number of concurrent readers, e.g. several matcher
+ *        threads. All of its functions are non-allocating and never write to the map.
+ *        The const accessors of the map itself are not all read-only: getDistributionBundle
+ *        and allocatePartiallyAllocatedBundles allocate missing bundles, and sampling a
+ *        distribution for the first time after an update fills in its cached information
+ *        matrix. The view does the latter once for all distributions on construction, so
+ *        construct it while no one else reads or writes the map, and do not write to the map
+ *        afterwards. A copy-on-write snapshot shares its blocks with the map it was taken from,
+ *        so the writer of that map counts as well: either pause it while the view is constructed,
+ *        or settle on the writer's side. map::snapshot does the latter, the view of a fresh
+ *        snapshot then only reads and the writer may go on.
+ *        get, sampleNonNormalized, sampleNonNormalizedBilinear and traverse take the same
+ *        arguments as on the map. The matchers only use these, so map() can be passed to them.
+ */
+template <typename map_t>
+class ReadView
+{
+public:
+    using Ptr      = std::shared_ptr<ReadView<map_t>>;
+    using ConstPtr = std::shared_ptr<const ReadView<map_t>>;
+
+    using map_ptr_t             = typename map_t::ConstPtr;
+    using index_t               = typename map_t::index_t;
+    using point_t               = typename map_t::point_t;
+    using pose_t                = typename map_t::pose_t;
+    using distribution_t        = typename map_t::distribution_t;
+    using distribution_bundle_t = typename map_t::distribution_bundle_t;
+
+    /**
+     * @param map         map to read, kept alive by the view
+     * @param num_threads threads settling the distributions, 0 uses all hardware threads
+     */
+    inline explicit ReadView(const map_ptr_t &map,
+                             const std::size_t num_threads = 0ul) :
+        map_(map)
+    {
+        settle(*map_, num_threads);
+    }
+
+    inline const map_t& map() const
+    {
+        return *map_;
+    }
+
+    inline const map_ptr_t& mapPtr() const
+    {
+        return map_;
+    }
+
+    inline const distribution_bundle_t* get(const point_t &p) const
+    {
+        return map_->get(p);
+    }
+
+    inline const distribution_bundle_t* get(const index_t &bi) const
+    {
+        return map_->get(bi);
+    }
+
+    template <typename ... args_t>
+    inline auto sampleNonNormalized(args_t &&...args) const
+        -> decltype(std::declval<const map_t&>().sampleNonNormalized(std::forward<args_t>(args)...))
+    {
+        return map_->sampleNonNormalized(std::forward<args_t>(args)...);
+    }
+
+    template <typename ... args_t>
+    inline auto sampleNonNormalizedBilinear(args_t &&...args) const
+        -> decltype(std::declval<const map_t&>().sampleNonNormalizedBilinear(std::forward<args_t>(args)...))
+    {
+        return map_->sampleNonNormalizedBilinear(std::forward<args_t>(args)...);
+    }
+
+    /**
+     * @brief Visit all bundles as function(index, bundle), the bundle is read-only.
+     */
+    template <typename Fn>
+    inline void traverse(const Fn &function) const
+    {
+        map_->traverse([&function](const index_t &bi, const distribution_bundle_t &bundle) {
+            function(bi, bundle);
+        });
+    }
+
+private:
+    map_ptr_t map_;
+};
+
+/**
+ * @brief Read-only view of a map for concurrent readers, see ReadView.
+ */
+template <typename map_t>
+inline typename ReadView<map_t>::ConstPtr readView(const std::shared_ptr<const map_t> &map,
+                                                   const std::size_t num_threads = 0ul)
+{
+    return typename ReadView<map_t>::ConstPtr(new ReadView<map_t>(map, num_threads));
+}
+}
+}
+
+#endif // CSLIBS_NDT_MAP_READ_VIEW_HPP
@@ -0,0 +1,54 @@
+#ifndef CSLIBS_NDT_MAP_SNAPSHOT_HPP
+#define CSLIBS_NDT_MAP_SNAPSHOT_HPP
+
+#include <cslibs_ndt/map/map.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+
+namespace cslibs_ndt {
+namespace map {
+namespace detail {
+template <typename map_t>
+inline auto settleSnapshot(const map_t &map, const std::size_t num_threads, int)
+    -> decltype(map.consumeUnsettled(std::declval<std::vector<typename map_t::index_t>&>()), void())
+{
+    std::vector<typename map_t::index_t> unsettled;
+    if (map.consumeUnsettled(unsettled))
+        cslibs_ndt::map::settle(map, unsettled.begin(), unsettled.end());
+    else
+        cslibs_ndt::map::settle(map, num_threads);
+}
+
+template <typename map_t>
+inline void settleSnapshot(const map_t &map, const std::size_t num_threads, long)
+{
+    cslibs_ndt::map::settle(map, num_threads);
+}
+}
+
+/**
+ * @brief Consistent view of a map which keeps being written to, e.g. handed from a mapping
+ *        to a localization thread. Maps with the backend::CopyOnWrite backend, e.g.
+ *        Map<tags::dynamic_map,3,Distribution,double,backend::CopyOnWrite>, share all storage
+ *        blocks with the snapshot, and the writer copies a block the first time it changes it.
+ *        Other backends fall back to a deep copy, as do decaying occupancy maps, whose snapshot
+ *        points all distributions to a copy of the clock.
+ *        The distributions of the map are settled first, see settle, so readers of the snapshot
+ *        never fill lazily cached matrices in blocks the writer may be copying meanwhile.
+ *        The first snapshot of a map settles all of it, later ones only the bundles updated
+ *        since the previous snapshot, see AbstractMap::consumeUnsettled, so snapshotting an
+ *        unchanged map costs the copy only.
+ *        The snapshot is a regular map of the same type and may be read concurrently with
+ *        writes to the source, taking it must not overlap with writes to the source.
+ * @param num_threads threads settling the map, 0 uses all hardware threads
+ */
+template <typename map_t>
+inline typename map_t::ConstPtr snapshot(const map_t &map,
+                                         const std::size_t num_threads = 0ul)
+{
+    detail::settleSnapshot(map, num_threads, 0);
+    return typename map_t::ConstPtr(new map_t(map));
+}
+}
+}
+
+#endif // CSLIBS_NDT_MAP_SNAPSHOT_HPP
@@ -15,6 +15,9 @@
 
 #include <cslibs_indexed_storage/backends.hpp>
 #include <cslibs_ndt/backend/octree.hpp>
+#include <cslibs_ndt/backend/block_hash.hpp>
+#include <cslibs_ndt/backend/copy_on_write.hpp>
+#include <cslibs_ndt/backend/rolling_window.hpp>
 namespace cis = cslibs_indexed_storage;
 
 namespace cslibs_ndt {
@@ -22,6 +25,7 @@ namespace map {
 
 namespace tags {
 enum option { static_map, dynamic_map };
+enum insert_option { serial_insert, parallel_insert };
 
 template <option o>
 struct default_types;
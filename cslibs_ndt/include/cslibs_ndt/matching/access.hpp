@@ -0,0 +1,73 @@
+#ifndef CSLIBS_NDT_MATCHING_ACCESS_HPP
+#define CSLIBS_NDT_MATCHING_ACCESS_HPP
+
+#include <cslibs_ndt/map/map.hpp>
+
+#include <stdexcept>
+
+namespace cslibs_ndt {
+namespace matching {
+
+/**
+ * @brief Access to the Gaussian terms of one distribution of a map:
+ *        operator()(d, fn) calls fn(distribution, weight) for every usable distribution,
+ *        the weight is the one sampleNonNormalized applies.
+ */
+template <typename ndt_t>
+class Access;
+
+template <cslibs_ndt::map::tags::option option_t,
+          std::size_t Dim,
+          typename _T,
+          template <typename, typename, typename...> class backend_t>
+class Access<cslibs_ndt::map::Map<option_t,Dim,cslibs_ndt::Distribution,_T,backend_t>>
+{
+public:
+    using ndt_t = cslibs_ndt::map::Map<option_t,Dim,cslibs_ndt::Distribution,_T,backend_t>;
+
+    inline explicit Access(const ndt_t &)
+    {
+    }
+
+    template <typename Fn>
+    inline void operator()(const typename ndt_t::distribution_t *d, const Fn &fn) const
+    {
+        if (d && d->valid())
+            fn(*d, static_cast<double>(ndt_t::div_count));
+    }
+};
+
+template <cslibs_ndt::map::tags::option option_t,
+          std::size_t Dim,
+          typename _T,
+          template <typename, typename, typename...> class backend_t>
+class Access<cslibs_ndt::map::Map<option_t,Dim,cslibs_ndt::OccupancyDistribution,_T,backend_t>>
+{
+public:
+    using ndt_t = cslibs_ndt::map::Map<option_t,Dim,cslibs_ndt::OccupancyDistribution,_T,backend_t>;
+    using ivm_t = typename ndt_t::inverse_sensor_model_t;
+
+    inline Access(const ndt_t &,
+                  const typename ivm_t::Ptr &ivm) :
+        ivm_(ivm)
+    {
+        if (!ivm_)
+            throw std::runtime_error("[Access]: inverse model not set");
+    }
+
+    template <typename Fn>
+    inline void operator()(const typename ndt_t::distribution_t *d, const Fn &fn) const
+    {
+        if (d && d->getDistribution() && d->getDistribution()->valid())
+            fn(*d->getDistribution(),
+               static_cast<double>(ndt_t::div_count * d->getOccupancy(ivm_)));
+    }
+
+private:
+    const typename ivm_t::Ptr ivm_;
+};
+
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_ACCESS_HPP
@@ -0,0 +1,205 @@
+#ifndef CSLIBS_NDT_MATCHING_BRANCH_AND_BOUND_GRIDS_HPP
+#define CSLIBS_NDT_MATCHING_BRANCH_AND_BOUND_GRIDS_HPP
+
+#include <Eigen/Core>
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace branch_and_bound {
+
+/**
+ * @brief Stack of precomputed max-pooled score grids (Hess et al., "Real-Time Loop Closure
+ *        in 2D LIDAR SLAM", 2016). Level 0 holds the map score per cell, level h at cell (u, v)
+ *        holds the maximum of level 0 over [u, u + 2^h) x [v, v + 2^h). Only the first two axes
+ *        are pooled, a third axis is kept as is, which makes 3D grids searchable in x, y and yaw.
+ *        Cells outside of the grid score 0.
+ */
+template <std::size_t Dim>
+class Grids
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    using Ptr           = std::shared_ptr<Grids<Dim>>;
+    using ConstPtr      = std::shared_ptr<const Grids<Dim>>;
+    using index_t       = std::array<int, Dim>;
+    using rotation_t    = Eigen::Matrix<double,Dim,Dim>;
+    using translation_t = Eigen::Matrix<double,Dim,1>;
+
+    /**
+     * @brief Build all levels from the level 0 scores.
+     * @param rotation    world <- grid rotation
+     * @param translation world <- grid translation, cell i covers [i, i + 1) * resolution in the grid frame
+     * @param resolution  cell size
+     * @param size        number of cells per axis
+     * @param levels      number of levels, at least one
+     * @param score       score(index) of a level 0 cell, expected to be non-negative
+     */
+    template <typename Fn>
+    inline Grids(const rotation_t    &rotation,
+                 const translation_t &translation,
+                 const double         resolution,
+                 const index_t       &size,
+                 const std::size_t    levels,
+                 const Fn            &score) :
+        resolution_(resolution),
+        size_(size),
+        rotation_(rotation),
+        translation_(translation)
+    {
+        if (levels == 0ul)
+            throw std::runtime_error("[Grids]: at least one level is required");
+        if (resolution <= 0.0)
+            throw std::runtime_error("[Grids]: resolution must be positive");
+
+        /// step one: level 0 from the scores
+        levels_.resize(levels);
+        allocate(0ul);
+        index_t i;
+        for (std::size_t c = 0 ; c < levels_[0].data.size() ; ++c) {
+            std::size_t rest = c;
+            for (std::size_t k = 0 ; k < Dim ; ++k) {
+                i[k]  = static_cast<int>(rest % static_cast<std::size_t>(size_[k]));
+                rest /= static_cast<std::size_t>(size_[k]);
+            }
+            levels_[0].data[c] = static_cast<float>(std::max(0.0, static_cast<double>(score(i))));
+        }
+
+        /// step two: level h pools two cells of level h - 1 per axis, i.e. windows of 2^h cells
+        for (std::size_t h = 1 ; h < levels ; ++h)
+            pool(h);
+    }
+
+    inline std::size_t levels() const
+    {
+        return levels_.size();
+    }
+
+    inline double getResolution() const
+    {
+        return resolution_;
+    }
+
+    inline const index_t& getSize() const
+    {
+        return size_;
+    }
+
+    /**
+     * @brief world <- grid rotation.
+     */
+    inline const rotation_t& rotation() const
+    {
+        return rotation_;
+    }
+
+    /**
+     * @brief world <- grid translation.
+     */
+    inline const translation_t& translation() const
+    {
+        return translation_;
+    }
+
+    /**
+     * @brief Pooled score of the window of level h starting at cell i, 0 outside the grid.
+     */
+    inline float at(const std::size_t h, const index_t &i) const
+    {
+        return at(levels_[h], i);
+    }
+
+private:
+    /**
+     * @brief Cells of one level, cell i is stored at i + offset.
+     */
+    struct Level
+    {
+        index_t            size;
+        index_t            offset;
+        std::vector<float> data;
+    };
+
+    inline static bool pooled(const std::size_t k)
+    {
+        return k < 2ul;
+    }
+
+    inline void allocate(const std::size_t h)
+    {
+        Level &level = levels_[h];
+        std::size_t cells = 1ul;
+        for (std::size_t k = 0 ; k < Dim ; ++k) {
+            const int w = pooled(k) ? (1 << h) - 1 : 0;
+            level.size[k]   = size_[k] + w;
+            level.offset[k] = w;
+            cells *= static_cast<std::size_t>(level.size[k]);
+        }
+        level.data.assign(cells, 0.0f);
+    }
+
+    inline void pool(const std::size_t h)
+    {
+        const int half = 1 << (h - 1);
+        allocate(h);
+
+        /// max of the windows starting at i and at i + half along x, then along y
+        Level x_pooled = levels_[h];
+        index_t i;
+        for (std::size_t c = 0 ; c < x_pooled.data.size() ; ++c) {
+            toIndex(x_pooled, c, i);
+            float v = at(h - 1, i);
+            i[0] += half;
+            v = std::max(v, at(h - 1, i));
+            x_pooled.data[c] = v;
+        }
+
+        Level &level = levels_[h];
+        for (std::size_t c = 0 ; c < level.data.size() ; ++c) {
+            toIndex(level, c, i);
+            float v = at(x_pooled, i);
+            i[1] += half;
+            v = std::max(v, at(x_pooled, i));
+            level.data[c] = v;
+        }
+    }
+
+    inline static void toIndex(const Level &level, const std::size_t c, index_t &i)
+    {
+        std::size_t rest = c;
+        for (std::size_t k = 0 ; k < Dim ; ++k) {
+            i[k]  = static_cast<int>(rest % static_cast<std::size_t>(level.size[k])) - level.offset[k];
+            rest /= static_cast<std::size_t>(level.size[k]);
+        }
+    }
+
+    inline static float at(const Level &level, const index_t &i)
+    {
+        std::size_t c = 0ul;
+        for (std::size_t k = Dim ; k-- > 0 ;) {
+            const int j = i[k] + level.offset[k];
+            if (j < 0 || j >= level.size[k])
+                return 0.0f;
+            c = c * static_cast<std::size_t>(level.size[k]) + static_cast<std::size_t>(j);
+        }
+        return level.data[c];
+    }
+
+    double             resolution_;
+    index_t            size_;
+    rotation_t         rotation_;
+    translation_t      translation_;
+    std::vector<Level> levels_;
+};
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_BRANCH_AND_BOUND_GRIDS_HPP
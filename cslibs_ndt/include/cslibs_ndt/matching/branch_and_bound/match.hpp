@@ -0,0 +1,323 @@
+#ifndef CSLIBS_NDT_MATCHING_BRANCH_AND_BOUND_MATCH_HPP
+#define CSLIBS_NDT_MATCHING_BRANCH_AND_BOUND_MATCH_HPP
+
+#include <cslibs_ndt/matching/branch_and_bound/parameter.hpp>
+#include <cslibs_ndt/matching/branch_and_bound/grids.hpp>
+#include <cslibs_ndt/matching/newton/model.hpp>
+#include <cslibs_ndt/utility/parallel.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace branch_and_bound {
+namespace detail {
+
+/**
+ * @brief Window of cell offsets [x, x + 2^height) x [y, y + 2^height) of one rotated scan,
+ *        score is the upper bound given by the pooled grid of that height.
+ */
+struct Candidate
+{
+    std::size_t rotation;
+    int         x;
+    int         y;
+    double      score;
+
+    inline bool operator > (const Candidate &other) const
+    {
+        return score > other.score;
+    }
+};
+
+/**
+ * @brief Depth-first branch-and-bound over the candidates of the rotated scans,
+ *        several workers share the best score found so far as bound.
+ */
+template <std::size_t Dim>
+class Search
+{
+public:
+    using index_t = typename Grids<Dim>::index_t;
+    using cells_t = std::vector<index_t>;
+
+    inline Search(const Grids<Dim>                            &grids,
+                  const std::vector<cells_t>                  &scans,
+                  const int                                    window,
+                  const double                                 min_score,
+                  const double                                 time_budget,
+                  const std::chrono::steady_clock::time_point &start) :
+        grids_(grids),
+        scans_(scans),
+        window_(window),
+        limited_(time_budget > 0.0),
+        deadline_(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double>(time_budget))),
+        best_score_(min_score),
+        best_{0ul, 0, 0, 0.0},
+        found_(false),
+        expired_(false),
+        candidates_(0ul)
+    {
+    }
+
+    /**
+     * @brief Mean pooled score of a scan shifted by a window start.
+     */
+    inline double score(const std::size_t rotation, const int x, const int y, const std::size_t height) const
+    {
+        const cells_t &cells = scans_[rotation];
+        double sum = 0.0;
+        for (index_t c : cells) {
+            c[0] += x;
+            c[1] += y;
+            sum += static_cast<double>(grids_.at(height, c));
+        }
+        return sum / static_cast<double>(cells.size());
+    }
+
+    /**
+     * @brief Visit candidates of the given height sorted by descending score.
+     */
+    inline void branch(const std::vector<Candidate> &candidates, const std::size_t height)
+    {
+        candidates_ += candidates.size();
+        for (const Candidate &c : candidates) {
+            if (c.score <= best_score_.load(std::memory_order_relaxed) || expired())
+                return;
+
+            if (height == 0ul) {
+                std::lock_guard<std::mutex> l(best_mutex_);
+                if (c.score > best_score_.load(std::memory_order_relaxed)) {
+                    best_ = c;
+                    found_ = true;
+                    best_score_.store(c.score, std::memory_order_relaxed);
+                }
+                continue;
+            }
+
+            const int half = 1 << (height - 1);
+            std::vector<Candidate> children;
+            children.reserve(4);
+            for (int dx = 0 ; dx <= half ; dx += half) {
+                for (int dy = 0 ; dy <= half ; dy += half) {
+                    const int x = c.x + dx;
+                    const int y = c.y + dy;
+                    if (x > window_ || y > window_)
+                        continue;
+                    children.emplace_back(Candidate{c.rotation, x, y, score(c.rotation, x, y, height - 1)});
+                }
+            }
+            std::sort(children.begin(), children.end(), std::greater<Candidate>());
+            branch(children, height - 1);
+        }
+    }
+
+    inline bool expired()
+    {
+        if (!limited_)
+            return false;
+        if (!expired_.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() > deadline_)
+            expired_.store(true, std::memory_order_relaxed);
+        return expired_.load(std::memory_order_relaxed);
+    }
+
+    inline bool timedOut() const
+    {
+        return expired_.load();
+    }
+
+    inline bool found() const
+    {
+        return found_;
+    }
+
+    inline const Candidate& best() const
+    {
+        return best_;
+    }
+
+    inline std::size_t candidates() const
+    {
+        return candidates_.load();
+    }
+
+private:
+    const Grids<Dim>                            &grids_;
+    const std::vector<cells_t>                  &scans_;
+    const int                                    window_;
+    const bool                                   limited_;
+    const std::chrono::steady_clock::time_point  deadline_;
+
+    std::atomic<double>                          best_score_;
+    std::mutex                                   best_mutex_;
+    Candidate                                    best_;
+    bool                                         found_;
+    std::atomic<bool>                            expired_;
+    std::atomic<std::size_t>                     candidates_;
+};
+
+inline Eigen::Matrix<double,2,2> yaw(const double angle, const Eigen::Matrix<double,2,2> &)
+{
+    return Eigen::Rotation2D<double>(angle).toRotationMatrix();
+}
+
+inline Eigen::Matrix<double,3,3> yaw(const double angle, const Eigen::Matrix<double,3,3> &)
+{
+    return Eigen::AngleAxis<double>(angle, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+}
+}
+
+/**
+ * @brief Global scan matching by branch-and-bound over x, y and yaw on precomputed
+ *        max-pooled score grids. The window around the initial guess is searched exhaustively
+ *        at grid resolution, candidates are pruned by the bounds of the pooled levels.
+ *        Rotations are distributed over threads, all share the best score found so far.
+ *        3D scans keep roll, pitch and z of the initial guess and are rotated about the world z axis.
+ * @param grids         precomputed score grids, see Grids
+ * @param points        iterable set of points offering p(i)
+ * @param initial_guess center of the search window
+ * @param parameter     search window, depth, bound and time budget
+ * @return the best pose mapping the points into the world frame and its mean level 0 score,
+ *         the initial guess with NO_MATCH if no candidate exceeds the minimum score
+ */
+template <std::size_t Dim, typename points_t, typename pose_t>
+inline Result<pose_t> match(const Grids<Dim> &grids,
+                            const points_t   &points,
+                            const pose_t     &initial_guess,
+                            const Parameter  &parameter = Parameter())
+{
+    using model_t       = newton::Model<Dim>;
+    using rotation_t    = typename model_t::rotation_t;
+    using translation_t = typename model_t::translation_t;
+    using index_t       = typename Grids<Dim>::index_t;
+    using cells_t       = std::vector<index_t>;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    auto elapsed = [&start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    Result<pose_t> result;
+    result.transform = initial_guess;
+
+    /// step one: points and their range, which determines the angular step
+    std::vector<translation_t, Eigen::aligned_allocator<translation_t>> sensor;
+    double range = 0.0;
+    for (const auto &p : points) {
+        translation_t q;
+        for (std::size_t k = 0 ; k < Dim ; ++k)
+            q(k) = static_cast<double>(p(k));
+        range = std::max(range, q.template head<2>().norm());
+        sensor.emplace_back(q);
+    }
+    if (sensor.empty()) {
+        result.duration = elapsed();
+        return result;
+    }
+
+    const double resolution = grids.getResolution();
+    const std::size_t depth = std::max<std::size_t>(1ul, std::min(parameter.depth, grids.levels()));
+    const int         window = static_cast<int>(std::ceil(parameter.linear_window / resolution));
+
+    double angular_step = parameter.angular_step;
+    if (angular_step <= 0.0)
+        angular_step = range > resolution ?
+                    std::acos(1.0 - resolution * resolution / (2.0 * range * range)) : M_PI_2;
+
+    std::vector<double> angles;
+    if (parameter.angular_window >= M_PI) {
+        const int n = static_cast<int>(std::ceil(2.0 * M_PI / angular_step));
+        for (int i = 0 ; i < n ; ++i)
+            angles.emplace_back(static_cast<double>(i - n / 2) * 2.0 * M_PI / static_cast<double>(n));
+    } else {
+        const int n = static_cast<int>(std::ceil(std::max(0.0, parameter.angular_window) / angular_step));
+        for (int i = -n ; i <= n ; ++i)
+            angles.emplace_back(static_cast<double>(i) * angular_step);
+    }
+
+    const std::size_t threads = parameter.num_threads > 0ul ?
+                parameter.num_threads : utility::num_threads(angles.size());
+
+    /// step two: rotate and discretize the scan in the grid frame for all angles
+    rotation_t    R0;
+    translation_t t0;
+    model_t::toEigen(initial_guess, R0, t0);
+    const rotation_t    grid_R = grids.rotation().transpose();
+    const translation_t grid_t = -(grid_R * grids.translation());
+
+    std::vector<cells_t> scans(angles.size());
+    utility::parallel_for(angles.size(), threads,
+                          [&](const std::size_t, const std::size_t begin, const std::size_t end) {
+        for (std::size_t a = begin ; a < end ; ++a) {
+            const rotation_t    R = grid_R * detail::yaw(angles[a], R0) * R0;
+            const translation_t t = grid_R * t0 + grid_t;
+            cells_t &cells = scans[a];
+            cells.reserve(sensor.size());
+            for (const translation_t &p : sensor) {
+                const translation_t q = (R * p + t) / resolution;
+                index_t c;
+                for (std::size_t k = 0 ; k < Dim ; ++k)
+                    c[k] = static_cast<int>(std::floor(q(k)));
+                cells.emplace_back(c);
+            }
+        }
+    });
+
+    /// step three: coarsest candidates of every rotation, rotations ordered by their best one
+    detail::Search<Dim> search(grids, scans, window, parameter.min_score, parameter.time_budget, start);
+    const std::size_t top  = depth - 1ul;
+    const int         step = 1 << top;
+
+    std::vector<std::vector<detail::Candidate>> candidates(angles.size());
+    utility::parallel_for(angles.size(), threads,
+                          [&](const std::size_t, const std::size_t begin, const std::size_t end) {
+        for (std::size_t a = begin ; a < end ; ++a) {
+            for (int x = -window ; x <= window ; x += step) {
+                for (int y = -window ; y <= window ; y += step)
+                    candidates[a].emplace_back(detail::Candidate{a, x, y, search.score(a, x, y, top)});
+            }
+            std::sort(candidates[a].begin(), candidates[a].end(), std::greater<detail::Candidate>());
+        }
+    });
+
+    std::vector<std::size_t> order(angles.size());
+    for (std::size_t a = 0 ; a < angles.size() ; ++a)
+        order[a] = a;
+    std::sort(order.begin(), order.end(), [&candidates](const std::size_t a, const std::size_t b) {
+        return candidates[a].front().score > candidates[b].front().score;
+    });
+
+    /// step four: branch and bound, workers take the rotations in order
+    std::atomic<std::size_t> next(0ul);
+    utility::parallel_for(threads, threads,
+                          [&](const std::size_t, const std::size_t, const std::size_t) {
+        for (std::size_t i = next++ ; i < order.size() && !search.expired() ; i = next++)
+            search.branch(candidates[order[i]], top);
+    });
+
+    result.candidates = search.candidates();
+    result.termination = search.timedOut() ? Termination::TIME_BUDGET :
+                                             (search.found() ? Termination::COMPLETE : Termination::NO_MATCH);
+    if (search.found()) {
+        const detail::Candidate &best = search.best();
+        translation_t offset = translation_t::Zero();
+        offset(0) = static_cast<double>(best.x) * resolution;
+        offset(1) = static_cast<double>(best.y) * resolution;
+        result.transform = model_t::template fromEigen<pose_t>(detail::yaw(angles[best.rotation], R0) * R0,
+                                                               t0 + grids.rotation() * offset);
+        result.score = best.score;
+    }
+    result.duration = elapsed();
+    return result;
+}
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_BRANCH_AND_BOUND_MATCH_HPP
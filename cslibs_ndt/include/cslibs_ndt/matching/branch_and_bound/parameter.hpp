@@ -0,0 +1,53 @@
+#ifndef CSLIBS_NDT_MATCHING_BRANCH_AND_BOUND_PARAMETER_HPP
+#define CSLIBS_NDT_MATCHING_BRANCH_AND_BOUND_PARAMETER_HPP
+
+#include <cstddef>
+#include <cmath>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace branch_and_bound {
+
+/**
+ * @brief Settings of the branch-and-bound matcher.
+ *        The search window is centered at the initial guess.
+ */
+struct Parameter
+{
+    double      linear_window   = 5.0;     // [m],   half size of the x and y window
+    double      angular_window  = M_PI;    // [rad], half size of the yaw window
+    double      angular_step    = 0.0;     // [rad], 0 derives it from the grid resolution and the scan range
+    std::size_t depth           = 7;       // number of max-pooled levels used, at most the precomputed ones
+    double      min_score       = 0.3;     // candidates have to score better to be accepted
+    double      time_budget     = 0.0;     // [s] from the call on, 0 searches without time limit
+    std::size_t num_threads     = 0;       // 0 uses all hardware threads
+};
+
+enum class Termination { COMPLETE, TIME_BUDGET, NO_MATCH, NO_POINTS };
+
+/**
+ * @brief Outcome of one search.
+ *        score is the mean of the finest grid over all points at the returned transform.
+ *        After TIME_BUDGET the best candidate found so far is returned.
+ */
+template <typename pose_t>
+struct Result
+{
+    pose_t      transform;
+    double      score       = 0.0;
+    std::size_t candidates  = 0;     // scored candidates on all levels
+    double      duration    = 0.0;   // [s]
+    Termination termination = Termination::NO_POINTS;
+
+    inline bool found() const
+    {
+        return termination == Termination::COMPLETE ||
+               (termination == Termination::TIME_BUDGET && score > 0.0);
+    }
+};
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_BRANCH_AND_BOUND_PARAMETER_HPP
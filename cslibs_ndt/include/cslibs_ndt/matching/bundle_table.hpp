@@ -0,0 +1,93 @@
+#ifndef CSLIBS_NDT_MATCHING_BUNDLE_TABLE_HPP
+#define CSLIBS_NDT_MATCHING_BUNDLE_TABLE_HPP
+
+#include <cslibs_ndt/matching/newton/model.hpp>
+
+#include <cslibs_math/common/array.hpp>
+
+#include <cmath>
+#include <unordered_map>
+
+namespace cslibs_ndt {
+namespace matching {
+
+/**
+ * @brief Bundle lookups of a map resolved once, e.g. for all hypotheses matched against it.
+ *        Empty bundles are kept as well, indices not in the table fall back to the map.
+ *        Filled before matching, read-only afterwards and then safe to share among threads.
+ */
+template <typename ndt_t>
+class BundleTable
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    static constexpr std::size_t Dim = std::tuple_size<typename ndt_t::index_t>::value;
+
+    using index_t  = typename ndt_t::index_t;
+    using bundle_t = typename ndt_t::distribution_bundle_t;
+
+    inline explicit BundleTable(const ndt_t &map) :
+        map_(map),
+        resolution_inv_(1.0 / static_cast<double>(map.getBundleResolution()))
+    {
+        newton::Model<Dim>::toEigen(map.getInitialOrigin().inverse(), rotation_, translation_);
+    }
+
+    inline void insert(const index_t &bi)
+    {
+        if (table_.find(bi) == table_.end())
+            table_.emplace(bi, map_.get(bi));
+    }
+
+    /**
+     * @brief Inserts the bundles the points fall into under the given transform.
+     */
+    template <typename points_t>
+    inline void insert(const points_t &points, const typename ndt_t::pose_t &pose)
+    {
+        rotation_t    rotation;
+        translation_t translation;
+        newton::Model<Dim>::toEigen(pose, rotation, translation);
+        const rotation_t    A = rotation_ * rotation;
+        const translation_t b = rotation_ * translation + translation_;
+
+        for (const auto &p : points) {
+            translation_t x;
+            for (std::size_t k = 0 ; k < Dim ; ++k)
+                x(k) = static_cast<double>(p(k));
+            const translation_t q = A * x + b;
+            index_t bi;
+            for (std::size_t k = 0 ; k < Dim ; ++k)
+                bi[k] = static_cast<int>(std::floor(q(k) * resolution_inv_));
+            insert(bi);
+        }
+    }
+
+    inline const bundle_t* get(const index_t &bi) const
+    {
+        const auto it = table_.find(bi);
+        return it != table_.end() ? it->second : map_.get(bi);
+    }
+
+    inline std::size_t size() const
+    {
+        return table_.size();
+    }
+
+private:
+    using rotation_t    = Eigen::Matrix<double,Dim,Dim>;
+    using translation_t = Eigen::Matrix<double,Dim,1>;
+
+    const ndt_t  &map_;
+    const double  resolution_inv_;
+    rotation_t    rotation_;      // map <- world
+    translation_t translation_;
+
+    std::unordered_map<index_t, const bundle_t*> table_;
+};
+
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_BUNDLE_TABLE_HPP
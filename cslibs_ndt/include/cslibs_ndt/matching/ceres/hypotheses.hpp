@@ -0,0 +1,242 @@
+#ifndef CSLIBS_NDT_MATCHING_CERES_HYPOTHESES_HPP
+#define CSLIBS_NDT_MATCHING_CERES_HYPOTHESES_HPP
+
+#include <cslibs_ndt/matching/ceres/problem.hpp>
+#include <cslibs_ndt/matching/hypotheses.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+
+#include <ceres/solver.h>
+
+#include <chrono>
+#include <cmath>
+#include <tuple>
+#include <utility>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace ceres {
+
+/**
+ * @brief Outcome of one hypothesis.
+ *        score is the mean of sampleNonNormalized over all points at the final transform.
+ */
+template <typename pose_t>
+struct Result
+{
+    pose_t      transform;
+    double      score      = 0.0;
+    std::size_t iterations = 0;     // successful and unsuccessful ceres steps
+    double      duration   = 0.0;   // [s]
+    bool        converged  = false;
+};
+
+namespace detail {
+/**
+ * @brief Number of leading args the map is sampled with, Flag::INTERPOLATION functors
+ *        take the sampling resolution or lattice cache as the last one.
+ */
+template <Flag flag_t, std::size_t N>
+struct MapArguments
+{
+    static constexpr std::size_t count = N;
+};
+
+template <std::size_t N>
+struct MapArguments<Flag::INTERPOLATION, N>
+{
+    static constexpr std::size_t count = N - 1;
+};
+
+template <typename ndt_t, typename point_t, typename tuple_t, std::size_t ... I>
+inline double sample(const ndt_t &map, const point_t &p, const tuple_t &args, std::index_sequence<I...>)
+{
+    return static_cast<double>(map.sampleNonNormalized(p, std::get<I>(args)...));
+}
+
+/**
+ * @brief Runs the hypotheses on a pool of threads. The points are copied once into a vector
+ *        of finite points, which all problems reference. problem(guess, points, translation,
+ *        rotation, ceres_problem) sets up one hypothesis, to_pose(translation, rotation)
+ *        converts the solution. Every solver is restricted to one thread if hypotheses
+ *        run in parallel. The map has to be settled by the caller, see map::settle.
+ */
+template <typename ndt_t, Flag flag_t, std::size_t T, std::size_t R, typename points_t,
+          typename problem_t, typename to_pose_t, typename ... args_t>
+inline std::vector<Result<typename ndt_t::pose_t>> matchHypotheses(
+        const ::ceres::Solver::Options                 &options,
+        const std::vector<typename ndt_t::pose_t>      &initial_guesses,
+        const std::size_t                               num_threads,
+        const points_t                                 &points,
+        const ndt_t                                    &map,
+        const problem_t                                &problem,
+        const to_pose_t                                &to_pose,
+        const args_t                                   &...args)
+{
+    using pose_t  = typename ndt_t::pose_t;
+    using point_t = typename ndt_t::point_t;
+
+    std::vector<point_t> data;
+    for (const auto &p : points) {
+        bool finite = true;
+        for (std::size_t k = 0 ; k < T ; ++k)
+            finite &= std::isfinite(static_cast<double>(p(k)));
+        if (finite)
+            data.emplace_back(p);
+    }
+
+    ::ceres::Solver::Options solver_options = options;
+    if (num_threads != 1ul && initial_guesses.size() > 1ul)
+        solver_options.num_threads = 1;
+
+    return matching::matchHypotheses(initial_guesses, [&](const pose_t &guess) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        double translation[T];
+        double rotation[R];
+        ::ceres::Problem ceres_problem;
+        problem(guess, data, translation, rotation, ceres_problem);
+
+        ::ceres::Solver::Summary summary;
+        if (!data.empty())
+            ::ceres::Solve(solver_options, &ceres_problem, &summary);
+
+        Result<pose_t> result;
+        result.transform  = to_pose(translation, rotation);
+        result.iterations = static_cast<std::size_t>(summary.num_successful_steps + summary.num_unsuccessful_steps);
+        result.converged  = summary.termination_type == ::ceres::CONVERGENCE;
+        const auto map_args = std::forward_as_tuple(args...);
+        for (const point_t &p : data)
+            result.score += sample(map, result.transform * p, map_args,
+                                   std::make_index_sequence<MapArguments<flag_t, sizeof...(args_t)>::count>());
+        result.score    = data.empty() ? 0.0 : result.score / static_cast<double>(data.size());
+        result.duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }, num_threads);
+}
+}
+
+/**
+ * @brief Scan matching of one scan from several initial guesses, one ceres problem per
+ *        hypothesis on a pool of threads. Each hypothesis is regularized towards its own
+ *        initial guess. Pass a shared LatticeCache::Ptr with Flag::INTERPOLATION,
+ *        so that all hypotheses read the same lattice. The hypotheses read the map concurrently,
+ *        it has to be settled once when it is handed over, see map::settle and map::ReadView,
+ *        and must not be written during the call.
+ * @param num_threads 0 uses all hardware threads
+ * @param args        additional map arguments, i.e. the inverse sensor model for occupancy maps
+ *                    and the sampling resolution or lattice cache for Flag::INTERPOLATION
+ * @return the results in the order of the initial guesses
+ */
+template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename points_t, typename ... args_t>
+inline std::vector<Result<typename ndt_t::pose_t>> MatchHypotheses2d(
+        const ::ceres::Solver::Options                 &options,
+        const double& translation_weight, const double& rotation_weight, const double& map_weight,
+        const std::vector<typename ndt_t::pose_t>      &initial_guesses,
+        const Differentiation                           differentiation,
+        const std::size_t                               num_threads,
+        const points_t                                 &points,
+        const ndt_t                                    &map,
+        const args_t                                   &...args)
+{
+    using pose_t  = typename ndt_t::pose_t;
+    using point_t = typename ndt_t::point_t;
+
+    return detail::matchHypotheses<ndt_t, flag_t, 2, 1>(
+                options, initial_guesses, num_threads, points, map,
+                [&](const pose_t &guess, const std::vector<point_t> &data,
+                    double *translation, double *rotation, ::ceres::Problem &problem) {
+        translation[0] = guess.tx();
+        translation[1] = guess.ty();
+        rotation[0]    = guess.yaw();
+        Problem2d<ndt_t, flag_t>(translation_weight, rotation_weight, map_weight,
+                                 guess.translation(), guess.yaw(),
+                                 translation, rotation,
+                                 problem, differentiation, data, map, args...);
+    },
+    [](const double *translation, const double *rotation) {
+        return pose_t(translation[0], translation[1], rotation[0]);
+    }, args...);
+}
+
+template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename points_t, typename ... args_t>
+inline std::vector<Result<typename ndt_t::pose_t>> MatchHypotheses3dQuaternion(
+        const ::ceres::Solver::Options                 &options,
+        const double& translation_weight, const double& rotation_weight, const double& map_weight,
+        const std::vector<typename ndt_t::pose_t>      &initial_guesses,
+        const bool                                      only_yaw,
+        const Differentiation                           differentiation,
+        const std::size_t                               num_threads,
+        const points_t                                 &points,
+        const ndt_t                                    &map,
+        const args_t                                   &...args)
+{
+    using pose_t  = typename ndt_t::pose_t;
+    using point_t = typename ndt_t::point_t;
+
+    return detail::matchHypotheses<ndt_t, flag_t, 3, 4>(
+                options, initial_guesses, num_threads, points, map,
+                [&](const pose_t &guess, const std::vector<point_t> &data,
+                    double *translation, double *rotation, ::ceres::Problem &problem) {
+        const auto &q = guess.rotation();
+        translation[0] = guess.tx();
+        translation[1] = guess.ty();
+        translation[2] = guess.tz();
+        rotation[0]    = q.w();
+        rotation[1]    = q.x();
+        rotation[2]    = q.y();
+        rotation[3]    = q.z();
+        Problem3dQuaternion<ndt_t, flag_t>(translation_weight, rotation_weight, map_weight,
+                                           guess.translation(), q,
+                                           translation, rotation,
+                                           problem, only_yaw, differentiation, data, map, args...);
+    },
+    [](const double *translation, const double *rotation) {
+        const double n = std::sqrt(rotation[0] * rotation[0] + rotation[1] * rotation[1] +
+                                   rotation[2] * rotation[2] + rotation[3] * rotation[3]);
+        return pose_t(cslibs_math_3d::Vector3d(translation[0], translation[1], translation[2]),
+                      cslibs_math_3d::Quaterniond(rotation[1] / n, rotation[2] / n, rotation[3] / n, rotation[0] / n));
+    }, args...);
+}
+
+template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename points_t, typename ... args_t>
+inline std::vector<Result<typename ndt_t::pose_t>> MatchHypotheses3dRPY(
+        const ::ceres::Solver::Options                 &options,
+        const double& translation_weight, const double& rotation_weight, const double& map_weight,
+        const std::vector<typename ndt_t::pose_t>      &initial_guesses,
+        const bool                                      only_yaw,
+        const Differentiation                           differentiation,
+        const std::size_t                               num_threads,
+        const points_t                                 &points,
+        const ndt_t                                    &map,
+        const args_t                                   &...args)
+{
+    using pose_t  = typename ndt_t::pose_t;
+    using point_t = typename ndt_t::point_t;
+
+    return detail::matchHypotheses<ndt_t, flag_t, 3, 3>(
+                options, initial_guesses, num_threads, points, map,
+                [&](const pose_t &guess, const std::vector<point_t> &data,
+                    double *translation, double *rotation, ::ceres::Problem &problem) {
+        const auto &q = guess.rotation();
+        translation[0] = guess.tx();
+        translation[1] = guess.ty();
+        translation[2] = guess.tz();
+        rotation[0]    = q.roll();
+        rotation[1]    = q.pitch();
+        rotation[2]    = q.yaw();
+        Problem3dRPY<ndt_t, flag_t>(translation_weight, rotation_weight, map_weight,
+                                    guess.translation(),
+                                    cslibs_math::linear::Vector<double,3>(rotation[0], rotation[1], rotation[2]),
+                                    translation, rotation,
+                                    problem, only_yaw, differentiation, data, map, args...);
+    },
+    [](const double *translation, const double *rotation) {
+        return pose_t(translation[0], translation[1], translation[2], rotation[0], rotation[1], rotation[2]);
+    }, args...);
+}
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_CERES_HYPOTHESES_HPP
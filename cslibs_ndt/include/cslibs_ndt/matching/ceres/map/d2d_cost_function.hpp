@@ -0,0 +1,140 @@
+#ifndef CSLIBS_NDT_MATCHING_CERES_D2D_COST_FUNCTION_HPP
+#define CSLIBS_NDT_MATCHING_CERES_D2D_COST_FUNCTION_HPP
+
+#include <cslibs_ndt/matching/d2d.hpp>
+#include <cslibs_ndt/matching/newton/model.hpp>
+
+#include <ceres/cost_function.h>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace ceres {
+
+/**
+ * @brief Unit quaternion in the w, x, y, z order of the ceres parameter blocks with the
+ *        first derivatives of its rotation matrix, second derivatives are not provided.
+ */
+class QuaternionModel : public newton::ModelBase<3,4>
+{
+public:
+    inline void update(const vector_t &x)
+    {
+        const double w = x(3), qx = x(4), qy = x(5), qz = x(6);
+        translation_ = x.head<3>();
+        rotation_ << 1.0 - 2.0 * (qy * qy + qz * qz), 2.0 * (qx * qy - w * qz),         2.0 * (qx * qz + w * qy),
+                     2.0 * (qx * qy + w * qz),         1.0 - 2.0 * (qx * qx + qz * qz), 2.0 * (qy * qz - w * qx),
+                     2.0 * (qx * qz - w * qy),         2.0 * (qy * qz + w * qx),         1.0 - 2.0 * (qx * qx + qy * qy);
+        first_[0] <<  0.0,      -2.0 * qz,  2.0 * qy,
+                      2.0 * qz,  0.0,      -2.0 * qx,
+                     -2.0 * qy,  2.0 * qx,  0.0;
+        first_[1] <<  0.0,       2.0 * qy,  2.0 * qz,
+                      2.0 * qy, -4.0 * qx, -2.0 * w,
+                      2.0 * qz,  2.0 * w,  -4.0 * qx;
+        first_[2] << -4.0 * qy,  2.0 * qx,  2.0 * w,
+                      2.0 * qx,  0.0,       2.0 * qz,
+                     -2.0 * w,   2.0 * qz, -4.0 * qy;
+        first_[3] << -4.0 * qz, -2.0 * w,   2.0 * qx,
+                      2.0 * w,  -4.0 * qz,  2.0 * qy,
+                      2.0 * qx,  2.0 * qy,  0.0;
+    }
+};
+
+/**
+ * @brief D2D scan matching cost with analytic Jacobians, one residual
+ *        w_i * (1 - score_i) per scan distribution with w_i = weight * sqrt(n_i / n),
+ *        i.e. the point residuals of the ScanMatchCostFunctors aggregated per distribution.
+ *        Parameter blocks are the translation and the rotation as parametrized by model_t:
+ *        newton::Model<2> for yaw, newton::Model<3> for roll, pitch, yaw and QuaternionModel.
+ */
+template <typename ndt_t, typename model_t>
+class D2DCostFunction : public ::ceres::CostFunction
+{
+public:
+    static constexpr std::size_t Dim = model_t::dimension;
+    static constexpr std::size_t R   = model_t::rotations;
+
+    using terms_t = d2d::Terms<ndt_t, R>;
+    using scan_t  = d2d::Scan<Dim>;
+
+    template <typename ... args_t>
+    static inline ::ceres::CostFunction* Create(const double   weight,
+                                                const scan_t  &scan,
+                                                const ndt_t   &map,
+                                                const args_t  &...args)
+    {
+        return new D2DCostFunction(weight, scan, map, args...);
+    }
+
+    virtual inline bool Evaluate(double const* const* parameters,
+                                 double* residuals,
+                                 double** jacobians) const override
+    {
+        typename model_t::vector_t x;
+        for (std::size_t i = 0 ; i < Dim ; ++i)
+            x(i) = parameters[0][i];
+        for (std::size_t i = 0 ; i < R ; ++i)
+            x(Dim + i) = parameters[1][i];
+        model_t model;
+        model.update(x);
+
+        const typename terms_t::Transform T =
+                terms_.transform(model.rotation(), model.translation(), model.firstDerivatives());
+
+        const bool derivatives = jacobians && (jacobians[0] || jacobians[1]);
+        typename terms_t::vector_t gradient;
+        for (std::size_t k = 0 ; k < scan_.size() ; ++k) {
+            gradient.setZero();
+            const double w = weights_[k];
+            residuals[k] = w * (1.0 - terms_.evaluate(scan_[k], T, 1.0, derivatives ? &gradient : nullptr));
+            if (residuals[k] == -residuals[k]) // only nan test that works
+                residuals[k] = 0.0;
+            if (!gradient.allFinite())
+                gradient.setZero();
+
+            if (derivatives && jacobians[0]) {
+                for (std::size_t i = 0 ; i < Dim ; ++i)
+                    jacobians[0][k * Dim + i] = -w * gradient(i);
+            }
+            if (derivatives && jacobians[1]) {
+                for (std::size_t i = 0 ; i < R ; ++i)
+                    jacobians[1][k * R + i] = -w * gradient(Dim + i);
+            }
+        }
+        return true;
+    }
+
+private:
+    template <typename ... args_t>
+    inline D2DCostFunction(const double   weight,
+                           const scan_t  &scan,
+                           const ndt_t   &map,
+                           const args_t  &...args) :
+        terms_(map, args...),
+        scan_(scan)
+    {
+        set_num_residuals(static_cast<int>(scan_.size()));
+        mutable_parameter_block_sizes()->push_back(static_cast<int>(Dim));
+        mutable_parameter_block_sizes()->push_back(static_cast<int>(R));
+
+        weights_.reserve(scan_.size());
+        for (const auto &s : scan_)
+            weights_.emplace_back(weight * std::sqrt(s.weight / scan_.weight()));
+    }
+
+    const terms_t       terms_;
+    const scan_t        scan_;
+    std::vector<double> weights_;
+};
+
+template <typename ndt_t>
+using D2DCostFunction2d           = D2DCostFunction<ndt_t, newton::Model<2>>;
+template <typename ndt_t>
+using D2DCostFunction3dRPY        = D2DCostFunction<ndt_t, newton::Model<3>>;
+template <typename ndt_t>
+using D2DCostFunction3dQuaternion = D2DCostFunction<ndt_t, QuaternionModel>;
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_CERES_D2D_COST_FUNCTION_HPP
@@ -0,0 +1,189 @@
+#ifndef CSLIBS_NDT_MATCHING_CERES_SCAN_MATCH_COST_FUNCTION_HPP
+#define CSLIBS_NDT_MATCHING_CERES_SCAN_MATCH_COST_FUNCTION_HPP
+
+#include <cslibs_ndt/matching/access.hpp>
+#include <cslibs_ndt/matching/newton/model.hpp>
+#include <cslibs_ndt/matching/ceres/map/d2d_cost_function.hpp>
+
+#include <ceres/cost_function.h>
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace ceres {
+
+/**
+ * @brief Point-to-distribution scan matching cost with analytic Jacobians,
+ *        same residuals weight * (1 - sampleNonNormalized) as the ScanMatchCostFunctors
+ *        of Flag::DIRECT, without Jet arithmetic. Parameter blocks are the translation and
+ *        the rotation as parametrized by model_t, see D2DCostFunction.
+ *        Evaluate keeps no state, so ceres may call it from several threads at once,
+ *        as long as the map is settled, see map::settle, and does not change meanwhile.
+ */
+template <typename ndt_t, typename model_t, typename points_t>
+class ScanMatchCostFunction : public ::ceres::CostFunction
+{
+public:
+    static constexpr std::size_t Dim = model_t::dimension;
+    static constexpr std::size_t R   = model_t::rotations;
+
+    using index_t        = typename ndt_t::index_t;
+    using bundle_t       = typename ndt_t::distribution_bundle_t;
+    using distribution_t = typename ndt_t::distribution_t::distribution_t;
+    using point_d_t      = Eigen::Matrix<double,Dim,1>;
+    using matrix_d_t     = Eigen::Matrix<double,Dim,Dim>;
+
+    template <typename ... args_t>
+    explicit inline ScanMatchCostFunction(const double  &weight,
+                                          points_t     &&points,
+                                          const ndt_t   &map,
+                                          const args_t  &...args) :
+        weight_(weight),
+        points_(points),
+        map_(map),
+        access_(map, args...),
+        resolution_inv_(1.0 / static_cast<double>(map.getBundleResolution()))
+    {
+        newton::Model<Dim>::toEigen(map.getInitialOrigin().inverse(), rotation_, translation_);
+
+        const std::size_t count = static_cast<std::size_t>(std::distance(std::begin(points_), std::end(points_)));
+        set_num_residuals(static_cast<int>(count));
+        mutable_parameter_block_sizes()->push_back(static_cast<int>(Dim));
+        mutable_parameter_block_sizes()->push_back(static_cast<int>(R));
+    }
+
+    virtual inline bool Evaluate(double const* const* parameters,
+                                 double* residuals,
+                                 double** jacobians) const override
+    {
+        typename model_t::vector_t x;
+        for (std::size_t i = 0 ; i < Dim ; ++i)
+            x(i) = parameters[0][i];
+        for (std::size_t i = 0 ; i < R ; ++i)
+            x(Dim + i) = parameters[1][i];
+        model_t model;
+        model.update(x);
+
+        /// step one: pose in the map frame, shared by all points
+        const matrix_d_t A = rotation_ * model.rotation();
+        const point_d_t  b = rotation_ * model.translation() + translation_;
+        const bool derivatives = jacobians && (jacobians[0] || jacobians[1]);
+
+        std::size_t k = 0;
+        for (const auto &point : points_) {
+            point_d_t p;
+            for (std::size_t j = 0 ; j < Dim ; ++j)
+                p(j) = static_cast<double>(point(j));
+
+            /// step two: bundle of the transformed point
+            const point_d_t q = A * p + b;
+            index_t bi;
+            for (std::size_t j = 0 ; j < Dim ; ++j)
+                bi[j] = static_cast<int>(std::floor(q(j) * resolution_inv_));
+
+            /// step three: score and sum_i e_i * I_i * d_i, the gradient of the score is -J^T of it
+            double    score = 0.0;
+            point_d_t v     = point_d_t::Zero();
+            if (const bundle_t *bundle = map_.get(bi)) {
+                for (std::size_t i = 0 ; i < ndt_t::bin_count ; ++i) {
+                    access_(bundle->at(i), [&](const distribution_t &d, const double w) {
+                        const point_d_t diff = q - d.getMean().template cast<double>();
+                        const point_d_t id   = d.getInformationMatrix().template cast<double>() * diff;
+                        const double    e    = w * std::exp(-0.5 * diff.dot(id));
+                        score += e;
+                        if (derivatives)
+                            v += e * id;
+                    });
+                }
+            }
+
+            residuals[k] = weight_ * (1.0 - score);
+            const bool valid = residuals[k] == residuals[k] && v.allFinite();
+            if (!valid) // nan, like the functors
+                residuals[k] = 0.0;
+
+            if (derivatives) {
+                const point_d_t u = valid ? point_d_t(rotation_.transpose() * (weight_ * v)) : point_d_t::Zero();
+                if (jacobians[0]) {
+                    for (std::size_t j = 0 ; j < Dim ; ++j)
+                        jacobians[0][k * Dim + j] = u(j);
+                }
+                if (jacobians[1]) {
+                    for (std::size_t r = 0 ; r < R ; ++r)
+                        jacobians[1][k * R + r] = u.dot(model.firstDerivative(r) * p);
+                }
+            }
+            ++k;
+        }
+        return true;
+    }
+
+private:
+    const double        weight_;
+    const points_t      points_;
+    const ndt_t        &map_;
+    const Access<ndt_t> access_;
+    const double        resolution_inv_;
+    matrix_d_t          rotation_;      // map <- world
+    point_d_t           translation_;
+};
+
+/**
+ * @brief Creates ScanMatchCostFunctions like ScanMatchCostFunctorCreator creates the autodiff ones,
+ *        the weight is divided by the square root of the number of points.
+ */
+template <typename ndt_t, typename model_t>
+class ScanMatchCostFunctionCreator
+{
+public:
+    template <typename points_t, typename ... args_t>
+    static inline ::ceres::CostFunction* Create(double weight, points_t&& points, const args_t &...args)
+    {
+        using function_t = ScanMatchCostFunction<ndt_t, model_t, points_t>;
+
+        const double count = static_cast<double>(points.size());
+        return new function_t(weight / std::sqrt(count), std::forward<points_t>(points), args...);
+    }
+
+    /**
+     * @brief One cost function per chunk of at most chunk_size points,
+     *        see ScanMatchCostFunctorCreator::CreateChunkedAutoDiffCostFunctions.
+     */
+    template <typename points_t, typename ... args_t>
+    static inline std::vector<::ceres::CostFunction*> CreateChunked(
+            double weight, const std::size_t chunk_size, points_t&& points, const args_t &...args)
+    {
+        using chunk_t    = typename std::decay<points_t>::type;
+        using function_t = ScanMatchCostFunction<ndt_t, model_t, chunk_t>;
+
+        const std::size_t count = points.size();
+        const std::size_t size  = chunk_size > 0ul ? chunk_size : std::max<std::size_t>(1ul, count);
+        const double chunk_weight = weight / std::sqrt(static_cast<double>(count));
+
+        std::vector<::ceres::CostFunction*> functions;
+        auto it = std::begin(points);
+        for (std::size_t begin = 0 ; begin < count ; begin += size) {
+            auto next = std::next(it, static_cast<std::ptrdiff_t>(std::min(count, begin + size) - begin));
+            functions.emplace_back(new function_t(chunk_weight, chunk_t(it, next), args...));
+            it = next;
+        }
+        return functions;
+    }
+};
+
+template <typename ndt_t>
+using ScanMatchCostFunction2dCreator           = ScanMatchCostFunctionCreator<ndt_t, newton::Model<2>>;
+template <typename ndt_t>
+using ScanMatchCostFunction3dRPYCreator        = ScanMatchCostFunctionCreator<ndt_t, newton::Model<3>>;
+template <typename ndt_t>
+using ScanMatchCostFunction3dQuaternionCreator = ScanMatchCostFunctionCreator<ndt_t, QuaternionModel>;
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_CERES_SCAN_MATCH_COST_FUNCTION_HPP
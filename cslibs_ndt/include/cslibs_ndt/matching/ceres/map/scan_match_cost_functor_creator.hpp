@@ -5,6 +5,11 @@
 #include <ceres/autodiff_cost_function.h>
 #include <ceres/numeric_diff_cost_function.h>
 
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
 namespace cslibs_ndt {
 namespace matching {
 namespace ceres {
@@ -39,6 +44,81 @@ public:
                     ::ceres::TAKE_OWNERSHIP,
                     count);
     }
+
+    /**
+     * @brief One cost function per chunk of at most chunk_size points instead of a single one
+     *        for the whole cloud. Ceres evaluates residual blocks in parallel with
+     *        Solver::Options::num_threads, chunks of a few hundred points keep the per block
+     *        Jacobians in cache. All chunks are weighted by the total point count, so the
+     *        summed cost equals the one of CreateAutoDiffCostFunction.
+     * @param chunk_size points per chunk, 0 puts all points into one chunk
+     */
+    template <typename points_t, typename ... args_t>
+    static inline std::vector<::ceres::CostFunction*> CreateChunkedAutoDiffCostFunctions(
+            double weight, const std::size_t chunk_size, points_t&& points, const args_t &...args)
+    {
+        using chunk_t  = typename chunk_type<points_t>::type;
+        using _child_t = child_t<base_t,chunk_t>;
+
+        const double chunk_weight = weight / std::sqrt(points.size());
+        std::vector<::ceres::CostFunction*> functions;
+        for (chunk_t &chunk : split(points, chunk_size)) {
+            const auto count = chunk.size();
+            functions.emplace_back(new ::ceres::AutoDiffCostFunction<_child_t, ::ceres::DYNAMIC, _child_t::N0, _child_t::N1>(
+                                       new _child_t(chunk_weight, std::move(chunk), args...),
+                                       count));
+        }
+        return functions;
+    }
+
+    template <::ceres::NumericDiffMethodType numeric_method_t = ::ceres::FORWARD,
+              typename points_t,
+              typename ... args_t>
+    static inline std::vector<::ceres::CostFunction*> CreateChunkedNumericDiffCostFunctions(
+            double weight, const std::size_t chunk_size, points_t&& points, const args_t &...args)
+    {
+        using chunk_t  = typename chunk_type<points_t>::type;
+        using _child_t = child_t<base_t,chunk_t>;
+
+        const double chunk_weight = weight / std::sqrt(points.size());
+        std::vector<::ceres::CostFunction*> functions;
+        for (chunk_t &chunk : split(points, chunk_size)) {
+            const auto count = chunk.size();
+            functions.emplace_back(new ::ceres::NumericDiffCostFunction<_child_t, numeric_method_t, ::ceres::DYNAMIC, _child_t::N0, _child_t::N1>(
+                                       new _child_t(chunk_weight, std::move(chunk), args...),
+                                       ::ceres::TAKE_OWNERSHIP,
+                                       count));
+        }
+        return functions;
+    }
+
+private:
+    // chunks keep the container type and thereby the allocator of the points
+    template <typename points_t>
+    struct chunk_type
+    {
+        using type = typename std::decay<points_t>::type;
+    };
+
+    template <typename points_t>
+    static inline std::vector<typename chunk_type<points_t>::type> split(const points_t &points,
+                                                                         const std::size_t chunk_size)
+    {
+        using chunk_t = typename chunk_type<points_t>::type;
+
+        const std::size_t count = points.size();
+        const std::size_t size  = chunk_size > 0ul ? chunk_size : std::max<std::size_t>(1ul, count);
+        std::vector<chunk_t> chunks;
+        chunks.reserve((count + size - 1ul) / size);
+        auto it = std::begin(points);
+        for (std::size_t begin = 0 ; begin < count ; begin += size) {
+            const std::size_t end = std::min(count, begin + size);
+            auto next = std::next(it, static_cast<std::ptrdiff_t>(end - begin));
+            chunks.emplace_back(it, next);
+            it = next;
+        }
+        return chunks;
+    }
 };
 
 }
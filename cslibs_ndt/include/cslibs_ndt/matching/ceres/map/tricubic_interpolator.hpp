@@ -0,0 +1,96 @@
+#ifndef CSLIBS_NDT_MATCHING_CERES_TRICUBIC_INTERPOLATOR_HPP
+#define CSLIBS_NDT_MATCHING_CERES_TRICUBIC_INTERPOLATOR_HPP
+
+#include <cmath>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace ceres {
+
+/**
+ * @brief Tricubic counterpart of ::ceres::BiCubicInterpolator, a Catmull-Rom (cubic Hermite)
+ *        spline along each axis of an unbounded 3D lattice. The grid has to provide
+ *
+ *            void GetValues(const int row, const int column, const int depth, double* const values) const;
+ *
+ *        filling the 4x4x4 values at [row, row + 4) x [column, column + 4) x [depth, depth + 4),
+ *        depth running fastest.
+ */
+template <typename grid_t>
+class TriCubicInterpolator
+{
+public:
+    explicit inline TriCubicInterpolator(const grid_t& grid) :
+        grid_(grid)
+    {
+    }
+
+    inline void Evaluate(const double& r, const double& c, const double& d,
+                         double* f, double* dfdr, double* dfdc, double* dfdd) const
+    {
+        const int row    = static_cast<int>(std::floor(r));
+        const int column = static_cast<int>(std::floor(c));
+        const int depth  = static_cast<int>(std::floor(d));
+
+        double values[64];
+        grid_.GetValues(row - 1, column - 1, depth - 1, values);
+
+        /// step one: along the depth, f and df/dd for each of the 4x4 rows and columns
+        double f_rc[16], fd_rc[16];
+        for (int i = 0 ; i < 16 ; ++i)
+            spline(values + 4 * i, d - depth, f_rc[i], fd_rc[i]);
+
+        /// step two: along the columns, interpolating df/dd as well
+        double f_r[4], fc_r[4], fd_r[4], unused;
+        for (int i = 0 ; i < 4 ; ++i) {
+            spline(f_rc  + 4 * i, c - column, f_r[i], fc_r[i]);
+            spline(fd_rc + 4 * i, c - column, fd_r[i], unused);
+        }
+
+        /// step three: along the rows
+        double value, dr, dc, dd;
+        spline(f_r,  r - row, value, dr);
+        spline(fc_r, r - row, dc, unused);
+        spline(fd_r, r - row, dd, unused);
+
+        if (f)
+            *f = value;
+        if (dfdr)
+            *dfdr = dr;
+        if (dfdc)
+            *dfdc = dc;
+        if (dfdd)
+            *dfdd = dd;
+    }
+
+    template <typename JetT>
+    inline void Evaluate(const JetT& r, const JetT& c, const JetT& d, JetT* f) const
+    {
+        double dfdr, dfdc, dfdd;
+        Evaluate(r.a, c.a, d.a, &f->a, &dfdr, &dfdc, &dfdd);
+        f->v = dfdr * r.v + dfdc * c.v + dfdd * d.v;
+    }
+
+private:
+    /**
+     * @brief Cubic Hermite spline through p[0], ..., p[3] at x in [0, 1) between
+     *        p[1] and p[2], with central difference tangents as ::ceres::CubicHermiteSpline.
+     */
+    inline static void spline(const double* p, const double x,
+                              double& f, double& dfdx)
+    {
+        const double a = 0.5 * (-p[0] + 3.0 * p[1] - 3.0 * p[2] + p[3]);
+        const double b = 0.5 * (2.0 * p[0] - 5.0 * p[1] + 4.0 * p[2] - p[3]);
+        const double c = 0.5 * (-p[0] + p[2]);
+        f    = p[1] + x * (c + x * (b + x * a));
+        dfdx = c + x * (2.0 * b + 3.0 * a * x);
+    }
+
+    const grid_t& grid_;
+};
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_CERES_TRICUBIC_INTERPOLATOR_HPP
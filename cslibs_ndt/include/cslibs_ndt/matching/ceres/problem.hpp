@@ -11,6 +11,8 @@
 #include <cslibs_ndt/matching/ceres/map/scan_match_cost_functor_2d.hpp>
 #include <cslibs_ndt/matching/ceres/map/scan_match_cost_functor_3d_quaternion.hpp>
 #include <cslibs_ndt/matching/ceres/map/scan_match_cost_functor_3d_rpy.hpp>
+#include <cslibs_ndt/matching/ceres/map/d2d_cost_function.hpp>
+#include <cslibs_ndt/matching/ceres/map/scan_match_cost_function.hpp>
 
 #include <cslibs_ndt/matching/ceres/local_parameterization.hpp>
 
@@ -18,33 +20,100 @@
 #include <ceres/local_parameterization.h>
 
 #include <type_traits>
+#include <vector>
+#include <stdexcept>
 
 namespace cslibs_ndt {
 namespace matching {
 namespace ceres {
 
+/**
+ * @brief How the Jacobians of the scan match cost are computed: ceres::Jet arithmetic,
+ *        finite differences or the closed-form ScanMatchCostFunction (Flag::DIRECT only).
+ */
+enum class Differentiation { AUTOMATIC, NUMERIC, ANALYTIC };
+
+namespace detail {
+template <Flag flag_t>
+struct AnalyticScanMatch
+{
+    template <typename creator_t, typename ... args_t>
+    static inline std::vector<::ceres::CostFunction*> create(const double& map_weight,
+                                                             const std::size_t chunk_size,
+                                                             const args_t &...args)
+    {
+        return chunk_size > 0ul ?
+                    creator_t::CreateChunked(map_weight, chunk_size, args...) :
+                    std::vector<::ceres::CostFunction*>{creator_t::Create(map_weight, args...)};
+    }
+};
+
+template <>
+struct AnalyticScanMatch<Flag::INTERPOLATION>
+{
+    template <typename creator_t, typename ... args_t>
+    static inline std::vector<::ceres::CostFunction*> create(const double&,
+                                                             const std::size_t,
+                                                             const args_t &...)
+    {
+        throw std::runtime_error("[Problem]: analytic derivatives are only available for Flag::DIRECT");
+    }
+};
+
+/**
+ * @brief Scan match residual blocks, chunk_size 0 adds the whole scan as one block.
+ */
+template <typename functor_creator_t, typename function_creator_t, Flag flag_t, typename ... args_t>
+inline void AddScanMatchResidualBlocks(const double& map_weight,
+                                       double* ceres_translation, double* ceres_rotation,
+                                       ::ceres::Problem& problem,
+                                       const Differentiation differentiation,
+                                       const std::size_t chunk_size,
+                                       const args_t &...args)
+{
+    if (map_weight == 0.0)
+        return;
+
+    std::vector<::ceres::CostFunction*> functions;
+    switch (differentiation) {
+    case Differentiation::ANALYTIC:
+        functions = AnalyticScanMatch<flag_t>::template create<function_creator_t>(map_weight, chunk_size, args...);
+        break;
+    case Differentiation::NUMERIC:
+        functions = chunk_size > 0ul ?
+                    functor_creator_t::CreateChunkedNumericDiffCostFunctions(map_weight, chunk_size, args...) :
+                    std::vector<::ceres::CostFunction*>{functor_creator_t::CreateNumericDiffCostFunction(map_weight, args...)};
+        break;
+    default:
+        functions = chunk_size > 0ul ?
+                    functor_creator_t::CreateChunkedAutoDiffCostFunctions(map_weight, chunk_size, args...) :
+                    std::vector<::ceres::CostFunction*>{functor_creator_t::CreateAutoDiffCostFunction(map_weight, args...)};
+        break;
+    }
+    for (::ceres::CostFunction* function : functions)
+        problem.AddResidualBlock(function, nullptr, ceres_translation, ceres_rotation);
+}
+
+inline Differentiation toDifferentiation(const bool use_numeric_diff)
+{
+    return use_numeric_diff ? Differentiation::NUMERIC : Differentiation::AUTOMATIC;
+}
+}
+
 template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename ... args_t>
 inline void Problem2d(const double& translation_weight, const double& rotation_weight, const double& map_weight,
                       const cslibs_math::linear::Vector<double,2>& translation, const double& rotation,
                       double* ceres_translation, double* ceres_rotation,
                       ::ceres::Problem& problem,
-                      const bool use_numeric_diff,
+                      const Differentiation differentiation,
                       const args_t &...args)
 {
     problem.AddParameterBlock(ceres_translation, 2, nullptr);
     problem.AddParameterBlock(ceres_rotation, 1, EulerPlus<1>::CreateAutoDiff());
 
-    if (map_weight != 0.0) {
-      problem.AddResidualBlock(
-                  use_numeric_diff ?
-            cslibs_ndt::matching::ceres::ScanMatchCostFunctor2dCreator<ndt_t, flag_t>::
-                  CreateNumericDiffCostFunction(map_weight, args...) :
-            cslibs_ndt::matching::ceres::ScanMatchCostFunctor2dCreator<ndt_t, flag_t>::
-                  CreateAutoDiffCostFunction(map_weight, args...),
-            nullptr,
-            ceres_translation,
-            ceres_rotation);
-    }
+    detail::AddScanMatchResidualBlocks<ScanMatchCostFunctor2dCreator<ndt_t, flag_t>,
+                                       ScanMatchCostFunction2dCreator<ndt_t>, flag_t>(
+                map_weight, ceres_translation, ceres_rotation, problem, differentiation, 0ul, args...);
     if (translation_weight != 0.0) {
       problem.AddResidualBlock(
             cslibs_ndt::matching::ceres::TranslationCostFunctor2d::
@@ -61,13 +130,27 @@ inline void Problem2d(const double& translation_weight, const double& rotation_w
     }
 }
 
+template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename ... args_t>
+inline void Problem2d(const double& translation_weight, const double& rotation_weight, const double& map_weight,
+                      const cslibs_math::linear::Vector<double,2>& translation, const double& rotation,
+                      double* ceres_translation, double* ceres_rotation,
+                      ::ceres::Problem& problem,
+                      const bool use_numeric_diff,
+                      const args_t &...args)
+{
+    Problem2d<ndt_t, flag_t>(translation_weight, rotation_weight, map_weight,
+                             translation, rotation,
+                             ceres_translation, ceres_rotation,
+                             problem, detail::toDifferentiation(use_numeric_diff), args...);
+}
+
 template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename ... args_t>
 inline void Problem3dQuaternion(const double& translation_weight, const double& rotation_weight, const double& map_weight,
                                 const cslibs_math::linear::Vector<double,3>& translation, const cslibs_math_3d::Quaterniond& rotation,
                                 double* ceres_translation, double* ceres_rotation,
                                 ::ceres::Problem& problem,
                                 const bool only_yaw,
-                                const bool use_numeric_diff,
+                                const Differentiation differentiation,
                                 const args_t &...args)
 {
     problem.AddParameterBlock(ceres_translation, 3, only_yaw ? new ::ceres::SubsetParameterization(3, { 2 }) :
@@ -75,17 +158,57 @@ inline void Problem3dQuaternion(const double& translation_weight, const double&
     problem.AddParameterBlock(ceres_rotation, 4, only_yaw ? YawOnlyQuaternionPlus::CreateAutoDiff() :
                                                             new ::ceres::QuaternionParameterization());
 
-    if (map_weight != 0.0) {
+    detail::AddScanMatchResidualBlocks<ScanMatchCostFunctor3dQuaternionCreator<ndt_t, flag_t>,
+                                       ScanMatchCostFunction3dQuaternionCreator<ndt_t>, flag_t>(
+                map_weight, ceres_translation, ceres_rotation, problem, differentiation, 0ul, args...);
+    if (translation_weight != 0.0) {
       problem.AddResidualBlock(
-                  use_numeric_diff ?
-            cslibs_ndt::matching::ceres::ScanMatchCostFunctor3dQuaternionCreator<ndt_t, flag_t>::
-                  CreateNumericDiffCostFunction(map_weight, args...) :
-            cslibs_ndt::matching::ceres::ScanMatchCostFunctor3dQuaternionCreator<ndt_t, flag_t>::
-                  CreateAutoDiffCostFunction(map_weight, args...),
+            cslibs_ndt::matching::ceres::TranslationCostFunctor3d::
+                  CreateAutoDiffCostFunction(translation_weight, translation),
+            nullptr,
+            ceres_translation);
+    }
+    if (rotation_weight != 0.0) {
+      problem.AddResidualBlock(
+            cslibs_ndt::matching::ceres::RotationCostFunctor3dQuaternion::
+                  CreateAutoDiffCostFunction(rotation_weight, rotation),
             nullptr,
-            ceres_translation,
             ceres_rotation);
     }
+}
+
+template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename ... args_t>
+inline void Problem3dQuaternion(const double& translation_weight, const double& rotation_weight, const double& map_weight,
+                                const cslibs_math::linear::Vector<double,3>& translation, const cslibs_math_3d::Quaterniond& rotation,
+                                double* ceres_translation, double* ceres_rotation,
+                                ::ceres::Problem& problem,
+                                const bool only_yaw,
+                                const bool use_numeric_diff,
+                                const args_t &...args)
+{
+    Problem3dQuaternion<ndt_t, flag_t>(translation_weight, rotation_weight, map_weight,
+                                       translation, rotation,
+                                       ceres_translation, ceres_rotation,
+                                       problem, only_yaw, detail::toDifferentiation(use_numeric_diff), args...);
+}
+
+template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename ... args_t>
+inline void Problem3dRPY(const double& translation_weight, const double& rotation_weight, const double& map_weight,
+                         const cslibs_math::linear::Vector<double,3>& translation, const cslibs_math::linear::Vector<double,3>& rotation,
+                         double* ceres_translation, double* ceres_rotation,
+                         ::ceres::Problem& problem,
+                         const bool only_yaw,
+                         const Differentiation differentiation,
+                         const args_t &...args)
+{
+    problem.AddParameterBlock(ceres_translation, 3, only_yaw ? new ::ceres::SubsetParameterization(3, { 2 }) :
+                                                               nullptr);
+    problem.AddParameterBlock(ceres_rotation, 3, only_yaw ? YawOnlyEulerPlus::CreateAutoDiff() :
+                                                            EulerPlus<3>::CreateAutoDiff());
+
+    detail::AddScanMatchResidualBlocks<ScanMatchCostFunctor3dRPYCreator<ndt_t, flag_t>,
+                                       ScanMatchCostFunction3dRPYCreator<ndt_t>, flag_t>(
+                map_weight, ceres_translation, ceres_rotation, problem, differentiation, 0ul, args...);
     if (translation_weight != 0.0) {
       problem.AddResidualBlock(
             cslibs_ndt::matching::ceres::TranslationCostFunctor3d::
@@ -95,7 +218,7 @@ inline void Problem3dQuaternion(const double& translation_weight, const double&
     }
     if (rotation_weight != 0.0) {
       problem.AddResidualBlock(
-            cslibs_ndt::matching::ceres::RotationCostFunctor3dQuaternion::
+            cslibs_ndt::matching::ceres::RotationCostFunctor3dRPY::
                   CreateAutoDiffCostFunction(rotation_weight, rotation),
             nullptr,
             ceres_rotation);
@@ -110,6 +233,155 @@ inline void Problem3dRPY(const double& translation_weight, const double& rotatio
                          const bool only_yaw,
                          const bool use_numeric_diff,
                          const args_t &...args)
+{
+    Problem3dRPY<ndt_t, flag_t>(translation_weight, rotation_weight, map_weight,
+                                translation, rotation,
+                                ceres_translation, ceres_rotation,
+                                problem, only_yaw, detail::toDifferentiation(use_numeric_diff), args...);
+}
+
+/**
+ * @brief Chunked variants of the problems above, the scan match cost is split into residual
+ *        blocks of at most chunk_size points, which ceres evaluates in parallel with
+ *        Solver::Options::num_threads. The points are copied into the chunks. With more than
+ *        one thread the map has to be settled before solving, see map::settle.
+ */
+template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename ... args_t>
+inline void Problem2dChunked(const double& translation_weight, const double& rotation_weight, const double& map_weight,
+                             const cslibs_math::linear::Vector<double,2>& translation, const double& rotation,
+                             double* ceres_translation, double* ceres_rotation,
+                             ::ceres::Problem& problem,
+                             const Differentiation differentiation,
+                             const std::size_t chunk_size,
+                             const args_t &...args)
+{
+    Problem2d<ndt_t, flag_t>(translation_weight, rotation_weight, 0.0,
+                             translation, rotation,
+                             ceres_translation, ceres_rotation,
+                             problem, differentiation, args...);
+    detail::AddScanMatchResidualBlocks<ScanMatchCostFunctor2dCreator<ndt_t, flag_t>,
+                                       ScanMatchCostFunction2dCreator<ndt_t>, flag_t>(
+                map_weight, ceres_translation, ceres_rotation, problem, differentiation, chunk_size, args...);
+}
+
+template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename ... args_t>
+inline void Problem3dQuaternionChunked(const double& translation_weight, const double& rotation_weight, const double& map_weight,
+                                       const cslibs_math::linear::Vector<double,3>& translation, const cslibs_math_3d::Quaterniond& rotation,
+                                       double* ceres_translation, double* ceres_rotation,
+                                       ::ceres::Problem& problem,
+                                       const bool only_yaw,
+                                       const Differentiation differentiation,
+                                       const std::size_t chunk_size,
+                                       const args_t &...args)
+{
+    Problem3dQuaternion<ndt_t, flag_t>(translation_weight, rotation_weight, 0.0,
+                                       translation, rotation,
+                                       ceres_translation, ceres_rotation,
+                                       problem, only_yaw, differentiation, args...);
+    detail::AddScanMatchResidualBlocks<ScanMatchCostFunctor3dQuaternionCreator<ndt_t, flag_t>,
+                                       ScanMatchCostFunction3dQuaternionCreator<ndt_t>, flag_t>(
+                map_weight, ceres_translation, ceres_rotation, problem, differentiation, chunk_size, args...);
+}
+
+template <typename ndt_t, Flag flag_t = Flag::DIRECT, typename ... args_t>
+inline void Problem3dRPYChunked(const double& translation_weight, const double& rotation_weight, const double& map_weight,
+                                const cslibs_math::linear::Vector<double,3>& translation, const cslibs_math::linear::Vector<double,3>& rotation,
+                                double* ceres_translation, double* ceres_rotation,
+                                ::ceres::Problem& problem,
+                                const bool only_yaw,
+                                const Differentiation differentiation,
+                                const std::size_t chunk_size,
+                                const args_t &...args)
+{
+    Problem3dRPY<ndt_t, flag_t>(translation_weight, rotation_weight, 0.0,
+                                translation, rotation,
+                                ceres_translation, ceres_rotation,
+                                problem, only_yaw, differentiation, args...);
+    detail::AddScanMatchResidualBlocks<ScanMatchCostFunctor3dRPYCreator<ndt_t, flag_t>,
+                                       ScanMatchCostFunction3dRPYCreator<ndt_t>, flag_t>(
+                map_weight, ceres_translation, ceres_rotation, problem, differentiation, chunk_size, args...);
+}
+
+/**
+ * @brief D2D variants of the problems above, args are the scan distributions,
+ *        the map and the additional map arguments. Jacobians are analytic.
+ */
+template <typename ndt_t, typename ... args_t>
+inline void Problem2dD2D(const double& translation_weight, const double& rotation_weight, const double& map_weight,
+                         const cslibs_math::linear::Vector<double,2>& translation, const double& rotation,
+                         double* ceres_translation, double* ceres_rotation,
+                         ::ceres::Problem& problem,
+                         const args_t &...args)
+{
+    problem.AddParameterBlock(ceres_translation, 2, nullptr);
+    problem.AddParameterBlock(ceres_rotation, 1, EulerPlus<1>::CreateAutoDiff());
+
+    if (map_weight != 0.0) {
+      problem.AddResidualBlock(
+            cslibs_ndt::matching::ceres::D2DCostFunction2d<ndt_t>::Create(map_weight, args...),
+            nullptr,
+            ceres_translation,
+            ceres_rotation);
+    }
+    if (translation_weight != 0.0) {
+      problem.AddResidualBlock(
+            cslibs_ndt::matching::ceres::TranslationCostFunctor2d::
+                  CreateAutoDiffCostFunction(translation_weight, translation),
+            nullptr,
+            ceres_translation);
+    }
+    if (rotation_weight != 0.0) {
+      problem.AddResidualBlock(
+            cslibs_ndt::matching::ceres::RotationCostFunctor2d::
+                  CreateAutoDiffCostFunction(rotation_weight, rotation),
+            nullptr,
+            ceres_rotation);
+    }
+}
+
+template <typename ndt_t, typename ... args_t>
+inline void Problem3dQuaternionD2D(const double& translation_weight, const double& rotation_weight, const double& map_weight,
+                                   const cslibs_math::linear::Vector<double,3>& translation, const cslibs_math_3d::Quaterniond& rotation,
+                                   double* ceres_translation, double* ceres_rotation,
+                                   ::ceres::Problem& problem,
+                                   const bool only_yaw,
+                                   const args_t &...args)
+{
+    problem.AddParameterBlock(ceres_translation, 3, only_yaw ? new ::ceres::SubsetParameterization(3, { 2 }) :
+                                                               nullptr);
+    problem.AddParameterBlock(ceres_rotation, 4, only_yaw ? YawOnlyQuaternionPlus::CreateAutoDiff() :
+                                                            new ::ceres::QuaternionParameterization());
+
+    if (map_weight != 0.0) {
+      problem.AddResidualBlock(
+            cslibs_ndt::matching::ceres::D2DCostFunction3dQuaternion<ndt_t>::Create(map_weight, args...),
+            nullptr,
+            ceres_translation,
+            ceres_rotation);
+    }
+    if (translation_weight != 0.0) {
+      problem.AddResidualBlock(
+            cslibs_ndt::matching::ceres::TranslationCostFunctor3d::
+                  CreateAutoDiffCostFunction(translation_weight, translation),
+            nullptr,
+            ceres_translation);
+    }
+    if (rotation_weight != 0.0) {
+      problem.AddResidualBlock(
+            cslibs_ndt::matching::ceres::RotationCostFunctor3dQuaternion::
+                  CreateAutoDiffCostFunction(rotation_weight, rotation),
+            nullptr,
+            ceres_rotation);
+    }
+}
+
+template <typename ndt_t, typename ... args_t>
+inline void Problem3dRPYD2D(const double& translation_weight, const double& rotation_weight, const double& map_weight,
+                            const cslibs_math::linear::Vector<double,3>& translation, const cslibs_math::linear::Vector<double,3>& rotation,
+                            double* ceres_translation, double* ceres_rotation,
+                            ::ceres::Problem& problem,
+                            const bool only_yaw,
+                            const args_t &...args)
 {
     problem.AddParameterBlock(ceres_translation, 3, only_yaw ? new ::ceres::SubsetParameterization(3, { 2 }) :
                                                                nullptr);
@@ -118,11 +390,7 @@ inline void Problem3dRPY(const double& translation_weight, const double& rotatio
 
     if (map_weight != 0.0) {
       problem.AddResidualBlock(
-                  use_numeric_diff ?
-            cslibs_ndt::matching::ceres::ScanMatchCostFunctor3dRPYCreator<ndt_t, flag_t>::
-                  CreateNumericDiffCostFunction(map_weight, args...) :
-            cslibs_ndt::matching::ceres::ScanMatchCostFunctor3dRPYCreator<ndt_t, flag_t>::
-                  CreateAutoDiffCostFunction(map_weight, args...),
+            cslibs_ndt::matching::ceres::D2DCostFunction3dRPY<ndt_t>::Create(map_weight, args...),
             nullptr,
             ceres_translation,
             ceres_rotation);
@@ -0,0 +1,34 @@
+#ifndef CSLIBS_NDT_MATCHING_COARSE_TO_FINE_HPP
+#define CSLIBS_NDT_MATCHING_COARSE_TO_FINE_HPP
+
+#include <cslibs_ndt/map/pyramid.hpp>
+
+namespace cslibs_ndt {
+namespace matching {
+
+/**
+ * @brief Coarse-to-fine matching on a map pyramid: the coarsest level is solved from the
+ *        initial guess, every finer level is warm-started with the result of the level above.
+ *        Independent of the solver, e.g. one of the ceres Problem front-ends per level.
+ * @param pyramid       map pyramid
+ * @param initial_guess start on the coarsest level
+ * @param solve         solve(map, level, guess) returns the transform found on one level
+ * @param finest_level  last level to solve, 0 is the base map
+ * @return the transform of the finest level solved
+ */
+template <typename map_t, typename solve_t>
+inline typename map_t::pose_t coarseToFine(const map::Pyramid<map_t>    &pyramid,
+                                           const typename map_t::pose_t &initial_guess,
+                                           const solve_t                &solve,
+                                           const std::size_t             finest_level = 0)
+{
+    typename map_t::pose_t guess = initial_guess;
+    for (std::size_t l = pyramid.levels() ; l > finest_level ; --l)
+        guess = solve(*pyramid.at(l - 1), l - 1, guess);
+    return guess;
+}
+
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_COARSE_TO_FINE_HPP
@@ -0,0 +1,288 @@
+#ifndef CSLIBS_NDT_MATCHING_D2D_HPP
+#define CSLIBS_NDT_MATCHING_D2D_HPP
+
+#include <cslibs_ndt/matching/access.hpp>
+#include <cslibs_ndt/matching/newton/model.hpp>
+
+#include <vector>
+#include <tuple>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace d2d {
+
+/**
+ * @brief One Gaussian of a scan in the frame of the scan points,
+ *        weight is the number of points it represents.
+ */
+template <std::size_t Dim>
+struct EIGEN_ALIGN16 ScanDistribution
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    Eigen::Matrix<double,Dim,1>   mean;
+    Eigen::Matrix<double,Dim,Dim> covariance;
+    double                        weight;
+};
+
+/**
+ * @brief Scan summarized by the distributions of a small NDT map, the input of
+ *        distribution-to-distribution (D2D) matching (Stoyanov et al., 2012).
+ *        All valid distributions of all storages are used, each weighted with
+ *        its number of points divided by the bin count like the map weights them.
+ */
+template <std::size_t Dim>
+class Scan
+{
+public:
+    using distribution_t = ScanDistribution<Dim>;
+    using container_t    = std::vector<distribution_t, Eigen::aligned_allocator<distribution_t>>;
+    using iterator_t     = typename container_t::const_iterator;
+
+    inline Scan() = default;
+
+    template <cslibs_ndt::map::tags::option option_t,
+              typename T,
+              template <typename, typename, typename...> class backend_t>
+    inline explicit Scan(const cslibs_ndt::map::Map<option_t,Dim,cslibs_ndt::Distribution,T,backend_t> &map)
+    {
+        using map_t = cslibs_ndt::map::Map<option_t,Dim,cslibs_ndt::Distribution,T,backend_t>;
+
+        // distributions live in the map frame of the scan map
+        Eigen::Matrix<double,Dim,Dim> rotation;
+        Eigen::Matrix<double,Dim,1>   translation;
+        newton::Model<Dim>::toEigen(map.getInitialOrigin(), rotation, translation);
+
+        for (const auto &storage : map.getStorages()) {
+            storage->traverse([this, &rotation, &translation](const typename map_t::index_t &,
+                                                              const typename map_t::distribution_t &d) {
+                if (!d.valid())
+                    return;
+                distribution_t s;
+                s.mean       = rotation * d.getMean().template cast<double>() + translation;
+                s.covariance = rotation * d.getCovariance().template cast<double>() * rotation.transpose();
+                s.weight     = static_cast<double>(d.getN()) * static_cast<double>(map_t::div_count);
+                distributions_.emplace_back(s);
+                weight_ += s.weight;
+            });
+        }
+    }
+
+    /**
+     * @brief Build the scan map from points with Map::insert.
+     * @param resolution resolution of the scan map, usually the one of the target map
+     */
+    template <typename T, typename iterator_t>
+    inline static Scan fromPoints(const iterator_t &points_begin,
+                                  const iterator_t &points_end,
+                                  const T           resolution)
+    {
+        using map_t = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,Dim,cslibs_ndt::Distribution,T>;
+
+        map_t map(typename map_t::pose_t(), resolution);
+        map.insert(points_begin, points_end);
+        return Scan(map);
+    }
+
+    inline std::size_t size() const
+    {
+        return distributions_.size();
+    }
+
+    inline bool empty() const
+    {
+        return distributions_.empty();
+    }
+
+    /**
+     * @brief Sum of all distribution weights, i.e. the number of points.
+     */
+    inline double weight() const
+    {
+        return weight_;
+    }
+
+    inline const distribution_t& operator [] (const std::size_t i) const
+    {
+        return distributions_[i];
+    }
+
+    inline iterator_t begin() const
+    {
+        return distributions_.begin();
+    }
+
+    inline iterator_t end() const
+    {
+        return distributions_.end();
+    }
+
+private:
+    container_t distributions_;
+    double      weight_ = 0.0;
+};
+
+/**
+ * @brief D2D score of scan distribution i against the distributions j of the map bundle
+ *        containing its transformed mean:
+ *            sum_j w_j * exp(-0.5 * m^T B^-1 m),  m = A mu_i + b - mu_j,  B = A C_i A^T + C_j,
+ *        with closed-form gradient and Hessian w.r.t. translation and Rotations rotation
+ *        parameters. Reduces to the point-to-distribution terms for C_i = 0.
+ */
+template <typename ndt_t, std::size_t Rotations>
+class Terms
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    static constexpr std::size_t Dim = std::tuple_size<typename ndt_t::index_t>::value;
+    static constexpr std::size_t N   = Dim + Rotations;
+
+    using point_d_t      = Eigen::Matrix<double,Dim,1>;
+    using matrix_d_t     = Eigen::Matrix<double,Dim,Dim>;
+    using vector_t       = Eigen::Matrix<double,N,1>;
+    using hessian_t      = Eigen::Matrix<double,N,N>;
+    using distribution_t = typename ndt_t::distribution_t::distribution_t;
+
+    /**
+     * @brief Pose in the map frame with the derivatives of its rotation,
+     *        prepared once per evaluation of a whole scan.
+     */
+    struct EIGEN_ALIGN16 Transform
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        matrix_d_t A;
+        point_d_t  b;
+        matrix_d_t dA[Rotations];
+        matrix_d_t ddA[Rotations * Rotations];
+        bool       second;
+    };
+
+    template <typename ... args_t>
+    inline explicit Terms(const ndt_t &map,
+                          const args_t &...args) :
+        map_(map),
+        access_(map, args...),
+        resolution_inv_(1.0 / static_cast<double>(map.getBundleResolution()))
+    {
+        newton::Model<Dim>::toEigen(map.getInitialOrigin().inverse(), rotation_, translation_);
+    }
+
+    /**
+     * @brief Move a pose and its rotation derivatives into the map frame.
+     * @param dR  Rotations first derivatives of R
+     * @param ddR Rotations x Rotations second derivatives of R, optional
+     */
+    inline Transform transform(const matrix_d_t &R,
+                               const point_d_t  &t,
+                               const matrix_d_t *dR,
+                               const matrix_d_t *ddR = nullptr) const
+    {
+        Transform T;
+        T.A = rotation_ * R;
+        T.b = rotation_ * t + translation_;
+        for (std::size_t r = 0 ; r < Rotations ; ++r)
+            T.dA[r] = rotation_ * dR[r];
+        T.second = ddR != nullptr;
+        if (T.second) {
+            for (std::size_t r = 0 ; r < Rotations * Rotations ; ++r)
+                T.ddA[r] = rotation_ * ddR[r];
+        }
+        return T;
+    }
+
+    /**
+     * @brief Score of one scan distribution times weight, gradient and hessian are optional
+     *        and get weight times the derivatives added. The hessian requires second derivatives.
+     */
+    inline double evaluate(const ScanDistribution<Dim> &s,
+                           const Transform             &T,
+                           const double                 weight,
+                           vector_t                    *gradient = nullptr,
+                           hessian_t                   *hessian  = nullptr) const
+    {
+        using jacobian_t = Eigen::Matrix<double,Dim,N>;
+
+        /// step one: transform into the map frame and find the bundle
+        const point_d_t q = T.A * s.mean + T.b;
+        typename ndt_t::index_t bi;
+        for (std::size_t k = 0 ; k < Dim ; ++k)
+            bi[k] = static_cast<int>(std::floor(q(k) * resolution_inv_));
+        const typename ndt_t::distribution_bundle_t *bundle = map_.get(bi);
+        if (!bundle)
+            return 0.0;
+
+        /// step two: terms shared by all map distributions, Z_r = dB/dr
+        const matrix_d_t CAt = s.covariance * T.A.transpose();
+        const matrix_d_t S   = T.A * CAt;
+        jacobian_t J;
+        matrix_d_t Z[Rotations];
+        point_d_t  second[Rotations * Rotations];
+        matrix_d_t Z2[Rotations * Rotations];
+        if (gradient) {
+            J.template leftCols<Dim>() = rotation_;
+            for (std::size_t r = 0 ; r < Rotations ; ++r) {
+                J.col(Dim + r) = T.dA[r] * s.mean;
+                const matrix_d_t Y = T.dA[r] * CAt;
+                Z[r] = Y + Y.transpose();
+            }
+        }
+        if (hessian && T.second) {
+            for (std::size_t r = 0 ; r < Rotations ; ++r) {
+                for (std::size_t c = 0 ; c < Rotations ; ++c) {
+                    const std::size_t rc = r * Rotations + c;
+                    const matrix_d_t W = T.ddA[rc] * CAt;
+                    const matrix_d_t V = T.dA[r] * s.covariance * T.dA[c].transpose();
+                    second[rc] = T.ddA[rc] * s.mean;
+                    Z2[rc]     = W + W.transpose() + V + V.transpose();
+                }
+            }
+        }
+
+        /// step three: accumulate the Gaussian terms
+        double score = 0.0;
+        for (std::size_t i = 0 ; i < ndt_t::bin_count ; ++i) {
+            access_(bundle->at(i), [&](const distribution_t &d, const double w) {
+                const point_d_t  m    = q - d.getMean().template cast<double>();
+                const matrix_d_t Binv = (S + d.getCovariance().template cast<double>()).inverse();
+                const point_d_t  x    = Binv * m;
+                const double     e    = weight * w * std::exp(-0.5 * m.dot(x));
+                score += e;
+                if (!gradient)
+                    return;
+
+                // ds/dp_k = 2 J_k^T x - x^T Z_k x with s = m^T B^-1 m
+                vector_t ds = 2.0 * J.transpose() * x;
+                for (std::size_t r = 0 ; r < Rotations ; ++r)
+                    ds(Dim + r) -= x.dot(Z[r] * x);
+                *gradient -= 0.5 * e * ds;
+                if (!hessian || !T.second)
+                    return;
+
+                // d2s/dp_k dp_l = 2 u_k^T B^-1 u_l + 2 x^T d2m/dp_k dp_l - x^T Z_kl x, u_k = J_k - Z_k x
+                jacobian_t U = J;
+                for (std::size_t r = 0 ; r < Rotations ; ++r)
+                    U.col(Dim + r) -= Z[r] * x;
+                hessian_t dds = 2.0 * U.transpose() * Binv * U;
+                for (std::size_t r = 0 ; r < Rotations * Rotations ; ++r)
+                    dds(Dim + r / Rotations, Dim + r % Rotations) += 2.0 * x.dot(second[r]) - x.dot(Z2[r] * x);
+                *hessian += e * (0.25 * ds * ds.transpose() - 0.5 * dds);
+            });
+        }
+        return score;
+    }
+
+private:
+    const ndt_t        &map_;
+    const Access<ndt_t> access_;
+    const double        resolution_inv_;
+    matrix_d_t          rotation_;      // map <- world
+    point_d_t           translation_;
+};
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_D2D_HPP
@@ -0,0 +1,148 @@
+#ifndef CSLIBS_NDT_MATCHING_GRADIENT_HPP
+#define CSLIBS_NDT_MATCHING_GRADIENT_HPP
+
+#include <cslibs_ndt/matching/newton/model.hpp>
+
+#include <array>
+#include <vector>
+#include <cmath>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace gradient {
+
+/**
+ * @brief Chains per point score gradients through the transform.
+ *        gradients holds Dim entries per point, the derivative of the (weighted) score
+ *        w.r.t. the transformed point in the world frame, as the batch sampleNonNormalized
+ *        of the maps returns it. Calls fn(k, row) with row = d/dx g_k^T (R(x) p_k + t(x))
+ *        for the points [begin, end), x being translation and rotation angles of newton::Model<Dim>.
+ */
+template <std::size_t Dim, typename T, typename point_t, typename fn_t>
+inline void rows(const double      *x,
+                 const point_t     *points,
+                 const T           *gradients,
+                 const std::size_t  begin,
+                 const std::size_t  end,
+                 const fn_t        &fn)
+{
+    using model_t   = newton::Model<Dim>;
+    using point_d_t = Eigen::Matrix<double,Dim,1>;
+
+    model_t model;
+    model.update(Eigen::Map<const typename model_t::vector_t>(x));
+
+    std::array<double,model_t::parameters> row;
+    for (std::size_t k = begin ; k < end ; ++k) {
+        point_d_t g, p;
+        for (std::size_t j = 0 ; j < Dim ; ++j) {
+            g(j) = static_cast<double>(gradients[k * Dim + j]);
+            p(j) = static_cast<double>(points[k](j));
+        }
+        for (std::size_t j = 0 ; j < Dim ; ++j)
+            row[j] = g(j);
+        for (std::size_t r = 0 ; r < model_t::rotations ; ++r)
+            row[Dim + r] = g.dot(model.firstDerivative(r) * p);
+        fn(k, row);
+    }
+}
+
+/**
+ * @brief Same for x = (tx, ty, tz, qx, qy, qz, qw). The rotation is the one of the
+ *        normalized quaternion, so the rows have no component along q.
+ */
+template <typename T, typename point_t, typename fn_t>
+inline void rowsQuaternion(const double      *x,
+                           const point_t     *points,
+                           const T           *gradients,
+                           const std::size_t  begin,
+                           const std::size_t  end,
+                           const fn_t        &fn)
+{
+    using vector_t = Eigen::Vector3d;
+
+    const Eigen::Vector4d q_raw(x[3], x[4], x[5], x[6]);
+    const double norm = q_raw.norm();
+    const Eigen::Vector4d q = norm > 0.0 ? Eigen::Vector4d(q_raw / norm) : Eigen::Vector4d::Zero();
+    const vector_t v(q(0), q(1), q(2));
+    const double   w = q(3);
+
+    std::array<double,7> row;
+    for (std::size_t k = begin ; k < end ; ++k) {
+        const vector_t g(static_cast<double>(gradients[k * 3]),
+                         static_cast<double>(gradients[k * 3 + 1]),
+                         static_cast<double>(gradients[k * 3 + 2]));
+        const vector_t p(static_cast<double>(points[k](0)),
+                         static_cast<double>(points[k](1)),
+                         static_cast<double>(points[k](2)));
+        for (std::size_t j = 0 ; j < 3 ; ++j)
+            row[j] = g(j);
+
+        /// R p = p + 2 w (v x p) + 2 v x (v x p), then through d(q/|q|)/dq = (I - q q^T) / |q|
+        Eigen::Vector4d dq;
+        const vector_t vp = v.cross(p);
+        for (int i = 0 ; i < 3 ; ++i) {
+            const vector_t ep = vector_t::Unit(i).cross(p);
+            dq(i) = g.dot(2.0 * w * ep + 2.0 * (vector_t::Unit(i).cross(vp) + v.cross(ep)));
+        }
+        dq(3) = g.dot(2.0 * vp);
+        if (norm > 0.0)
+            dq = (dq - q * q.dot(dq)) / norm;
+        for (std::size_t j = 0 ; j < 4 ; ++j)
+            row[3 + j] = dq(j);
+        fn(k, row);
+    }
+}
+
+/**
+ * @brief Adds the sum of all rows to grad.
+ */
+template <std::size_t Dim, typename T, typename point_t>
+inline void chain(const double                *x,
+                  const std::vector<point_t>  &points,
+                  const std::vector<T>        &gradients,
+                  double                      *grad)
+{
+    rows<Dim>(x, points.data(), gradients.data(), 0ul, points.size(),
+              [grad](const std::size_t, const std::array<double,Dim + newton::Model<Dim>::rotations> &row) {
+        for (std::size_t j = 0 ; j < row.size() ; ++j)
+            grad[j] += row[j];
+    });
+}
+
+template <typename T, typename point_t>
+inline void chainQuaternion(const double                *x,
+                            const std::vector<point_t>  &points,
+                            const std::vector<T>        &gradients,
+                            double                      *grad)
+{
+    rowsQuaternion(x, points.data(), gradients.data(), 0ul, points.size(),
+                   [grad](const std::size_t, const std::array<double,7> &row) {
+        for (std::size_t j = 0 ; j < row.size() ; ++j)
+            grad[j] += row[j];
+    });
+}
+
+/**
+ * @brief Derivative of the norm of a vector, zero at the origin.
+ */
+template <std::size_t N>
+inline void norm(const std::array<double,N> &v,
+                 const double                weight,
+                 double                     *grad)
+{
+    double n = 0.0;
+    for (const double e : v)
+        n += e * e;
+    n = std::sqrt(n);
+    if (n == 0.0)
+        return;
+    for (std::size_t i = 0 ; i < N ; ++i)
+        grad[i] += weight * v[i] / n;
+}
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_GRADIENT_HPP
@@ -0,0 +1,47 @@
+#ifndef CSLIBS_NDT_MATCHING_HYPOTHESES_HPP
+#define CSLIBS_NDT_MATCHING_HYPOTHESES_HPP
+
+#include <cslibs_ndt/utility/parallel.hpp>
+
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include <type_traits>
+
+namespace cslibs_ndt {
+namespace matching {
+
+/**
+ * @brief Matches one scan from several initial guesses, e.g. particle clusters or loop closure
+ *        candidates. The hypotheses are independent and handed out one at a time to a pool of
+ *        threads, so a slowly converging one does not hold up the others.
+ *        Independent of the solver, like coarseToFine.
+ * @param initial_guesses one start per hypothesis
+ * @param match           match(guess) returns the result of one hypothesis, called concurrently
+ * @param num_threads     0 uses all hardware threads
+ * @return the results in the order of the initial guesses
+ */
+template <typename pose_t, typename match_t>
+inline auto matchHypotheses(const std::vector<pose_t> &initial_guesses,
+                            const match_t             &match,
+                            const std::size_t          num_threads = 0)
+    -> std::vector<typename std::decay<decltype(match(initial_guesses.front()))>::type>
+{
+    using result_t = typename std::decay<decltype(match(initial_guesses.front()))>::type;
+
+    std::vector<result_t> results(initial_guesses.size());
+    const std::size_t threads = num_threads > 0ul ?
+                std::min(num_threads, initial_guesses.size()) : utility::num_threads(initial_guesses.size());
+
+    std::atomic<std::size_t> next(0ul);
+    utility::parallel_for(threads, threads, [&](const std::size_t, const std::size_t, const std::size_t) {
+        for (std::size_t i = next++ ; i < initial_guesses.size() ; i = next++)
+            results[i] = match(initial_guesses[i]);
+    });
+    return results;
+}
+
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_HYPOTHESES_HPP
@@ -0,0 +1,256 @@
+#ifndef CSLIBS_NDT_MATCHING_LATTICE_CACHE_HPP
+#define CSLIBS_NDT_MATCHING_LATTICE_CACHE_HPP
+
+#include <cslibs_ndt/matching/newton/model.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+#include <cslibs_ndt/utility/to_point.hpp>
+
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace cslibs_ndt {
+namespace matching {
+
+/**
+ * @brief Lazily sampled lattice of sampleNonNormalized at the integer multiples of the
+ *        sampling resolution in the world frame, the grid the ceres interpolators read.
+ *        Samples are computed a tile of tile_size^Dim lattice points at a time on first access
+ *        and kept until the bundles they fall into are invalidated, so one cache can be shared
+ *        by all cost functors and scans matched against the same map.
+ *        The map is settled on construction and the invalidated bundles again on invalidation,
+ *        see map::settle, so concurrent readers only read the map and are safe. The map must not
+ *        be written while the cache is read, changes are followed by invalidate before reading on.
+ */
+template <typename ndt_t>
+class LatticeCache
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    using Ptr = std::shared_ptr<LatticeCache<ndt_t>>;
+
+    static constexpr std::size_t Dim = std::tuple_size<typename ndt_t::index_t>::value;
+    static constexpr int tile_size = 16;
+
+    using index_t        = std::array<int,Dim>;
+    using bundle_index_t = typename ndt_t::index_t;
+    using point_t        = typename ndt_t::point_t;
+
+    /**
+     * @param map                 map to sample, must outlive the cache, settled with all hardware threads
+     * @param sampling_resolution distance of the lattice points
+     * @param args                additional map arguments, i.e. the inverse sensor model for occupancy maps
+     */
+    template <typename ... args_t>
+    inline LatticeCache(const ndt_t       &map,
+                        const double       sampling_resolution,
+                        const args_t      &...args) :
+        sampling_resolution_(sampling_resolution),
+        bundle_resolution_(static_cast<double>(map.getBundleResolution())),
+        map_(map),
+        sample_([&map, args...](const point_t &p) {
+            return static_cast<double>(map.sampleNonNormalized(p, args...));
+        })
+    {
+        if (sampling_resolution_ <= 0.0)
+            throw std::runtime_error("[LatticeCache]: sampling resolution must be positive");
+        cslibs_ndt::map::settle(map_);
+        newton::Model<Dim>::toEigen(map.getInitialOrigin(), rotation_, translation_);
+    }
+
+    inline double getSamplingResolution() const
+    {
+        return sampling_resolution_;
+    }
+
+    /**
+     * @brief Sample at the lattice point i, i.e. at i * sampling_resolution in the world frame.
+     */
+    inline double at(const index_t &i) const
+    {
+        index_t t;
+        std::size_t offset = 0;
+        for (std::size_t k = Dim ; k-- > 0 ; ) {
+            t[k] = floorDiv(i[k]);
+            offset = offset * tile_size + static_cast<std::size_t>(i[k] - t[k] * tile_size);
+        }
+        return (*tile(t))[offset];
+    }
+
+    /**
+     * @brief Samples at the n^Dim lattice points [min, min + n), the last index running fastest,
+     *        i.e. values[i0][i1]... Every tile overlapping the block is looked up once.
+     */
+    template <std::size_t n>
+    inline void block(const index_t &min, double *values) const
+    {
+        index_t t_min, t_max;
+        for (std::size_t k = 0 ; k < Dim ; ++k) {
+            t_min[k] = floorDiv(min[k]);
+            t_max[k] = floorDiv(min[k] + static_cast<int>(n) - 1);
+        }
+
+        index_t t = t_min;
+        do {
+            const std::shared_ptr<const tile_t> values_t = tile(t);
+            index_t lo, hi;
+            for (std::size_t k = 0 ; k < Dim ; ++k) {
+                lo[k] = std::max(min[k], t[k] * tile_size);
+                hi[k] = std::min(min[k] + static_cast<int>(n), (t[k] + 1) * tile_size) - 1;
+            }
+
+            index_t i = lo;
+            do {
+                std::size_t offset_t = 0, offset_b = 0;
+                for (std::size_t k = Dim ; k-- > 0 ; )
+                    offset_t = offset_t * tile_size + static_cast<std::size_t>(i[k] - t[k] * tile_size);
+                for (std::size_t k = 0 ; k < Dim ; ++k)
+                    offset_b = offset_b * n + static_cast<std::size_t>(i[k] - min[k]);
+                values[offset_b] = (*values_t)[offset_t];
+            } while (next(i, lo, hi));
+        } while (next(t, t_min, t_max));
+    }
+
+    /**
+     * @brief Settles the given bundle and drops all tiles with lattice points in it, to be called
+     *        for every bundle whose distributions changed.
+     */
+    inline void invalidate(const bundle_index_t &bundle)
+    {
+        cslibs_ndt::map::settle(map_, &bundle, &bundle + 1);
+
+        /// step one: lattice bounding box of the bundle's corners in the world frame
+        index_t min, max;
+        min.fill(std::numeric_limits<int>::max());
+        max.fill(std::numeric_limits<int>::min());
+        for (std::size_t c = 0 ; c < (1ul << Dim) ; ++c) {
+            vector_t corner;
+            for (std::size_t k = 0 ; k < Dim ; ++k)
+                corner(k) = (bundle[k] + ((c >> k) & 1ul)) * bundle_resolution_;
+            const vector_t w = rotation_ * corner + translation_;
+            for (std::size_t k = 0 ; k < Dim ; ++k) {
+                min[k] = std::min(min[k], floorDiv(static_cast<int>(std::floor(w(k) / sampling_resolution_))));
+                max[k] = std::max(max[k], floorDiv(static_cast<int>(std::ceil (w(k) / sampling_resolution_))));
+            }
+        }
+
+        /// step two: drop the tiles in it
+        std::unique_lock<std::shared_timed_mutex> l(mutex_);
+        index_t t = min;
+        do {
+            tiles_.erase(t);
+        } while (next(t, min, max));
+    }
+
+    /**
+     * @brief Drops the tiles of all bundles in [bundles_begin, bundles_end), e.g. of the
+     *        changes handed out by AbstractMap::consumeChanges.
+     */
+    template <typename iterator_t>
+    inline void invalidate(const iterator_t &bundles_begin,
+                           const iterator_t &bundles_end)
+    {
+        for (iterator_t it = bundles_begin ; it != bundles_end ; ++it)
+            invalidate(*it);
+    }
+
+    inline void clear()
+    {
+        std::unique_lock<std::shared_timed_mutex> l(mutex_);
+        tiles_.clear();
+    }
+
+    /**
+     * @brief Number of sampled tiles.
+     */
+    inline std::size_t size() const
+    {
+        std::shared_lock<std::shared_timed_mutex> l(mutex_);
+        return tiles_.size();
+    }
+
+private:
+    using vector_t = Eigen::Matrix<double,Dim,1>;
+    using tile_t   = std::vector<double>;
+
+    struct Hash
+    {
+        inline std::size_t operator()(const index_t &index) const
+        {
+            static constexpr std::size_t primes[] = {73856093ul, 19349663ul, 83492791ul};
+            std::size_t h = 0;
+            for (std::size_t i = 0 ; i < Dim ; ++i)
+                h ^= static_cast<std::size_t>(index[i]) * primes[i % 3];
+            return h;
+        }
+    };
+
+    inline static int floorDiv(const int i)
+    {
+        return i >= 0 ? i / tile_size : -((-i - 1) / tile_size) - 1;
+    }
+
+    /**
+     * @brief Advances i through the box [min, max], false once all indices were visited.
+     */
+    inline static bool next(index_t &i, const index_t &min, const index_t &max)
+    {
+        for (std::size_t k = 0 ; k < Dim ; ++k) {
+            if (++i[k] <= max[k])
+                return true;
+            i[k] = min[k];
+        }
+        return false;
+    }
+
+    inline std::shared_ptr<const tile_t> tile(const index_t &t) const
+    {
+        {
+            std::shared_lock<std::shared_timed_mutex> l(mutex_);
+            const auto it = tiles_.find(t);
+            if (it != tiles_.end())
+                return it->second;
+        }
+
+        /// sampled without holding the lock, a tile sampled concurrently by another thread wins
+        std::size_t size = 1;
+        for (std::size_t k = 0 ; k < Dim ; ++k)
+            size *= tile_size;
+        std::shared_ptr<tile_t> values(new tile_t(size));
+        for (std::size_t offset = 0 ; offset < size ; ++offset) {
+            index_t i;
+            std::size_t o = offset;
+            for (std::size_t k = 0 ; k < Dim ; ++k, o /= tile_size)
+                i[k] = t[k] * tile_size + static_cast<int>(o % tile_size);
+            (*values)[offset] = sample_(utility::to_point<point_t>([this, &i](const std::size_t k) {
+                return i[k] * sampling_resolution_;
+            }));
+        }
+
+        std::unique_lock<std::shared_timed_mutex> l(mutex_);
+        return tiles_.emplace(t, std::move(values)).first->second;
+    }
+
+    const double                              sampling_resolution_;
+    const double                              bundle_resolution_;
+    const ndt_t                              &map_;
+    const std::function<double(const point_t&)> sample_;
+    Eigen::Matrix<double,Dim,Dim>             rotation_;      // world <- map
+    vector_t                                  translation_;
+
+    mutable std::shared_timed_mutex           mutex_;
+    mutable std::unordered_map<index_t, std::shared_ptr<const tile_t>, Hash> tiles_;
+};
+
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_LATTICE_CACHE_HPP
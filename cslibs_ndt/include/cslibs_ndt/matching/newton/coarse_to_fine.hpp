@@ -0,0 +1,79 @@
+#ifndef CSLIBS_NDT_MATCHING_NEWTON_COARSE_TO_FINE_HPP
+#define CSLIBS_NDT_MATCHING_NEWTON_COARSE_TO_FINE_HPP
+
+#include <cslibs_ndt/matching/newton/match.hpp>
+#include <cslibs_ndt/matching/coarse_to_fine.hpp>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace newton {
+
+namespace detail {
+template <typename ndt_t, typename data_t, typename ... args_t>
+inline Result<typename ndt_t::pose_t> match(const map::Pyramid<ndt_t>    &pyramid,
+                                            const data_t                 &data,
+                                            const typename ndt_t::pose_t &initial_guess,
+                                            const Parameter              &parameter,
+                                            const args_t                 &...args)
+{
+    using pose_t = typename ndt_t::pose_t;
+
+    Result<pose_t> result;
+    result.transform = initial_guess;
+    coarseToFine(pyramid, initial_guess,
+                 [&](const ndt_t &map, const std::size_t, const pose_t &guess) {
+        const Result<pose_t> level = newton::match(map, data, guess, parameter, args...);
+        result.transform    = level.transform;
+        result.score        = level.score;
+        result.termination  = level.termination;
+        result.iterations  += level.iterations;
+        result.evaluations += level.evaluations;
+        result.duration    += level.duration;
+        return level.transform;
+    });
+    return result;
+}
+}
+
+/**
+ * @brief Newton matching on all levels of a map pyramid, coarse to fine.
+ *        Transform, score and termination are the ones of the base level, iterations,
+ *        evaluations and duration are summed over all levels.
+ *        A level without progress hands its guess on unchanged.
+ */
+template <typename ndt_t, typename points_t, typename ... args_t>
+inline Result<typename ndt_t::pose_t> match(const map::Pyramid<ndt_t>    &pyramid,
+                                            const points_t               &points,
+                                            const typename ndt_t::pose_t &initial_guess,
+                                            const Parameter              &parameter,
+                                            const args_t                 &...args)
+{
+    return detail::match(pyramid, points, initial_guess, parameter, args...);
+}
+
+/**
+ * @brief D2D matching on all levels of a map pyramid, coarse to fine.
+ */
+template <typename ndt_t, std::size_t Dim, typename ... args_t>
+inline Result<typename ndt_t::pose_t> match(const map::Pyramid<ndt_t>    &pyramid,
+                                            const d2d::Scan<Dim>         &scan,
+                                            const typename ndt_t::pose_t &initial_guess,
+                                            const Parameter              &parameter,
+                                            const args_t                 &...args)
+{
+    return detail::match(pyramid, scan, initial_guess, parameter, args...);
+}
+
+template <typename ndt_t, typename points_t>
+inline Result<typename ndt_t::pose_t> match(const map::Pyramid<ndt_t>    &pyramid,
+                                            const points_t               &points,
+                                            const typename ndt_t::pose_t &initial_guess)
+{
+    return match(pyramid, points, initial_guess, Parameter());
+}
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_NEWTON_COARSE_TO_FINE_HPP
@@ -0,0 +1,63 @@
+#ifndef CSLIBS_NDT_MATCHING_NEWTON_D2D_OBJECTIVE_HPP
+#define CSLIBS_NDT_MATCHING_NEWTON_D2D_OBJECTIVE_HPP
+
+#include <cslibs_ndt/matching/d2d.hpp>
+#include <cslibs_ndt/matching/newton/model.hpp>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace newton {
+
+/**
+ * @brief D2D score of a scan, the sum of the point weighted scores of its distributions,
+ *        with closed-form gradient and Hessian w.r.t. the Model parameters.
+ */
+template <typename ndt_t>
+class D2DObjective
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    static constexpr std::size_t Dim = std::tuple_size<typename ndt_t::index_t>::value;
+
+    using model_t   = Model<Dim>;
+    using terms_t   = d2d::Terms<ndt_t, model_t::rotations>;
+    using vector_t  = typename terms_t::vector_t;
+    using hessian_t = typename terms_t::hessian_t;
+
+    template <typename ... args_t>
+    inline explicit D2DObjective(const ndt_t &map,
+                                 const args_t &...args) :
+        terms_(map, args...)
+    {
+    }
+
+    inline double evaluate(const model_t        &model,
+                           const d2d::Scan<Dim> &scan,
+                           vector_t             *gradient = nullptr,
+                           hessian_t            *hessian  = nullptr) const
+    {
+        if (gradient)
+            gradient->setZero();
+        if (hessian)
+            hessian->setZero();
+
+        const typename terms_t::Transform T =
+                terms_.transform(model.rotation(), model.translation(), model.firstDerivatives(),
+                                 hessian ? model.secondDerivatives() : nullptr);
+
+        double score = 0.0;
+        for (const auto &s : scan)
+            score += terms_.evaluate(s, T, s.weight, gradient, hessian);
+        return score;
+    }
+
+private:
+    const terms_t terms_;
+};
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_NEWTON_D2D_OBJECTIVE_HPP
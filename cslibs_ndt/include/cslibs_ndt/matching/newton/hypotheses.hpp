@@ -0,0 +1,80 @@
+#ifndef CSLIBS_NDT_MATCHING_NEWTON_HYPOTHESES_HPP
+#define CSLIBS_NDT_MATCHING_NEWTON_HYPOTHESES_HPP
+
+#include <cslibs_ndt/matching/newton/match.hpp>
+#include <cslibs_ndt/matching/hypotheses.hpp>
+#include <cslibs_ndt/matching/bundle_table.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+
+#include <Eigen/StdVector>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace newton {
+
+/**
+ * @brief Newton matching of one scan from several initial guesses on a pool of threads.
+ *        The points are converted once, non-finite ones are dropped, and all hypotheses share
+ *        one objective whose bundle lookups go through a table prefetched at the initial guesses.
+ *        Each result equals the one of match(map, points, guess, parameter, args...).
+ *        The hypotheses read the map concurrently, it has to be settled once when it is handed
+ *        over, see map::settle and map::ReadView, and must not be written during the call.
+ * @param num_threads 0 uses all hardware threads
+ * @return the results in the order of the initial guesses
+ */
+template <typename ndt_t, typename points_t, typename ... args_t>
+inline std::vector<Result<typename ndt_t::pose_t>> matchHypotheses(
+        const ndt_t                                    &map,
+        const points_t                                 &points,
+        const std::vector<typename ndt_t::pose_t>      &initial_guesses,
+        const Parameter                                &parameter,
+        const std::size_t                               num_threads,
+        const args_t                                   &...args)
+{
+    using pose_t    = typename ndt_t::pose_t;
+    using point_d_t = typename Objective<ndt_t>::point_d_t;
+
+    /// step one: points as doubles, once for all hypotheses
+    std::vector<point_d_t, Eigen::aligned_allocator<point_d_t>> data;
+    for (const auto &p : points) {
+        point_d_t x;
+        for (std::size_t k = 0 ; k < Objective<ndt_t>::Dim ; ++k)
+            x(k) = static_cast<double>(p(k));
+        if (x.allFinite())
+            data.emplace_back(x);
+    }
+
+    /// step two: bundles hit at the initial guesses, later lookups mostly hit the same ones
+    BundleTable<ndt_t> table(map);
+    for (const pose_t &guess : initial_guesses)
+        table.insert(data, guess);
+
+    Objective<ndt_t> objective(map, args...);
+    objective.setBundleTable(&table);
+
+    /// step three: the hypotheses, sharing objective and data read-only
+    return matching::matchHypotheses(initial_guesses, [&](const pose_t &guess) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (data.empty()) {
+            Result<pose_t> result;
+            result.transform = guess;
+            return result;
+        }
+        return detail::optimize(objective, data, static_cast<double>(data.size()), guess, parameter, start);
+    }, num_threads);
+}
+
+template <typename ndt_t, typename points_t>
+inline std::vector<Result<typename ndt_t::pose_t>> matchHypotheses(
+        const ndt_t                                    &map,
+        const points_t                                 &points,
+        const std::vector<typename ndt_t::pose_t>      &initial_guesses)
+{
+    return matchHypotheses(map, points, initial_guesses, Parameter(), 0ul);
+}
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_NEWTON_HYPOTHESES_HPP
@@ -0,0 +1,227 @@
+#ifndef CSLIBS_NDT_MATCHING_NEWTON_MATCH_HPP
+#define CSLIBS_NDT_MATCHING_NEWTON_MATCH_HPP
+
+#include <cslibs_ndt/matching/newton/parameter.hpp>
+#include <cslibs_ndt/matching/newton/objective.hpp>
+#include <cslibs_ndt/matching/newton/d2d_objective.hpp>
+
+#include <Eigen/Cholesky>
+
+#include <chrono>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace newton {
+
+/**
+ * @brief Newton direction for minimizing f with gradient g and Hessian H.
+ *        An indefinite H is shifted by a growing multiple of the identity
+ *        until it is positive definite, as proposed by Magnusson.
+ * @param shifted set if H had to be shifted, the direction is then damped
+ */
+template <typename vector_t, typename hessian_t>
+inline vector_t direction(const vector_t &g, const hessian_t &H, bool &shifted)
+{
+    auto positive = [](const Eigen::LDLT<hessian_t> &ldlt) {
+        return ldlt.info() == Eigen::Success && ldlt.vectorD().minCoeff() > 0.0;
+    };
+
+    Eigen::LDLT<hessian_t> ldlt(H);
+    shifted = !positive(ldlt);
+    double shift = 1e-6 * std::max(1.0, H.diagonal().cwiseAbs().maxCoeff());
+    for (std::size_t i = 0 ; !positive(ldlt) && i < 32 ; ++i, shift *= 10.0)
+        ldlt.compute(H + shift * hessian_t::Identity());
+    return ldlt.solve(-g);
+}
+
+namespace detail {
+/**
+ * @brief Newton iterations maximizing the score of an objective, shared by all matching modes.
+ * @param size normalization of the reported score, i.e. the number of points
+ */
+template <typename objective_t, typename data_t, typename pose_t>
+inline Result<pose_t> optimize(const objective_t                           &objective,
+                               const data_t                                &data,
+                               const double                                 size,
+                               const pose_t                                &initial_guess,
+                               const Parameter                             &parameter,
+                               const std::chrono::steady_clock::time_point &start)
+{
+    using model_t   = typename objective_t::model_t;
+    using vector_t  = typename objective_t::vector_t;
+    using hessian_t = typename objective_t::hessian_t;
+
+    Result<pose_t> result;
+    result.transform = initial_guess;
+
+    vector_t x = model_t::fromPose(initial_guess);
+    model_t  model;
+    model.update(x);
+
+    vector_t  g;
+    hessian_t H;
+    double score = objective.evaluate(model, data, &g, &H);
+    ++result.evaluations;
+
+    // no overlap with the map at all, there is nothing to follow
+    result.termination = score > 0.0 ? Termination::MAX_ITERATIONS : Termination::NO_PROGRESS;
+    while (score > 0.0 && result.iterations < parameter.max_iterations) {
+        /// step one: Newton step for f = -score, clipped to the maximum step length
+        const vector_t gf = -g;
+        bool damped = false;
+        vector_t step = direction<vector_t,hessian_t>(gf, -H, damped);
+        if (!step.allFinite() || gf.dot(step) > 0.0) {
+            step   = -gf;
+            damped = true;
+        }
+        const double length = step.norm();
+        if (length > parameter.max_step_length)
+            step *= parameter.max_step_length / length;
+
+        /// step two: backtracking line search until the score increases sufficiently,
+        ///           derivatives are evaluated along, so the accepted step does not need another pass
+        const double slope = gf.dot(step);
+        const std::size_t tries = parameter.use_line_search ? std::max<std::size_t>(1ul, parameter.max_line_search_iterations) : 1ul;
+        double    alpha    = 1.0;
+        bool      accepted = false;
+        double    score_next = score;
+        vector_t  x_next;
+        vector_t  g_next;
+        hessian_t H_next;
+        model_t   model_next;
+        for (std::size_t i = 0 ; i < tries ; ++i, alpha *= parameter.line_search_shrink) {
+            x_next = x + alpha * step;
+            model_t::normalize(x_next);
+            model_next.update(x_next);
+            score_next = objective.evaluate(model_next, data, &g_next, &H_next);
+            ++result.evaluations;
+            if (!parameter.use_line_search ||
+                    score_next >= score - parameter.line_search_decrease * alpha * slope) {
+                accepted = true;
+                break;
+            }
+        }
+        if (!accepted) {
+            result.termination = Termination::NO_PROGRESS;
+            break;
+        }
+
+        /// step three: a damped full step is expanded while the score keeps increasing
+        if (parameter.use_line_search && damped && alpha == 1.0) {
+            const double step_length = step.norm();
+            for (std::size_t i = 0 ; i < tries && 2.0 * alpha * step_length <= parameter.max_step_length ; ++i) {
+                vector_t x_try = x + 2.0 * alpha * step;
+                model_t::normalize(x_try);
+                model_t model_try;
+                model_try.update(x_try);
+                vector_t  g_try;
+                hessian_t H_try;
+                const double score_try = objective.evaluate(model_try, data, &g_try, &H_try);
+                ++result.evaluations;
+                if (score_try <= score_next)
+                    break;
+                alpha     *= 2.0;
+                score_next = score_try;
+                x_next     = x_try;
+                g_next     = g_try;
+                H_next     = H_try;
+                model_next = model_try;
+            }
+        }
+
+        /// step four: take the step and check for convergence
+        const vector_t delta    = alpha * step;
+        const double   previous = score;
+        x     = x_next;
+        g     = g_next;
+        H     = H_next;
+        model = model_next;
+        score = score_next;
+        ++result.iterations;
+
+        const bool small_step  = model_t::translationNorm(delta) < parameter.translation_epsilon &&
+                                 model_t::rotationNorm(delta)    < parameter.rotation_epsilon;
+        const bool small_score = std::fabs(score - previous) <= parameter.score_epsilon * std::max(std::fabs(previous), 1e-12);
+        if (small_step || small_score) {
+            result.termination = Termination::CONVERGED;
+            break;
+        }
+    }
+
+    result.transform = model_t::template toPose<pose_t>(x);
+    result.score     = score / size;
+    result.duration  = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+}
+
+/**
+ * @brief Point-to-distribution NDT matching with Newton's method on the closed-form
+ *        score gradient and Hessian, without any external solver.
+ *        The returned transform maximizes the summed sampleNonNormalized of the
+ *        transformed points, i.e. it maps the point frame into the world frame of the map.
+ * @param map           Distribution or OccupancyDistribution map, 2D or 3D
+ * @param points        iterable set of points offering p(i)
+ * @param initial_guess start of the optimization
+ * @param parameter     solver settings
+ * @param args          additional map arguments, i.e. the inverse sensor model for occupancy maps
+ */
+template <typename ndt_t, typename points_t, typename ... args_t>
+inline Result<typename ndt_t::pose_t> match(const ndt_t                  &map,
+                                            const points_t               &points,
+                                            const typename ndt_t::pose_t &initial_guess,
+                                            const Parameter              &parameter,
+                                            const args_t                 &...args)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const std::size_t size = static_cast<std::size_t>(std::distance(std::begin(points), std::end(points)));
+    if (size == 0ul) {
+        Result<typename ndt_t::pose_t> result;
+        result.transform = initial_guess;
+        return result;
+    }
+
+    const Objective<ndt_t> objective(map, args...);
+    return detail::optimize(objective, points, static_cast<double>(size), initial_guess, parameter, start);
+}
+
+/**
+ * @brief Distribution-to-distribution (D2D) NDT matching, the scan is given by the
+ *        distributions of a small NDT map. Same solver and result as the point-to-distribution
+ *        match, the score is normalized by the number of points the scan distributions hold.
+ */
+template <typename ndt_t, std::size_t Dim, typename ... args_t>
+inline Result<typename ndt_t::pose_t> match(const ndt_t                  &map,
+                                            const d2d::Scan<Dim>         &scan,
+                                            const typename ndt_t::pose_t &initial_guess,
+                                            const Parameter              &parameter,
+                                            const args_t                 &...args)
+{
+    static_assert(Dim == D2DObjective<ndt_t>::Dim, "scan and map dimension differ");
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (scan.empty()) {
+        Result<typename ndt_t::pose_t> result;
+        result.transform = initial_guess;
+        return result;
+    }
+
+    const D2DObjective<ndt_t> objective(map, args...);
+    return detail::optimize(objective, scan, scan.weight(), initial_guess, parameter, start);
+}
+
+template <typename ndt_t, typename points_t>
+inline Result<typename ndt_t::pose_t> match(const ndt_t                  &map,
+                                            const points_t               &points,
+                                            const typename ndt_t::pose_t &initial_guess)
+{
+    return match(map, points, initial_guess, Parameter());
+}
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_NEWTON_MATCH_HPP
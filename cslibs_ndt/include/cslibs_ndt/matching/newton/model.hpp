@@ -0,0 +1,228 @@
+#ifndef CSLIBS_NDT_MATCHING_NEWTON_MODEL_HPP
+#define CSLIBS_NDT_MATCHING_NEWTON_MODEL_HPP
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <cmath>
+#include <algorithm>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace newton {
+
+/**
+ * @brief Rigid transform parametrization: translation followed by Dim rotation angles.
+ *        Holds the rotation matrix and its first and second derivatives w.r.t. the angles
+ *        for the current parameters, which gives closed-form point Jacobians and Hessians
+ *        (Magnusson, "The Three-Dimensional Normal-Distributions Transform", 2009).
+ */
+template <std::size_t Dim>
+class Model;
+
+template <std::size_t Dim, std::size_t Rotations>
+class ModelBase
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    static constexpr std::size_t dimension  = Dim;
+    static constexpr std::size_t rotations  = Rotations;
+    static constexpr std::size_t parameters = Dim + Rotations;
+
+    using vector_t      = Eigen::Matrix<double,parameters,1>;
+    using rotation_t    = Eigen::Matrix<double,Dim,Dim>;
+    using translation_t = Eigen::Matrix<double,Dim,1>;
+
+    inline const rotation_t& rotation() const
+    {
+        return rotation_;
+    }
+
+    inline const translation_t& translation() const
+    {
+        return translation_;
+    }
+
+    inline const rotation_t& firstDerivative(const std::size_t i) const
+    {
+        return first_[i];
+    }
+
+    inline const rotation_t& secondDerivative(const std::size_t i, const std::size_t j) const
+    {
+        return second_[i * Rotations + j];
+    }
+
+    inline const rotation_t* firstDerivatives() const
+    {
+        return first_;
+    }
+
+    inline const rotation_t* secondDerivatives() const
+    {
+        return second_;
+    }
+
+    inline static double translationNorm(const vector_t &step)
+    {
+        return step.template head<Dim>().norm();
+    }
+
+    inline static double rotationNorm(const vector_t &step)
+    {
+        return step.template tail<Rotations>().norm();
+    }
+
+    inline static void normalize(vector_t &x)
+    {
+        for (std::size_t i = Dim ; i < parameters ; ++i)
+            x(i) = std::atan2(std::sin(x(i)), std::cos(x(i)));
+    }
+
+protected:
+    rotation_t    rotation_;
+    translation_t translation_;
+    rotation_t    first_[Rotations];
+    rotation_t    second_[Rotations * Rotations];
+};
+
+/**
+ * @brief x, y, yaw.
+ */
+template <>
+class Model<2> : public ModelBase<2,1>
+{
+public:
+    template <typename pose_t>
+    inline static vector_t fromPose(const pose_t &pose)
+    {
+        return vector_t(pose.tx(), pose.ty(), pose.yaw());
+    }
+
+    template <typename pose_t>
+    inline static pose_t toPose(const vector_t &x)
+    {
+        return pose_t(x(0), x(1), x(2));
+    }
+
+    template <typename pose_t>
+    inline static void toEigen(const pose_t &pose, rotation_t &rotation, translation_t &translation)
+    {
+        rotation    = Eigen::Rotation2D<double>(static_cast<double>(pose.yaw())).toRotationMatrix();
+        translation = translation_t(static_cast<double>(pose.tx()), static_cast<double>(pose.ty()));
+    }
+
+    template <typename pose_t>
+    inline static pose_t fromEigen(const rotation_t &rotation, const translation_t &translation)
+    {
+        return pose_t(translation(0), translation(1), std::atan2(rotation(1,0), rotation(0,0)));
+    }
+
+    inline void update(const vector_t &x)
+    {
+        const double c = std::cos(x(2));
+        const double s = std::sin(x(2));
+        translation_ = x.head<2>();
+        rotation_  << c, -s,
+                      s,  c;
+        first_[0]  << -s, -c,
+                       c, -s;
+        second_[0] = -rotation_;
+    }
+};
+
+/**
+ * @brief x, y, z, roll, pitch, yaw with R = Rz(yaw) * Ry(pitch) * Rx(roll).
+ */
+template <>
+class Model<3> : public ModelBase<3,3>
+{
+public:
+    template <typename pose_t>
+    inline static vector_t fromPose(const pose_t &pose)
+    {
+        const auto &r = pose.rotation();
+        vector_t x;
+        x << pose.tx(), pose.ty(), pose.tz(), r.roll(), r.pitch(), r.yaw();
+        return x;
+    }
+
+    template <typename pose_t>
+    inline static pose_t toPose(const vector_t &x)
+    {
+        return pose_t(x(0), x(1), x(2), x(3), x(4), x(5));
+    }
+
+    template <typename pose_t>
+    inline static void toEigen(const pose_t &pose, rotation_t &rotation, translation_t &translation)
+    {
+        const auto &r = pose.rotation();
+        rotation    = Eigen::Quaternion<double>(static_cast<double>(r.w()), static_cast<double>(r.x()),
+                                                static_cast<double>(r.y()), static_cast<double>(r.z())).toRotationMatrix();
+        translation = translation_t(static_cast<double>(pose.tx()), static_cast<double>(pose.ty()), static_cast<double>(pose.tz()));
+    }
+
+    template <typename pose_t>
+    inline static pose_t fromEigen(const rotation_t &rotation, const translation_t &translation)
+    {
+        const double pitch = std::asin(std::max(-1.0, std::min(1.0, -rotation(2,0))));
+        return pose_t(translation(0), translation(1), translation(2),
+                      std::atan2(rotation(2,1), rotation(2,2)), pitch, std::atan2(rotation(1,0), rotation(0,0)));
+    }
+
+    inline void update(const vector_t &x)
+    {
+        /// elementary rotations and their derivatives, order: roll (x), pitch (y), yaw (z)
+        rotation_t r[3][3];
+        for (std::size_t i = 0 ; i < 3 ; ++i)
+            elementary(i, x(3 + i), r[i][0], r[i][1], r[i][2]);
+
+        auto compose = [&r](const std::size_t dx, const std::size_t dy, const std::size_t dz) {
+            return rotation_t(r[2][dz] * r[1][dy] * r[0][dx]);
+        };
+
+        translation_ = x.head<3>();
+        rotation_    = compose(0, 0, 0);
+        for (std::size_t i = 0 ; i < 3 ; ++i) {
+            for (std::size_t j = 0 ; j < 3 ; ++j) {
+                std::size_t d[3] = {0, 0, 0};
+                ++d[i];
+                ++d[j];
+                second_[i * 3 + j] = compose(d[0], d[1], d[2]);
+            }
+            std::size_t d[3] = {0, 0, 0};
+            ++d[i];
+            first_[i] = compose(d[0], d[1], d[2]);
+        }
+    }
+
+private:
+    /**
+     * @brief Rotation about one axis (0 = x, 1 = y, 2 = z) and its first and second derivative.
+     */
+    inline static void elementary(const std::size_t axis, const double angle,
+                                  rotation_t &r, rotation_t &dr, rotation_t &ddr)
+    {
+        const double c = std::cos(angle);
+        const double s = std::sin(angle);
+        const std::size_t a = (axis + 1) % 3;
+        const std::size_t b = (axis + 2) % 3;
+
+        r.setZero();
+        dr.setZero();
+        r(axis, axis) = 1.0;
+        r(a,a)  =  c; r(a,b)  = -s;
+        r(b,a)  =  s; r(b,b)  =  c;
+        dr(a,a) = -s; dr(a,b) = -c;
+        dr(b,a) =  c; dr(b,b) = -s;
+        ddr = -r;
+        ddr(axis, axis) = 0.0;
+    }
+};
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_NEWTON_MODEL_HPP
@@ -0,0 +1,143 @@
+#ifndef CSLIBS_NDT_MATCHING_NEWTON_OBJECTIVE_HPP
+#define CSLIBS_NDT_MATCHING_NEWTON_OBJECTIVE_HPP
+
+#include <cslibs_ndt/matching/access.hpp>
+#include <cslibs_ndt/matching/bundle_table.hpp>
+#include <cslibs_ndt/matching/newton/model.hpp>
+
+#include <tuple>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace newton {
+
+/**
+ * @brief NDT score sum_k sum_i w_i * exp(-0.5 * d_ki^T I_i d_ki) of a point set,
+ *        with closed-form gradient and Hessian w.r.t. the Model parameters.
+ *        Distributions are looked up in the map frame like the ceres functors do.
+ */
+template <typename ndt_t>
+class Objective
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    static constexpr std::size_t Dim = std::tuple_size<typename ndt_t::index_t>::value;
+
+    using model_t    = Model<Dim>;
+    using vector_t   = typename model_t::vector_t;
+    using hessian_t  = Eigen::Matrix<double,model_t::parameters,model_t::parameters>;
+    using point_d_t  = Eigen::Matrix<double,Dim,1>;
+    using matrix_d_t = Eigen::Matrix<double,Dim,Dim>;
+    using distribution_t = typename ndt_t::distribution_t::distribution_t;
+
+    template <typename ... args_t>
+    inline explicit Objective(const ndt_t &map,
+                              const args_t &...args) :
+        map_(map),
+        access_(map, args...),
+        resolution_inv_(1.0 / static_cast<double>(map.getBundleResolution()))
+    {
+        model_t::toEigen(map.getInitialOrigin().inverse(), rotation_, translation_);
+    }
+
+    /**
+     * @brief Resolve bundles through a prefetched table, which has to outlive the objective.
+     */
+    inline void setBundleTable(const BundleTable<ndt_t> *table)
+    {
+        table_ = table;
+    }
+
+    /**
+     * @brief Score of the points under the model transform, gradient and hessian are optional.
+     */
+    template <typename points_t>
+    inline double evaluate(const model_t  &model,
+                           const points_t &points,
+                           vector_t       *gradient = nullptr,
+                           hessian_t      *hessian  = nullptr) const
+    {
+        static constexpr std::size_t N = model_t::parameters;
+        static constexpr std::size_t R = model_t::rotations;
+        using jacobian_t = Eigen::Matrix<double,Dim,N>;
+
+        double score = 0.0;
+        if (gradient)
+            gradient->setZero();
+        if (hessian)
+            hessian->setZero();
+
+        jacobian_t J;
+        J.template leftCols<Dim>() = rotation_;
+        point_d_t  second[R * R];
+
+        const matrix_d_t A = rotation_ * model.rotation();
+        const point_d_t  b = rotation_ * model.translation() + translation_;
+
+        for (const auto &p : points) {
+            point_d_t x;
+            for (std::size_t k = 0 ; k < Dim ; ++k)
+                x(k) = static_cast<double>(p(k));
+
+            /// step one: transform into the map frame and find the bundle
+            const point_d_t q = A * x + b;
+            typename ndt_t::index_t bi;
+            for (std::size_t k = 0 ; k < Dim ; ++k)
+                bi[k] = static_cast<int>(std::floor(q(k) * resolution_inv_));
+            const typename ndt_t::distribution_bundle_t *bundle = table_ ? table_->get(bi) : map_.get(bi);
+            if (!bundle)
+                continue;
+
+            /// step two: point Jacobian and second derivatives, shared by all distributions
+            if (gradient) {
+                for (std::size_t r = 0 ; r < R ; ++r)
+                    J.col(Dim + r) = rotation_ * (model.firstDerivative(r) * x);
+            }
+            if (hessian) {
+                for (std::size_t r = 0 ; r < R * R ; ++r)
+                    second[r] = rotation_ * (model.secondDerivative(r / R, r % R) * x);
+            }
+
+            /// step three: accumulate the Gaussian terms
+            for (std::size_t i = 0 ; i < ndt_t::bin_count ; ++i) {
+                access_(bundle->at(i), [&](const distribution_t &distribution, const double weight) {
+                    const matrix_d_t inf = distribution.getInformationMatrix().template cast<double>();
+                    const point_d_t  d   = q - distribution.getMean().template cast<double>();
+                    const point_d_t  id  = inf * d;
+                    const double     e   = weight * std::exp(-0.5 * d.dot(id));
+                    score += e;
+                    if (!gradient)
+                        return;
+
+                    // d(score)/dp = -e * J^T I d
+                    const vector_t a = J.transpose() * id;
+                    *gradient -= e * a;
+                    if (!hessian)
+                        return;
+
+                    // d2(score)/dp2 = e * ((J^T I d)(J^T I d)^T - J^T I J - d^T I d2q/dp2)
+                    hessian_t h = a * a.transpose() - J.transpose() * inf * J;
+                    for (std::size_t r = 0 ; r < R * R ; ++r)
+                        h(Dim + r / R, Dim + r % R) -= id.dot(second[r]);
+                    *hessian += e * h;
+                });
+            }
+        }
+        return score;
+    }
+
+private:
+    const ndt_t        &map_;
+    const Access<ndt_t> access_;
+    const double        resolution_inv_;
+    matrix_d_t          rotation_;      // map <- world
+    point_d_t           translation_;
+    const BundleTable<ndt_t> *table_ = nullptr;
+};
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_NEWTON_OBJECTIVE_HPP
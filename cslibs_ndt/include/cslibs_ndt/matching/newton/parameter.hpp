@@ -0,0 +1,53 @@
+#ifndef CSLIBS_NDT_MATCHING_NEWTON_PARAMETER_HPP
+#define CSLIBS_NDT_MATCHING_NEWTON_PARAMETER_HPP
+
+#include <cstddef>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace newton {
+
+/**
+ * @brief Settings of the Newton matcher.
+ */
+struct Parameter
+{
+    std::size_t max_iterations              = 35;
+    double      translation_epsilon         = 1e-4;  // [m],   converged if a step is smaller
+    double      rotation_epsilon            = 1e-4;  // [rad], converged if a step is smaller
+    double      score_epsilon               = 1e-7;  // converged if the relative score change is smaller
+    double      max_step_length             = 0.5;   // Newton steps are clipped to this length
+
+    bool        use_line_search             = true;
+    std::size_t max_line_search_iterations  = 10;
+    double      line_search_decrease        = 1e-4;  // sufficient decrease (Armijo) constant
+    double      line_search_shrink          = 0.5;   // step length factor per backtracking iteration
+};
+
+enum class Termination { CONVERGED, MAX_ITERATIONS, NO_PROGRESS, NO_POINTS };
+
+/**
+ * @brief Outcome of one match.
+ *        score is the mean of sampleNonNormalized over all points at the final transform.
+ */
+template <typename pose_t>
+struct Result
+{
+    pose_t      transform;
+    double      score       = 0.0;
+    std::size_t iterations  = 0;     // Newton iterations
+    std::size_t evaluations = 0;     // objective evaluations, including line search
+    double      duration    = 0.0;   // [s]
+    Termination termination = Termination::NO_POINTS;
+
+    inline bool converged() const
+    {
+        return termination == Termination::CONVERGED;
+    }
+};
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_MATCHING_NEWTON_PARAMETER_HPP
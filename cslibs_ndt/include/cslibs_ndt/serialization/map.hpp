@@ -56,7 +56,7 @@ static inline bool save(const map_t &map,
         return false;
 
     /// step four: write out the storages
-    storages_t storages = map.getStorages();
+    const auto storages = map.getStorages();
 
     std::array<std::thread, map_t::bin_count> threads;
     std::atomic_bool success(true);
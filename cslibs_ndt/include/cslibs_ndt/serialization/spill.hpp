@@ -0,0 +1,74 @@
+#ifndef CSLIBS_NDT_SERIALIZATION_SPILL_HPP
+#define CSLIBS_NDT_SERIALIZATION_SPILL_HPP
+
+#include <cslibs_ndt/serialization/filesystem.hpp>
+#include <cslibs_ndt/serialization/storage.hpp>
+
+#include <cslibs_math/serialization/array.hpp>
+
+#include <array>
+#include <fstream>
+#include <memory>
+#include <tuple>
+
+namespace cslibs_ndt {
+namespace serialization {
+/**
+ * @brief Spill callback of a rolling window map, see GenericMap::setSpill, which appends every
+ *        evicted distribution to store_<i>.bin in path, in the format of the storage files of
+ *        a saved map. They can be read back with cslibs_ndt::binary<...>::load, a distribution
+ *        evicted several times is then merged like on any insert into a storage.
+ */
+template <typename map_t>
+class Spill
+{
+public:
+    using index_t        = typename map_t::index_t;
+    using distribution_t = typename map_t::distribution_t;
+    using files_t        = std::array<std::ofstream, map_t::bin_count>;
+
+    /**
+     * @param path directory of the storage files, it is created if missing, existing files are appended to
+     */
+    inline explicit Spill(const std::string &path) :
+        files_(new files_t)
+    {
+        const boost::filesystem::path path_root(path);
+        if (!cslibs_ndt::common::serialization::check_directory_quiet(path_root))
+            boost::filesystem::create_directories(path_root);
+
+        for (std::size_t i = 0 ; i < map_t::bin_count ; ++i) {
+            const boost::filesystem::path path_file = path_root / boost::filesystem::path("store_" + std::to_string(i) + ".bin");
+            (*files_)[i].open(path_file.string(), std::ios::binary | std::ios::app);
+        }
+    }
+
+    inline void operator()(const std::size_t i, const index_t &index, const distribution_t &d) const
+    {
+        std::ofstream &out = (*files_)[i];
+        cslibs_math::serialization::array::binary<int, std::tuple_size<index_t>::value>::write(index, out);
+        cslibs_ndt::write(d, out);
+    }
+
+    inline bool good() const
+    {
+        for (const auto &file : *files_)
+            if (!file.good())
+                return false;
+        return true;
+    }
+
+    inline void flush()
+    {
+        for (auto &file : *files_)
+            file.flush();
+    }
+
+private:
+    // shared, the map stores a copy of the callback
+    std::shared_ptr<files_t> files_;
+};
+}
+}
+
+#endif // CSLIBS_NDT_SERIALIZATION_SPILL_HPP
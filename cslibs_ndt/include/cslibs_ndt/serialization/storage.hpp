@@ -7,6 +7,8 @@
 
 #include <cslibs_ndt/common/distribution.hpp>
 #include <cslibs_ndt/common/occupancy_distribution.hpp>
+#include <cslibs_ndt/common/inline_occupancy_distribution.hpp>
+#include <cslibs_ndt/common/decaying_occupancy_distribution.hpp>
 #include <cslibs_ndt/common/weighted_occupancy_distribution.hpp>
 #include <cslibs_ndt/serialization/filesystem.hpp>
 
@@ -65,6 +67,56 @@ std::size_t read(std::ifstream &in, OccupancyDistribution<Tp,Size> &d)
     return sizeof(std::size_t) + r;
 }
 
+template<typename Tp, std::size_t Size>
+void write(const InlineOccupancyDistribution<Tp,Size> &d, std::ofstream &out)
+{
+    cslibs_math::serialization::io<std::size_t>::write(d.numFree(), out);
+    if (!d.getDistribution())
+        cslibs_math::serialization::binary<cslibs_math::statistics::StableDistribution,Tp,Size,3>::write(out);
+    else
+        cslibs_math::serialization::binary<cslibs_math::statistics::StableDistribution,Tp,Size,3>::write(*(d.getDistribution()), out);
+}
+
+template<typename Tp, std::size_t Size>
+std::size_t read(std::ifstream &in, InlineOccupancyDistribution<Tp,Size> &d)
+{
+    std::size_t f = cslibs_math::serialization::io<std::size_t>::read(in);
+    typename InlineOccupancyDistribution<Tp,Size>::distribution_t tmp;
+    std::size_t r = cslibs_math::serialization::binary<cslibs_math::statistics::StableDistribution,Tp,Size,3>::read(in,tmp);
+    d = tmp.getN() != 0 ? InlineOccupancyDistribution<Tp,Size>(f, tmp) : InlineOccupancyDistribution<Tp,Size>(f);
+    return sizeof(std::size_t) + r;
+}
+
+/**
+ * @brief The weights are written decayed until the time of the clock, which becomes the stamp.
+ *        Half-life and time are not part of the storage, the clock of the map is set on the next update.
+ */
+template<typename Tp, std::size_t Size>
+void write(const DecayingOccupancyDistribution<Tp,Size> &d, std::ofstream &out)
+{
+    const Tp stamp = d.getClock() ? std::max(d.getStamp(), d.getClock()->getTime()) : d.getStamp();
+    cslibs_math::serialization::io<Tp>::write(d.weightFree(), out);
+    cslibs_math::serialization::io<Tp>::write(d.weightOccupied(), out);
+    cslibs_math::serialization::io<Tp>::write(stamp, out);
+    if (!d.getDistribution())
+        cslibs_math::serialization::binary<cslibs_math::statistics::StableDistribution,Tp,Size,3>::write(out);
+    else
+        cslibs_math::serialization::binary<cslibs_math::statistics::StableDistribution,Tp,Size,3>::write(*(d.getDistribution()), out);
+}
+
+template<typename Tp, std::size_t Size>
+std::size_t read(std::ifstream &in, DecayingOccupancyDistribution<Tp,Size> &d)
+{
+    const Tp weight_free     = cslibs_math::serialization::io<Tp>::read(in);
+    const Tp weight_occupied = cslibs_math::serialization::io<Tp>::read(in);
+    const Tp stamp           = cslibs_math::serialization::io<Tp>::read(in);
+    typename DecayingOccupancyDistribution<Tp,Size>::distribution_t tmp;
+    std::size_t r = cslibs_math::serialization::binary<cslibs_math::statistics::StableDistribution,Tp,Size,3>::read(in,tmp);
+    d = tmp.getN() != 0 ? DecayingOccupancyDistribution<Tp,Size>(weight_free, weight_occupied, stamp, tmp) :
+                          DecayingOccupancyDistribution<Tp,Size>(weight_free, weight_occupied, stamp);
+    return 3 * sizeof(Tp) + r;
+}
+
 template<typename Tp, std::size_t Size>
 void write(const WeightedOccupancyDistribution<Tp,Size> &d, std::ofstream &out)
 {
@@ -98,7 +150,7 @@ struct binary {
     using data_t    = T<Tp,Size>;
     using storage_t = cis::Storage<data_if<data_t>, index_t, backend_t>;
 
-    inline static bool save(const std::shared_ptr<storage_t> &storage,
+    inline static bool save(const std::shared_ptr<const storage_t> &storage,
                             const boost::filesystem::path &path)
     {
         std::ofstream out(path.string(), std::ios::binary | std::ios::trunc);
@@ -0,0 +1,242 @@
+#ifndef CSLIBS_NDT_UTILITY_BATCH_SAMPLE_HPP
+#define CSLIBS_NDT_UTILITY_BATCH_SAMPLE_HPP
+
+#include <cslibs_ndt/utility/simd.hpp>
+#include <cslibs_ndt/utility/integer_sequence.hpp>
+#include <cslibs_ndt/utility/to_point.hpp>
+#include <cslibs_ndt/utility/binary_indices.hpp>
+
+#include <Eigen/Core>
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace cslibs_ndt {
+namespace utility {
+
+/**
+ * @brief Buffered evaluation of weighted, non-normalized Gaussian terms
+ *        w * exp(-0.5 * d^T I d) with d = p - mean, for many (point, distribution) pairs.
+ *        Terms are collected in structure-of-arrays form and evaluated chunk-wise,
+ *        the quadratic forms with simd::Pack and the exponentials in a plain loop
+ *        left to the compiler's vector math. Results are added to scores[id],
+ *        gradients (optional, Dim entries per id) receive the derivative w.r.t. p.
+ */
+template <typename T, std::size_t Dim, std::size_t Capacity = 512>
+class GaussianBatch
+{
+public:
+    using mean_t        = Eigen::Matrix<T,Dim,1>;
+    using information_t = Eigen::Matrix<T,Dim,Dim>;
+
+    static constexpr std::size_t triangle = Dim * (Dim + 1) / 2;
+
+    inline GaussianBatch(T *scores,
+                         T *gradients = nullptr) :
+        scores_(scores),
+        gradients_(gradients),
+        ids_(Capacity),
+        weights_(Capacity),
+        exponents_(Capacity),
+        values_(Capacity)
+    {
+        for (auto &d : diff_)
+            d.resize(Capacity);
+        for (auto &i : information_)
+            i.resize(Capacity);
+        for (auto &i : information_diff_)
+            i.resize(Capacity);
+    }
+
+    inline GaussianBatch(const GaussianBatch &) = delete;
+    inline GaussianBatch& operator = (const GaussianBatch &) = delete;
+
+    inline ~GaussianBatch()
+    {
+        flush();
+    }
+
+    template <typename point_t>
+    inline void add(const std::size_t  id,
+                    const point_t     &p,
+                    const mean_t      &mean,
+                    const information_t &information,
+                    const T            weight)
+    {
+        ids_[size_]     = id;
+        weights_[size_] = weight;
+        for (std::size_t k = 0 ; k < Dim ; ++k)
+            diff_[k][size_] = static_cast<T>(p(k)) - mean(k);
+        for (std::size_t k = 0 ; k < Dim ; ++k)
+            for (std::size_t l = k ; l < Dim ; ++l)
+                information_[index(k,l)][size_] = information(k,l);
+
+        if (++size_ == Capacity)
+            flush();
+    }
+
+    /**
+     * @brief Evaluate all pending terms and scatter them into the outputs.
+     */
+    inline void flush()
+    {
+        using pack_t   = simd::Pack<T>;
+        using scalar_t = simd::Scalar<T>;
+
+        /// step one: quadratic forms, packed as far as possible
+        std::size_t t = evaluate<pack_t>(0ul, size_);
+        evaluate<scalar_t>(t, size_);
+
+        /// step two: exponentials
+        for (std::size_t i = 0 ; i < size_ ; ++i)
+            values_[i] = weights_[i] * std::exp(T(-0.5) * exponents_[i]);
+
+        /// step three: scatter, gradient of w * exp(-0.5 d^T I d) is -w * exp(...) * I d
+        for (std::size_t i = 0 ; i < size_ ; ++i)
+            scores_[ids_[i]] += values_[i];
+        if (gradients_) {
+            for (std::size_t i = 0 ; i < size_ ; ++i)
+                for (std::size_t k = 0 ; k < Dim ; ++k)
+                    gradients_[ids_[i] * Dim + k] -= values_[i] * information_diff_[k][i];
+        }
+        size_ = 0;
+    }
+
+private:
+    T *scores_;
+    T *gradients_;
+
+    std::size_t                            size_ = 0;
+    std::vector<std::size_t>               ids_;
+    std::vector<T>                         weights_;
+    std::array<std::vector<T>, Dim>        diff_;
+    std::array<std::vector<T>, triangle>   information_;
+    std::array<std::vector<T>, Dim>        information_diff_;
+    std::vector<T>                         exponents_;
+    std::vector<T>                         values_;
+
+    inline static constexpr std::size_t index(const std::size_t k, const std::size_t l)
+    {
+        return k <= l ? k * Dim - k * (k + 1) / 2 + l : index(l, k);
+    }
+
+    template <typename pack_t>
+    inline std::size_t evaluate(std::size_t t, const std::size_t end)
+    {
+        using p_t = typename pack_t::type;
+        for ( ; t + pack_t::size <= end ; t += pack_t::size) {
+            p_t d[Dim];
+            for (std::size_t k = 0 ; k < Dim ; ++k)
+                d[k] = pack_t::load(&diff_[k][t]);
+
+            p_t q = pack_t::set1(T(0.0));
+            for (std::size_t k = 0 ; k < Dim ; ++k) {
+                p_t s = pack_t::set1(T(0.0));
+                for (std::size_t l = 0 ; l < Dim ; ++l)
+                    s = pack_t::add(s, pack_t::mul(pack_t::load(&information_[index(k,l)][t]), d[l]));
+                pack_t::store(&information_diff_[k][t], s);
+                q = pack_t::add(q, pack_t::mul(d[k], s));
+            }
+            pack_t::store(&exponents_[t], q);
+        }
+        return t;
+    }
+};
+
+/**
+ * @brief Batch sampling shared by all map layouts. The point set is transformed by each of
+ *        the poses and all transformed points are binned by bundle, so every bundle is looked
+ *        up once and its distributions are evaluated for all of its points in one go.
+ *        Outputs are ordered pose major, gradients are taken w.r.t. the transformed point.
+ * @param w_T_m             initial origin of the map, gradients are rotated back by it
+ * @param to_bundle_index   to_bundle_index(p_w, p_m, bi) transforms p_w into the map frame and
+ *                          returns whether its bundle bi lies within the map
+ * @param lookup            lookup(bi) returns a pointer to bundle bi, null if not allocated
+ * @param term              term(bundle, i, mean, information) returns the weight of the i-th
+ *                          distribution of a bundle and fills in its parameters, zero skips it
+ */
+template <std::size_t Dim, typename point_t, typename index_t,
+          typename T, typename point_in_t, typename pose_t, typename transform_t,
+          typename to_bundle_index_fn_t, typename lookup_fn_t, typename term_fn_t>
+inline void sample_batch(const point_in_t           *points,
+                         const std::size_t           size,
+                         const pose_t               *poses,
+                         const std::size_t           num_poses,
+                         const transform_t          &w_T_m,
+                         T                          *scores,
+                         T                          *gradients,
+                         const to_bundle_index_fn_t &to_bundle_index,
+                         const lookup_fn_t          &lookup,
+                         const term_fn_t            &term)
+{
+    using batch_t = GaussianBatch<T,Dim>;
+    static constexpr std::size_t bin_count = two_pow(Dim);
+
+    const std::size_t count = size * num_poses;
+    std::fill(scores, scores + count, T());
+    if (gradients)
+        std::fill(gradients, gradients + count * Dim, T());
+
+    /// step one: transform points and compute bundle indices
+    std::vector<point_t, Eigen::aligned_allocator<point_t>> points_m(count);
+    std::vector<index_t>     indices(count);
+    std::vector<std::size_t> order;
+    order.reserve(count);
+    for (std::size_t k = 0 ; k < num_poses ; ++k) {
+        const pose_t &pose = poses[k];
+        for (std::size_t i = 0, id = k * size ; i < size ; ++i, ++id) {
+            const point_in_t &p = points[i];
+            const point_t pw = pose * to_point<point_t>([&p](const std::size_t& c) {
+                return static_cast<T>(p(c));
+            });
+            if (to_bundle_index(pw, points_m[id], indices[id]))
+                order.emplace_back(id);
+        }
+    }
+
+    /// step two: bin points by bundle
+    std::sort(order.begin(), order.end(), [&indices](const std::size_t a, const std::size_t b) {
+        return indices[a] < indices[b];
+    });
+
+    /// step three: one lookup per bundle and distribution, terms go to the packed kernel
+    {
+        batch_t batch(scores, gradients);
+        typename batch_t::mean_t        mean;
+        typename batch_t::information_t information;
+        for (std::size_t begin = 0, end = 0 ; begin < order.size() ; begin = end) {
+            const index_t &bi = indices[order[begin]];
+            for (end = begin + 1 ; end < order.size() && indices[order[end]] == bi ; ++end);
+
+            const auto *bundle = lookup(bi);
+            if (!bundle)
+                continue;
+            for (std::size_t i = 0 ; i < bin_count ; ++i) {
+                const T weight = term(bundle, i, mean, information);
+                if (weight == T())
+                    continue;
+                for (std::size_t j = begin ; j < end ; ++j)
+                    batch.add(order[j], points_m[order[j]], mean, information, weight);
+            }
+        }
+    }
+
+    /// step four: gradients were taken in the map frame, rotate them back
+    if (gradients) {
+        const point_t origin = w_T_m * point_t();
+        for (std::size_t i = 0 ; i < count ; ++i) {
+            T *g = gradients + i * Dim;
+            const point_t gw = w_T_m * to_point<point_t>([g](const std::size_t& c) {
+                return g[c];
+            }) - origin;
+            for (std::size_t k = 0 ; k < Dim ; ++k)
+                g[k] = gw(k);
+        }
+    }
+}
+}
+}
+
+#endif // CSLIBS_NDT_UTILITY_BATCH_SAMPLE_HPP
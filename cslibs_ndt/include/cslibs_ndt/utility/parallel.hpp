@@ -0,0 +1,53 @@
+#ifndef CSLIBS_NDT_UTILITY_PARALLEL_HPP
+#define CSLIBS_NDT_UTILITY_PARALLEL_HPP
+
+#include <thread>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace cslibs_ndt {
+namespace utility {
+
+/**
+ * @brief Number of worker threads to use for a given amount of independent jobs.
+ * @param max_jobs  upper bound, no more threads than jobs are spawned
+ * @return the number of threads, at least one
+ */
+inline std::size_t num_threads(const std::size_t max_jobs = std::numeric_limits<std::size_t>::max())
+{
+    const std::size_t hardware = std::max<std::size_t>(1ul, std::thread::hardware_concurrency());
+    return std::max<std::size_t>(1ul, std::min(hardware, max_jobs));
+}
+
+/**
+ * @brief Split [0, size) into num_threads contiguous chunks and process them in parallel.
+ *        The function is called as function(thread_id, begin, end).
+ */
+template <typename Fn>
+inline void parallel_for(const std::size_t size,
+                         const std::size_t num_threads,
+                         const Fn &function)
+{
+    if (num_threads <= 1ul) {
+        function(0ul, 0ul, size);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (std::size_t t = 0 ; t < num_threads ; ++t) {
+        const std::size_t begin = (size * t)      / num_threads;
+        const std::size_t end   = (size * (t+1ul)) / num_threads;
+        threads.emplace_back([&function, t, begin, end]() {
+            function(t, begin, end);
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+}
+
+}
+}
+
+#endif // CSLIBS_NDT_UTILITY_PARALLEL_HPP
@@ -0,0 +1,102 @@
+#ifndef CSLIBS_NDT_UTILITY_SIMD_HPP
+#define CSLIBS_NDT_UTILITY_SIMD_HPP
+
+#include <cstddef>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace cslibs_ndt {
+namespace utility {
+namespace simd {
+
+/**
+ * @brief Minimal packed arithmetic used by the batch kernels.
+ *        The widest instruction set enabled at compile time is used
+ *        (AVX with -mavx / -mavx2 / -march=native, SSE2 on every x86_64 build),
+ *        all other targets and types fall back to one element per pack.
+ *        Loads and stores are unaligned.
+ */
+template <typename T>
+struct Scalar
+{
+    using type = T;
+    static constexpr std::size_t size = 1;
+
+    inline static type load(const T *p)             { return *p; }
+    inline static void store(T *p, const type &v)   { *p = v; }
+    inline static type set1(const T v)              { return v; }
+    inline static type add(const type &a, const type &b) { return a + b; }
+    inline static type sub(const type &a, const type &b) { return a - b; }
+    inline static type mul(const type &a, const type &b) { return a * b; }
+};
+
+template <typename T>
+struct Pack : public Scalar<T>
+{
+};
+
+#if defined(__AVX__)
+template <>
+struct Pack<double>
+{
+    using type = __m256d;
+    static constexpr std::size_t size = 4;
+
+    inline static type load(const double *p)             { return _mm256_loadu_pd(p); }
+    inline static void store(double *p, const type &v)   { _mm256_storeu_pd(p, v); }
+    inline static type set1(const double v)              { return _mm256_set1_pd(v); }
+    inline static type add(const type &a, const type &b) { return _mm256_add_pd(a, b); }
+    inline static type sub(const type &a, const type &b) { return _mm256_sub_pd(a, b); }
+    inline static type mul(const type &a, const type &b) { return _mm256_mul_pd(a, b); }
+};
+
+template <>
+struct Pack<float>
+{
+    using type = __m256;
+    static constexpr std::size_t size = 8;
+
+    inline static type load(const float *p)              { return _mm256_loadu_ps(p); }
+    inline static void store(float *p, const type &v)    { _mm256_storeu_ps(p, v); }
+    inline static type set1(const float v)               { return _mm256_set1_ps(v); }
+    inline static type add(const type &a, const type &b) { return _mm256_add_ps(a, b); }
+    inline static type sub(const type &a, const type &b) { return _mm256_sub_ps(a, b); }
+    inline static type mul(const type &a, const type &b) { return _mm256_mul_ps(a, b); }
+};
+#elif defined(__SSE2__)
+template <>
+struct Pack<double>
+{
+    using type = __m128d;
+    static constexpr std::size_t size = 2;
+
+    inline static type load(const double *p)             { return _mm_loadu_pd(p); }
+    inline static void store(double *p, const type &v)   { _mm_storeu_pd(p, v); }
+    inline static type set1(const double v)              { return _mm_set1_pd(v); }
+    inline static type add(const type &a, const type &b) { return _mm_add_pd(a, b); }
+    inline static type sub(const type &a, const type &b) { return _mm_sub_pd(a, b); }
+    inline static type mul(const type &a, const type &b) { return _mm_mul_pd(a, b); }
+};
+
+template <>
+struct Pack<float>
+{
+    using type = __m128;
+    static constexpr std::size_t size = 4;
+
+    inline static type load(const float *p)              { return _mm_loadu_ps(p); }
+    inline static void store(float *p, const type &v)    { _mm_storeu_ps(p, v); }
+    inline static type set1(const float v)               { return _mm_set1_ps(v); }
+    inline static type add(const type &a, const type &b) { return _mm_add_ps(a, b); }
+    inline static type sub(const type &a, const type &b) { return _mm_sub_ps(a, b); }
+    inline static type mul(const type &a, const type &b) { return _mm_mul_ps(a, b); }
+};
+#endif
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_UTILITY_SIMD_HPP
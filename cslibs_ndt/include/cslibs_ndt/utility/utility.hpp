@@ -7,5 +7,6 @@
 #include <cslibs_ndt/utility/create.hpp>
 #include <cslibs_ndt/utility/for_each.hpp>
 #include <cslibs_ndt/utility/to_point.hpp>
+#include <cslibs_ndt/utility/parallel.hpp>
 
 #endif // CSLIBS_NDT_UTILITY_HPP
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt/backend/block_hash.hpp>
+#include <cslibs_indexed_storage/storage.hpp>
+#include <cslibs_math/random/random.hpp>
+
+#include <map>
+
+const std::size_t NUM_SAMPLES = 10000;
+using rng_t     = cslibs_math::random::Uniform<double,1>;
+using index_t   = std::array<int,3>;
+using storage_t = cis::Storage<cis::interface::dense<double>, index_t, cslibs_ndt::backend::BlockHash>;
+
+void fill(storage_t &storage, std::map<index_t, double> &expected, const double extent)
+{
+    rng_t rng(-extent, extent);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++i) {
+        const index_t index = {{static_cast<int>(rng.get()), static_cast<int>(rng.get()), static_cast<int>(rng.get())}};
+        if (expected.find(index) != expected.end())
+            continue;
+
+        const double value = rng.get();
+        storage.insert(index, value);
+        expected[index] = value;
+    }
+}
+
+void testEqual(const storage_t &storage, const std::map<index_t, double> &expected)
+{
+    EXPECT_EQ(storage.size(), expected.size());
+
+    std::size_t visited = 0;
+    storage.traverse([&expected, &visited](const index_t &index, const double &value) {
+        const auto it = expected.find(index);
+        ASSERT_NE(it, expected.end());
+        EXPECT_EQ(it->second, value);
+        ++visited;
+    });
+    EXPECT_EQ(visited, expected.size());
+
+    for (const auto &e : expected) {
+        const double *value = storage.get(e.first);
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(*value, e.second);
+    }
+}
+
+TEST(Test_cslibs_ndt, testBlockHashInsertGet)
+{
+    storage_t storage;
+    std::map<index_t, double> expected;
+    fill(storage, expected, 20.0);
+    testEqual(storage, expected);
+
+    // neighbours of occupied cells inside the same block are not set
+    const index_t missing = {{25, -25, 25}};
+    EXPECT_EQ(storage.get(missing), nullptr);
+}
+
+TEST(Test_cslibs_ndt, testBlockHashUnbounded)
+{
+    // beyond the +-32768 index range of the octree
+    storage_t storage;
+    std::map<index_t, double> expected;
+    fill(storage, expected, 1e6);
+    testEqual(storage, expected);
+}
+
+TEST(Test_cslibs_ndt, testBlockHashCopyClear)
+{
+    storage_t storage;
+    const std::size_t empty_size = storage.byte_size();
+
+    std::map<index_t, double> expected;
+    fill(storage, expected, 100.0);
+
+    storage_t copy(storage);
+    for (const auto &e : expected)
+        *storage.get(e.first) += 1.0;
+    testEqual(copy, expected);
+
+    EXPECT_GT(storage.byte_size(), empty_size + expected.size() * sizeof(double));
+    storage.clear();
+    EXPECT_EQ(storage.size(), 0ul);
+    for (const auto &e : expected)
+        EXPECT_EQ(storage.get(e.first), nullptr);
+
+    std::map<index_t, double> refilled;
+    fill(storage, refilled, 100.0);
+    testEqual(storage, refilled);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
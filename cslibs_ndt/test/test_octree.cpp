@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt/backend/octree.hpp>
+#include <cslibs_indexed_storage/storage.hpp>
+#include <cslibs_math/random/random.hpp>
+
+#include <map>
+
+const std::size_t NUM_SAMPLES = 10000;
+using rng_t     = cslibs_math::random::Uniform<double,1>;
+using index_t   = std::array<int,3>;
+using storage_t = cis::Storage<cis::interface::dense<double>, index_t, cslibs_ndt::backend::OcTree>;
+
+void fill(storage_t &storage, std::map<index_t, double> &expected)
+{
+    rng_t rng(-1000.0, 1000.0);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++i) {
+        const index_t index = {{static_cast<int>(rng.get()), static_cast<int>(rng.get()), static_cast<int>(rng.get())}};
+        if (expected.find(index) != expected.end())
+            continue;
+
+        const double value = rng.get();
+        storage.insert(index, value);
+        expected[index] = value;
+    }
+}
+
+void testEqual(const storage_t &storage, const std::map<index_t, double> &expected)
+{
+    std::size_t visited = 0;
+    storage.traverse([&expected, &visited](const index_t &index, const double &value) {
+        const auto it = expected.find(index);
+        ASSERT_NE(it, expected.end());
+        EXPECT_EQ(it->second, value);
+        ++visited;
+    });
+    EXPECT_EQ(visited, expected.size());
+
+    for (const auto &e : expected) {
+        const double *value = storage.get(e.first);
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(*value, e.second);
+    }
+}
+
+TEST(Test_cslibs_ndt, testOcTreeInsertGet)
+{
+    storage_t storage;
+    std::map<index_t, double> expected;
+    fill(storage, expected);
+    testEqual(storage, expected);
+
+    const index_t missing = {{2000, 2000, 2000}};
+    EXPECT_EQ(storage.get(missing), nullptr);
+}
+
+TEST(Test_cslibs_ndt, testOcTreeCopy)
+{
+    storage_t storage;
+    std::map<index_t, double> expected;
+    fill(storage, expected);
+
+    storage_t copy(storage);
+    for (const auto &e : expected)
+        *storage.get(e.first) += 1.0;
+
+    // the copy owns its own nodes and data
+    testEqual(copy, expected);
+}
+
+TEST(Test_cslibs_ndt, testOcTreeClear)
+{
+    storage_t storage;
+    const std::size_t empty_size = storage.byte_size();
+
+    std::map<index_t, double> expected;
+    fill(storage, expected);
+    const std::size_t filled_size = storage.byte_size();
+    EXPECT_GT(filled_size, empty_size + expected.size() * sizeof(double));
+
+    storage.clear();
+    EXPECT_EQ(storage.byte_size(), empty_size);
+    for (const auto &e : expected)
+        EXPECT_EQ(storage.get(e.first), nullptr);
+
+    // the tree is usable after a bulk release
+    std::map<index_t, double> refilled;
+    fill(storage, refilled);
+    testEqual(storage, refilled);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt/backend/rolling_window.hpp>
+#include <cslibs_indexed_storage/storage.hpp>
+#include <cslibs_math/random/random.hpp>
+
+#include <map>
+
+const std::size_t NUM_SAMPLES = 10000;
+using rng_t      = cslibs_math::random::Uniform<double,1>;
+using index_t    = std::array<int,3>;
+using storage_t  = cis::Storage<cis::interface::dense<double>, index_t, cslibs_ndt::backend::RollingWindow>;
+using capacity_t = std::array<std::size_t,3>;
+
+bool inside(const index_t &index, const index_t &min, const index_t &max)
+{
+    for (std::size_t i = 0 ; i < 3 ; ++i)
+        if (index[i] < min[i] || index[i] > max[i])
+            return false;
+    return true;
+}
+
+void fill(storage_t &storage, std::map<index_t, double> &expected, const index_t &min, const index_t &max)
+{
+    rng_t rng(0.0, 1.0);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++i) {
+        index_t index;
+        for (std::size_t k = 0 ; k < 3 ; ++k)
+            index[k] = min[k] + static_cast<int>(rng.get() * (max[k] - min[k] + 1));
+        if (!inside(index, min, max) || storage.get(index))
+            continue;
+
+        const double value = rng.get();
+        storage.insert(index, value);
+        expected[index] = value;
+    }
+}
+
+void testEqual(const storage_t &storage, const std::map<index_t, double> &expected)
+{
+    EXPECT_EQ(storage.size(), expected.size());
+
+    std::size_t visited = 0;
+    storage.traverse([&expected, &visited](const index_t &index, const double &value) {
+        const auto it = expected.find(index);
+        ASSERT_NE(it, expected.end());
+        EXPECT_EQ(it->second, value);
+        ++visited;
+    });
+    EXPECT_EQ(visited, expected.size());
+
+    for (const auto &e : expected) {
+        const double *value = storage.get(e.first);
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(*value, e.second);
+    }
+}
+
+TEST(Test_cslibs_ndt, testRollingWindowInsertGet)
+{
+    storage_t storage;
+    storage.set<cslibs_ndt::backend::tags::window_capacity>(capacity_t{{20ul, 20ul, 10ul}});
+
+    const index_t min = {{-7, -13, 2}};
+    const index_t max = {{12, 6, 11}};
+    storage.set<cslibs_ndt::backend::tags::window>(min, max);
+
+    std::map<index_t, double> expected;
+    fill(storage, expected, min, max);
+    testEqual(storage, expected);
+
+    // outside of the window nothing is stored
+    const index_t outside = {{13, 0, 5}};
+    EXPECT_EQ(storage.get(outside), nullptr);
+    EXPECT_THROW(storage.insert(outside, 1.0), std::out_of_range);
+
+    // the window must fit the capacity
+    const index_t too_large = {{12, 6, 12}};
+    EXPECT_THROW(storage.set<cslibs_ndt::backend::tags::window>(min, too_large), std::invalid_argument);
+}
+
+TEST(Test_cslibs_ndt, testRollingWindowMove)
+{
+    storage_t storage;
+    storage.set<cslibs_ndt::backend::tags::window_capacity>(capacity_t{{16ul, 16ul, 16ul}});
+
+    std::map<index_t, double> evicted;
+    storage.set<cslibs_ndt::backend::tags::on_evict>([&evicted](const index_t &index, double &value) {
+        EXPECT_TRUE(evicted.emplace(index, value).second);
+    });
+
+    index_t min = {{0, 0, 0}};
+    index_t max = {{15, 15, 15}};
+    storage.set<cslibs_ndt::backend::tags::window>(min, max);
+    const std::size_t empty_size = storage.byte_size();
+
+    std::map<index_t, double> expected;
+    fill(storage, expected, min, max);
+    const std::size_t byte_size = storage.byte_size();
+
+    // move diagonally, also by more than the window size, and back
+    const std::vector<index_t> offsets = {{{3, -5, 1}}, {{-9, 2, 7}}, {{40, 40, -40}}, {{-34, -37, 32}}};
+    for (const index_t &offset : offsets) {
+        for (std::size_t k = 0 ; k < 3 ; ++k) {
+            min[k] += offset[k];
+            max[k] += offset[k];
+        }
+        storage.set<cslibs_ndt::backend::tags::window>(min, max);
+
+        // everything which left the window was handed out exactly once
+        for (auto it = expected.begin() ; it != expected.end() ;) {
+            if (inside(it->first, min, max)) {
+                ++it;
+                continue;
+            }
+            const auto e = evicted.find(it->first);
+            ASSERT_NE(e, evicted.end());
+            EXPECT_EQ(it->second, e->second);
+            evicted.erase(e);
+            it = expected.erase(it);
+        }
+        EXPECT_TRUE(evicted.empty());
+        testEqual(storage, expected);
+
+        fill(storage, expected, min, max);
+        testEqual(storage, expected);
+
+        // memory is bounded by the window, not by the distance travelled
+        EXPECT_LE(storage.byte_size(), 2ul * byte_size);
+    }
+
+    // blocks are released once everything in them was evicted
+    for (std::size_t k = 0 ; k < 3 ; ++k) {
+        min[k] += 1000;
+        max[k] += 1000;
+    }
+    storage.set<cslibs_ndt::backend::tags::window>(min, max);
+    EXPECT_EQ(evicted.size(), expected.size());
+    EXPECT_EQ(storage.size(), 0ul);
+    EXPECT_EQ(storage.byte_size(), empty_size);
+}
+
+TEST(Test_cslibs_ndt, testRollingWindowCopyClear)
+{
+    storage_t storage;
+    storage.set<cslibs_ndt::backend::tags::window_capacity>(capacity_t{{32ul, 32ul, 32ul}});
+    const index_t min = {{-16, -16, -16}};
+    const index_t max = {{15, 15, 15}};
+    storage.set<cslibs_ndt::backend::tags::window>(min, max);
+    const std::size_t empty_size = storage.byte_size();
+
+    std::map<index_t, double> expected;
+    fill(storage, expected, min, max);
+
+    storage_t copy(storage);
+    for (const auto &e : expected)
+        *storage.get(e.first) += 1.0;
+    testEqual(copy, expected);
+
+    EXPECT_GT(storage.byte_size(), empty_size + expected.size() * sizeof(double));
+    storage.clear();
+    EXPECT_EQ(storage.size(), 0ul);
+    EXPECT_EQ(storage.byte_size(), empty_size);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
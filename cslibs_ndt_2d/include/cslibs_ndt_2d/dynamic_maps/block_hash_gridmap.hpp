@@ -0,0 +1,20 @@
+#ifndef CSLIBS_NDT_2D_DYNAMIC_MAPS_BLOCK_HASH_GRIDMAP_HPP
+#define CSLIBS_NDT_2D_DYNAMIC_MAPS_BLOCK_HASH_GRIDMAP_HPP
+
+#include <cslibs_ndt/map/map.hpp>
+
+namespace cslibs_ndt_2d {
+namespace dynamic_maps {
+namespace block_hash {
+
+template <typename T>
+using Gridmap = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,2,cslibs_ndt::Distribution,T,cslibs_ndt::backend::BlockHash>;
+
+template <typename T>
+using OccupancyGridmap = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,2,cslibs_ndt::OccupancyDistribution,T,cslibs_ndt::backend::BlockHash>;
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_2D_DYNAMIC_MAPS_BLOCK_HASH_GRIDMAP_HPP
@@ -9,6 +9,12 @@ namespace dynamic_maps {
 template <typename T>
 using OccupancyGridmap = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,2,cslibs_ndt::OccupancyDistribution,T>;
 
+template <typename T>
+using InlineOccupancyGridmap = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,2,cslibs_ndt::InlineOccupancyDistribution,T>;
+
+template <typename T>
+using DecayingOccupancyGridmap = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,2,cslibs_ndt::DecayingOccupancyDistribution,T>;
+
 }
 }
 
@@ -0,0 +1,15 @@
+#ifndef CSLIBS_NDT_2D_FROZEN_MAPS_GRIDMAP_HPP
+#define CSLIBS_NDT_2D_FROZEN_MAPS_GRIDMAP_HPP
+
+#include <cslibs_ndt/map/map.hpp>
+
+namespace cslibs_ndt_2d {
+namespace frozen_maps {
+
+template <typename T, cslibs_ndt::map::tags::option option_t = cslibs_ndt::map::tags::dynamic_map>
+using Gridmap = cslibs_ndt::map::FrozenMap<option_t,2,cslibs_ndt::Distribution,T>;
+
+}
+}
+
+#endif // CSLIBS_NDT_2D_FROZEN_MAPS_GRIDMAP_HPP
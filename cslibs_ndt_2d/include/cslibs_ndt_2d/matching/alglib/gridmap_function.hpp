@@ -2,7 +2,12 @@
 #define CSLIBS_NDT_2D_MATCHING_ALGLIB_GRIDMAP_FUNCTION_HPP
 
 #include <cslibs_ndt/matching/alglib/function.hpp>
+#include <cslibs_ndt/matching/gradient.hpp>
 #include <cslibs_ndt/map/map.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+#include <cslibs_ndt/utility/parallel.hpp>
+
+#include <cslibs_math/common/angle.hpp>
 
 #include <optimization.h>
 
@@ -28,42 +33,23 @@ public:
         double translation_weight_;
         double rotation_weight_;
         double map_weight_;
+
+        std::size_t num_threads_ = 0; // 0 uses all hardware threads
+        bool        settled_     = false; // the map is settled once on the first evaluation, reset after writing to it
     };
 
     inline static void apply(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi, void *ptr)
     {
-        // check that all necessary information is given
-        const auto& casted_ptr = (Functor*)ptr;
-        if (!casted_ptr) {
-            std::cerr << "Correct Functor not given..." << std::endl;
-            return;
-        }
-
-        // dissolve Functor
-        const Functor& object = *casted_ptr;
-        const auto& points    = *(object.points_);
-        const auto& map       = *(object.map_);
-
-        const double& map_weight   = /*std::sqrt*/(object.map_weight_);         //*0.5;
-        const double& trans_weight = /*std::sqrt*/(object.translation_weight_); //*0.5;
-        const double& rot_weight   = /*std::sqrt*/(object.rotation_weight_);    //*0.5;
-
-        const typename ndt_t::pose_t current_transform(x[0],x[1],x[2]);
-
-        // evaluate function
-        std::size_t i=0;
-        const double num_points =  static_cast<double>(points.size());
-        for (const auto& p : points) {
-            const typename ndt_t::point_t q = current_transform * typename ndt_t::point_t(p(0),p(1));
-            const double score = map.sampleNonNormalized(q);
-            fi[i++] = map_weight * (std::isnormal(score) ? (1.0 - score) : 1.0) / num_points;
-        }
+        evaluate(x, fi, nullptr, ptr);
+    }
 
-        // calculate translational and rotational function component
-        const auto& initial_guess = (object.initial_guess_);
-        fi[i++] = trans_weight * (x[0] - initial_guess[0]);
-        fi[i++] = trans_weight * (x[1] - initial_guess[1]);
-        fi[i++] = rot_weight * std::fabs(cslibs_math::common::angle::difference(x[2], initial_guess[2]));
+    /**
+     * @brief Function vector and Jacobian for minlmcreatevj.
+     */
+    inline static void jacobian(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi,
+                                ::alglib::real_2d_array &jac, void *ptr)
+    {
+        evaluate(x, fi, &jac, ptr);
     }
 
     inline static double mapScore(const ::alglib::real_1d_array &x, const ::alglib::real_1d_array &fi, void* ptr)
@@ -88,6 +74,77 @@ public:
 
         return score;
     }
+
+private:
+    inline static void evaluate(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi,
+                                ::alglib::real_2d_array *jac, void *ptr)
+    {
+        // check that all necessary information is given
+        const auto& casted_ptr = (Functor*)ptr;
+        if (!casted_ptr) {
+            std::cerr << "Correct Functor not given..." << std::endl;
+            return;
+        }
+
+        // dissolve Functor
+        Functor&       object = *casted_ptr;
+        const auto& points    = *(object.points_);
+        const auto& map       = *(object.map_);
+
+        const double& map_weight   = /*std::sqrt*/(object.map_weight_);         //*0.5;
+        const double& trans_weight = /*std::sqrt*/(object.translation_weight_); //*0.5;
+        const double& rot_weight   = /*std::sqrt*/(object.rotation_weight_);    //*0.5;
+
+        const typename ndt_t::pose_t current_transform(x[0],x[1],x[2]);
+
+        // evaluate function, the points are split among the threads
+        const double num_points = static_cast<double>(points.size());
+        const std::size_t threads = object.num_threads_ > 0ul ?
+                    object.num_threads_ : utility::num_threads(points.size() / points_per_thread);
+
+        // sampling fills lazily cached matrices, the threads below must only read
+        if (threads > 1ul && !object.settled_) {
+            cslibs_ndt::map::settle(map, threads);
+            object.settled_ = true;
+        }
+
+        std::vector<_T> scores(points.size());
+        std::vector<_T> gradients(jac ? points.size() * 2 : 0);
+        utility::parallel_for(points.size(), threads,
+                              [&](const std::size_t, const std::size_t begin, const std::size_t end) {
+            map.sampleNonNormalized(points.data() + begin, end - begin, current_transform,
+                                    scores.data() + begin, jac ? gradients.data() + begin * 2 : nullptr);
+            for (std::size_t k = begin ; k < end ; ++k)
+                fi[k] = map_weight * (std::isnormal(scores[k]) ? (1.0 - scores[k]) : 1.0) / num_points;
+            if (!jac)
+                return;
+
+            gradient::rows<2>(x.getcontent(), points.data(), gradients.data(), begin, end,
+                              [&](const std::size_t k, const std::array<double,3> &row) {
+                const double factor = std::isnormal(scores[k]) ? -map_weight / num_points : 0.0;
+                for (std::size_t c = 0 ; c < 3 ; ++c)
+                    (*jac)[k][c] = factor * row[c];
+            });
+        });
+
+        // calculate translational and rotational function component, each depends on one parameter
+        const auto& initial_guess = (object.initial_guess_);
+        const std::size_t i = points.size();
+        const double rot_diff = cslibs_math::common::angle::difference(x[2], initial_guess[2]);
+        fi[i]     = trans_weight * (x[0] - initial_guess[0]);
+        fi[i + 1] = trans_weight * (x[1] - initial_guess[1]);
+        fi[i + 2] = rot_weight * std::fabs(rot_diff);
+        if (jac) {
+            for (std::size_t r = i ; r < i + 3 ; ++r)
+                for (std::size_t c = 0 ; c < 3 ; ++c)
+                    (*jac)[r][c] = 0.0;
+            (*jac)[i][0]     = trans_weight;
+            (*jac)[i + 1][1] = trans_weight;
+            (*jac)[i + 2][2] = rot_diff < 0.0 ? -rot_weight : rot_weight;
+        }
+    }
+
+    static constexpr std::size_t points_per_thread = 512;
 };
 
 }
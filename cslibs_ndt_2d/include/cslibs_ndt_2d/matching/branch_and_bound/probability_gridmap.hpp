@@ -0,0 +1,60 @@
+#ifndef CSLIBS_NDT_2D_MATCHING_BRANCH_AND_BOUND_PROBABILITY_GRIDMAP_HPP
+#define CSLIBS_NDT_2D_MATCHING_BRANCH_AND_BOUND_PROBABILITY_GRIDMAP_HPP
+
+#include <cslibs_ndt/matching/branch_and_bound/match.hpp>
+#include <cslibs_ndt_2d/conversion/probability_gridmap.hpp>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace branch_and_bound {
+
+/**
+ * @brief Score grids of a sampled NDT map, level 0 are the cells of the gridmap.
+ * @param gridmap output of cslibs_ndt_2d::conversion::from
+ * @param levels  number of max-pooled levels, the coarsest windows span 2^(levels - 1) cells
+ */
+template <typename T>
+inline typename Grids<2>::Ptr fromGridmap(const cslibs_gridmaps::static_maps::ProbabilityGridmap<T,T> &gridmap,
+                                          const std::size_t levels)
+{
+    using grids_t = Grids<2>;
+
+    typename grids_t::rotation_t    rotation;
+    typename grids_t::translation_t translation;
+    newton::Model<2>::toEigen(gridmap.getOrigin(), rotation, translation);
+
+    const typename grids_t::index_t size{{static_cast<int>(gridmap.getWidth()),
+                                          static_cast<int>(gridmap.getHeight())}};
+    return typename grids_t::Ptr(new grids_t(rotation, translation,
+                                             static_cast<double>(gridmap.getResolution()), size, levels,
+                                             [&gridmap](const typename grids_t::index_t &i) {
+        return static_cast<double>(gridmap.at(static_cast<std::size_t>(i[0]), static_cast<std::size_t>(i[1])));
+    }));
+}
+
+/**
+ * @brief Score grids of a 2D NDT map, converted to a ProbabilityGridmap first.
+ * @param args additional conversion arguments, i.e. the inverse sensor model for occupancy maps
+ */
+template <cslibs_ndt::map::tags::option option_t,
+          template <typename,std::size_t> class data_t,
+          typename T,
+          template <typename, typename, typename...> class backend_t,
+          typename ... args_t>
+inline typename Grids<2>::Ptr fromMap(const cslibs_ndt::map::Map<option_t,2,data_t,T,backend_t> &map,
+                                      const T            sampling_resolution,
+                                      const std::size_t  levels,
+                                      const args_t      &...args)
+{
+    typename cslibs_gridmaps::static_maps::ProbabilityGridmap<T,T>::Ptr gridmap;
+    cslibs_ndt_2d::conversion::from(map, gridmap, sampling_resolution, args...);
+    if (!gridmap)
+        throw std::runtime_error("[BranchAndBound]: map could not be converted");
+    return fromGridmap(*gridmap, levels);
+}
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_2D_MATCHING_BRANCH_AND_BOUND_PROBABILITY_GRIDMAP_HPP
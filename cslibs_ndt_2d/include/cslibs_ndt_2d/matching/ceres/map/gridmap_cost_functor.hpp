@@ -3,6 +3,7 @@
 
 #include <cslibs_ndt/map/map.hpp>
 #include <cslibs_ndt/matching/ceres/map/scan_match_cost_functor.hpp>
+#include <cslibs_ndt/matching/lattice_cache.hpp>
 
 #include <ceres/cubic_interpolation.h>
 
@@ -77,7 +78,7 @@ private:
     Eigen::Matrix<double,2,1> trans_;
 };
 
-// only possible for maps of dimension 2
+// bicubic, maps of dimension 3 interpolate tricubically
 template <cslibs_ndt::map::tags::option option_t,
           typename _T,
           template <typename, typename, typename...> class backend_t>
@@ -92,6 +93,7 @@ class ScanMatchCostFunctor<
     using transform_t = typename ndt_t::pose_t;
     using bundle_t = typename ndt_t::distribution_bundle_t;
     using index_t = typename ndt_t::index_t;
+    using cache_t = LatticeCache<ndt_t>;
 
     template <typename>
     friend class ::ceres::BiCubicInterpolator;
@@ -101,8 +103,18 @@ class ScanMatchCostFunctor<
 protected:
     explicit inline ScanMatchCostFunctor(const ndt_t& map,
                                          const double& sampling_resolution) :
+        ScanMatchCostFunctor(map, typename cache_t::Ptr(new cache_t(map, sampling_resolution)))
+    {
+    }
+
+    /**
+     * @brief Reads the lattice from a cache, which can be shared by all functors of the map.
+     */
+    explicit inline ScanMatchCostFunctor(const ndt_t& map,
+                                         const typename cache_t::Ptr& cache) :
         map_(map),
-        sampling_resolution_(sampling_resolution),
+        cache_(cache),
+        sampling_resolution_(cache->getSamplingResolution()),
         interpolator_(*this)
     {
     }
@@ -124,12 +136,11 @@ protected:
 private:
     inline void GetValue(const int row, const int column, double* const value) const
     {
-        *value = 1.0 - map_.sampleNonNormalized(
-                    point_t(row * sampling_resolution_,
-                            column * sampling_resolution_));
+        *value = 1.0 - cache_->at({{row, column}});
     }
 
     const ndt_t& map_;
+    const typename cache_t::Ptr cache_;
     const double sampling_resolution_;
     const ::ceres::BiCubicInterpolator<ScanMatchCostFunctor<ndt_t,Flag::INTERPOLATION>> interpolator_;
 };
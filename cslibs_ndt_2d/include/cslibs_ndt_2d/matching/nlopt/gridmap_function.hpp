@@ -2,8 +2,11 @@
 #define CSLIBS_NDT_2D_MATCHING_NLOPT_GRIDMAP_FUNCTION_HPP
 
 #include <cslibs_ndt/matching/nlopt/function.hpp>
+#include <cslibs_ndt/matching/gradient.hpp>
 #include <cslibs_ndt/map/map.hpp>
 
+#include <cslibs_math/common/angle.hpp>
+
 namespace cslibs_ndt {
 namespace matching {
 namespace nlopt {
@@ -32,12 +35,6 @@ public:
 
     inline static double apply(unsigned n, const double *x, double *grad, void* ptr)
     {
-        // since f is discontinuous, use derivative-free algorithms!
-        if (grad) {
-            std::cerr << "Gradient not implemented..." << std::endl;
-            return 0;
-        }
-
         // check that all necessary information is given
         const auto& casted_ptr = (Functor*)ptr;
         if (!casted_ptr) {
@@ -53,10 +50,12 @@ public:
         double fi = 0;
         const typename ndt_t::pose_t current_transform(x[0],x[1],x[2]);
 
-        // evaluate function
-        for (const auto& p : points) {
-            const typename ndt_t::point_t q = current_transform * typename ndt_t::point_t(p(0),p(1));
-            const double score = map.sampleNonNormalized(q);
+        // evaluate function, with the score gradient of every point if requested
+        std::vector<_T> scores(points.size());
+        std::vector<_T> gradients(grad ? points.size() * 2 : 0);
+        map.sampleNonNormalized(points.data(), points.size(), current_transform, scores.data(),
+                                grad ? gradients.data() : nullptr);
+        for (const double score : scores) {
             fi += std::isnormal(score) ? (1.0 - score) : 1.0;
         }
 
@@ -70,6 +69,18 @@ public:
              object.translation_weight_ * trans_diff +
              object.rotation_weight_ * std::fabs(rot_diff);
 
+        // calculate gradient, the points only contribute through their scores
+        if (grad) {
+            std::fill(grad, grad + n, 0.0);
+            const _T factor = static_cast<_T>(-object.map_weight_ / static_cast<double>(points.size()));
+            for (_T &g : gradients)
+                g *= factor;
+            gradient::chain<2>(x, points, gradients, grad);
+            gradient::norm<2>({{x[0] - initial_guess[0], x[1] - initial_guess[1]}},
+                              object.translation_weight_, grad);
+            gradient::norm<1>({{rot_diff}}, object.rotation_weight_, grad + 2);
+        }
+
         return fi;
     }
 
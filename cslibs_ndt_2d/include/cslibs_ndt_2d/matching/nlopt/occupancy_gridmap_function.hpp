@@ -2,8 +2,11 @@
 #define CSLIBS_NDT_2D_MATCHING_NLOPT_OCCUPANCY_GRIDMAP_FUNCTION_HPP
 
 #include <cslibs_ndt/matching/nlopt/function.hpp>
+#include <cslibs_ndt/matching/gradient.hpp>
 #include <cslibs_ndt/map/map.hpp>
 
+#include <cslibs_math/common/angle.hpp>
+
 namespace cslibs_ndt {
 namespace matching {
 namespace nlopt {
@@ -33,12 +36,6 @@ public:
 
     inline static double apply(unsigned n, const double *x, double *grad, void* ptr)
     {
-        // since f is discontinuous, use derivative-free algorithms!
-        if (grad) {
-            std::cerr << "Gradient not implemented..." << std::endl;
-            return 0;
-        }
-
         // check that all necessary information is given
         const auto& casted_ptr = (Functor*)ptr;
         if (!casted_ptr) {
@@ -55,14 +52,25 @@ public:
         double fi = 0;
         const typename ndt_t::pose_t current_transform(x[0],x[1],x[2]);
 
-        // evaluate function
+        // evaluate function, with the score gradient of every point if requested
         auto sq = [](const double& x) { return x * x; };
         const double num_points =  static_cast<double>(points.size());
-        for (const auto& p : points) {
-            const typename ndt_t::point_t q = current_transform * typename ndt_t::point_t(p(0),p(1));
-            const double score = map.sampleNonNormalized(q, ivm);
+        std::vector<_T> scores(points.size());
+        std::vector<_T> gradients(grad ? points.size() * 2 : 0);
+        map.sampleNonNormalized(points.data(), points.size(), current_transform, ivm, scores.data(),
+                                grad ? gradients.data() : nullptr);
+        for (std::size_t i = 0 ; i < scores.size() ; ++i) {
+            const double score = scores[i];
             fi += 0.5 * object.map_weight_ * sq((std::isnormal(score) ? (1.0 - score) : 1.0) / num_points);
             //fi += std::isnormal(score) ? (1.0 - score) : 1.0;
+
+            // d/ds of 0.5 * (above), which is constant for non-normal scores
+            if (grad) {
+                const _T factor = static_cast<_T>(std::isnormal(score) ?
+                                                  -0.5 * object.map_weight_ * (1.0 - score) / sq(num_points) : 0.0);
+                gradients[i * 2]     *= factor;
+                gradients[i * 2 + 1] *= factor;
+            }
         }
 
         // calculate translational and rotational function component
@@ -77,6 +85,15 @@ public:
         fi += object.translation_weight_ * (sq(x[0] - initial_guess[0]) + sq(x[1] - initial_guess[1]));
         fi += object.rotation_weight_ * sq(rot_diff);
 
+        // calculate gradient of 0.5*fi
+        if (grad) {
+            std::fill(grad, grad + n, 0.0);
+            gradient::chain<2>(x, points, gradients, grad);
+            grad[0] += object.translation_weight_ * (x[0] - initial_guess[0]);
+            grad[1] += object.translation_weight_ * (x[1] - initial_guess[1]);
+            grad[2] += object.rotation_weight_ * rot_diff;
+        }
+
         return 0.5*fi;
     }
 
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_2d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_2d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_2d/matching/alglib/gridmap_function.hpp>
+#include <cslibs_ndt_2d/matching/alglib/occupancy_gridmap_function.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_2d::Point2d>;
+
+/**
+ * @brief Compares the Jacobian at x to central differences of apply, see the 3D test.
+ */
+template <std::size_t n, typename apply_t, typename jacobian_t, typename functor_t>
+void testJacobian(const apply_t &apply, const jacobian_t &jacobian, functor_t &functor, const std::array<double,n> &x)
+{
+    const std::size_t num_points = functor.points_->size();
+    const std::size_t m          = num_points + n;
+    const double      scale      = functor.map_weight_ / static_cast<double>(num_points);
+
+    ::alglib::real_1d_array xa, fi, fi_apply;
+    ::alglib::real_2d_array jac;
+    xa.setcontent(n, x.data());
+    fi.setlength(m);
+    fi_apply.setlength(m);
+    jac.setlength(m, n);
+
+    jacobian(xa, fi, jac, &functor);
+    apply(xa, fi_apply, &functor);
+    for (std::size_t r = 0 ; r < m ; ++r)
+        EXPECT_EQ(fi_apply[r], fi[r]);
+
+    const double h = 1e-7;
+    for (std::size_t c = 0 ; c < n ; ++c) {
+        ::alglib::real_1d_array xp = xa, xm = xa, fp, fm;
+        xp[c] += h;
+        xm[c] -= h;
+        fp.setlength(m);
+        fm.setlength(m);
+        apply(xp, fp, &functor);
+        apply(xm, fm, &functor);
+
+        std::size_t jumps = 0;
+        for (std::size_t r = 0 ; r < m ; ++r) {
+            const double expected = (fp[r] - fm[r]) / (2.0 * h);
+            const bool   near     = std::fabs(expected - jac[r][c]) <= 1e-4 * std::max(scale, std::fabs(expected));
+            if (r < num_points)
+                jumps += near ? 0ul : 1ul;
+            else
+                EXPECT_TRUE(near) << "prior row " << r - num_points << ", column " << c << ": "
+                                  << expected << " vs. " << jac[r][c];
+        }
+        EXPECT_LE(jumps, 2ul) << "column " << c;
+    }
+}
+
+template <typename function_t, typename map_t, typename... args_t>
+void testFunction(const map_t &map, const args_t*... ivm)
+{
+    const cslibs_math_2d::Transform2d truth(0.3, -0.2, 0.1);
+    const cslibs_math_2d::Transform2d truth_inv = truth.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(1000))
+        scan.emplace_back(truth_inv * p);
+
+    // several threads, the first evaluation runs on a map which has not been sampled before
+    typename function_t::Functor functor{&map, &scan, ivm..., {{0.1, 0.1, 0.05}}, 0.1, 0.2, 1.0, 4ul};
+    testJacobian<3>(&function_t::apply, &function_t::jacobian, functor, {{0.25, -0.15, 0.12}});
+}
+
+TEST(Test_cslibs_ndt_2d, testAlglibJacobianGridmap)
+{
+    using map_t = cslibs_ndt_2d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(20000);
+    map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testFunction<cslibs_ndt::matching::alglib::Function<map_t, cslibs_math_2d::Point2d>>(map);
+}
+
+TEST(Test_cslibs_ndt_2d, testAlglibJacobianOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_2d::dynamic_maps::OccupancyGridmap<double>;
+
+    // scanned from the center of the room
+    const cslibs_math_2d::Transform2d sensor(10.0, 7.0, 0.0);
+    const cslibs_math_2d::Transform2d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(20000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testFunction<cslibs_ndt::matching::alglib::Function<map_t, cslibs_math_2d::Point2d>>(map, &ivm);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_2d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_2d/matching/branch_and_bound/probability_gridmap.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+namespace bnb = cslibs_ndt::matching::branch_and_bound;
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using map_t   = cslibs_ndt_2d::dynamic_maps::Gridmap<double>;
+using cloud_t = std::vector<cslibs_math_2d::Point2d>;
+
+const cslibs_math_2d::Transform2d TRUTH(1.3, -0.8, 2.1);
+
+cloud_t generateScan(const std::size_t size)
+{
+    const cslibs_math_2d::Transform2d truth_inv = TRUTH.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(size, true))
+        points.emplace_back(truth_inv * p);
+    return points;
+}
+
+bnb::Grids<2>::Ptr generateGrids(const std::size_t levels)
+{
+    map_t map(cslibs_math_2d::Transform2d(0.5, -0.5, 0.0), 1.0);
+    const cloud_t room = generateRoom(20000, true);
+    map.insert(room.begin(), room.end());
+    return bnb::fromMap(map, 0.1, levels);
+}
+
+TEST(Test_cslibs_ndt_2d, testBranchAndBoundPooling)
+{
+    const bnb::Grids<2>::Ptr grids = generateGrids(4);
+    ASSERT_EQ(4ul, grids->levels());
+
+    // level h holds the maximum of level 0 over the window of 2^h cells
+    const auto &size = grids->getSize();
+    for (std::size_t h = 1 ; h < grids->levels() ; ++h) {
+        const int w = 1 << h;
+        for (int u = -w ; u < size[0] ; u += 7) {
+            for (int v = -w ; v < size[1] ; v += 5) {
+                float expected = 0.0f;
+                for (int i = 0 ; i < w ; ++i) {
+                    for (int j = 0 ; j < w ; ++j)
+                        expected = std::max(expected, grids->at(0, {{u + i, v + j}}));
+                }
+                EXPECT_EQ(expected, grids->at(h, {{u, v}}));
+            }
+        }
+    }
+}
+
+TEST(Test_cslibs_ndt_2d, testBranchAndBoundMatch)
+{
+    const bnb::Grids<2>::Ptr grids = generateGrids(7);
+    const cloud_t scan = generateScan(500);
+
+    bnb::Parameter parameter;
+    parameter.linear_window  = 3.0;
+    parameter.angular_window = M_PI;
+    const bnb::Result<cslibs_math_2d::Transform2d> result =
+            bnb::match(*grids, scan, cslibs_math_2d::Transform2d(), parameter);
+
+    EXPECT_EQ(bnb::Termination::COMPLETE, result.termination);
+    EXPECT_TRUE(result.found());
+    EXPECT_GT(result.score, parameter.min_score);
+    EXPECT_NEAR(result.transform.tx(), TRUTH.tx(), 0.2);
+    EXPECT_NEAR(result.transform.ty(), TRUTH.ty(), 0.2);
+    EXPECT_NEAR(std::cos(result.transform.yaw() - TRUTH.yaw()), 1.0, 1e-3);
+}
+
+TEST(Test_cslibs_ndt_2d, testBranchAndBoundExhaustive)
+{
+    const bnb::Grids<2>::Ptr grids = generateGrids(7);
+    const cloud_t scan = generateScan(200);
+
+    // bounds never prune the optimum, a single level scores every candidate
+    bnb::Parameter parameter;
+    parameter.linear_window  = 1.0;
+    parameter.angular_window = 0.2;
+    parameter.min_score      = 0.0;
+    const cslibs_math_2d::Transform2d guess(1.0, -0.5, 2.0);
+    const auto pruned = bnb::match(*grids, scan, guess, parameter);
+    parameter.depth = 1;
+    const auto exhaustive = bnb::match(*grids, scan, guess, parameter);
+
+    EXPECT_EQ(bnb::Termination::COMPLETE, pruned.termination);
+    EXPECT_EQ(bnb::Termination::COMPLETE, exhaustive.termination);
+    EXPECT_NEAR(pruned.score, exhaustive.score, 1e-9);
+    EXPECT_LT(pruned.candidates, exhaustive.candidates);
+}
+
+TEST(Test_cslibs_ndt_2d, testBranchAndBoundTimeBudget)
+{
+    const bnb::Grids<2>::Ptr grids = generateGrids(7);
+    const cloud_t scan = generateScan(500);
+
+    bnb::Parameter parameter;
+    parameter.angular_window = M_PI;
+    parameter.angular_step   = 0.001;
+    parameter.time_budget    = 1e-3;
+    const auto result = bnb::match(*grids, scan, cslibs_math_2d::Transform2d(), parameter);
+    EXPECT_EQ(bnb::Termination::TIME_BUDGET, result.termination);
+
+    const auto empty = bnb::match(*grids, cloud_t(), cslibs_math_2d::Transform2d(), parameter);
+    EXPECT_EQ(bnb::Termination::NO_POINTS, empty.termination);
+    EXPECT_FALSE(empty.found());
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_2d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_2d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_2d/matching/ceres/map/gridmap_cost_functor.hpp>
+#include <cslibs_ndt_2d/matching/ceres/map/occupancy_gridmap_cost_functor.hpp>
+#include <cslibs_ndt/matching/ceres/hypotheses.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+namespace nc = cslibs_ndt::matching::ceres;
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_2d::Point2d>;
+using poses_t = std::vector<cslibs_math_2d::Transform2d>;
+
+::ceres::Solver::Options options()
+{
+    ::ceres::Solver::Options options;
+    options.linear_solver_type = ::ceres::DENSE_QR;
+    options.max_num_iterations = 100;
+    options.num_threads        = 1;
+    return options;
+}
+
+/**
+ * @brief Runs the hypotheses on 4 threads and each of them on its own, see the 3D test.
+ */
+template <typename map_t, typename... args_t>
+void testHypotheses(const map_t &map, const nc::Differentiation differentiation, const args_t&... args)
+{
+    const cslibs_math_2d::Transform2d truth(0.3, -0.2, 0.1);
+    const cslibs_math_2d::Transform2d truth_inv = truth.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(2000))
+        scan.emplace_back(truth_inv * p);
+
+    // settled once when handed over, the hypotheses only read it
+    cslibs_ndt::map::settle(map);
+
+    rng_t rng_trans(-0.15, 0.15), rng_r(-0.05, 0.05);
+    poses_t guesses;
+    for (std::size_t i = 0 ; i < 8 ; ++ i)
+        guesses.emplace_back(truth * cslibs_math_2d::Transform2d(rng_trans.get(), rng_trans.get(), rng_r.get()));
+    // far off, no overlap at all
+    guesses.emplace_back(100.0, 100.0, 0.0);
+
+    const auto results = nc::MatchHypotheses2d<map_t>(options(), 0.0, 0.0, 1.0, guesses,
+                                                      differentiation, 4ul, scan, map, args...);
+    ASSERT_EQ(guesses.size(), results.size());
+
+    for (std::size_t i = 0 ; i < guesses.size() ; ++ i) {
+        const auto single = nc::MatchHypotheses2d<map_t>(options(), 0.0, 0.0, 1.0, poses_t{guesses[i]},
+                                                         differentiation, 1ul, scan, map, args...);
+        ASSERT_EQ(1ul, single.size());
+        EXPECT_EQ(single.front().iterations, results[i].iterations);
+        EXPECT_NEAR(single.front().score,           results[i].score,           1e-12);
+        EXPECT_NEAR(single.front().transform.tx(),  results[i].transform.tx(),  1e-12);
+        EXPECT_NEAR(single.front().transform.ty(),  results[i].transform.ty(),  1e-12);
+        EXPECT_NEAR(single.front().transform.yaw(), results[i].transform.yaw(), 1e-12);
+    }
+
+    for (std::size_t i = 0 ; i + 1 < guesses.size() ; ++ i) {
+        EXPECT_NEAR(results[i].transform.tx(),  truth.tx(),  0.05);
+        EXPECT_NEAR(results[i].transform.ty(),  truth.ty(),  0.05);
+        EXPECT_NEAR(results[i].transform.yaw(), truth.yaw(), 0.02);
+    }
+    EXPECT_EQ(0.0, results.back().score);
+}
+
+TEST(Test_cslibs_ndt_2d, testCeresHypothesesGridmap)
+{
+    using map_t = cslibs_ndt_2d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(20000);
+    map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testHypotheses(map, nc::Differentiation::AUTOMATIC);
+    testHypotheses(map, nc::Differentiation::ANALYTIC);
+}
+
+TEST(Test_cslibs_ndt_2d, testCeresHypothesesOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_2d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_2d::Transform2d sensor(10.0, 7.0, 0.0);
+    const cslibs_math_2d::Transform2d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(20000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testHypotheses(map, nc::Differentiation::AUTOMATIC, ivm);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_2d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_2d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/matching/lattice_cache.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <thread>
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using map_t   = cslibs_ndt_2d::dynamic_maps::Gridmap<double>;
+using cloud_t = std::vector<cslibs_math_2d::Point2d>;
+using cache_t = cslibs_ndt::matching::LatticeCache<map_t>;
+
+const double SAMPLING_RESOLUTION = 0.1;
+
+cloud_t generatePoints(const std::size_t size, const double min, const double max)
+{
+    rng_t rng(min, max);
+    cloud_t cloud;
+    for (std::size_t i = 0 ; i < size ; ++i)
+        cloud.emplace_back(rng.get(), rng.get());
+    return cloud;
+}
+
+template <typename ndt_t, typename ... args_t>
+void testSamples(const ndt_t &map, const cslibs_ndt::matching::LatticeCache<ndt_t> &cache, const args_t &...args)
+{
+    for (int r = -40 ; r < 80 ; r += 3) {
+        for (int c = -40 ; c < 80 ; c += 7) {
+            const double expected = map.sampleNonNormalized(
+                        cslibs_math_2d::Point2d(r * SAMPLING_RESOLUTION, c * SAMPLING_RESOLUTION), args...);
+            EXPECT_EQ(expected, cache.at({{r, c}}));
+        }
+    }
+}
+
+TEST(Test_cslibs_ndt_2d, testLatticeCacheSample)
+{
+    const cloud_t points = generatePoints(5000, -3.0, 7.0);
+    map_t map(cslibs_math_2d::Transform2d(0.3, -0.2, 0.4), 1.0);
+    map.insert(points.begin(), points.end());
+
+    const cache_t cache(map, SAMPLING_RESOLUTION);
+    EXPECT_EQ(0ul, cache.size());
+    testSamples(map, cache);
+    EXPECT_EQ(64ul, cache.size()); // [-48, 80)^2 in tiles of 16
+
+    // sampled once, the second pass only reads
+    testSamples(map, cache);
+    EXPECT_EQ(64ul, cache.size());
+}
+
+TEST(Test_cslibs_ndt_2d, testLatticeCacheOccupancy)
+{
+    using occ_map_t   = cslibs_ndt_2d::dynamic_maps::OccupancyGridmap<double>;
+    using occ_cache_t = cslibs_ndt::matching::LatticeCache<occ_map_t>;
+
+    const cloud_t points = generatePoints(5000, -3.0, 7.0);
+    occ_map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(points.begin(), points.end(), cslibs_math_2d::Transform2d(2.0, 2.0, 0.0));
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const occ_cache_t cache(map, SAMPLING_RESOLUTION, ivm);
+    testSamples(map, cache, ivm);
+}
+
+TEST(Test_cslibs_ndt_2d, testLatticeCacheInvalidate)
+{
+    const cloud_t points = generatePoints(5000, -3.0, 7.0);
+    map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(points.begin(), points.end());
+
+    cache_t cache(map, SAMPLING_RESOLUTION);
+    testSamples(map, cache);
+    const std::size_t tiles = cache.size();
+
+    // new points change the distributions of their bundles and of the neighbouring ones
+    const cloud_t update = generatePoints(500, 1.0, 1.4);
+    map.insert(update.begin(), update.end());
+    const int resolution_inv = static_cast<int>(1.0 / map.getBundleResolution());
+    for (int i = 1 * resolution_inv - 1 ; i <= 2 * resolution_inv ; ++i) {
+        for (int j = 1 * resolution_inv - 1 ; j <= 2 * resolution_inv ; ++j)
+            cache.invalidate({{i, j}});
+    }
+    EXPECT_LT(cache.size(), tiles);
+    EXPECT_GT(cache.size(), 0ul);
+    testSamples(map, cache);
+
+    cache.clear();
+    EXPECT_EQ(0ul, cache.size());
+}
+
+TEST(Test_cslibs_ndt_2d, testLatticeCacheChanges)
+{
+    const cloud_t points = generatePoints(5000, -3.0, 7.0);
+    map_t map(cslibs_math_2d::Transform2d(0.3, -0.2, 0.4), 1.0);
+    map.insert(points.begin(), points.end());
+    map.setChangeTracking(true);
+
+    cache_t cache(map, SAMPLING_RESOLUTION);
+    testSamples(map, cache);
+    const std::size_t tiles = cache.size();
+
+    // only the tiles of the changed bundles are sampled again
+    const cloud_t update = generatePoints(500, 1.0, 1.4);
+    map.insert(update.begin(), update.end());
+    std::vector<map_t::index_t> changes;
+    map.consumeChanges(changes);
+    cache.invalidate(changes.begin(), changes.end());
+    EXPECT_LT(cache.size(), tiles);
+    EXPECT_GT(cache.size(), 0ul);
+    testSamples(map, cache);
+}
+
+TEST(Test_cslibs_ndt_2d, testLatticeCacheConcurrentReaders)
+{
+    const cloud_t points = generatePoints(5000, -3.0, 7.0);
+    map_t map(cslibs_math_2d::Transform2d(0.3, -0.2, 0.4), 1.0);
+    map.insert(points.begin(), points.end());
+
+    // the cache settles the map, afterwards its readers only read, the expected values are
+    // sampled up front so that only the cache is shared between the threads
+    const cache_t cache(map, SAMPLING_RESOLUTION);
+    const int min = -40, max = 80;
+    std::vector<double> expected;
+    for (int r = min ; r < max ; ++r) {
+        for (int c = min ; c < max ; ++c)
+            expected.emplace_back(map.sampleNonNormalized(
+                                      cslibs_math_2d::Point2d(r * SAMPLING_RESOLUTION, c * SAMPLING_RESOLUTION)));
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<std::size_t> errors(8, 0ul);
+    for (std::size_t t = 0 ; t < errors.size() ; ++t) {
+        threads.emplace_back([&cache, &expected, &errors, t]() {
+            rng_t rng(min, max);
+            for (std::size_t i = 0 ; i < 20000 ; ++i) {
+                const int r = std::min(max - 1, static_cast<int>(std::floor(rng.get())));
+                const int c = std::min(max - 1, static_cast<int>(std::floor(rng.get())));
+                if (cache.at({{r, c}}) != expected[(r - min) * (max - min) + (c - min)])
+                    ++errors[t];
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    for (const std::size_t e : errors)
+        EXPECT_EQ(0ul, e);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
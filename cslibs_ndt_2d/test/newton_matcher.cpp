@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_2d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_2d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/matching/newton/match.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using map_t   = cslibs_ndt_2d::dynamic_maps::Gridmap<double>;
+using cloud_t = std::vector<cslibs_math_2d::Point2d>;
+using scan_t  = cslibs_ndt::matching::d2d::Scan<2>;
+
+const cslibs_math_2d::Transform2d TRUTH(0.3, -0.2, 0.05);
+
+template <typename map_t, typename scan_t, typename... args_t>
+void testMatch(const map_t &map, const scan_t &scan, const args_t&... args)
+{
+    const auto result = cslibs_ndt::matching::newton::match(
+                map, scan, cslibs_math_2d::Transform2d(), cslibs_ndt::matching::newton::Parameter(), args...);
+
+    EXPECT_TRUE(result.converged());
+    EXPECT_GT(result.iterations, 0ul);
+    EXPECT_GT(result.score, 0.0);
+    EXPECT_NEAR(result.transform.tx(),  TRUTH.tx(),  0.03);
+    EXPECT_NEAR(result.transform.ty(),  TRUTH.ty(),  0.03);
+    EXPECT_NEAR(result.transform.yaw(), TRUTH.yaw(), 0.01);
+}
+
+cloud_t generateScan(const std::size_t size)
+{
+    const cslibs_math_2d::Transform2d truth_inv = TRUTH.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(size))
+        scan.emplace_back(truth_inv * p);
+    return scan;
+}
+
+TEST(Test_cslibs_ndt_2d, testModelDerivatives)
+{
+    using model_t = cslibs_ndt::matching::newton::Model<2>;
+
+    model_t::vector_t x;
+    x << 0.25, -0.15, 0.7;
+    model_t model;
+    model.update(x);
+
+    EXPECT_TRUE(model.translation().isApprox(x.head<2>()));
+    EXPECT_NEAR(model.rotation().determinant(), 1.0, 1e-12);
+
+    // central differences of the rotation and of its analytic first derivative w.r.t. yaw
+    const double h = 1e-6;
+    model_t::vector_t xp = x, xm = x;
+    xp(2) += h;
+    xm(2) -= h;
+    model_t mp, mm;
+    mp.update(xp);
+    mm.update(xm);
+
+    const model_t::rotation_t dR  = (mp.rotation() - mm.rotation()) / (2.0 * h);
+    const model_t::rotation_t ddR = (mp.firstDerivative(0) - mm.firstDerivative(0)) / (2.0 * h);
+    for (std::size_t i = 0 ; i < 2 ; ++ i) {
+        for (std::size_t j = 0 ; j < 2 ; ++ j) {
+            EXPECT_NEAR(model.firstDerivative(0)(i, j),     dR(i, j),  1e-8);
+            EXPECT_NEAR(model.secondDerivative(0, 0)(i, j), ddR(i, j), 1e-8);
+        }
+    }
+
+    // pose round trip
+    const cslibs_math_2d::Transform2d pose = model_t::toPose<cslibs_math_2d::Transform2d>(x);
+    EXPECT_TRUE(model_t::fromPose(pose).isApprox(x));
+    EXPECT_NEAR(model_t::fromEigen<cslibs_math_2d::Transform2d>(model.rotation(), model.translation()).yaw(),
+                x(2), 1e-12);
+}
+
+TEST(Test_cslibs_ndt_2d, testNewtonMatchGridmap)
+{
+    const cloud_t room = generateRoom(20000);
+    map_t map(cslibs_math_2d::Transform2d(0.5, -0.5, 0.1), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testMatch(map, generateScan(2000));
+}
+
+TEST(Test_cslibs_ndt_2d, testNewtonMatchOccupancyGridmap)
+{
+    using occ_map_t = cslibs_ndt_2d::dynamic_maps::OccupancyGridmap<double>;
+
+    // scanned from the center of the room
+    const cslibs_math_2d::Transform2d sensor(10.0, 7.0, 0.0);
+    const cslibs_math_2d::Transform2d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(20000))
+        points.emplace_back(sensor_inv * p);
+
+    occ_map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testMatch(map, generateScan(2000), ivm);
+}
+
+TEST(Test_cslibs_ndt_2d, testD2DDerivatives)
+{
+    using objective_t = cslibs_ndt::matching::newton::D2DObjective<map_t>;
+
+    const cloud_t room = generateRoom(20000);
+    map_t map(cslibs_math_2d::Transform2d(0.5, -0.5, 0.1), 1.0);
+    map.insert(room.begin(), room.end());
+    const cloud_t points = generateScan(5000);
+    const scan_t scan = scan_t::fromPoints(points.begin(), points.end(), 1.0);
+
+    const objective_t objective(map);
+    objective_t::vector_t x;
+    x << 0.25, -0.15, 0.04;
+    objective_t::model_t model;
+    model.update(x);
+
+    objective_t::vector_t  g;
+    objective_t::hessian_t H;
+    objective.evaluate(model, scan, &g, &H);
+
+    // central differences of the score and of the analytic gradient
+    const double h = 1e-6;
+    for (std::size_t i = 0 ; i < 3 ; ++ i) {
+        objective_t::vector_t xp = x, xm = x;
+        xp(i) += h;
+        xm(i) -= h;
+        objective_t::model_t mp, mm;
+        mp.update(xp);
+        mm.update(xm);
+        objective_t::vector_t  gp, gm;
+        objective_t::hessian_t Hp, Hm;
+        const double dscore = (objective.evaluate(mp, scan, &gp, &Hp) - objective.evaluate(mm, scan, &gm, &Hm)) / (2.0 * h);
+        EXPECT_NEAR(g(i), dscore, 1e-4 * (1.0 + std::fabs(dscore)));
+        for (std::size_t j = 0 ; j < 3 ; ++ j) {
+            const double dg = (gp(j) - gm(j)) / (2.0 * h);
+            EXPECT_NEAR(H(j, i), dg, 1e-3 * (1.0 + std::fabs(dg)));
+        }
+    }
+}
+
+TEST(Test_cslibs_ndt_2d, testD2DGridmap)
+{
+    const cloud_t room = generateRoom(20000);
+    map_t map(cslibs_math_2d::Transform2d(0.5, -0.5, 0.1), 1.0);
+    map.insert(room.begin(), room.end());
+
+    const cloud_t points = generateScan(20000);
+    testMatch(map, scan_t::fromPoints(points.begin(), points.end(), 1.0));
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
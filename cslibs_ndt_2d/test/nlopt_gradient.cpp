@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_2d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_2d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_2d/frozen_maps/gridmap.hpp>
+#include <cslibs_ndt_2d/frozen_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_2d/static_maps/soa_gridmap.hpp>
+#include <cslibs_ndt/conversion/map.hpp>
+#include <cslibs_ndt_2d/matching/nlopt/gridmap_function.hpp>
+#include <cslibs_ndt_2d/matching/nlopt/occupancy_gridmap_function.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_2d::Point2d>;
+
+/**
+ * @brief Compares the gradient at x to central differences, see the 3D test.
+ */
+template <typename function_t, typename map_t, typename... args_t>
+void testGradient(const map_t &map, const args_t*... ivm)
+{
+    const cslibs_math_2d::Transform2d truth(0.3, -0.2, 0.1);
+    const cslibs_math_2d::Transform2d truth_inv = truth.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(1000))
+        scan.emplace_back(truth_inv * p);
+
+    typename function_t::Functor functor{&map, &scan, ivm..., {{0.1, 0.1, 0.05}}, 0.1, 0.2, 1.0};
+    const std::array<double,3> x{{0.25, -0.15, 0.12}};
+
+    std::array<double,3> grad;
+    const double f = function_t::apply(3, x.data(), grad.data(), &functor);
+    EXPECT_EQ(f, function_t::apply(3, x.data(), nullptr, &functor));
+
+    const double h = 1e-7;
+    for (std::size_t i = 0 ; i < 3 ; ++i) {
+        std::array<double,3> xp = x, xm = x;
+        xp[i] += h;
+        xm[i] -= h;
+        const double expected = (function_t::apply(3, xp.data(), nullptr, &functor) -
+                                 function_t::apply(3, xm.data(), nullptr, &functor)) / (2.0 * h);
+        EXPECT_NEAR(expected, grad[i], 1e-4 * std::max(1.0, std::fabs(expected)));
+    }
+}
+
+TEST(Test_cslibs_ndt_2d, testNLoptGradientGridmap)
+{
+    using map_t = cslibs_ndt_2d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(20000);
+    map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testGradient<cslibs_ndt::matching::nlopt::Function<map_t, cslibs_math_2d::Point2d>>(map);
+}
+
+TEST(Test_cslibs_ndt_2d, testNLoptGradientOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_2d::dynamic_maps::OccupancyGridmap<double>;
+
+    // scanned from the center of the room
+    const cslibs_math_2d::Transform2d sensor(10.0, 7.0, 0.0);
+    const cslibs_math_2d::Transform2d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(20000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testGradient<cslibs_ndt::matching::nlopt::Function<map_t, cslibs_math_2d::Point2d>>(map, &ivm);
+}
+
+TEST(Test_cslibs_ndt_2d, testNLoptGradientFrozenGridmap)
+{
+    using map_t    = cslibs_ndt_2d::dynamic_maps::Gridmap<double>;
+    using frozen_t = cslibs_ndt_2d::frozen_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(20000);
+    map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(room.begin(), room.end());
+    const frozen_t frozen(map);
+
+    testGradient<cslibs_ndt::matching::nlopt::Function<frozen_t, cslibs_math_2d::Point2d>>(frozen);
+}
+
+TEST(Test_cslibs_ndt_2d, testNLoptGradientFrozenOccupancyGridmap)
+{
+    using map_t    = cslibs_ndt_2d::dynamic_maps::OccupancyGridmap<double>;
+    using frozen_t = cslibs_ndt_2d::frozen_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_2d::Transform2d sensor(10.0, 7.0, 0.0);
+    const cslibs_math_2d::Transform2d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(20000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_2d::Transform2d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const frozen_t frozen(map, ivm);
+    testGradient<cslibs_ndt::matching::nlopt::Function<frozen_t, cslibs_math_2d::Point2d>>(frozen, &ivm);
+}
+
+TEST(Test_cslibs_ndt_2d, testNLoptGradientSoAGridmap)
+{
+    using map_t = cslibs_ndt_2d::dynamic_maps::Gridmap<double>;
+    using soa_t = cslibs_ndt_2d::static_maps::soa::Gridmap<double>;
+    using to_soa_t = cslibs_ndt::conversion::convert<
+        cslibs_ndt::map::tags::static_map, cslibs_ndt::map::tags::dynamic_map, 2, cslibs_ndt::Distribution, double,
+        cslibs_ndt::backend::SoA>;
+
+    const cloud_t room = generateRoom(20000);
+    map_t::Ptr map(new map_t(cslibs_math_2d::Transform2d(), 1.0));
+    map->insert(room.begin(), room.end());
+    const soa_t::Ptr soa = to_soa_t::from(map);
+    ASSERT_NE(soa, nullptr);
+
+    testGradient<cslibs_ndt::matching::nlopt::Function<soa_t, cslibs_math_2d::Point2d>>(*soa);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
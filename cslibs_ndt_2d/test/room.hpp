@@ -0,0 +1,36 @@
+#ifndef CSLIBS_NDT_2D_TEST_ROOM_HPP
+#define CSLIBS_NDT_2D_TEST_ROOM_HPP
+
+#include <cslibs_math_2d/linear/point.hpp>
+#include <cslibs_math/random/random.hpp>
+
+#include <array>
+#include <vector>
+
+/**
+ * @brief Points on the walls of a 20m x 14m room with an L-shaped block in it,
+ *        optionally with a pillar which breaks the symmetry of the room.
+ */
+inline std::vector<cslibs_math_2d::Point2d> generateRoom(const std::size_t size,
+                                                         const bool        pillar = false)
+{
+    using rng_t = cslibs_math::random::Uniform<double,1>;
+
+    const std::array<std::array<double,4>,8> walls{{
+        {{ 0.0,  0.0, 20.0,  0.0}}, {{20.0,  0.0, 20.0, 14.0}},
+        {{20.0, 14.0,  0.0, 14.0}}, {{ 0.0, 14.0,  0.0,  0.0}},
+        {{ 5.0,  4.0,  9.0,  4.0}}, {{ 5.0,  4.0,  5.0,  8.0}},
+        {{15.0, 10.0, 16.0, 10.0}}, {{16.0, 10.0, 16.0, 11.0}}}};
+
+    rng_t rng_wall(0.0, pillar ? 8.0 : 6.0), rng_s(0.0, 1.0), rng_noise(-0.02, 0.02);
+    std::vector<cslibs_math_2d::Point2d> cloud;
+    for (std::size_t i = 0 ; i < size ; ++ i) {
+        const auto &w = walls[static_cast<std::size_t>(rng_wall.get())];
+        const double t = rng_s.get();
+        cloud.emplace_back(w[0] + t * (w[2] - w[0]) + rng_noise.get(),
+                           w[1] + t * (w[3] - w[1]) + rng_noise.get());
+    }
+    return cloud;
+}
+
+#endif // CSLIBS_NDT_2D_TEST_ROOM_HPP
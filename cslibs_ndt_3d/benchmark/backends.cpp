@@ -0,0 +1,111 @@
+#include <cslibs_ndt/map/map.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using clock_t_ = std::chrono::high_resolution_clock;
+
+template <template <typename, typename, typename...> class backend_t>
+using map_t = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,3,cslibs_ndt::Distribution,double,backend_t>;
+
+template <typename data_interface_t_, typename index_interface_t_, typename... options_ts_>
+using kdtree_t = cis::backend::kdtree::KDTree<data_interface_t_, index_interface_t_, options_ts_...>;
+
+struct Result {
+    double insert   = 0.0;
+    double sample   = 0.0;
+    double traverse = 0.0;
+    double sum      = 0.0;
+    std::size_t bundles = 0;
+};
+
+template <template <typename, typename, typename...> class backend_t>
+Result run(const cslibs_math_3d::Pointcloud3d::Ptr &cloud,
+           const std::vector<cslibs_math_3d::Point3d> &queries,
+           const std::size_t iterations)
+{
+    using m_t = map_t<backend_t>;
+    using db_t = typename m_t::distribution_bundle_t;
+    Result r;
+
+    /// step one: build the map from scratch
+    typename m_t::Ptr map;
+    const auto insert_start = clock_t_::now();
+    for (std::size_t i = 0 ; i < iterations ; ++i) {
+        map.reset(new m_t(cslibs_math_3d::Transform3d(), 0.5));
+        map->insert(cloud);
+    }
+    r.insert = std::chrono::duration<double>(clock_t_::now() - insert_start).count() / iterations;
+
+    /// step two: point queries, a mix of hits and misses
+    const auto sample_start = clock_t_::now();
+    for (std::size_t i = 0 ; i < iterations ; ++i)
+        for (const auto &q : queries)
+            r.sum += map->sampleNonNormalized(q);
+    r.sample = std::chrono::duration<double>(clock_t_::now() - sample_start).count() / iterations;
+
+    /// step three: visit all bundles
+    const auto traverse_start = clock_t_::now();
+    for (std::size_t i = 0 ; i < iterations ; ++i) {
+        r.bundles = 0;
+        map->traverse([&r](const typename m_t::index_t &, const db_t &b) {
+            r.bundles += b.at(0) ? 1ul : 0ul;
+        });
+    }
+    r.traverse = std::chrono::duration<double>(clock_t_::now() - traverse_start).count() / iterations;
+
+    return r;
+}
+
+void print(const std::string &name, const Result &r)
+{
+    std::cout << std::setw(12) << name
+              << std::setw(14) << r.insert   * 1e3
+              << std::setw(14) << r.sample   * 1e3
+              << std::setw(14) << r.traverse * 1e3
+              << std::setw(12) << r.bundles << "\n";
+}
+
+/**
+ * @brief Compare the dynamic map backends on insert, sample and traverse
+ *        of a synthetic outdoor sized cloud.
+ */
+int main(int argc, char *argv[])
+{
+    const std::size_t points     = argc > 1 ? std::stoul(argv[1]) : 200000ul;
+    const std::size_t iterations = argc > 2 ? std::stoul(argv[2]) : 5ul;
+    const double      extent     = argc > 3 ? std::stod(argv[3])  : 100.0;
+
+    cslibs_math::random::Uniform<double,1> rng_xy(-extent, extent);
+    cslibs_math::random::Uniform<double,1> rng_z(-2.0, 5.0);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t i = 0 ; i < points ; ++i)
+        cloud->insert(cslibs_math_3d::Point3d(rng_xy.get(), rng_xy.get(), rng_z.get()));
+
+    std::vector<cslibs_math_3d::Point3d> queries;
+    for (std::size_t i = 0 ; i < points ; ++i)
+        queries.emplace_back(rng_xy.get(), rng_xy.get(), rng_z.get());
+
+    const Result octree     = run<cslibs_ndt::backend::OcTree>(cloud, queries, iterations);
+    const Result block_hash = run<cslibs_ndt::backend::BlockHash>(cloud, queries, iterations);
+    const Result kdtree     = run<kdtree_t>(cloud, queries, iterations);
+
+    std::cout << std::setw(12) << "backend"
+              << std::setw(14) << "insert [ms]"
+              << std::setw(14) << "sample [ms]"
+              << std::setw(14) << "traverse [ms]"
+              << std::setw(12) << "bundles" << "\n";
+    print("octree",     octree);
+    print("block hash", block_hash);
+    print("kdtree",     kdtree);
+
+    const bool equal = octree.bundles == block_hash.bundles && octree.bundles == kdtree.bundles &&
+                       octree.sum == block_hash.sum && octree.sum == kdtree.sum;
+    std::cout << "results equal : " << (equal ? "yes" : "no") << std::endl;
+
+    return equal ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/gridmap_cost_functor.hpp>
+#include <cslibs_ndt/matching/ceres/problem.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <ceres/ceres.h>
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include "../test/room.hpp"
+
+namespace nc = cslibs_ndt::matching::ceres;
+
+using map_t    = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+using clock_t_ = std::chrono::high_resolution_clock;
+using rng_t    = cslibs_math::random::Uniform<double,1>;
+using cloud_t  = std::vector<cslibs_math_3d::Point3d>;
+
+struct Result {
+    double evaluate   = 0.0;    // [s] per Problem::Evaluate with gradient and Jacobian
+    double solve      = 0.0;    // [s] per Solve
+    double iterations = 0.0;
+};
+
+/**
+ * @brief Problem3dQuaternionChunked from initial, chunk_size 0 builds the single block Problem3dQuaternion.
+ */
+Result run(const map_t &map, const cloud_t &scan, const cslibs_math_3d::Transform3d &initial,
+           const nc::Differentiation differentiation, const std::size_t chunk_size,
+           const int num_threads, const std::size_t trials)
+{
+    Result r;
+    for (std::size_t i = 0 ; i < trials ; ++i) {
+        const auto &q0 = initial.rotation();
+        double translation[3] = {initial.tx(), initial.ty(), initial.tz()};
+        double rotation[4]    = {q0.w(), q0.x(), q0.y(), q0.z()};
+
+        ::ceres::Problem problem;
+        if (chunk_size == 0ul)
+            nc::Problem3dQuaternion<map_t>(0.0, 0.0, 1.0, initial.translation(), initial.rotation(),
+                                           translation, rotation, problem, false, differentiation, scan, map);
+        else
+            nc::Problem3dQuaternionChunked<map_t>(0.0, 0.0, 1.0, initial.translation(), initial.rotation(),
+                                                  translation, rotation, problem, false, differentiation,
+                                                  chunk_size, scan, map);
+
+        double cost = 0.0;
+        std::vector<double> gradient;
+        ::ceres::CRSMatrix jacobian;
+        ::ceres::Problem::EvaluateOptions evaluate_options;
+        evaluate_options.num_threads = num_threads;
+        auto start = clock_t_::now();
+        problem.Evaluate(evaluate_options, &cost, nullptr, &gradient, &jacobian);
+        r.evaluate += std::chrono::duration<double>(clock_t_::now() - start).count();
+
+        ::ceres::Solver::Options options;
+        options.linear_solver_type = ::ceres::DENSE_QR;
+        options.max_num_iterations = 100;
+        options.num_threads        = num_threads;
+        ::ceres::Solver::Summary summary;
+        start = clock_t_::now();
+        ::ceres::Solve(options, &problem, &summary);
+        r.solve      += std::chrono::duration<double>(clock_t_::now() - start).count();
+        r.iterations += static_cast<double>(summary.iterations.size());
+    }
+
+    const double n = static_cast<double>(trials);
+    r.evaluate   /= n;
+    r.solve      /= n;
+    r.iterations /= n;
+    return r;
+}
+
+void print(const std::string &name, const int num_threads, const Result &r, const Result &base)
+{
+    std::cout << std::setw(20) << name
+              << std::setw(9)  << num_threads
+              << std::setw(16) << r.evaluate * 1e3
+              << std::setw(12) << r.solve * 1e3
+              << std::setw(12) << r.iterations
+              << std::setw(12) << base.solve / r.solve << "\n";
+}
+
+/**
+ * @brief Thread scaling of the chunked scan match problem. Problem::Evaluate and a full Solve of
+ *        Problem3dQuaternionChunked with 1, 2, 4 and 8 threads, against the single residual
+ *        block of Problem3dQuaternion, for autodiff and analytic Jacobians. The speedup is
+ *        relative to the single block solve. The map is settled before, as required for
+ *        concurrent evaluations.
+ */
+int main(int argc, char *argv[])
+{
+    const std::size_t trials     = argc > 1 ? std::stoul(argv[1]) : 10ul;
+    const std::size_t scan_size  = argc > 2 ? std::stoul(argv[2]) : 20000ul;
+    const std::size_t chunk_size = argc > 3 ? std::stoul(argv[3]) : 256ul;
+
+    const cloud_t room = generateRoom(200000);
+    map_t map(cslibs_math_3d::Transform3d(), 0.5);
+    map.insert(room.begin(), room.end());
+    cslibs_ndt::map::settle(map);
+
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+    const cslibs_math_3d::Transform3d initial   = truth * cslibs_math_3d::Transform3d(0.1, -0.1, 0.05, 0.01, 0.02, -0.05);
+    cloud_t scan;
+    for (const auto &p : generateRoom(scan_size))
+        scan.emplace_back(truth_inv * p);
+
+    std::cout << "scan points     : " << scan_size  << "\n"
+              << "chunk size      : " << chunk_size << "\n";
+    std::cout << std::setw(20) << "problem"
+              << std::setw(9)  << "threads"
+              << std::setw(16) << "evaluate [ms]"
+              << std::setw(12) << "solve [ms]"
+              << std::setw(12) << "iterations"
+              << std::setw(12) << "speedup" << "\n";
+
+    for (const auto &d : {std::make_pair(std::string("autodiff"), nc::Differentiation::AUTOMATIC),
+                          std::make_pair(std::string("analytic"), nc::Differentiation::ANALYTIC)}) {
+        const Result single = run(map, scan, initial, d.second, 0ul, 1, trials);
+        print(d.first + " single", 1, single, single);
+        for (const int num_threads : {1, 2, 4, 8})
+            print(d.first + " chunked", num_threads,
+                  run(map, scan, initial, d.second, chunk_size, num_threads, trials), single);
+    }
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/gridmap_cost_functor.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/occupancy_gridmap_cost_functor.hpp>
+#include <cslibs_ndt/matching/ceres/problem.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <chrono>
+#include <memory>
+#include <iostream>
+#include <iomanip>
+
+#include "../test/room.hpp"
+
+namespace nc = cslibs_ndt::matching::ceres;
+
+using clock_t_ = std::chrono::high_resolution_clock;
+using rng_t    = cslibs_math::random::Uniform<double,1>;
+using ivm_t    = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t  = std::vector<cslibs_math_3d::Point3d>;
+
+/**
+ * @brief Mean time [s] of one Evaluate with both Jacobians, at poses jittered around the
+ *        given parameter blocks, so that points move between bundles like during a solve.
+ */
+template <std::size_t R>
+double run(::ceres::CostFunction *cost_ptr,
+           const std::array<double,3> &translation, const std::array<double,R> &rotation,
+           const std::size_t iterations)
+{
+    const std::unique_ptr<::ceres::CostFunction> cost(cost_ptr);
+    const std::size_t n = static_cast<std::size_t>(cost->num_residuals());
+    std::vector<double> residuals(n), jacobian_t(n * 3), jacobian_r(n * R);
+    double *jacobians[2] = {jacobian_t.data(), jacobian_r.data()};
+
+    rng_t rng(-0.02, 0.02);
+    double duration = 0.0;
+    for (std::size_t i = 0 ; i < iterations ; ++i) {
+        std::array<double,3> t = translation;
+        for (double &v : t)
+            v += rng.get();
+        const double *parameters[2] = {t.data(), rotation.data()};
+
+        const auto start = clock_t_::now();
+        cost->Evaluate(parameters, residuals.data(), jacobians);
+        duration += std::chrono::duration<double>(clock_t_::now() - start).count();
+    }
+    return duration / static_cast<double>(iterations);
+}
+
+void print(const std::string &name, const double autodiff, const double analytic, const std::size_t points)
+{
+    std::cout << std::setw(24) << name
+              << std::setw(16) << autodiff * 1e3
+              << std::setw(16) << analytic * 1e3
+              << std::setw(16) << autodiff / static_cast<double>(points) * 1e9
+              << std::setw(16) << analytic / static_cast<double>(points) * 1e9
+              << std::setw(10) << autodiff / analytic << "\n";
+}
+
+template <typename map_t, typename... args_t>
+void benchmark(const std::string &name, const map_t &map, const cloud_t &scan,
+               const std::size_t iterations, const args_t&... args)
+{
+    const cslibs_math_3d::Transform3d pose(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const auto &q = pose.rotation();
+    const std::array<double,3> translation{{pose.tx(), pose.ty(), pose.tz()}};
+
+    const std::array<double,4> wxyz{{q.w(), q.x(), q.y(), q.z()}};
+    const double quaternion_autodiff = run<4>(
+                nc::ScanMatchCostFunctor3dQuaternionCreator<map_t, nc::Flag::DIRECT>::CreateAutoDiffCostFunction(1.0, scan, map, args...),
+                translation, wxyz, iterations);
+    const double quaternion_analytic = run<4>(
+                nc::ScanMatchCostFunction3dQuaternionCreator<map_t>::Create(1.0, scan, map, args...),
+                translation, wxyz, iterations);
+    print(name + " quaternion", quaternion_autodiff, quaternion_analytic, scan.size());
+
+    const std::array<double,3> rpy{{q.roll(), q.pitch(), q.yaw()}};
+    const double rpy_autodiff = run<3>(
+                nc::ScanMatchCostFunctor3dRPYCreator<map_t, nc::Flag::DIRECT>::CreateAutoDiffCostFunction(1.0, scan, map, args...),
+                translation, rpy, iterations);
+    const double rpy_analytic = run<3>(
+                nc::ScanMatchCostFunction3dRPYCreator<map_t>::Create(1.0, scan, map, args...),
+                translation, rpy, iterations);
+    print(name + " rpy", rpy_autodiff, rpy_analytic, scan.size());
+}
+
+/**
+ * @brief Cost of one Evaluate of the scan match residual block with both Jacobians,
+ *        autodiff ScanMatchCostFunctor against the analytic ScanMatchCostFunction,
+ *        for both rotation parametrizations. The maps are settled before, so lazily
+ *        computed information matrices do not count.
+ */
+int main(int argc, char *argv[])
+{
+    const std::size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200ul;
+    const std::size_t scan_size  = argc > 2 ? std::stoul(argv[2]) : 5000ul;
+
+    const cloud_t room = generateRoom(200000);
+
+    cslibs_ndt_3d::dynamic_maps::Gridmap<double> gridmap(cslibs_math_3d::Transform3d(), 0.5);
+    gridmap.insert(room.begin(), room.end());
+    cslibs_ndt::map::settle(gridmap);
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : room)
+        points.emplace_back(sensor_inv * p);
+    cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double> occupancy_gridmap(cslibs_math_3d::Transform3d(), 0.5);
+    occupancy_gridmap.insert(points.begin(), points.end(), sensor);
+    cslibs_ndt::map::settle(occupancy_gridmap);
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+
+    // the scan in the frame of the pose the cost functions are evaluated at
+    const cslibs_math_3d::Transform3d pose_inv = cslibs_math_3d::Transform3d(0.3, -0.2, 0.1, 0.02, -0.03, 0.1).inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(scan_size))
+        scan.emplace_back(pose_inv * p);
+
+    std::cout << "scan points     : " << scan_size  << "\n"
+              << "iterations      : " << iterations << "\n";
+    std::cout << std::setw(24) << "map"
+              << std::setw(16) << "autodiff [ms]"
+              << std::setw(16) << "analytic [ms]"
+              << std::setw(16) << "autodiff [ns/p]"
+              << std::setw(16) << "analytic [ns/p]"
+              << std::setw(10) << "speedup" << "\n";
+    benchmark("gridmap",   gridmap,           scan, iterations);
+    benchmark("occupancy", occupancy_gridmap, scan, iterations, ivm);
+
+    return 0;
+}
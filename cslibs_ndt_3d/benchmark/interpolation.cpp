@@ -0,0 +1,154 @@
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt/matching/ceres/problem.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/gridmap_cost_functor.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <ceres/ceres.h>
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+namespace nc = cslibs_ndt::matching::ceres;
+
+using map_t    = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+using cache_t  = cslibs_ndt::matching::LatticeCache<map_t>;
+using points_t = std::vector<cslibs_math_3d::Point3d>;
+using rng_t    = cslibs_math::random::Uniform<double,1>;
+using clock_t_ = std::chrono::high_resolution_clock;
+
+struct Result {
+    double iterations  = 0.0;
+    double time        = 0.0;
+    double translation = 0.0;
+    double rotation    = 0.0;
+};
+
+/**
+ * @brief Synthetic room with a floor, four walls and a few boxes.
+ */
+cslibs_math_3d::Pointcloud3d::Ptr generateRoom(const std::size_t points)
+{
+    rng_t rng_u(-5.0, 5.0);
+    rng_t rng_h( 0.0, 3.0);
+    rng_t rng_b( 0.0, 1.0);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t i = 0 ; i < points ; ++ i) {
+        switch (i % 7) {
+        case 0: cloud->insert(cslibs_math_3d::Point3d(rng_u.get(), rng_u.get(), 0.0));        break;
+        case 1: cloud->insert(cslibs_math_3d::Point3d(-5.0, rng_u.get(), rng_h.get()));       break;
+        case 2: cloud->insert(cslibs_math_3d::Point3d( 5.0, rng_u.get(), rng_h.get()));       break;
+        case 3: cloud->insert(cslibs_math_3d::Point3d(rng_u.get(), -5.0, rng_h.get()));       break;
+        case 4: cloud->insert(cslibs_math_3d::Point3d(rng_u.get(),  5.0, rng_h.get()));       break;
+        case 5: cloud->insert(cslibs_math_3d::Point3d(1.0 + rng_b.get(), -2.0, rng_b.get())); break;
+        default: cloud->insert(cslibs_math_3d::Point3d(-2.0, 1.0 + rng_b.get(), rng_b.get())); break;
+        }
+    }
+    return cloud;
+}
+
+template <nc::Flag flag_t, typename ... args_t>
+void match(const cslibs_math_3d::Transform3d &truth,
+           const cslibs_math_3d::Transform3d &initial,
+           const map_t &map,
+           const points_t &scan,
+           Result &r,
+           const args_t &...args)
+{
+    const auto &q0 = initial.rotation();
+    double translation[3] = {initial.tx(), initial.ty(), initial.tz()};
+    double rotation[4]    = {q0.w(), q0.x(), q0.y(), q0.z()};
+
+    ::ceres::Problem problem;
+    nc::Problem3dQuaternion<map_t, flag_t>(0.0, 0.0, 1.0,
+                                           initial.translation(), initial.rotation(),
+                                           translation, rotation,
+                                           problem, false, nc::Differentiation::AUTOMATIC,
+                                           scan, map, args...);
+
+    ::ceres::Solver::Options options;
+    options.linear_solver_type = ::ceres::DENSE_QR;
+    options.max_num_iterations = 100;
+    ::ceres::Solver::Summary summary;
+
+    const auto start = clock_t_::now();
+    ::ceres::Solve(options, &problem, &summary);
+    r.time       += std::chrono::duration<double>(clock_t_::now() - start).count();
+    r.iterations += static_cast<double>(summary.iterations.size());
+
+    const auto &t = truth.translation();
+    const auto &q = truth.rotation();
+    const Eigen::Quaterniond estimate(rotation[0], rotation[1], rotation[2], rotation[3]);
+    r.translation += (Eigen::Vector3d(translation[0], translation[1], translation[2]) -
+                      Eigen::Vector3d(t(0), t(1), t(2))).norm();
+    r.rotation    += estimate.normalized().angularDistance(Eigen::Quaterniond(q.w(), q.x(), q.y(), q.z()));
+}
+
+void print(const std::string &name, const Result &r, const double trials)
+{
+    std::cout << std::setw(16) << name
+              << std::setw(12) << r.iterations / trials
+              << std::setw(12) << r.time / trials * 1e3
+              << std::setw(16) << r.translation / trials
+              << std::setw(14) << r.rotation / trials << "\n";
+}
+
+/**
+ * @brief Compare Flag::DIRECT and the tricubic Flag::INTERPOLATION on iterations to convergence,
+ *        solver time and final error of Problem3dQuaternion, matching scans of a synthetic room
+ *        from perturbed initial guesses. The lattice cache is shared by all trials, its
+ *        sampling time is reported separately as the first, cold trial.
+ */
+int main(int argc, char *argv[])
+{
+    const std::size_t trials              = argc > 1 ? std::stoul(argv[1]) : 20ul;
+    const std::size_t scan_size           = argc > 2 ? std::stoul(argv[2]) : 2000ul;
+    const double      sampling_resolution = argc > 3 ? std::stod(argv[3])  : 0.1;
+
+    const cslibs_math_3d::Pointcloud3d::Ptr room = generateRoom(200000);
+    map_t map(cslibs_math_3d::Transform3d(), 0.5);
+    map.insert(room);
+
+    const cache_t::Ptr cache(new cache_t(map, sampling_resolution));
+
+    rng_t rng_trans(-0.3, 0.3);
+    rng_t rng_r(-0.1, 0.1);
+    rng_t rng_p(0.0, 1.0);
+
+    Result direct, interpolation, cold;
+    for (std::size_t i = 0 ; i < trials ; ++ i) {
+        const cslibs_math_3d::Transform3d truth(rng_trans.get(), rng_trans.get(), 0.5 + rng_trans.get(),
+                                                rng_r.get(), rng_r.get(), 4.0 * rng_r.get());
+        const cslibs_math_3d::Transform3d offset(rng_trans.get(), rng_trans.get(), rng_trans.get(),
+                                                 rng_r.get(), rng_r.get(), rng_r.get());
+        const cslibs_math_3d::Transform3d initial = truth * offset;
+
+        /// the scan is a random subset of the room in the sensor frame
+        const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+        points_t scan;
+        const double ratio = static_cast<double>(scan_size) / static_cast<double>(room->size());
+        for (const auto &p : *room) {
+            if (rng_p.get() < ratio)
+                scan.emplace_back(truth_inv * p);
+        }
+
+        match<nc::Flag::DIRECT>(truth, initial, map, scan, direct);
+        match<nc::Flag::INTERPOLATION>(truth, initial, map, scan, i == 0 ? cold : interpolation, cache);
+    }
+
+    const double n = static_cast<double>(trials);
+    std::cout << "scan points     : " << scan_size  << "\n"
+              << "lattice tiles   : " << cache->size() << "\n";
+    std::cout << std::setw(16) << "flag"
+              << std::setw(12) << "iterations"
+              << std::setw(12) << "time [ms]"
+              << std::setw(16) << "error [m]"
+              << std::setw(14) << "error [rad]" << "\n";
+    print("direct",        direct, n);
+    print("interpolation", interpolation, std::max(1.0, n - 1.0));
+    print("(cold cache)",  cold, 1.0);
+
+    return 0;
+}
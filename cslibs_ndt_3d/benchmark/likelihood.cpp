@@ -0,0 +1,144 @@
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/map/likelihood.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+using clock_t_ = std::chrono::high_resolution_clock;
+using rng_t    = cslibs_math::random::Uniform<double,1>;
+using ivm_t    = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t  = std::vector<cslibs_math_3d::Point3d>;
+using poses_t  = std::vector<cslibs_math_3d::Transform3d>;
+
+struct Result {
+    double      duration = 0.0;     // [s] per evaluation of all particles
+    double      best     = 0.0;
+    std::size_t argmax   = 0;
+};
+
+template <typename fn_t>
+Result run(const fn_t &fn, const std::size_t iterations)
+{
+    Result r;
+    std::vector<double> l;
+    const auto start = clock_t_::now();
+    for (std::size_t i = 0 ; i < iterations ; ++i)
+        l = fn();
+    r.duration = std::chrono::duration<double>(clock_t_::now() - start).count() / iterations;
+    r.argmax   = static_cast<std::size_t>(std::max_element(l.begin(), l.end()) - l.begin());
+    r.best     = l[r.argmax];
+    return r;
+}
+
+void print(const std::string &name, const Result &r, const std::size_t particles)
+{
+    std::cout << std::setw(24) << name
+              << std::setw(14) << r.duration * 1e3
+              << std::setw(16) << static_cast<std::size_t>(particles / r.duration)
+              << std::setw(16) << r.best
+              << std::setw(8)  << r.argmax << "\n";
+}
+
+/**
+ * @brief Points on the floor and the walls of a 40m x 30m x 3m hall.
+ */
+cloud_t generateHall(const std::size_t size)
+{
+    rng_t rng_x(0.0, 40.0), rng_y(0.0, 30.0), rng_z(0.0, 3.0), rng_noise(-0.02, 0.02);
+    rng_t rng_surface(0.0, 5.0);
+
+    cloud_t cloud;
+    for (std::size_t i = 0 ; i < size ; ++ i) {
+        const int surface = static_cast<int>(rng_surface.get());
+        cslibs_math_3d::Point3d p;
+        switch (surface) {
+        case 0:  p = cslibs_math_3d::Point3d(rng_x.get(), rng_y.get(), 0.0);  break;
+        case 1:  p = cslibs_math_3d::Point3d(0.0,  rng_y.get(), rng_z.get()); break;
+        case 2:  p = cslibs_math_3d::Point3d(40.0, rng_y.get(), rng_z.get()); break;
+        case 3:  p = cslibs_math_3d::Point3d(rng_x.get(), 0.0, rng_z.get());  break;
+        default: p = cslibs_math_3d::Point3d(rng_x.get(), 30.0, rng_z.get()); break;
+        }
+        cloud.emplace_back(p(0) + rng_noise.get(), p(1) + rng_noise.get(), p(2) + rng_noise.get());
+    }
+    return cloud;
+}
+
+template <typename map_t, typename ... args_t>
+void compare(const std::string &name, const map_t &map, const cloud_t &scan, const poses_t &particles,
+             const std::size_t iterations, const std::size_t threads, const args_t &...args)
+{
+    const cslibs_ndt::map::LikelihoodModel model;
+    cslibs_ndt::map::settle(map);
+
+    /// step one: what a filter does today, every particle on its own
+    const Result naive = run([&]() {
+        std::vector<double> l(particles.size(), 0.0);
+        for (std::size_t i = 0 ; i < particles.size() ; ++i)
+            for (const auto &p : scan)
+                l[i] += std::log(model.hit * map.sampleNonNormalized(particles[i] * p, args...) + model.random);
+        return l;
+    }, iterations);
+
+    /// step two: batched, sorted by bundle
+    const Result single = run([&]() {
+        return cslibs_ndt::map::logLikelihoods(map, scan, particles, model, 1ul, args...);
+    }, iterations);
+    const Result multi = run([&]() {
+        return cslibs_ndt::map::logLikelihoods(map, scan, particles, model, threads, args...);
+    }, iterations);
+
+    std::cout << name << "\n"
+              << std::setw(24) << "method"
+              << std::setw(14) << "time [ms]"
+              << std::setw(16) << "particles/s"
+              << std::setw(16) << "best"
+              << std::setw(8)  << "argmax" << "\n";
+    print("per particle",   naive,  particles.size());
+    print("batched 1 thread", single, particles.size());
+    print("batched " + std::to_string(threads) + " threads", multi, particles.size());
+}
+
+/**
+ * @brief Particles per second of the batched likelihood against scoring every particle
+ *        on its own, on a distribution and an occupancy map of a synthetic hall.
+ */
+int main(int argc, char *argv[])
+{
+    const std::size_t num_particles = argc > 1 ? std::stoul(argv[1]) : 1000ul;
+    const std::size_t num_points    = argc > 2 ? std::stoul(argv[2]) : 500ul;
+    const std::size_t iterations    = argc > 3 ? std::stoul(argv[3]) : 5ul;
+    const std::size_t threads       = argc > 4 ? std::stoul(argv[4]) : cslibs_ndt::utility::num_threads();
+
+    const cslibs_math_3d::Transform3d truth(20.0, 15.0, 1.0, 0.0, 0.0, 0.3);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+
+    const cloud_t hall = generateHall(400000);
+    cloud_t scan;
+    for (const auto &p : generateHall(num_points))
+        scan.emplace_back(truth_inv * p);
+
+    rng_t rng_trans(-1.0, 1.0), rng_yaw(-0.2, 0.2);
+    poses_t particles{truth};
+    while (particles.size() < num_particles)
+        particles.emplace_back(truth * cslibs_math_3d::Transform3d(rng_trans.get(), rng_trans.get(), 0.0,
+                                                                   0.0, 0.0, rng_yaw.get()));
+
+    cslibs_ndt_3d::dynamic_maps::Gridmap<double> gridmap(cslibs_math_3d::Transform3d(), 1.0);
+    gridmap.insert(hall.begin(), hall.end());
+    compare("gridmap", gridmap, scan, particles, iterations, threads);
+
+    cloud_t hall_sensor;
+    for (const auto &p : hall)
+        hall_sensor.emplace_back(truth_inv * p);
+    cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double> occupancy_gridmap(cslibs_math_3d::Transform3d(), 1.0);
+    occupancy_gridmap.insert(hall_sensor.begin(), hall_sensor.end(), truth);
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    compare("occupancy gridmap", occupancy_gridmap, scan, particles, iterations, threads, ivm);
+
+    return 0;
+}
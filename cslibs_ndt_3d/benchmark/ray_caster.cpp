@@ -0,0 +1,117 @@
+#include <cslibs_ndt/map/batch_ray_caster.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <chrono>
+#include <iostream>
+
+using map_t        = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+using point_t      = cslibs_ndt::map::traits<3,double>::point_t;
+using index_t      = std::array<int,3>;
+using iterator_t   = cslibs_ndt::map::traits<3,double>::default_iterator_t;
+using ray_caster_t = cslibs_ndt::map::BatchRayCaster<3,double,iterator_t>;
+using clock_t_     = std::chrono::high_resolution_clock;
+
+/**
+ * @brief Compare OccupancyGridmap::insert with and without the batched free space
+ *        traversal on a synthetic lidar scan, and the free space counting of both
+ *        on its own. Both walk every ray completely, the batched path counts the
+ *        cells around the sensor densely and runs the rays in parallel.
+ */
+int main(int argc, char *argv[])
+{
+    const std::size_t rings      = argc > 1 ? std::stoul(argv[1]) : 64ul;
+    const std::size_t beams      = argc > 2 ? std::stoul(argv[2]) : 1024ul;
+    const std::size_t iterations = argc > 3 ? std::stoul(argv[3]) : 10ul;
+    const double      resolution = 0.5;
+
+    cslibs_math::random::Uniform<double,1> rng_range(2.0, 50.0);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t r = 0 ; r < rings ; ++ r) {
+        const double elevation = -0.4 + 0.8 * static_cast<double>(r) / static_cast<double>(rings);
+        for (std::size_t b = 0 ; b < beams ; ++ b) {
+            const double azimuth = -M_PI + 2.0 * M_PI * static_cast<double>(b) / static_cast<double>(beams);
+            const double range   = rng_range.get();
+            cloud->insert(cslibs_math_3d::Point3d(range * std::cos(elevation) * std::cos(azimuth),
+                                                  range * std::cos(elevation) * std::sin(azimuth),
+                                                  range * std::sin(elevation)));
+        }
+    }
+    const cslibs_math_3d::Transform3d origin;
+
+    /// step one: whole insertion, serial and batched into fresh maps
+    auto time_insert = [&cloud, &origin, resolution, iterations](const cslibs_ndt::map::tags::insert_option option,
+                                                                 map_t::Ptr &map) {
+        double time = 0.0;
+        for (std::size_t i = 0 ; i < iterations ; ++ i) {
+            map.reset(new map_t(origin, resolution));
+            const auto start = clock_t_::now();
+            map->insert(cloud, origin, option);
+            time += std::chrono::duration<double>(clock_t_::now() - start).count();
+        }
+        return time;
+    };
+    map_t::Ptr serial, batched;
+    const double serial_time  = time_insert(cslibs_ndt::map::tags::serial_insert,   serial);
+    const double batched_time = time_insert(cslibs_ndt::map::tags::parallel_insert, batched);
+
+    /// step two: free space counting only, one line iterator per ray into a hash map vs. the caster
+    const double bundle_resolution = serial->getBundleResolution();
+    const point_t start(0.0, 0.0, 0.0);
+    auto valid = [](const index_t &) { return true; };
+
+    std::unordered_map<index_t, std::size_t> naive;
+    const auto naive_start = clock_t_::now();
+    for (std::size_t i = 0 ; i < iterations ; ++ i) {
+        naive.clear();
+        for (const auto &end : *cloud) {
+            iterator_t it(start, end, bundle_resolution);
+            while (!it.done()) {
+                const index_t &bi = it();
+                if (valid(bi))
+                    naive[bi] += 1ul;
+                ++it;
+            }
+        }
+    }
+    const double naive_time = std::chrono::duration<double>(clock_t_::now() - naive_start).count();
+
+    ray_caster_t::free_updates_t batch;
+    ray_caster_t caster(bundle_resolution);
+    const auto batch_start = clock_t_::now();
+    for (std::size_t i = 0 ; i < iterations ; ++ i) {
+        caster.clear();
+        for (const auto &end : *cloud)
+            caster.add(end);
+        caster.cast(start, valid, batch);
+    }
+    const double batch_time = std::chrono::duration<double>(clock_t_::now() - batch_start).count();
+
+    /// step three: both have to produce the same free counts and maps
+    bool equal = naive.size() == batch.size();
+    for (const auto &u : batch) {
+        const auto it = naive.find(u.first);
+        equal &= it != naive.end() && it->second == u.second;
+    }
+    serial->traverse([&batched, &equal](const index_t &bi, const map_t::distribution_bundle_t &b) {
+        const map_t::distribution_bundle_t *bb = batched->get(bi);
+        equal &= bb != nullptr;
+        for (std::size_t i = 0 ; bb && i < map_t::bin_count ; ++ i)
+            equal &= b.at(i)->numFree() == bb->at(i)->numFree() && b.at(i)->numOccupied() == bb->at(i)->numOccupied();
+    });
+
+    const double num_rays = static_cast<double>(cloud->size() * iterations);
+    std::cout << "rays per scan          : " << cloud->size()          << "\n"
+              << "threads                : " << cslibs_ndt::utility::num_threads() << "\n"
+              << "insert serial   [1/s]  : " << num_rays / serial_time  << "\n"
+              << "insert batched  [1/s]  : " << num_rays / batched_time << "\n"
+              << "insert speedup         : " << serial_time / batched_time << "\n"
+              << "counting per ray [1/s] : " << num_rays / naive_time << "\n"
+              << "counting batched [1/s] : " << num_rays / batch_time << "\n"
+              << "counting speedup       : " << naive_time / batch_time << "\n"
+              << "results equal          : " << (equal ? "yes" : "no") << std::endl;
+
+    return equal ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+#ifndef CSLIBS_NDT_3D_FROZEN_MAPS_OCCUPANCY_GRIDMAP_HPP
+#define CSLIBS_NDT_3D_FROZEN_MAPS_OCCUPANCY_GRIDMAP_HPP
+
+#include <cslibs_ndt/map/map.hpp>
+
+namespace cslibs_ndt_3d {
+namespace frozen_maps {
+
+template <typename T, cslibs_ndt::map::tags::option option_t = cslibs_ndt::map::tags::dynamic_map>
+using OccupancyGridmap = cslibs_ndt::map::FrozenMap<option_t,3,cslibs_ndt::OccupancyDistribution,T>;
+
+}
+}
+
+#endif // CSLIBS_NDT_3D_FROZEN_MAPS_OCCUPANCY_GRIDMAP_HPP
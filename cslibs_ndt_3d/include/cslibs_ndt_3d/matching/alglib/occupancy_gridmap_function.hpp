@@ -2,7 +2,12 @@
 #define CSLIBS_NDT_3D_MATCHING_ALGLIB_OCCUPANCY_GRIDMAP_FUNCTION_HPP
 
 #include <cslibs_ndt/matching/alglib/function.hpp>
+#include <cslibs_ndt/matching/gradient.hpp>
 #include <cslibs_ndt/map/map.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+#include <cslibs_ndt/utility/parallel.hpp>
+
+#include <cslibs_math/common/angle.hpp>
 
 #include <optimization.h>
 
@@ -30,61 +35,75 @@ public:
         double translation_weight_;
         double rotation_weight_;
         double map_weight_;
+
+        std::size_t num_threads_ = 0; // 0 uses all hardware threads
+        bool        settled_     = false; // the map is settled once on the first evaluation, reset after writing to it
     };
     using FunctorRPY = Functor<6>;
     using FunctorQuaternion = Functor<7>;
 
     inline static void applyRPY(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi, void *ptr)
+    {
+        evaluateRPY(x, fi, nullptr, ptr);
+    }
+
+    /**
+     * @brief Function vector and Jacobian for minlmcreatevj.
+     */
+    inline static void jacobianRPY(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi,
+                                   ::alglib::real_2d_array &jac, void *ptr)
+    {
+        evaluateRPY(x, fi, &jac, ptr);
+    }
+
+    inline static double mapScoreRPY(const ::alglib::real_1d_array &x, const ::alglib::real_1d_array &fi, void* ptr)
     {
         // check that all necessary information is given
         const auto& casted_ptr = (Functor<6>*)ptr;
         if (!casted_ptr) {
             std::cerr << "Correct Functor not given..." << std::endl;
-            return;
+            return 0;
         }
 
-        // dissolve Functor
+        // calculate scaling
         const Functor<6>& object = *casted_ptr;
-        const auto& points       = *(object.points_);
-        const auto& map          = *(object.map_);
-        const auto& ivm          = *(object.ivm_);
+        const double num_points  = object.points_->size();
+        const double scale       = /*std::sqrt(2.0*/ 1.0 / object.map_weight_;
+        const double absolute    = 1.0 / num_points;
 
-        const double& map_weight   = /*std::sqrt*/(object.map_weight_);         //*0.5;
-        const double& trans_weight = /*std::sqrt*/(object.translation_weight_); //*0.5;
-        const double& rot_weight   = /*std::sqrt*/(object.rotation_weight_);    //*0.5;
+        // extract score from fi
+        double score = 0.0;
+        for (std::size_t i=0; i<num_points; ++i)
+            score += (absolute - (fi[i] * scale));
 
-        const typename ndt_t::pose_t current_transform(x[0],x[1],x[2],x[3],x[4],x[5]); // xyz rpy
+        return score;
+    }
 
-        // evaluate function
-        std::size_t i=0;
-        const double num_points =  static_cast<double>(points.size());
-        for (const auto& p : points) {
-            const typename ndt_t::point_t q = current_transform * typename ndt_t::point_t(p(0),p(1),p(2));
-            const double score = map.sampleNonNormalized(q, ivm);
-            fi[i++] = map_weight * (std::isnormal(score) ? (1.0 - score) : 1.0) / num_points;
-        }
+    inline static void applyQuaternion(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi, void *ptr)
+    {
+        evaluateQuaternion(x, fi, nullptr, ptr);
+    }
 
-        // calculate translational and rotational function component
-        const auto& initial_guess = (object.initial_guess_);
-        fi[i++] = trans_weight * (x[0] - initial_guess[0]);
-        fi[i++] = trans_weight * (x[1] - initial_guess[1]);
-        fi[i++] = trans_weight * (x[2] - initial_guess[2]);
-        fi[i++] = rot_weight * std::fabs(cslibs_math::common::angle::difference(x[3], initial_guess[3]));
-        fi[i++] = rot_weight * std::fabs(cslibs_math::common::angle::difference(x[4], initial_guess[4]));
-        fi[i++] = rot_weight * std::fabs(cslibs_math::common::angle::difference(x[5], initial_guess[5]));
+    /**
+     * @brief Function vector and Jacobian for minlmcreatevj, the quaternion is normalized.
+     */
+    inline static void jacobianQuaternion(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi,
+                                          ::alglib::real_2d_array &jac, void *ptr)
+    {
+        evaluateQuaternion(x, fi, &jac, ptr);
     }
 
-    inline static double mapScoreRPY(const ::alglib::real_1d_array &x, const ::alglib::real_1d_array &fi, void* ptr)
+    inline static double mapScoreQuaternion(const ::alglib::real_1d_array &x, const ::alglib::real_1d_array &fi, void* ptr)
     {
         // check that all necessary information is given
-        const auto& casted_ptr = (Functor<6>*)ptr;
+        const auto& casted_ptr = (Functor<7>*)ptr;
         if (!casted_ptr) {
             std::cerr << "Correct Functor not given..." << std::endl;
             return 0;
         }
 
         // calculate scaling
-        const Functor<6>& object = *casted_ptr;
+        const Functor<7>& object = *casted_ptr;
         const double num_points  = object.points_->size();
         const double scale       = /*std::sqrt(2.0*/ 1.0 / object.map_weight_;
         const double absolute    = 1.0 / num_points;
@@ -97,7 +116,52 @@ public:
         return score;
     }
 
-    inline static void applyQuaternion(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi, void *ptr)
+private:
+    inline static void evaluateRPY(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi,
+                                   ::alglib::real_2d_array *jac, void *ptr)
+    {
+        // check that all necessary information is given
+        const auto& casted_ptr = (Functor<6>*)ptr;
+        if (!casted_ptr) {
+            std::cerr << "Correct Functor not given..." << std::endl;
+            return;
+        }
+
+        // dissolve Functor
+        const Functor<6>& object = *casted_ptr;
+        const auto& points       = *(object.points_);
+
+        const double& trans_weight = /*std::sqrt*/(object.translation_weight_); //*0.5;
+        const double& rot_weight   = /*std::sqrt*/(object.rotation_weight_);    //*0.5;
+
+        const typename ndt_t::pose_t current_transform(x[0],x[1],x[2],x[3],x[4],x[5]); // xyz rpy
+
+        // evaluate function
+        evaluateMap(*casted_ptr, x, current_transform, fi, jac);
+
+        // calculate translational and rotational function component, each depends on one parameter
+        const auto& initial_guess = (object.initial_guess_);
+        std::size_t i = points.size();
+        if (jac) {
+            for (std::size_t r = i ; r < i + 6 ; ++r)
+                for (std::size_t c = 0 ; c < 6 ; ++c)
+                    (*jac)[r][c] = 0.0;
+        }
+        for (std::size_t j = 0 ; j < 3 ; ++j, ++i) {
+            fi[i] = trans_weight * (x[j] - initial_guess[j]);
+            if (jac)
+                (*jac)[i][j] = trans_weight;
+        }
+        for (std::size_t j = 3 ; j < 6 ; ++j, ++i) {
+            const double diff = cslibs_math::common::angle::difference(x[j], initial_guess[j]);
+            fi[i] = rot_weight * std::fabs(diff);
+            if (jac)
+                (*jac)[i][j] = diff < 0.0 ? -rot_weight : rot_weight;
+        }
+    }
+
+    inline static void evaluateQuaternion(const ::alglib::real_1d_array &x, ::alglib::real_1d_array &fi,
+                                          ::alglib::real_2d_array *jac, void *ptr)
     {
         // check that all necessary information is given
         const auto& casted_ptr = (Functor<7>*)ptr;
@@ -109,64 +173,121 @@ public:
         // dissolve Functor
         const Functor<7>& object = *casted_ptr;
         const auto& points       = *(object.points_);
-        const auto& map          = *(object.map_);
-        const auto& ivm          = *(object.ivm_);
 
-        const double& map_weight   = /*std::sqrt*/(object.map_weight_);         //*0.5;
         const double& trans_weight = /*std::sqrt*/(object.translation_weight_); //*0.5;
         const double& rot_weight   = /*std::sqrt*/(object.rotation_weight_);    //*0.5;
 
+        const Eigen::Vector4d q_raw(x[3],x[4],x[5],x[6]);
+        const double          q_norm = q_raw.norm();
+        const Eigen::Vector4d q = q_raw / q_norm;
         const typename ndt_t::pose_t current_transform(
-                    cslibs_math_3d::Vector3<_T>(x[0],x[1],x[2]),          // xyz
-                    cslibs_math_3d::Quaternion<_T>(x[3],x[4],x[5],x[6])); // xyzw
+                    cslibs_math_3d::Vector3<_T>(x[0],x[1],x[2]),                  // xyz
+                    cslibs_math_3d::Quaternion<_T>(q(0),q(1),q(2),q(3)));         // xyzw
 
         // evaluate function
-        std::size_t i=0;
-        const double num_points =  static_cast<double>(points.size());
-        for (const auto& p : points) {
-            const typename ndt_t::point_t q = current_transform * typename ndt_t::point_t(p(0),p(1),p(2));
-            const double score = map.sampleNonNormalized(q, ivm);
-            fi[i++] = map_weight * (std::isnormal(score) ? (1.0 - score) : 1.0) / num_points;
-        }
+        evaluateMap(*casted_ptr, x, current_transform, fi, jac);
 
         // calculate translational and rotational function component
         const auto& initial_guess = (object.initial_guess_);
-        fi[i++] = trans_weight * (x[0] - initial_guess[0]);
-        fi[i++] = trans_weight * (x[1] - initial_guess[1]);
-        fi[i++] = trans_weight * (x[2] - initial_guess[2]);
+        std::size_t i = points.size();
+        if (jac) {
+            for (std::size_t r = i ; r < i + 7 ; ++r)
+                for (std::size_t c = 0 ; c < 7 ; ++c)
+                    (*jac)[r][c] = 0.0;
+        }
+        for (std::size_t j = 0 ; j < 3 ; ++j, ++i) {
+            fi[i] = trans_weight * (x[j] - initial_guess[j]);
+            if (jac)
+                (*jac)[i][j] = trans_weight;
+        }
 
         const auto& rot = current_transform.rotation();
         const cslibs_math_3d::Quaternion<_T> initial_rot_inverse(
                     -initial_guess[3], -initial_guess[4], -initial_guess[5], initial_guess[6]);
         const auto& rot_diff = initial_rot_inverse * rot;
-        fi[i++] = rot_weight * std::fabs(rot_diff.w());
-        fi[i++] = rot_weight * std::fabs(rot_diff.x());
-        fi[i++] = rot_weight * std::fabs(rot_diff.y());
-        fi[i++] = rot_weight * std::fabs(rot_diff.z());
+        const std::array<double,4> diff{{rot_diff.w(), rot_diff.x(), rot_diff.y(), rot_diff.z()}};
+        for (std::size_t j = 0 ; j < 4 ; ++j)
+            fi[i + j] = rot_weight * std::fabs(diff[j]);
+        if (jac) {
+            // rot_diff = a * q is linear in q (x y z w), then through d(q/|q|)/dq
+            const double ax = -initial_guess[3], ay = -initial_guess[4], az = -initial_guess[5], aw = initial_guess[6];
+            Eigen::Matrix4d product; // rows w x y z
+            product << -ax, -ay, -az,  aw,
+                        aw, -az,  ay,  ax,
+                        az,  aw, -ax,  ay,
+                       -ay,  ax,  aw,  az;
+            const Eigen::Matrix4d d = product * (Eigen::Matrix4d::Identity() - q * q.transpose()) / q_norm;
+            for (std::size_t j = 0 ; j < 4 ; ++j) {
+                const double sign = diff[j] < 0.0 ? -rot_weight : rot_weight;
+                for (std::size_t c = 0 ; c < 4 ; ++c)
+                    (*jac)[i + j][3 + c] = sign * d(j, c);
+            }
+        }
     }
 
-    inline static double mapScoreQuaternion(const ::alglib::real_1d_array &x, const ::alglib::real_1d_array &fi, void* ptr)
+    /**
+     * @brief Map components of fi and, if jac is given, their Jacobian rows.
+     *        The points are split among the threads, which sample and differentiate them independently.
+     *        With several threads the map is settled on the first evaluation, see map::settle, later
+     *        evaluations only sample. It must not be written while the functor is in use.
+     */
+    template <std::size_t n>
+    inline static void evaluateMap(Functor<n>                    &object,
+                                   const ::alglib::real_1d_array &x,
+                                   const typename ndt_t::pose_t  &current_transform,
+                                   ::alglib::real_1d_array       &fi,
+                                   ::alglib::real_2d_array       *jac)
     {
-        // check that all necessary information is given
-        const auto& casted_ptr = (Functor<7>*)ptr;
-        if (!casted_ptr) {
-            std::cerr << "Correct Functor not given..." << std::endl;
-            return 0;
+        const auto& points = *(object.points_);
+        const auto& map    = *(object.map_);
+        const auto& ivm    = *(object.ivm_);
+
+        const double& map_weight = /*std::sqrt*/(object.map_weight_);           //*0.5;
+        const double num_points  = static_cast<double>(points.size());
+        const std::size_t threads = object.num_threads_ > 0ul ?
+                    object.num_threads_ : utility::num_threads(points.size() / points_per_thread);
+
+        // sampling fills lazily cached matrices, the threads below must only read
+        if (threads > 1ul && !object.settled_) {
+            cslibs_ndt::map::settle(map, threads);
+            object.settled_ = true;
         }
 
-        // calculate scaling
-        const Functor<7>& object = *casted_ptr;
-        const double num_points  = object.points_->size();
-        const double scale       = /*std::sqrt(2.0*/ 1.0 / object.map_weight_;
-        const double absolute    = 1.0 / num_points;
+        std::vector<_T> scores(points.size());
+        std::vector<_T> gradients(jac ? points.size() * 3 : 0);
+        utility::parallel_for(points.size(), threads,
+                              [&](const std::size_t, const std::size_t begin, const std::size_t end) {
+            map.sampleNonNormalized(points.data() + begin, end - begin, current_transform, ivm,
+                                    scores.data() + begin, jac ? gradients.data() + begin * 3 : nullptr);
+            for (std::size_t k = begin ; k < end ; ++k)
+                fi[k] = map_weight * (std::isnormal(scores[k]) ? (1.0 - scores[k]) : 1.0) / num_points;
+            if (!jac)
+                return;
 
-        // extract score from fi
-        double score = 0.0;
-        for (std::size_t i=0; i<num_points; ++i)
-            score += (absolute - (fi[i] * scale));
+            rows(object, x.getcontent(), gradients.data(), begin, end,
+                 [&](const std::size_t k, const std::array<double,n> &row) {
+                const double factor = std::isnormal(scores[k]) ? -map_weight / num_points : 0.0;
+                for (std::size_t c = 0 ; c < n ; ++c)
+                    (*jac)[k][c] = factor * row[c];
+            });
+        });
+    }
 
-        return score;
+    template <typename fn_t>
+    inline static void rows(const Functor<6> &object, const double *x, const _T *gradients,
+                            const std::size_t begin, const std::size_t end, const fn_t &fn)
+    {
+        gradient::rows<3>(x, object.points_->data(), gradients, begin, end, fn);
     }
+
+    template <typename fn_t>
+    inline static void rows(const Functor<7> &object, const double *x, const _T *gradients,
+                            const std::size_t begin, const std::size_t end, const fn_t &fn)
+    {
+        gradient::rowsQuaternion(x, object.points_->data(), gradients, begin, end, fn);
+    }
+
+    static constexpr std::size_t points_per_thread = 512;
 };
 
 }
@@ -0,0 +1,58 @@
+#ifndef CSLIBS_NDT_3D_MATCHING_BRANCH_AND_BOUND_GRIDMAP_HPP
+#define CSLIBS_NDT_3D_MATCHING_BRANCH_AND_BOUND_GRIDMAP_HPP
+
+#include <cslibs_ndt/matching/branch_and_bound/match.hpp>
+#include <cslibs_ndt/map/map.hpp>
+
+namespace cslibs_ndt {
+namespace matching {
+namespace branch_and_bound {
+
+/**
+ * @brief Score grids of a 3D NDT map for yaw-only global matching.
+ *        Level 0 holds sampleNonNormalized at the voxel centers of the map frame,
+ *        the levels pool x and y only.
+ * @param sampling_resolution voxel size
+ * @param levels              number of max-pooled levels
+ * @param args                additional map arguments, i.e. the inverse sensor model for occupancy maps
+ */
+template <cslibs_ndt::map::tags::option option_t,
+          template <typename,std::size_t> class data_t,
+          typename T,
+          template <typename, typename, typename...> class backend_t,
+          typename ... args_t>
+inline typename Grids<3>::Ptr fromMap(const cslibs_ndt::map::Map<option_t,3,data_t,T,backend_t> &map,
+                                      const T            sampling_resolution,
+                                      const std::size_t  levels,
+                                      const args_t      &...args)
+{
+    using grids_t = Grids<3>;
+    using point_t = typename cslibs_ndt::map::Map<option_t,3,data_t,T,backend_t>::point_t;
+
+    /// the grid starts at the minimum corner of the map
+    typename grids_t::rotation_t    rotation;
+    typename grids_t::translation_t translation;
+    newton::Model<3>::toEigen(map.getInitialOrigin(), rotation, translation);
+
+    const point_t min = map.getMin();
+    const point_t max = map.getMax();
+    typename grids_t::index_t size;
+    for (std::size_t k = 0 ; k < 3 ; ++k)
+        size[k] = std::max(1, static_cast<int>(std::ceil((max(k) - min(k)) / sampling_resolution)));
+    translation += rotation * typename grids_t::translation_t(min(0), min(1), min(2));
+
+    const double resolution = static_cast<double>(sampling_resolution);
+    return typename grids_t::Ptr(new grids_t(rotation, translation, resolution, size, levels,
+                                             [&](const typename grids_t::index_t &i) {
+        const typename grids_t::translation_t p = rotation * typename grids_t::translation_t(
+                    (i[0] + 0.5) * resolution, (i[1] + 0.5) * resolution, (i[2] + 0.5) * resolution) + translation;
+        return static_cast<double>(map.sampleNonNormalized(point_t(static_cast<T>(p(0)), static_cast<T>(p(1)),
+                                                                   static_cast<T>(p(2))), args...));
+    }));
+}
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_3D_MATCHING_BRANCH_AND_BOUND_GRIDMAP_HPP
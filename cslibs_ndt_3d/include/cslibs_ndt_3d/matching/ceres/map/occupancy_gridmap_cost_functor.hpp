@@ -3,6 +3,8 @@
 
 #include <cslibs_ndt/map/map.hpp>
 #include <cslibs_ndt/matching/ceres/map/scan_match_cost_functor.hpp>
+#include <cslibs_ndt/matching/ceres/map/tricubic_interpolator.hpp>
+#include <cslibs_ndt/matching/lattice_cache.hpp>
 
 namespace cslibs_ndt {
 namespace matching {
@@ -85,6 +87,76 @@ private:
     Eigen::Matrix<double,3,1> trans_;
 };
 
+// tricubic on a sparse lattice, sampled on demand
+template <cslibs_ndt::map::tags::option option_t,
+          typename _T,
+          template <typename, typename, typename...> class backend_t>
+class ScanMatchCostFunctor<
+        cslibs_ndt::map::Map<option_t,3,cslibs_ndt::OccupancyDistribution,_T,backend_t>,
+        Flag::INTERPOLATION>
+{
+    using ndt_t = cslibs_ndt::map::Map<option_t,3,cslibs_ndt::OccupancyDistribution,_T,backend_t>;
+
+    using ivm_t = typename ndt_t::inverse_sensor_model_t;
+    using point_t = typename ndt_t::point_t;
+    using cache_t = LatticeCache<ndt_t>;
+
+    template <typename>
+    friend class TriCubicInterpolator;
+
+protected:
+    explicit inline ScanMatchCostFunctor(const ndt_t& map,
+                                         const typename ivm_t::Ptr& ivm,
+                                         const double& sampling_resolution) :
+        ScanMatchCostFunctor(map, ivm, typename cache_t::Ptr(new cache_t(map, sampling_resolution, ivm)))
+    {
+    }
+
+    /**
+     * @brief Reads the lattice from a cache, which can be shared by all functors of the map.
+     *        The cache has to be constructed with the same inverse model.
+     */
+    explicit inline ScanMatchCostFunctor(const ndt_t& map,
+                                         const typename ivm_t::Ptr& ivm,
+                                         const typename cache_t::Ptr& cache) :
+        map_(map),
+        ivm_(ivm),
+        cache_(cache),
+        sampling_resolution_(cache->getSamplingResolution()),
+        interpolator_(*this)
+    {
+    }
+
+    template <int _D>
+    inline void Evaluate(const Eigen::Matrix<double,_D,1>& q, double* const value) const
+    {
+        *value = 1.0 - map_.sampleNonNormalized(point_t(q(0),q(1),q(2)), ivm_);
+    }
+
+    template <typename JetT, int _D>
+    inline void Evaluate(const Eigen::Matrix<JetT,_D,1>& q, JetT* const value) const
+    {
+        interpolator_.Evaluate(q(0) / sampling_resolution_,
+                               q(1) / sampling_resolution_,
+                               q(2) / sampling_resolution_,
+                               value);
+    }
+
+private:
+    inline void GetValues(const int row, const int column, const int depth, double* const values) const
+    {
+        cache_->template block<4>({{row, column, depth}}, values);
+        for (std::size_t i = 0 ; i < 64 ; ++i)
+            values[i] = 1.0 - values[i];
+    }
+
+    const ndt_t& map_;
+    const typename ivm_t::Ptr ivm_;
+    const typename cache_t::Ptr cache_;
+    const double sampling_resolution_;
+    const TriCubicInterpolator<ScanMatchCostFunctor<ndt_t,Flag::INTERPOLATION>> interpolator_;
+};
+
 }
 }
 }
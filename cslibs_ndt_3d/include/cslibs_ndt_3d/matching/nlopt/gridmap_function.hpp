@@ -2,8 +2,11 @@
 #define CSLIBS_NDT_3D_MATCHING_NLOPT_GRIDMAP_FUNCTION_HPP
 
 #include <cslibs_ndt/matching/nlopt/function.hpp>
+#include <cslibs_ndt/matching/gradient.hpp>
 #include <cslibs_ndt/map/map.hpp>
 
+#include <cslibs_math/common/angle.hpp>
+
 namespace cslibs_ndt {
 namespace matching {
 namespace nlopt {
@@ -39,12 +42,6 @@ public:
 
     inline static double applyRPY(unsigned n, const double *x, double *grad, void* ptr)
     {
-        // since f is discontinuous, use derivative-free algorithms!
-        if (grad) {
-            std::cerr << "Gradient not implemented..." << std::endl;
-            return 0;
-        }
-
         // check that all necessary information is given
         const auto& casted_ptr = (Functor<6>*)ptr;
         if (!casted_ptr) {
@@ -60,10 +57,12 @@ public:
         double fi = 0;
         const typename ndt_t::pose_t current_transform(x[0],x[1],x[2],x[3],x[4],x[5]); // xyz rpy
 
-        // evaluate function
-        for (const auto& p : points) {
-            const typename ndt_t::point_t q = current_transform * typename ndt_t::point_t(p(0),p(1),p(2));
-            const double score = map.sampleNonNormalized(q);
+        // evaluate function, with the score gradient of every point if requested
+        std::vector<_T> scores(points.size());
+        std::vector<_T> gradients(grad ? points.size() * 3 : 0);
+        map.sampleNonNormalized(points.data(), points.size(), current_transform, scores.data(),
+                                grad ? gradients.data() : nullptr);
+        for (const double score : scores) {
             fi += std::isnormal(score) ? (1.0 - score) : 1.0;
         }
 
@@ -79,6 +78,21 @@ public:
              object.translation_weight_ * trans_diff +
              object.rotation_weight_ * std::fabs(rot_diff);
 
+        // calculate gradient, the points only contribute through their scores
+        if (grad) {
+            std::fill(grad, grad + n, 0.0);
+            const _T factor = static_cast<_T>(-object.map_weight_ / static_cast<double>(points.size()));
+            for (_T &g : gradients)
+                g *= factor;
+            gradient::chain<3>(x, points, gradients, grad);
+            gradient::norm<3>({{x[0] - initial_guess[0], x[1] - initial_guess[1], x[2] - initial_guess[2]}},
+                              object.translation_weight_, grad);
+            gradient::norm<3>({{cslibs_math::common::angle::difference(x[3], initial_guess[3]),
+                                cslibs_math::common::angle::difference(x[4], initial_guess[4]),
+                                cslibs_math::common::angle::difference(x[5], initial_guess[5])}},
+                              object.rotation_weight_, grad + 3);
+        }
+
         return fi;
     }
 
@@ -106,14 +120,30 @@ public:
                 object.map_weight_;
     }
 
-    inline static double applyQuaternion(unsigned n, const double *x, double *grad, void* ptr)
+    /**
+     * @brief Normalized rotation of x = xyz xyzw.
+     */
+    template <typename T = _T>
+    inline static cslibs_math_3d::Quaternion<T> quaternion(const double *x)
     {
-        // since f is discontinuous, use derivative-free algorithms!
-        if (grad) {
-            std::cerr << "Gradient not implemented..." << std::endl;
-            return 0;
-        }
+        const double norm = std::sqrt(x[3]*x[3] + x[4]*x[4] + x[5]*x[5] + x[6]*x[6]);
+        return cslibs_math_3d::Quaternion<T>(static_cast<T>(x[3] / norm), static_cast<T>(x[4] / norm),
+                                             static_cast<T>(x[5] / norm), static_cast<T>(x[6] / norm));
+    }
+
+    /**
+     * @brief Norm of the roll, pitch and yaw differences of the rotation of x to the initial guess.
+     */
+    inline static double rotationDifference(const double *x, const std::array<double,7> &initial_guess)
+    {
+        const cslibs_math_3d::Quaternion<double> rot = quaternion<double>(x);
+        return hypot(cslibs_math::common::angle::difference(rot.roll(),  initial_guess[3]),
+                     cslibs_math::common::angle::difference(rot.pitch(), initial_guess[4]),
+                     cslibs_math::common::angle::difference(rot.yaw(),   initial_guess[5]));
+    }
 
+    inline static double applyQuaternion(unsigned n, const double *x, double *grad, void* ptr)
+    {
         // check that all necessary information is given
         const auto& casted_ptr = (Functor<7>*)ptr;
         if (!casted_ptr) {
@@ -129,13 +159,15 @@ public:
         double fi = 0;
         const typename ndt_t::pose_t current_transform(
                     cslibs_math_3d::Vector3<_T>(x[0],x[1],x[2]),          // xyz
-                    cslibs_math_3d::Quaternion<_T>(x[3],x[4],x[5],x[6])); // xyzw
+                    quaternion(x));                                       // xyzw
         const auto& rot = current_transform.rotation();
 
-        // evaluate function
-        for (const auto& p : points) {
-            const typename ndt_t::point_t q = current_transform * typename ndt_t::point_t(p(0),p(1),p(2));
-            const double score = map.sampleNonNormalized(q);
+        // evaluate function, with the score gradient of every point if requested
+        std::vector<_T> scores(points.size());
+        std::vector<_T> gradients(grad ? points.size() * 3 : 0);
+        map.sampleNonNormalized(points.data(), points.size(), current_transform, scores.data(),
+                                grad ? gradients.data() : nullptr);
+        for (const double score : scores) {
             fi += std::isnormal(score) ? (1.0 - score) : 1.0;
         }
 
@@ -151,6 +183,28 @@ public:
              object.translation_weight_ * trans_diff +
              object.rotation_weight_ * std::fabs(rot_diff);
 
+        // calculate gradient, the rotational component is differentiated numerically
+        if (grad) {
+            std::fill(grad, grad + n, 0.0);
+            const _T factor = static_cast<_T>(-object.map_weight_ / static_cast<double>(points.size()));
+            for (_T &g : gradients)
+                g *= factor;
+            gradient::chainQuaternion(x, points, gradients, grad);
+            gradient::norm<3>({{x[0] - initial_guess[0], x[1] - initial_guess[1], x[2] - initial_guess[2]}},
+                              object.translation_weight_, grad);
+
+            const double h = 1e-6;
+            std::array<double,7> xh{{x[0],x[1],x[2],x[3],x[4],x[5],x[6]}};
+            for (std::size_t i = 3 ; i < 7 ; ++i) {
+                xh[i] = x[i] + h;
+                const double rot_diff_p = rotationDifference(xh.data(), initial_guess);
+                xh[i] = x[i] - h;
+                const double rot_diff_m = rotationDifference(xh.data(), initial_guess);
+                xh[i] = x[i];
+                grad[i] += object.rotation_weight_ * (rot_diff_p - rot_diff_m) / (2.0 * h);
+            }
+        }
+
         return fi;
     }
 
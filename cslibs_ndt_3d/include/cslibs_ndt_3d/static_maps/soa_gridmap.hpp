@@ -0,0 +1,17 @@
+#ifndef CSLIBS_NDT_3D_STATIC_MAPS_SOA_GRIDMAP_HPP
+#define CSLIBS_NDT_3D_STATIC_MAPS_SOA_GRIDMAP_HPP
+
+#include <cslibs_ndt/map/map.hpp>
+
+namespace cslibs_ndt_3d {
+namespace static_maps {
+namespace soa {
+
+template <typename T>
+using Gridmap = cslibs_ndt::map::Map<cslibs_ndt::map::tags::static_map,3,cslibs_ndt::Distribution,T,cslibs_ndt::backend::SoA>;
+
+}
+}
+}
+
+#endif // CSLIBS_NDT_3D_STATIC_MAPS_SOA_GRIDMAP_HPP
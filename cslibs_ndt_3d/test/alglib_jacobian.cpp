@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/frozen_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/frozen_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/soa_gridmap.hpp>
+#include <cslibs_ndt/conversion/map.hpp>
+#include <cslibs_ndt_3d/matching/alglib/gridmap_function.hpp>
+#include <cslibs_ndt_3d/matching/alglib/occupancy_gridmap_function.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+/**
+ * @brief Compares the Jacobian of jacobian at x to central differences of apply, column by column.
+ *        A point changing its bundle within the step makes its row jump, a few of those are
+ *        tolerated among the map rows. The last rows, the pose prior, have to match all.
+ */
+template <std::size_t n, typename apply_t, typename jacobian_t, typename functor_t>
+void testJacobian(const apply_t &apply, const jacobian_t &jacobian, functor_t &functor, const std::array<double,n> &x)
+{
+    const std::size_t num_points = functor.points_->size();
+    const std::size_t m          = num_points + n;
+    const double      scale      = functor.map_weight_ / static_cast<double>(num_points);
+
+    ::alglib::real_1d_array xa, fi, fi_apply;
+    ::alglib::real_2d_array jac;
+    xa.setcontent(n, x.data());
+    fi.setlength(m);
+    fi_apply.setlength(m);
+    jac.setlength(m, n);
+
+    jacobian(xa, fi, jac, &functor);
+    apply(xa, fi_apply, &functor);
+    for (std::size_t r = 0 ; r < m ; ++r)
+        EXPECT_EQ(fi_apply[r], fi[r]);
+
+    const double h = 1e-7;
+    for (std::size_t c = 0 ; c < n ; ++c) {
+        ::alglib::real_1d_array xp = xa, xm = xa, fp, fm;
+        xp[c] += h;
+        xm[c] -= h;
+        fp.setlength(m);
+        fm.setlength(m);
+        apply(xp, fp, &functor);
+        apply(xm, fm, &functor);
+
+        std::size_t jumps = 0;
+        for (std::size_t r = 0 ; r < m ; ++r) {
+            const double expected = (fp[r] - fm[r]) / (2.0 * h);
+            const bool   near     = std::fabs(expected - jac[r][c]) <= 1e-4 * std::max(scale, std::fabs(expected));
+            if (r < num_points)
+                jumps += near ? 0ul : 1ul;
+            else
+                EXPECT_TRUE(near) << "prior row " << r - num_points << ", column " << c << ": "
+                                  << expected << " vs. " << jac[r][c];
+        }
+        EXPECT_LE(jumps, 2ul) << "column " << c;
+    }
+}
+
+/**
+ * @brief The rotation is the one of the normalized quaternion, so scaling q changes no
+ *        component of the function and every Jacobian row is orthogonal to q.
+ */
+template <typename apply_t, typename jacobian_t, typename functor_t>
+void testQuaternionScale(const apply_t &apply, const jacobian_t &jacobian, functor_t &functor, const std::array<double,7> &x)
+{
+    const std::size_t m = functor.points_->size() + 7;
+
+    std::array<double,7> x_scaled = x;
+    for (std::size_t c = 3 ; c < 7 ; ++c)
+        x_scaled[c] *= 2.5;
+
+    ::alglib::real_1d_array xa, xa_scaled, fi, fi_scaled;
+    ::alglib::real_2d_array jac;
+    xa.setcontent(7, x.data());
+    xa_scaled.setcontent(7, x_scaled.data());
+    fi.setlength(m);
+    fi_scaled.setlength(m);
+    jac.setlength(m, 7);
+
+    apply(xa, fi, &functor);
+    jacobian(xa_scaled, fi_scaled, jac, &functor);
+    for (std::size_t r = 0 ; r < m ; ++r) {
+        EXPECT_NEAR(fi[r], fi_scaled[r], 1e-12);
+
+        double along = 0.0;
+        for (std::size_t c = 3 ; c < 7 ; ++c)
+            along += jac[r][c] * x_scaled[c];
+        EXPECT_NEAR(0.0, along, 1e-12);
+    }
+}
+
+template <typename function_t, typename map_t, typename... args_t>
+void testFunction(const map_t &map, const args_t*... ivm)
+{
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(1000))
+        scan.emplace_back(truth_inv * p);
+
+    // several threads, the first evaluation runs on a map which has not been sampled before
+    typename function_t::FunctorRPY rpy{&map, &scan, ivm..., {{0.1, 0.1, 0.0, 0.0, 0.0, 0.05}}, 0.1, 0.2, 1.0, 4ul};
+    testJacobian<6>(&function_t::applyRPY, &function_t::jacobianRPY, rpy, {{0.25, -0.15, 0.08, 0.01, -0.02, 0.12}});
+    EXPECT_TRUE(rpy.settled_); // once, later evaluations only sample
+
+    // off the unit sphere, the Jacobian includes the derivative of the normalization
+    const cslibs_math_3d::Quaternion<double> q(0.01, -0.02, 0.12);
+    const std::array<double,7> x{{0.25, -0.15, 0.08, q.x(), q.y(), q.z(), q.w()}};
+    const std::array<double,7> x_off{{0.25, -0.15, 0.08, 1.3 * q.x(), 1.3 * q.y(), 1.3 * q.z(), 1.3 * q.w()}};
+    typename function_t::FunctorQuaternion quaternion{&map, &scan, ivm..., {{0.1, 0.1, 0.0, 0.0, 0.0, 0.05, 1.0}}, 0.1, 0.2, 1.0, 4ul};
+    testJacobian<7>(&function_t::applyQuaternion, &function_t::jacobianQuaternion, quaternion, x);
+    testJacobian<7>(&function_t::applyQuaternion, &function_t::jacobianQuaternion, quaternion, x_off);
+    testQuaternionScale(&function_t::applyQuaternion, &function_t::jacobianQuaternion, quaternion, x);
+}
+
+TEST(Test_cslibs_ndt_3d, testAlglibJacobianGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(50000);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testFunction<cslibs_ndt::matching::alglib::Function<map_t, cslibs_math_3d::Point3d>>(map);
+}
+
+TEST(Test_cslibs_ndt_3d, testAlglibJacobianOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    // scanned from the center of the room
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(50000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testFunction<cslibs_ndt::matching::alglib::Function<map_t, cslibs_math_3d::Point3d>>(map, &ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testAlglibJacobianFrozenGridmap)
+{
+    using map_t    = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+    using frozen_t = cslibs_ndt_3d::frozen_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(50000);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+    const frozen_t frozen(map);
+
+    testFunction<cslibs_ndt::matching::alglib::Function<frozen_t, cslibs_math_3d::Point3d>>(frozen);
+}
+
+TEST(Test_cslibs_ndt_3d, testAlglibJacobianFrozenOccupancyGridmap)
+{
+    using map_t    = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+    using frozen_t = cslibs_ndt_3d::frozen_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(50000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const frozen_t frozen(map, ivm);
+    testFunction<cslibs_ndt::matching::alglib::Function<frozen_t, cslibs_math_3d::Point3d>>(frozen, &ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testAlglibJacobianSoAGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+    using soa_t = cslibs_ndt_3d::static_maps::soa::Gridmap<double>;
+    using to_soa_t = cslibs_ndt::conversion::convert<
+        cslibs_ndt::map::tags::static_map, cslibs_ndt::map::tags::dynamic_map, 3, cslibs_ndt::Distribution, double,
+        cslibs_ndt::backend::SoA>;
+
+    const cloud_t room = generateRoom(50000);
+    map_t::Ptr map(new map_t(cslibs_math_3d::Transform3d(), 1.0));
+    map->insert(room.begin(), room.end());
+    const soa_t::Ptr soa = to_soa_t::from(map);
+    ASSERT_NE(soa, nullptr);
+
+    testFunction<cslibs_ndt::matching::alglib::Function<soa_t, cslibs_math_3d::Point3d>>(*soa);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
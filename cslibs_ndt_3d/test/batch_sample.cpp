@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+const std::size_t NUM_SAMPLES = 20000;
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+cslibs_math_3d::Pointcloud3d::Ptr generateCloud()
+{
+    rng_t rng_coord(-5.0, 5.0);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i)
+        cloud->insert(cslibs_math_3d::Point3d(rng_coord.get(), rng_coord.get(), rng_coord.get()));
+    return cloud;
+}
+
+cloud_t generateQueries()
+{
+    rng_t rng_coord(-6.0, 6.0);
+
+    cloud_t queries;
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i)
+        queries.emplace_back(rng_coord.get(), rng_coord.get(), rng_coord.get());
+    return queries;
+}
+
+template <typename map_t, typename... args_t>
+void testBatch(const map_t &map, const args_t&... args)
+{
+    const cloud_t queries = generateQueries();
+    const cslibs_math_3d::Transform3d pose(0.2, 0.1, -0.3, 0.05, -0.1, 0.4);
+
+    std::vector<double> scores(queries.size());
+    std::vector<double> gradients(queries.size() * 3);
+    map.sampleNonNormalized(queries.data(), queries.size(), pose, args..., scores.data(), gradients.data());
+
+    // scores only, gradients are optional
+    std::vector<double> scores_only(queries.size());
+    map.sampleNonNormalized(queries.data(), queries.size(), pose, args..., scores_only.data());
+
+    const double h = 1e-6;
+    std::size_t hits = 0;
+    for (std::size_t i = 0 ; i < queries.size() ; ++ i) {
+        const cslibs_math_3d::Point3d q = pose * queries[i];
+        const double s = map.sampleNonNormalized(q, args...);
+        EXPECT_NEAR(s, scores[i], 1e-9);
+        EXPECT_EQ(scores[i], scores_only[i]);
+        hits += s > 0.0 ? 1ul : 0ul;
+
+        // central differences, unless the step crosses a bundle border
+        for (std::size_t k = 0 ; k < 3 ; ++ k) {
+            cslibs_math_3d::Point3d qp = q, qm = q;
+            qp(k) += h;
+            qm(k) -= h;
+            if (map.get(qp) != map.get(qm))
+                continue;
+            const double g = (map.sampleNonNormalized(qp, args...) - map.sampleNonNormalized(qm, args...)) / (2.0 * h);
+            EXPECT_NEAR(g, gradients[i * 3 + k], 1e-5);
+        }
+    }
+    EXPECT_GT(hits, queries.size() / 2);
+}
+
+TEST(Test_cslibs_ndt_3d, testBatchDynamicGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cslibs_math_3d::Transform3d origin(1.0, -2.0, 0.5, 0.1, -0.2, 0.3);
+    map_t map(origin, 1.0);
+    map.insert(generateCloud());
+
+    testBatch(map);
+}
+
+TEST(Test_cslibs_ndt_3d, testBatchStaticGridmap)
+{
+    using map_t = cslibs_ndt_3d::static_maps::Gridmap<double>;
+
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(-8.0, -8.0, -8.0));
+    const typename map_t::size_t size = {{16ul, 16ul, 16ul}};
+    const typename map_t::index_t min_index = {{0, 0, 0}};
+
+    map_t map(origin, 1.0, size, min_index);
+    map.insert(generateCloud());
+
+    testBatch(map);
+}
+
+TEST(Test_cslibs_ndt_3d, testBatchOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d origin(1.0, -2.0, 0.5, 0.1, -0.2, 0.3);
+    map_t map(origin, 1.0);
+    map.insert(generateCloud());
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testBatch(map, ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testBatchEmpty)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    const cloud_t queries = generateQueries();
+
+    std::vector<double> scores(queries.size(), 1.0);
+    map.sampleNonNormalized(queries.data(), queries.size(), cslibs_math_3d::Transform3d(), scores.data());
+    for (const double s : scores)
+        EXPECT_EQ(0.0, s);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/matching/branch_and_bound/gridmap.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+namespace bnb = cslibs_ndt::matching::branch_and_bound;
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using map_t   = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+// yaw-only search: z, roll and pitch are taken from the initial guess
+const cslibs_math_3d::Transform3d TRUTH(0.9, -0.6, 0.0, 0.0, 0.0, -2.4);
+
+cloud_t generateScan(const std::size_t size)
+{
+    const cslibs_math_3d::Transform3d truth_inv = TRUTH.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(size))
+        points.emplace_back(truth_inv * p);
+    return points;
+}
+
+void testMatch(const bnb::Grids<3> &grids)
+{
+    bnb::Parameter parameter;
+    parameter.linear_window = 2.0;
+    parameter.min_score     = 0.1;
+    const bnb::Result<cslibs_math_3d::Transform3d> result =
+            bnb::match(grids, generateScan(1000), cslibs_math_3d::Transform3d(), parameter);
+
+    EXPECT_EQ(bnb::Termination::COMPLETE, result.termination);
+    EXPECT_GT(result.score, parameter.min_score);
+    EXPECT_NEAR(result.transform.tx(), TRUTH.tx(), 0.25);
+    EXPECT_NEAR(result.transform.ty(), TRUTH.ty(), 0.25);
+    EXPECT_NEAR(result.transform.tz(), 0.0, 1e-9);
+    EXPECT_NEAR(std::cos(result.transform.rotation().yaw() - TRUTH.rotation().yaw()), 1.0, 1e-3);
+}
+
+TEST(Test_cslibs_ndt_3d, testBranchAndBoundGridmap)
+{
+    const cloud_t room = generateRoom(50000);
+    map_t map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    map.insert(room.begin(), room.end());
+
+    const bnb::Grids<3>::Ptr grids = bnb::fromMap(map, 0.2, 5);
+    EXPECT_EQ(5ul, grids->levels());
+    testMatch(*grids);
+}
+
+TEST(Test_cslibs_ndt_3d, testBranchAndBoundOccupancyGridmap)
+{
+    using occ_map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    // scanned from the center of the room
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(50000))
+        points.emplace_back(sensor_inv * p);
+
+    occ_map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testMatch(*bnb::fromMap(map, 0.2, 5, ivm));
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/gridmap_cost_functor.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/occupancy_gridmap_cost_functor.hpp>
+#include <cslibs_ndt/matching/ceres/problem.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <ceres/ceres.h>
+
+#include "room.hpp"
+
+namespace nc = cslibs_ndt::matching::ceres;
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+struct Evaluation {
+    double              cost = 0.0;
+    std::vector<double> gradient;
+    int                 blocks = 0;
+};
+
+/**
+ * @brief Cost and gradient of the problem built by add, evaluated by num_threads threads.
+ */
+template <std::size_t R, typename add_t>
+Evaluation evaluate(const add_t &add, const std::array<double,3> &translation, const std::array<double,R> &rotation,
+                    const int num_threads)
+{
+    std::array<double,3> t = translation;
+    std::array<double,R> r = rotation;
+    ::ceres::Problem problem;
+    add(t.data(), r.data(), problem);
+
+    Evaluation e;
+    ::ceres::Problem::EvaluateOptions options;
+    options.num_threads = num_threads;
+    EXPECT_TRUE(problem.Evaluate(options, &e.cost, nullptr, &e.gradient, nullptr));
+    e.blocks = problem.NumResidualBlocks();
+    return e;
+}
+
+/**
+ * @brief Splitting the scan match cost into chunks must not change cost and gradient of the
+ *        problem, whatever the chunk size, the differentiation and the number of threads.
+ *        add(differentiation, chunk_size, translation, rotation, problem) builds the chunked problem,
+ *        chunk_size 0 meaning the single block problem.
+ */
+template <std::size_t R, typename add_t>
+void testChunked(const add_t &add, const std::size_t points,
+                 const std::array<double,3> &translation, const std::array<double,R> &rotation)
+{
+    for (const nc::Differentiation differentiation : {nc::Differentiation::AUTOMATIC,
+                                                      nc::Differentiation::NUMERIC,
+                                                      nc::Differentiation::ANALYTIC}) {
+        const Evaluation single = evaluate<R>([&](double *t, double *r, ::ceres::Problem &problem) {
+            add(differentiation, 0ul, t, r, problem);
+        }, translation, rotation, 1);
+        ASSERT_GT(single.cost, 0.0);
+
+        for (const std::size_t chunk_size : {1ul, 7ul, 128ul, points, 2ul * points}) {
+            for (const int num_threads : {1, 4}) {
+                const Evaluation chunked = evaluate<R>([&](double *t, double *r, ::ceres::Problem &problem) {
+                    add(differentiation, chunk_size, t, r, problem);
+                }, translation, rotation, num_threads);
+
+                // the two priors and one block per chunk
+                EXPECT_EQ(static_cast<int>(2ul + (points + chunk_size - 1ul) / chunk_size), chunked.blocks);
+                EXPECT_NEAR(single.cost, chunked.cost, 1e-10 * single.cost);
+                ASSERT_EQ(single.gradient.size(), chunked.gradient.size());
+                for (std::size_t i = 0 ; i < single.gradient.size() ; ++i)
+                    EXPECT_NEAR(single.gradient[i], chunked.gradient[i], 1e-9 * std::max(1.0, std::fabs(single.gradient[i])))
+                            << "chunk size " << chunk_size << ", threads " << num_threads << ", entry " << i;
+            }
+        }
+    }
+}
+
+template <typename map_t, typename... args_t>
+void testProblems(const map_t &map, const args_t&... args)
+{
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(1000))
+        scan.emplace_back(truth_inv * p);
+
+    // chunks are evaluated concurrently, the map has to be settled before
+    cslibs_ndt::map::settle(map);
+
+    const cslibs_math_3d::Transform3d initial = truth * cslibs_math_3d::Transform3d(0.05, -0.03, 0.02, 0.01, 0.02, -0.03);
+    const auto &q = initial.rotation();
+
+    testChunked<4>([&](const nc::Differentiation differentiation, const std::size_t chunk_size,
+                       double *t, double *r, ::ceres::Problem &problem) {
+        if (chunk_size == 0ul)
+            nc::Problem3dQuaternion<map_t>(0.1, 0.2, 1.0, initial.translation(), initial.rotation(),
+                                           t, r, problem, false, differentiation, scan, map, args...);
+        else
+            nc::Problem3dQuaternionChunked<map_t>(0.1, 0.2, 1.0, initial.translation(), initial.rotation(),
+                                                  t, r, problem, false, differentiation, chunk_size, scan, map, args...);
+    }, scan.size(), {{initial.tx() + 0.02, initial.ty() - 0.01, initial.tz()}}, {{q.w(), q.x(), q.y(), q.z()}});
+
+    const cslibs_math::linear::Vector<double,3> rpy(q.roll(), q.pitch(), q.yaw());
+    testChunked<3>([&](const nc::Differentiation differentiation, const std::size_t chunk_size,
+                       double *t, double *r, ::ceres::Problem &problem) {
+        if (chunk_size == 0ul)
+            nc::Problem3dRPY<map_t>(0.1, 0.2, 1.0, initial.translation(), rpy,
+                                    t, r, problem, false, differentiation, scan, map, args...);
+        else
+            nc::Problem3dRPYChunked<map_t>(0.1, 0.2, 1.0, initial.translation(), rpy,
+                                           t, r, problem, false, differentiation, chunk_size, scan, map, args...);
+    }, scan.size(), {{initial.tx() + 0.02, initial.ty() - 0.01, initial.tz()}}, {{q.roll() + 0.01, q.pitch(), q.yaw() - 0.02}});
+}
+
+TEST(Test_cslibs_ndt_3d, testCeresChunkedGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(100000);
+    map_t map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testProblems(map);
+}
+
+TEST(Test_cslibs_ndt_3d, testCeresChunkedOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(100000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testProblems(map, ivm);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
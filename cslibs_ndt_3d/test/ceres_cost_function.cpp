@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/gridmap_cost_functor.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/occupancy_gridmap_cost_functor.hpp>
+#include <cslibs_ndt/matching/ceres/problem.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <memory>
+
+#include "room.hpp"
+
+namespace nc = cslibs_ndt::matching::ceres;
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+/**
+ * @brief Residuals and Jacobians of cost at the given parameter blocks, the Jacobians row-major.
+ */
+template <std::size_t R>
+void evaluate(const ::ceres::CostFunction &cost,
+              const std::array<double,3> &translation, const std::array<double,R> &rotation,
+              std::vector<double> &residuals, std::vector<double> &jacobian_t, std::vector<double> &jacobian_r)
+{
+    const std::size_t n = static_cast<std::size_t>(cost.num_residuals());
+    residuals.resize(n);
+    jacobian_t.resize(n * 3);
+    jacobian_r.resize(n * R);
+
+    const double *parameters[2] = {translation.data(), rotation.data()};
+    double       *jacobians[2]  = {jacobian_t.data(), jacobian_r.data()};
+    ASSERT_TRUE(cost.Evaluate(parameters, residuals.data(), jacobians));
+}
+
+/**
+ * @brief The analytic ScanMatchCostFunction has to give the residuals and Jacobians
+ *        of the autodiff ScanMatchCostFunctor, in the same parameter layout. Evaluating
+ *        the analytic one at another pose in between must not change its result.
+ */
+template <std::size_t R>
+void compare(::ceres::CostFunction *autodiff_ptr, ::ceres::CostFunction *analytic_ptr,
+             const std::array<double,3> &translation,       const std::array<double,R> &rotation,
+             const std::array<double,3> &other_translation, const std::array<double,R> &other_rotation)
+{
+    const std::unique_ptr<::ceres::CostFunction> autodiff(autodiff_ptr);
+    const std::unique_ptr<::ceres::CostFunction> analytic(analytic_ptr);
+    ASSERT_EQ(autodiff->num_residuals(), analytic->num_residuals());
+    ASSERT_EQ(autodiff->parameter_block_sizes(), analytic->parameter_block_sizes());
+
+    std::vector<double> r_auto, jt_auto, jr_auto;
+    std::vector<double> r_analytic, jt_analytic, jr_analytic;
+    evaluate<R>(*autodiff, translation, rotation, r_auto, jt_auto, jr_auto);
+    evaluate<R>(*analytic, other_translation, other_rotation, r_analytic, jt_analytic, jr_analytic);
+    evaluate<R>(*analytic, translation, rotation, r_analytic, jt_analytic, jr_analytic);
+
+    const double weight = r_auto.empty() ? 0.0 : 1.0 / std::sqrt(static_cast<double>(r_auto.size()));
+    std::size_t hits = 0;
+    for (std::size_t k = 0 ; k < r_auto.size() ; ++k) {
+        EXPECT_NEAR(r_auto[k], r_analytic[k], 1e-9 * weight);
+        hits += r_auto[k] < weight ? 1ul : 0ul;
+    }
+    // most points have to overlap with the map for the comparison to mean anything
+    EXPECT_GT(hits, r_auto.size() / 2);
+
+    for (std::size_t i = 0 ; i < jt_auto.size() ; ++i)
+        EXPECT_NEAR(jt_auto[i], jt_analytic[i], 1e-9 * std::max(weight, std::fabs(jt_auto[i])));
+    for (std::size_t i = 0 ; i < jr_auto.size() ; ++i)
+        EXPECT_NEAR(jr_auto[i], jr_analytic[i], 1e-9 * std::max(weight, std::fabs(jr_auto[i])));
+}
+
+template <typename map_t, typename... args_t>
+void testCostFunction(const map_t &map, const args_t&... args)
+{
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(1000))
+        scan.emplace_back(truth_inv * p);
+
+    const cslibs_math_3d::Transform3d pose  = truth * cslibs_math_3d::Transform3d(0.05, -0.03, 0.02, 0.01, 0.02, -0.03);
+    const cslibs_math_3d::Transform3d other = truth * cslibs_math_3d::Transform3d(-0.4, 0.3, 0.2, -0.05, 0.04, 0.1);
+    const auto &qp = pose.rotation();
+    const auto &qo = other.rotation();
+
+    // quaternion blocks are w x y z
+    compare<4>(nc::ScanMatchCostFunctor3dQuaternionCreator<map_t, nc::Flag::DIRECT>::CreateAutoDiffCostFunction(1.0, scan, map, args...),
+               nc::ScanMatchCostFunction3dQuaternionCreator<map_t>::Create(1.0, scan, map, args...),
+               {{pose.tx(),  pose.ty(),  pose.tz()}},  {{qp.w(), qp.x(), qp.y(), qp.z()}},
+               {{other.tx(), other.ty(), other.tz()}}, {{qo.w(), qo.x(), qo.y(), qo.z()}});
+
+    // rpy blocks are roll pitch yaw
+    compare<3>(nc::ScanMatchCostFunctor3dRPYCreator<map_t, nc::Flag::DIRECT>::CreateAutoDiffCostFunction(1.0, scan, map, args...),
+               nc::ScanMatchCostFunction3dRPYCreator<map_t>::Create(1.0, scan, map, args...),
+               {{pose.tx(),  pose.ty(),  pose.tz()}},  {{qp.roll(), qp.pitch(), qp.yaw()}},
+               {{other.tx(), other.ty(), other.tz()}}, {{qo.roll(), qo.pitch(), qo.yaw()}});
+}
+
+TEST(Test_cslibs_ndt_3d, testCeresCostFunctionGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(100000);
+    map_t map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testCostFunction(map);
+}
+
+TEST(Test_cslibs_ndt_3d, testCeresCostFunctionOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(100000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testCostFunction(map, ivm);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
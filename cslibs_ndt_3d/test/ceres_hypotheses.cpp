@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/gridmap_cost_functor.hpp>
+#include <cslibs_ndt_3d/matching/ceres/map/occupancy_gridmap_cost_functor.hpp>
+#include <cslibs_ndt/matching/ceres/hypotheses.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+namespace nc = cslibs_ndt::matching::ceres;
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+using poses_t = std::vector<cslibs_math_3d::Transform3d>;
+
+poses_t generateGuesses(const cslibs_math_3d::Transform3d &truth, const std::size_t size)
+{
+    rng_t rng_trans(-0.15, 0.15), rng_r(-0.03, 0.03);
+
+    poses_t guesses;
+    for (std::size_t i = 0 ; i < size ; ++ i)
+        guesses.emplace_back(truth * cslibs_math_3d::Transform3d(rng_trans.get(), rng_trans.get(), rng_trans.get(),
+                                                                 rng_r.get(), rng_r.get(), rng_r.get()));
+    // far off, no overlap at all
+    guesses.emplace_back(100.0, 100.0, 100.0, 0.0, 0.0, 0.0);
+    return guesses;
+}
+
+::ceres::Solver::Options options()
+{
+    ::ceres::Solver::Options options;
+    options.linear_solver_type = ::ceres::DENSE_QR;
+    options.max_num_iterations = 100;
+    options.num_threads        = 1;
+    return options;
+}
+
+/**
+ * @brief Runs the hypotheses on 4 threads and each of them on its own, which has to give the same
+ *        results. match(guesses, num_threads) wraps one of the MatchHypotheses3d* functions.
+ */
+template <typename match_t>
+void testHypotheses(const match_t &match)
+{
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+
+    cloud_t scan;
+    for (const auto &p : generateRoom(3000))
+        scan.emplace_back(truth_inv * p);
+
+    const poses_t guesses = generateGuesses(truth, 8);
+    const auto results = match(guesses, scan, 4ul);
+    ASSERT_EQ(guesses.size(), results.size());
+
+    for (std::size_t i = 0 ; i < guesses.size() ; ++ i) {
+        // same as solving each hypothesis on its own
+        const auto single = match(poses_t{guesses[i]}, scan, 1ul);
+        ASSERT_EQ(1ul, single.size());
+        EXPECT_EQ(single.front().iterations, results[i].iterations);
+        EXPECT_EQ(single.front().converged,  results[i].converged);
+        EXPECT_NEAR(single.front().score,          results[i].score,          1e-12);
+        EXPECT_NEAR(single.front().transform.tx(), results[i].transform.tx(), 1e-12);
+        EXPECT_NEAR(single.front().transform.ty(), results[i].transform.ty(), 1e-12);
+        EXPECT_NEAR(single.front().transform.tz(), results[i].transform.tz(), 1e-12);
+        EXPECT_NEAR(single.front().transform.rotation().yaw(), results[i].transform.rotation().yaw(), 1e-12);
+    }
+
+    // the hypotheses near the truth converge to it
+    for (std::size_t i = 0 ; i + 1 < guesses.size() ; ++ i) {
+        EXPECT_NEAR(results[i].transform.tx(), truth.tx(), 0.05);
+        EXPECT_NEAR(results[i].transform.ty(), truth.ty(), 0.05);
+        EXPECT_NEAR(results[i].transform.rotation().yaw(), truth.rotation().yaw(), 0.02);
+        EXPECT_GT(results[i].score, results.back().score);
+    }
+    EXPECT_EQ(0.0, results.back().score);
+}
+
+TEST(Test_cslibs_ndt_3d, testCeresHypothesesQuaternion)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(100000);
+    map_t map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    map.insert(room.begin(), room.end());
+    cslibs_ndt::map::settle(map);
+
+    testHypotheses([&map](const poses_t &guesses, const cloud_t &scan, const std::size_t num_threads) {
+        return nc::MatchHypotheses3dQuaternion<map_t>(options(), 0.0, 0.0, 1.0, guesses, false,
+                                                      nc::Differentiation::AUTOMATIC, num_threads, scan, map);
+    });
+}
+
+TEST(Test_cslibs_ndt_3d, testCeresHypothesesRPY)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(100000);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+    cslibs_ndt::map::settle(map);
+
+    testHypotheses([&map](const poses_t &guesses, const cloud_t &scan, const std::size_t num_threads) {
+        return nc::MatchHypotheses3dRPY<map_t>(options(), 0.0, 0.0, 1.0, guesses, false,
+                                               nc::Differentiation::ANALYTIC, num_threads, scan, map);
+    });
+}
+
+TEST(Test_cslibs_ndt_3d, testCeresHypothesesOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(100000))
+        points.emplace_back(sensor_inv * p);
+
+    // settled once when handed over, the hypotheses sample it concurrently
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+    cslibs_ndt::map::settle(map);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testHypotheses([&map, &ivm](const poses_t &guesses, const cloud_t &scan, const std::size_t num_threads) {
+        return nc::MatchHypotheses3dQuaternion<map_t>(options(), 0.0, 0.0, 1.0, guesses, false,
+                                                      nc::Differentiation::AUTOMATIC, num_threads, scan, map, ivm);
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/rolling_gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/gridmap.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <set>
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+cloud_t generateCloud(const std::size_t size, const cslibs_math_3d::Point3d &center, const double extent)
+{
+    rng_t rng(-extent, extent);
+    cloud_t cloud;
+    for (std::size_t i = 0 ; i < size ; ++ i)
+        cloud.emplace_back(center(0) + rng.get(), center(1) + rng.get(), center(2) + rng.get());
+    return cloud;
+}
+
+/**
+ * @brief Samples at a few points inside of bundle bi, for maps with identity origin.
+ */
+template <typename map_t, typename ... args_t>
+std::vector<double> sampleBundle(const map_t &map, const typename map_t::index_t &bi, const args_t &...args)
+{
+    static const std::array<double,3> offsets = {{0.1, 0.5, 0.8}};
+    std::vector<double> samples;
+    for (const double o : offsets) {
+        const cslibs_math_3d::Point3d p((bi[0] + o) * map.getBundleResolution(),
+                                        (bi[1] + o) * map.getBundleResolution(),
+                                        (bi[2] + (1.0 - o)) * map.getBundleResolution());
+        samples.emplace_back(map.sampleNonNormalized(p, args...));
+    }
+    return samples;
+}
+
+bool equal(const std::vector<double> &a, const std::vector<double> &b)
+{
+    for (std::size_t i = 0 ; i < a.size() ; ++i)
+        if (a[i] != b[i] && !(std::isnan(a[i]) && std::isnan(b[i])))
+            return false;
+    return true;
+}
+
+/**
+ * @brief Every bundle whose samples differ from before is reported, bundles not reported are unchanged.
+ */
+template <typename map_t, typename ... args_t>
+void testChanges(const map_t &before, const map_t &after, const std::vector<typename map_t::index_t> &changes,
+                 const args_t &...args)
+{
+    const std::set<typename map_t::index_t> changed(changes.begin(), changes.end());
+    EXPECT_EQ(changed.size(), changes.size());
+    EXPECT_TRUE(std::is_sorted(changes.begin(), changes.end()));
+
+    std::size_t differing = 0;
+    std::vector<typename map_t::index_t> indices;
+    after.getBundleIndices(indices);
+    for (const auto &bi : indices) {
+        if (equal(sampleBundle(before, bi, args...), sampleBundle(after, bi, args...)))
+            continue;
+        EXPECT_EQ(1ul, changed.count(bi));
+        ++differing;
+    }
+    EXPECT_GT(differing, 0ul);
+    EXPECT_LT(changes.size(), indices.size());
+}
+
+TEST(Test_cslibs_ndt_3d, testChangeTrackingGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t cloud  = generateCloud(50000, cslibs_math_3d::Point3d(0.0, 0.0, 0.0), 10.0);
+    const cloud_t update = generateCloud(2000,  cslibs_math_3d::Point3d(3.0, -2.0, 1.0), 1.5);
+
+    // without tracking only the generation moves
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    EXPECT_FALSE(map.getChangeTracking());
+    EXPECT_EQ(0ul, map.getGeneration());
+    map.insert(cloud.begin(), cloud.end());
+    EXPECT_GT(map.getGeneration(), 0ul);
+    EXPECT_FALSE(map.hasChanges());
+
+    map.setChangeTracking(true);
+    const map_t before(map);
+    const std::size_t generation = map.getGeneration();
+    map.insert(update.begin(), update.end());
+    EXPECT_GT(map.getGeneration(), generation);
+    EXPECT_TRUE(map.hasChanges());
+
+    std::vector<map_t::index_t> changes;
+    EXPECT_EQ(map.getGeneration(), map.consumeChanges(changes));
+    testChanges(before, map, changes);
+
+    // consumed changes are cleared
+    EXPECT_FALSE(map.hasChanges());
+    std::vector<map_t::index_t> none;
+    map.consumeChanges(none);
+    EXPECT_TRUE(none.empty());
+
+    // the parallel insertion reports the same changes
+    map_t parallel(before);
+    parallel.setChangeTracking(true);
+    parallel.insert(update.begin(), update.end(), cslibs_math_3d::Transform3d(), cslibs_ndt::map::tags::parallel_insert);
+    std::vector<map_t::index_t> parallel_changes;
+    parallel.consumeChanges(parallel_changes);
+    EXPECT_EQ(changes, parallel_changes);
+}
+
+TEST(Test_cslibs_ndt_3d, testChangeTrackingStaticGridmap)
+{
+    using map_t = cslibs_ndt_3d::static_maps::Gridmap<double>;
+
+    const cloud_t cloud  = generateCloud(50000, cslibs_math_3d::Point3d(8.0, 8.0, 8.0), 7.9);
+    const cloud_t update = generateCloud(2000,  cslibs_math_3d::Point3d(0.5, 0.5, 0.5), 1.0);
+
+    // changes at the border of the map stay within it
+    map_t map(cslibs_math_3d::Transform3d(), 1.0, {{16ul, 16ul, 16ul}}, {{0, 0, 0}});
+    map.insert(cloud.begin(), cloud.end());
+    map.setChangeTracking(true);
+    const map_t before(map);
+    map.insert(update.begin(), update.end());
+
+    std::vector<map_t::index_t> changes;
+    map.consumeChanges(changes);
+    testChanges(before, map, changes);
+    for (const auto &bi : changes)
+        for (std::size_t k = 0 ; k < 3 ; ++k)
+            EXPECT_GE(bi[k], 0);
+}
+
+TEST(Test_cslibs_ndt_3d, testChangeTrackingOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const cloud_t scan   = generateCloud(5000, cslibs_math_3d::Point3d(0.0, 0.0, 0.0), 9.0);
+    const cloud_t update = generateCloud(200,  cslibs_math_3d::Point3d(6.0, 5.0, 0.0), 1.0);
+
+    // bundles traversed by the rays are changed as well
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(scan.begin(), scan.end(), cslibs_math_3d::Transform3d());
+    map.setChangeTracking(true);
+    const map_t before(map);
+    map.insert(update.begin(), update.end(), cslibs_math_3d::Transform3d());
+
+    std::vector<map_t::index_t> changes;
+    map.consumeChanges(changes);
+    testChanges(before, map, changes, ivm);
+
+    // disabling drops what was recorded
+    map.insert(update.begin(), update.end(), cslibs_math_3d::Transform3d());
+    EXPECT_TRUE(map.hasChanges());
+    map.setChangeTracking(false);
+    EXPECT_FALSE(map.hasChanges());
+}
+
+TEST(Test_cslibs_ndt_3d, testChangeTrackingRollingWindow)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::rolling::Gridmap<double>;
+
+    const cloud_t cloud = generateCloud(20000, cslibs_math_3d::Point3d(0.0, 0.0, 0.0), 4.0);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0, {{8.0, 8.0, 8.0}});
+    map.insert(cloud.begin(), cloud.end());
+    std::vector<map_t::index_t> indices;
+    map.getBundleIndices(indices);
+
+    // evicted bundles are reported, they are gone from the map
+    map.setChangeTracking(true);
+    map.moveWindow(cslibs_math_3d::Point3d(3.0, 0.0, 0.0));
+    std::vector<map_t::index_t> changes;
+    map.consumeChanges(changes);
+
+    std::size_t evicted = 0;
+    for (const auto &bi : indices) {
+        if (map.get(bi))
+            continue;
+        EXPECT_TRUE(std::binary_search(changes.begin(), changes.end(), bi));
+        ++evicted;
+    }
+    EXPECT_GT(evicted, 0ul);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/map/snapshot.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <atomic>
+#include <thread>
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+template <typename T>
+using CowGridmap = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,3,cslibs_ndt::Distribution,T,
+                                        cslibs_ndt::backend::CopyOnWrite>;
+template <typename T>
+using CowOccupancyGridmap = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,3,cslibs_ndt::OccupancyDistribution,T,
+                                                 cslibs_ndt::backend::CopyOnWrite>;
+
+cloud_t generateCloud(const std::size_t size, const double min, const double max)
+{
+    rng_t rng(min, max);
+    cloud_t cloud;
+    for (std::size_t i = 0 ; i < size ; ++ i)
+        cloud.emplace_back(rng.get(), rng.get(), rng.get());
+    return cloud;
+}
+
+template <typename map_t, typename... args_t>
+std::vector<double> sample(const map_t &map, const cloud_t &queries, const args_t&... args)
+{
+    std::vector<double> scores;
+    for (const auto &q : queries)
+        scores.emplace_back(map.sampleNonNormalized(q, args...));
+    return scores;
+}
+
+template <typename map_t, typename... args_t>
+std::vector<double> sampleBilinear(const map_t &map, const cloud_t &queries, const args_t&... args)
+{
+    std::vector<double> scores;
+    for (const auto &q : queries)
+        scores.emplace_back(map.sampleNonNormalizedBilinear(q, args...));
+    return scores;
+}
+
+TEST(Test_cslibs_ndt_3d, testCopyOnWriteGridmap)
+{
+    using map_t       = CowGridmap<double>;
+    using reference_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t first   = generateCloud(20000, -5.0, 5.0);
+    const cloud_t second  = generateCloud(20000, -2.0, 8.0);
+    const cloud_t queries = generateCloud(2000, -6.0, 9.0);
+
+    map_t       map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    reference_t reference(map.getInitialOrigin(), 1.0);
+    map.insert(first.begin(), first.end());
+    reference.insert(first.begin(), first.end());
+
+    const map_t::ConstPtr       snap           = cslibs_ndt::map::snapshot(map);
+    const reference_t::ConstPtr reference_snap = cslibs_ndt::map::snapshot(reference);
+    const std::vector<double> before          = sample(*snap, queries);
+    const std::vector<double> before_bilinear = sampleBilinear(*snap, queries);
+    EXPECT_EQ(before, sample(reference, queries));
+
+    // the writer copies what it touches, the snapshot keeps the state it was taken at
+    map.insert(second.begin(), second.end());
+    reference.insert(second.begin(), second.end());
+    EXPECT_EQ(before,          sample(*snap, queries));
+    EXPECT_EQ(before_bilinear, sampleBilinear(*snap, queries));
+    EXPECT_EQ(sample(reference, queries),         sample(map, queries));
+    EXPECT_EQ(sampleBilinear(reference, queries), sampleBilinear(map, queries));
+
+    std::vector<map_t::index_t> snap_indices, map_indices, reference_indices;
+    snap->getBundleIndices(snap_indices);
+    map.getBundleIndices(map_indices);
+    reference.getBundleIndices(reference_indices);
+    EXPECT_LT(snap_indices.size(), map_indices.size());
+    EXPECT_EQ(reference_indices.size(), map_indices.size());
+
+    // expanding the snapshot allocates into its own blocks only
+    snap->allocatePartiallyAllocatedBundles();
+    reference_snap->allocatePartiallyAllocatedBundles();
+    EXPECT_EQ(sample(*reference_snap, queries), sample(*snap, queries));
+    EXPECT_EQ(sample(reference, queries),       sample(map, queries));
+}
+
+TEST(Test_cslibs_ndt_3d, testCopyOnWriteOccupancyGridmap)
+{
+    using map_t       = CowOccupancyGridmap<double>;
+    using reference_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+    const cloud_t first   = generateCloud(5000, -5.0, 5.0);
+    const cloud_t second  = generateCloud(5000, -3.0, 3.0);
+    const cloud_t queries = generateCloud(2000, -6.0, 6.0);
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+
+    map_t       map(cslibs_math_3d::Transform3d(), 1.0);
+    reference_t reference(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(first.begin(), first.end(), sensor);
+    reference.insert(first.begin(), first.end(), sensor);
+
+    const map_t::ConstPtr snap = cslibs_ndt::map::snapshot(map);
+    const std::vector<double> before = sample(*snap, queries, ivm);
+    EXPECT_EQ(before, sample(reference, queries, ivm));
+
+    // free space updates rewrite shared distributions as well
+    map.insert(second.begin(), second.end(), sensor);
+    reference.insert(second.begin(), second.end(), sensor);
+    EXPECT_EQ(before, sample(*snap, queries, ivm));
+    EXPECT_EQ(sample(reference, queries, ivm), sample(map, queries, ivm));
+}
+
+TEST(Test_cslibs_ndt_3d, testCopyOnWriteSnapshotOfSnapshot)
+{
+    using map_t = CowGridmap<double>;
+
+    const cloud_t queries = generateCloud(2000, -6.0, 6.0);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    std::vector<map_t::ConstPtr>     snaps;
+    std::vector<std::vector<double>> scores;
+    for (std::size_t i = 0 ; i < 4 ; ++ i) {
+        const cloud_t cloud = generateCloud(5000, -5.0 + static_cast<double>(i), 5.0);
+        map.insert(cloud.begin(), cloud.end());
+        snaps.emplace_back(cslibs_ndt::map::snapshot(map));
+        scores.emplace_back(sample(map, queries));
+    }
+
+    // dropping the older snapshots leaves the others intact
+    snaps.front().reset();
+    snaps[2].reset();
+    EXPECT_EQ(scores[1], sample(*snaps[1], queries));
+    EXPECT_EQ(scores[3], sample(*snaps[3], queries));
+    EXPECT_EQ(scores[3], sample(map, queries));
+}
+
+TEST(Test_cslibs_ndt_3d, testCopyOnWriteConcurrentReader)
+{
+    using map_t = CowGridmap<double>;
+
+    const cloud_t first   = generateCloud(20000, -5.0, 5.0);
+    const cloud_t queries = generateCloud(1000, -6.0, 6.0);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(first.begin(), first.end());
+
+    const map_t::ConstPtr     snap   = cslibs_ndt::map::snapshot(map);
+    const std::vector<double> before = sample(*snap, queries);
+
+    // the reader only touches the snapshot, while the writer keeps inserting into the map
+    std::atomic<bool> done(false);
+    std::size_t       mismatches = 0;
+    std::thread reader([&]() {
+        while (!done.load())
+            mismatches += sample(*snap, queries) == before ? 0ul : 1ul;
+    });
+    for (std::size_t i = 0 ; i < 8 ; ++ i) {
+        const cloud_t cloud = generateCloud(5000, -3.0, 3.0 + static_cast<double>(i));
+        map.insert(cloud.begin(), cloud.end());
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(0ul, mismatches);
+}
+
+TEST(Test_cslibs_ndt_3d, testCopyOnWriteConcurrentFirstReader)
+{
+    using map_t       = CowGridmap<double>;
+    using reference_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t first   = generateCloud(20000, -5.0, 5.0);
+    const cloud_t queries = generateCloud(1000, -6.0, 6.0);
+
+    map_t       map(cslibs_math_3d::Transform3d(), 1.0);
+    reference_t reference(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(first.begin(), first.end());
+    reference.insert(first.begin(), first.end());
+
+    // nothing sampled the distributions before, the reader is the first to, while the writer
+    // copies the blocks holding them
+    const map_t::ConstPtr snap = cslibs_ndt::map::snapshot(map);
+    const std::vector<double> expected = sample(reference, queries);
+
+    std::atomic<bool> done(false);
+    std::size_t       passes     = 0;
+    std::size_t       mismatches = 0;
+    std::thread reader([&]() {
+        do {
+            mismatches += sample(*snap, queries) == expected ? 0ul : 1ul;
+            ++passes;
+        } while (!done.load());
+    });
+    for (std::size_t i = 0 ; i < 8 ; ++ i) {
+        const cloud_t cloud = generateCloud(5000, -5.0, 5.0);
+        map.insert(cloud.begin(), cloud.end());
+    }
+    done = true;
+    reader.join();
+    EXPECT_LT(0ul, passes);
+    EXPECT_EQ(0ul, mismatches);
+    EXPECT_EQ(expected, sample(*snap, queries));
+}
+
+TEST(Test_cslibs_ndt_3d, testCopyIsIndependent)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t first   = generateCloud(20000, -5.0, 5.0);
+    const cloud_t second  = generateCloud(20000, -4.0, 4.0);
+    const cloud_t queries = generateCloud(2000, -6.0, 6.0);
+
+    // a deep copy references its own distributions, neither writes to nor destruction of the source affect it
+    map_t::Ptr map(new map_t(cslibs_math_3d::Transform3d(), 1.0));
+    map->insert(first.begin(), first.end());
+    const std::vector<double> before = sample(*map, queries);
+
+    const map_t::ConstPtr copy = cslibs_ndt::map::snapshot(*map);
+    map->insert(second.begin(), second.end());
+    EXPECT_EQ(before, sample(*copy, queries));
+    map.reset();
+    EXPECT_EQ(before, sample(*copy, queries));
+}
+
+TEST(Test_cslibs_ndt_3d, testSnapshotSettlesUpdatesOnly)
+{
+    using map_t = CowGridmap<double>;
+
+    const cloud_t update  = generateCloud(2000, -1.0, 1.0);
+    const cloud_t queries = generateCloud(2000, -2.0, 2.0);
+
+    // the first snapshot settles the whole map, later ones the bundles updated since
+    std::vector<std::size_t> settled;
+    for (const double extent : {4.0, 16.0}) {
+        const cloud_t points = generateCloud(static_cast<std::size_t>(100.0 * extent * extent * extent), -extent, extent);
+        map_t map(cslibs_math_3d::Transform3d(), 1.0);
+        map.insert(points.begin(), points.end());
+        cslibs_ndt::map::snapshot(map);
+
+        // nothing to settle for an unchanged map, whatever its size
+        std::vector<map_t::index_t> unsettled;
+        cslibs_ndt::map::snapshot(map);
+        EXPECT_TRUE(map.consumeUnsettled(unsettled));
+        EXPECT_TRUE(unsettled.empty());
+
+        map.insert(update.begin(), update.end());
+        EXPECT_TRUE(map.consumeUnsettled(unsettled));
+        EXPECT_FALSE(unsettled.empty());
+        settled.emplace_back(unsettled.size());
+
+        cslibs_ndt::map::settle(map, unsettled.begin(), unsettled.end());
+        const map_t::ConstPtr snap = cslibs_ndt::map::snapshot(map);
+        EXPECT_EQ(sample(map, queries), sample(*snap, queries));
+    }
+    // the same update, the same work
+    EXPECT_EQ(settled.front(), settled.back());
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
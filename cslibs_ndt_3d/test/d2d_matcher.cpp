@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/matching/newton/match.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using map_t   = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+using scan_t  = cslibs_ndt::matching::d2d::Scan<3>;
+
+const cslibs_math_3d::Transform3d TRUTH(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+
+template <typename map_t, typename... args_t>
+void testMatch(const map_t &map, const scan_t &scan, const args_t&... args)
+{
+    const auto result = cslibs_ndt::matching::newton::match(
+                map, scan, cslibs_math_3d::Transform3d(), cslibs_ndt::matching::newton::Parameter(), args...);
+
+    EXPECT_TRUE(result.converged());
+    EXPECT_GT(result.iterations, 0ul);
+    EXPECT_GT(result.score, 0.0);
+
+    EXPECT_NEAR(result.transform.tx(), TRUTH.tx(), 0.03);
+    EXPECT_NEAR(result.transform.ty(), TRUTH.ty(), 0.03);
+    EXPECT_NEAR(result.transform.tz(), TRUTH.tz(), 0.03);
+    EXPECT_NEAR(result.transform.rotation().roll(),  TRUTH.rotation().roll(),  0.01);
+    EXPECT_NEAR(result.transform.rotation().pitch(), TRUTH.rotation().pitch(), 0.01);
+    EXPECT_NEAR(result.transform.rotation().yaw(),   TRUTH.rotation().yaw(),   0.01);
+}
+
+scan_t generateScan(const double resolution)
+{
+    const cslibs_math_3d::Transform3d truth_inv = TRUTH.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(20000))
+        points.emplace_back(truth_inv * p);
+    return scan_t::fromPoints(points.begin(), points.end(), resolution);
+}
+
+TEST(Test_cslibs_ndt_3d, testD2DScan)
+{
+    const cloud_t room = generateRoom(100000);
+    const scan_t scan = scan_t::fromPoints(room.begin(), room.end(), 1.0);
+
+    // far less distributions than points, each point is held by up to bin_count distributions
+    EXPECT_GT(scan.size(), 0ul);
+    EXPECT_LT(scan.size() * 20, room.size());
+    EXPECT_LE(scan.weight(), static_cast<double>(room.size()));
+    EXPECT_GT(scan.weight(), 0.9 * static_cast<double>(room.size()));
+    for (const auto &s : scan) {
+        EXPECT_GT(s.weight, 0.0);
+        EXPECT_GE(s.mean(0), -0.1);
+        EXPECT_LE(s.mean(0), 10.1);
+        EXPECT_GE(s.covariance.determinant(), 0.0);
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testD2DDerivatives)
+{
+    using objective_t = cslibs_ndt::matching::newton::D2DObjective<map_t>;
+
+    const cloud_t room = generateRoom(50000);
+    map_t map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    map.insert(room.begin(), room.end());
+    const scan_t scan = generateScan(1.0);
+
+    const objective_t objective(map);
+    objective_t::vector_t x;
+    x << 0.25, -0.15, 0.05, 0.01, -0.02, 0.08;
+    objective_t::model_t model;
+    model.update(x);
+
+    objective_t::vector_t  g;
+    objective_t::hessian_t H;
+    objective.evaluate(model, scan, &g, &H);
+
+    // central differences of the score and of the analytic gradient
+    const double h = 1e-6;
+    for (std::size_t i = 0 ; i < 6 ; ++ i) {
+        objective_t::vector_t xp = x, xm = x;
+        xp(i) += h;
+        xm(i) -= h;
+        objective_t::model_t mp, mm;
+        mp.update(xp);
+        mm.update(xm);
+        objective_t::vector_t  gp, gm;
+        objective_t::hessian_t Hp, Hm;
+        const double dscore = (objective.evaluate(mp, scan, &gp, &Hp) - objective.evaluate(mm, scan, &gm, &Hm)) / (2.0 * h);
+        EXPECT_NEAR(g(i), dscore, 1e-4 * (1.0 + std::fabs(dscore)));
+        for (std::size_t j = 0 ; j < 6 ; ++ j) {
+            const double dg = (gp(j) - gm(j)) / (2.0 * h);
+            EXPECT_NEAR(H(j, i), dg, 1e-3 * (1.0 + std::fabs(dg)));
+        }
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testD2DGridmap)
+{
+    const cloud_t room = generateRoom(100000);
+    map_t map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testMatch(map, generateScan(1.0));
+}
+
+TEST(Test_cslibs_ndt_3d, testD2DOccupancyGridmap)
+{
+    using occ_map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    // scanned from the center of the room
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(100000))
+        points.emplace_back(sensor_inv * p);
+
+    occ_map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testMatch(map, generateScan(1.0), ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testD2DEmpty)
+{
+    const cloud_t room = generateRoom(10000);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+
+    const auto result = cslibs_ndt::matching::newton::match(map, scan_t(), cslibs_math_3d::Transform3d());
+    EXPECT_EQ(cslibs_ndt::matching::newton::Termination::NO_POINTS, result.termination);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
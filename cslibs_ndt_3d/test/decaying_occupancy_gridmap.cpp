@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/conversion/map.hpp>
+#include <cslibs_ndt/map/snapshot.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+const std::size_t NUM_SAMPLES = 10000;
+
+using rng_t = cslibs_math::random::Uniform<double,1>;
+using ivm_t = cslibs_gridmaps::utility::InverseModel<double>;
+
+cslibs_math_3d::Pointcloud3d::Ptr generateCloud()
+{
+    rng_t rng_coord(-10.0, 10.0);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i) {
+        const cslibs_math_3d::Point3d p(rng_coord.get(), rng_coord.get(), rng_coord.get());
+        cloud->insert(p);
+    }
+    return cloud;
+}
+
+std::vector<cslibs_math_3d::Point3d> generateQueries()
+{
+    rng_t rng_coord(-10.0, 10.0);
+    std::vector<cslibs_math_3d::Point3d> queries;
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i)
+        queries.emplace_back(rng_coord.get(), rng_coord.get(), rng_coord.get());
+    return queries;
+}
+
+bool equal(const double a, const double b)
+{
+    // degenerate distributions evaluate to NaN in both maps
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+template <typename map_t, typename decaying_map_t>
+void testEqual(const map_t &map, const decaying_map_t &decaying, const ivm_t::Ptr &ivm)
+{
+    for (const auto &q : generateQueries())
+        EXPECT_TRUE(equal(map.sampleNonNormalized(q, ivm), decaying.sampleNonNormalized(q, ivm)));
+}
+
+TEST(Test_cslibs_ndt_3d, testDecayingOccupancyDistribution)
+{
+    using distribution_t = cslibs_ndt::DecayingOccupancyDistribution<double,3>;
+    using clock_t        = distribution_t::clock_t;
+
+    const ivm_t ivm(0.5, 0.45, 0.65);
+    const std::shared_ptr<clock_t> clock(new clock_t(2.0, 1.0));
+
+    distribution_t d;
+    d.setClock(clock);
+    d.updateFree(4);
+    d.updateOccupied(cslibs_math_3d::Point3d(0.1, 0.2, 0.3));
+    d.updateOccupied(cslibs_math_3d::Point3d(0.2, 0.1, 0.4));
+    EXPECT_EQ(1.0, d.getStamp());
+    EXPECT_EQ(4.0, d.weightFree());
+    EXPECT_EQ(2.0, d.weightOccupied());
+
+    // reads decay lazily, the stored state is left untouched
+    const double occupancy = d.getOccupancy(ivm);
+    clock->setTime(5.0);
+    EXPECT_EQ(1.0,  d.getStamp());
+    EXPECT_EQ(1.0,  d.weightFree());
+    EXPECT_EQ(0.5,  d.weightOccupied());
+    EXPECT_EQ(2ul,  d.numOccupied());
+    EXPECT_NE(occupancy, d.getOccupancy(ivm));
+
+    // the next update applies the decay and moves the stamp
+    d.updateFree();
+    EXPECT_EQ(5.0, d.getStamp());
+    EXPECT_EQ(2.0, d.weightFree());
+    EXPECT_EQ(0.5, d.weightOccupied());
+
+    // without evidence left the occupancy returns to the prior
+    clock->setTime(1e4);
+    EXPECT_NEAR(ivm.getProbPrior(), d.getOccupancy(ivm), 1e-9);
+
+    // and the Gaussian is estimated anew
+    d.updateOccupied(cslibs_math_3d::Point3d(0.3, 0.3, 0.3));
+    EXPECT_EQ(1ul, d.numOccupied());
+    EXPECT_EQ(1.0, d.weightOccupied());
+}
+
+TEST(Test_cslibs_ndt_3d, testDynamicDecayingOccupancyGridmap)
+{
+    using map_t          = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+    using decaying_map_t = cslibs_ndt_3d::dynamic_maps::DecayingOccupancyGridmap<double>;
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(1.0, -2.0, 0.5));
+    const cslibs_math_3d::Transform3d points_origin(cslibs_math_3d::Vector3d(0.5, 0.25, -1.0));
+
+    // with an infinite half-life nothing decays, the map equals an ordinary occupancy map
+    map_t          map(origin, 1.0);
+    decaying_map_t decaying(origin, 1.0);
+    EXPECT_TRUE(std::isinf(decaying.getHalfLife()));
+    for (std::size_t i = 0 ; i < 2 ; ++ i) {
+        const auto cloud = generateCloud();
+        map.insert(cloud, points_origin);
+        decaying.setTime(static_cast<double>(i));
+        decaying.insert(cloud, points_origin);
+    }
+    decaying.setTime(100.0);
+    testEqual(map, decaying, ivm);
+
+    const std::vector<cslibs_math_3d::Point3d> queries = generateQueries();
+    std::vector<double> before;
+    for (const auto &q : queries)
+        before.emplace_back(decaying.sampleNonNormalized(q, ivm));
+
+    // once decaying, every cell goes back to the prior by reading at a later time only
+    decaying.setHalfLife(1.0);
+
+    // copies own a clock of their own, the copy keeps the time it was taken at
+    decaying_map_t copy(decaying);
+    EXPECT_NE(decaying.getClock(), copy.getClock());
+    EXPECT_EQ(decaying.getTime(),     copy.getTime());
+    EXPECT_EQ(decaying.getHalfLife(), copy.getHalfLife());
+
+    decaying.setTime(200.0);
+    EXPECT_EQ(100.0, copy.getTime());
+    std::size_t changed = 0;
+    for (std::size_t i = 0 ; i < queries.size() ; ++ i) {
+        const double s = decaying.sampleNonNormalized(queries[i], ivm);
+        EXPECT_TRUE(equal(before[i], copy.sampleNonNormalized(queries[i], ivm)));
+        if (!equal(s, before[i]))
+            ++changed;
+    }
+    EXPECT_GT(changed, 0ul);
+
+    // all distributions of the copy follow its clock
+    copy.setTime(200.0);
+    for (const auto &q : queries)
+        EXPECT_TRUE(equal(decaying.sampleNonNormalized(q, ivm), copy.sampleNonNormalized(q, ivm)));
+
+    // reads left the stored evidence untouched
+    decaying.setHalfLife(std::numeric_limits<double>::infinity());
+    for (std::size_t i = 0 ; i < queries.size() ; ++ i)
+        EXPECT_TRUE(equal(before[i], decaying.sampleNonNormalized(queries[i], ivm)));
+}
+
+TEST(Test_cslibs_ndt_3d, testDecayingOccupancyGridmapForgets)
+{
+    using map_t          = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+    using decaying_map_t = cslibs_ndt_3d::dynamic_maps::DecayingOccupancyGridmap<double>;
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const cslibs_math_3d::Transform3d points_origin(cslibs_math_3d::Vector3d(0.5, 0.25, -1.0));
+
+    // evidence many half-lifes old does not count anymore, neither its weight nor its Gaussian
+    const auto cloud = generateCloud();
+    map_t          map(cslibs_math_3d::Transform3d(), 1.0);
+    decaying_map_t decaying(cslibs_math_3d::Transform3d(), 1.0);
+    decaying.setHalfLife(1.0);
+    for (std::size_t i = 0 ; i < 3 ; ++ i) {
+        decaying.setTime(1e4 * static_cast<double>(i));
+        decaying.insert(cloud, points_origin);
+    }
+    map.insert(cloud, points_origin);
+    testEqual(map, decaying, ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testDecayingOccupancyGridmapSnapshot)
+{
+    using decaying_map_t = cslibs_ndt_3d::dynamic_maps::DecayingOccupancyGridmap<double>;
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const std::vector<cslibs_math_3d::Point3d> queries = generateQueries();
+
+    decaying_map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.setHalfLife(1.0);
+    map.setTime(0.0);
+    map.insert(generateCloud());
+
+    // the writer moving the time on neither changes nor races with reads of the snapshot
+    const decaying_map_t::ConstPtr snap = cslibs_ndt::map::snapshot(map);
+    std::vector<double> before;
+    for (const auto &q : queries)
+        before.emplace_back(snap->sampleNonNormalized(q, ivm));
+
+    map.setTime(5.0);
+    map.insert(generateCloud());
+    EXPECT_EQ(0.0, snap->getTime());
+    for (std::size_t i = 0 ; i < queries.size() ; ++ i)
+        EXPECT_TRUE(equal(before[i], snap->sampleNonNormalized(queries[i], ivm)));
+}
+
+TEST(Test_cslibs_ndt_3d, testStaticDecayingOccupancyGridmapConversion)
+{
+    using map_t         = cslibs_ndt_3d::static_maps::DecayingOccupancyGridmap<double>;
+    using dynamic_map_t = cslibs_ndt_3d::dynamic_maps::DecayingOccupancyGridmap<double>;
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(-8.0, -8.0, -8.0));
+    const typename map_t::size_t size = {{8ul, 8ul, 8ul}};
+    const typename map_t::index_t min_index = {{0, 0, 0}};
+
+    typename map_t::Ptr map(new map_t(origin, 2.0, size, min_index));
+    map->setHalfLife(10.0);
+    map->setTime(0.0);
+    map->insert(generateCloud());
+    map->setTime(5.0);
+
+    // converted maps read the same, also after the time moved on
+    using convert_t = cslibs_ndt::conversion::convert<
+        cslibs_ndt::map::tags::dynamic_map, cslibs_ndt::map::tags::static_map,
+        3, cslibs_ndt::DecayingOccupancyDistribution, double>;
+    const typename dynamic_map_t::Ptr converted = convert_t::from(map);
+    ASSERT_NE(converted, nullptr);
+    EXPECT_NE(map->getClock(), converted->getClock());
+    EXPECT_EQ(5.0, converted->getTime());
+    testEqual(*map, *converted, ivm);
+
+    // the converted map has its own clock
+    map->setTime(20.0);
+    EXPECT_EQ(5.0, converted->getTime());
+    converted->setTime(20.0);
+    testEqual(*map, *converted, ivm);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
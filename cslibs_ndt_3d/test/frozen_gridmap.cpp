@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+const std::size_t NUM_SAMPLES = 20000;
+
+using rng_t = cslibs_math::random::Uniform<double,1>;
+using ivm_t = cslibs_gridmaps::utility::InverseModel<double>;
+
+cslibs_math_3d::Pointcloud3d::Ptr generateCloud()
+{
+    rng_t rng_coord(-10.0, 10.0);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i)
+        cloud->insert(cslibs_math_3d::Point3d(rng_coord.get(), rng_coord.get(), rng_coord.get()));
+    return cloud;
+}
+
+template <typename map_t, typename frozen_t, typename... args_t>
+void testSamples(const map_t &map, const frozen_t &frozen, const args_t&... args)
+{
+    rng_t rng_coord(-12.0, 12.0);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i) {
+        const cslibs_math_3d::Point3d p(rng_coord.get(), rng_coord.get(), rng_coord.get());
+        EXPECT_NEAR(map.sampleNonNormalized(p, args...),         frozen.sampleNonNormalized(p, args...),         1e-9);
+        EXPECT_NEAR(map.sampleNonNormalizedBilinear(p, args...), frozen.sampleNonNormalizedBilinear(p, args...), 1e-9);
+    }
+}
+
+template <typename map_t, typename frozen_t>
+void testBundles(const map_t &map, const frozen_t &frozen)
+{
+    using index_t = std::array<int, 3>;
+
+    std::size_t bundles = 0;
+    map.traverse([&frozen, &bundles](const index_t &bi, const typename map_t::distribution_bundle_t &b) {
+        const typename frozen_t::distribution_bundle_t *bb = frozen.get(bi);
+        ASSERT_NE(bb, nullptr);
+        ++bundles;
+
+        // the accessors the matchers use
+        for (std::size_t i = 0 ; i < map_t::bin_count ; ++ i) {
+            const auto &d  = b.at(i);
+            const auto &dd = bb->at(i);
+            EXPECT_EQ(static_cast<bool>(d), static_cast<bool>(dd));
+            if (!d || !d->valid())
+                continue;
+
+            ASSERT_TRUE(dd->valid());
+            for (std::size_t j = 0 ; j < 3 ; ++ j) {
+                EXPECT_EQ(d->getMean()(j), dd->getMean()(j));
+                for (std::size_t k = 0 ; k < 3 ; ++ k)
+                    EXPECT_NEAR(d->getInformationMatrix()(j, k), dd->getInformationMatrix()(j, k), 1e-9);
+            }
+        }
+    });
+
+    std::size_t frozen_bundles = 0;
+    frozen.traverse([&frozen_bundles](const index_t &, const typename frozen_t::distribution_bundle_t &) {
+        ++frozen_bundles;
+    });
+    EXPECT_EQ(bundles, frozen_bundles);
+}
+
+TEST(Test_cslibs_ndt_3d, testFrozenDynamicGridmap)
+{
+    using map_t    = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+    using frozen_t = cslibs_ndt::map::FrozenMap<cslibs_ndt::map::tags::dynamic_map,3,cslibs_ndt::Distribution,double>;
+
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(1.0, -2.0, 0.5));
+    map_t map(origin, 1.0);
+    map.insert(generateCloud());
+
+    const frozen_t frozen(map);
+    testBundles(map, frozen);
+    testSamples(map, frozen);
+
+    // serial build and copies are identical
+    const frozen_t serial(map, 1ul);
+    const frozen_t copy(serial);
+    testBundles(map, copy);
+    testSamples(map, copy);
+}
+
+TEST(Test_cslibs_ndt_3d, testFrozenStaticGridmap)
+{
+    using map_t    = cslibs_ndt_3d::static_maps::Gridmap<double>;
+    using frozen_t = cslibs_ndt::map::FrozenMap<cslibs_ndt::map::tags::static_map,3,cslibs_ndt::Distribution,double>;
+
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(-8.0, -8.0, -8.0));
+    const typename map_t::size_t size = {{8ul, 8ul, 8ul}};
+    const typename map_t::index_t min_index = {{0, 0, 0}};
+
+    map_t map(origin, 2.0, size, min_index);
+    map.insert(generateCloud());
+
+    const frozen_t frozen(map);
+    testBundles(map, frozen);
+    testSamples(map, frozen);
+}
+
+TEST(Test_cslibs_ndt_3d, testFrozenOccupancyGridmap)
+{
+    using map_t    = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+    using frozen_t = cslibs_ndt::map::FrozenMap<cslibs_ndt::map::tags::dynamic_map,3,cslibs_ndt::OccupancyDistribution,double>;
+
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(1.0, -2.0, 0.5));
+    map_t map(origin, 1.0);
+    map.insert(generateCloud());
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const frozen_t frozen(map, ivm);
+    testSamples(map, frozen, ivm);
+
+    using index_t = std::array<int, 3>;
+    map.traverse([&frozen, &ivm](const index_t &bi, const typename map_t::distribution_bundle_t &b) {
+        const typename frozen_t::distribution_bundle_t *bb = frozen.get(bi);
+        ASSERT_NE(bb, nullptr);
+        for (std::size_t i = 0 ; i < map_t::bin_count ; ++ i) {
+            EXPECT_EQ(b.at(i)->getOccupancy(ivm), bb->at(i)->getOccupancy(ivm));
+            EXPECT_EQ(static_cast<bool>(b.at(i)->getDistribution()), bb->at(i)->getDistribution() != nullptr);
+        }
+    });
+
+    // the occupancies are compiled, any other inverse model is rejected, even an equal one
+    EXPECT_EQ(ivm, frozen.getInverseModel());
+    const frozen_t copy(frozen);
+    testSamples(map, copy, ivm);
+
+    const ivm_t::Ptr other(new ivm_t(0.5, 0.45, 0.65));
+    const cslibs_math_3d::Point3d p(1.5, -1.0, 0.5);
+    EXPECT_THROW(frozen.sampleNonNormalized(p, other), std::runtime_error);
+    EXPECT_THROW(frozen.sampleNonNormalizedBilinear(p, other), std::runtime_error);
+    EXPECT_THROW(frozen.sampleNonNormalized(p, ivm_t::Ptr()), std::runtime_error);
+
+    std::vector<index_t> indices;
+    frozen.getBundleIndices(indices);
+    ASSERT_FALSE(indices.empty());
+    EXPECT_THROW(frozen.get(indices.front())->at(0)->getOccupancy(other), std::runtime_error);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
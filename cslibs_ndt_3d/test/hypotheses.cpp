@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/matching/newton/hypotheses.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <limits>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+using poses_t = std::vector<cslibs_math_3d::Transform3d>;
+
+poses_t generateGuesses(const cslibs_math_3d::Transform3d &truth, const std::size_t size)
+{
+    rng_t rng_trans(-0.3, 0.3), rng_r(-0.05, 0.05);
+
+    poses_t guesses;
+    for (std::size_t i = 0 ; i < size ; ++ i)
+        guesses.emplace_back(truth * cslibs_math_3d::Transform3d(rng_trans.get(), rng_trans.get(), rng_trans.get(),
+                                                                 rng_r.get(), rng_r.get(), rng_r.get()));
+    // far off, no overlap at all
+    guesses.emplace_back(100.0, 100.0, 100.0, 0.0, 0.0, 0.0);
+    return guesses;
+}
+
+template <typename map_t, typename... args_t>
+void testHypotheses(const map_t &map, const args_t&... args)
+{
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+
+    cloud_t scan;
+    for (const auto &p : generateRoom(5000))
+        scan.emplace_back(truth_inv * p);
+
+    // settled once when handed over, the hypotheses only read it
+    cslibs_ndt::map::settle(map);
+
+    const poses_t guesses = generateGuesses(truth, 16);
+    const cslibs_ndt::matching::newton::Parameter parameter;
+    const auto results = cslibs_ndt::matching::newton::matchHypotheses(map, scan, guesses, parameter, 4ul, args...);
+    ASSERT_EQ(guesses.size(), results.size());
+
+    for (std::size_t i = 0 ; i < guesses.size() ; ++ i) {
+        // same as matching each hypothesis on its own
+        const auto single = cslibs_ndt::matching::newton::match(map, scan, guesses[i], parameter, args...);
+        EXPECT_EQ(single.termination, results[i].termination);
+        EXPECT_EQ(single.iterations,  results[i].iterations);
+        EXPECT_EQ(single.evaluations, results[i].evaluations);
+        EXPECT_NEAR(single.score,                results[i].score,                1e-12);
+        EXPECT_NEAR(single.transform.tx(),       results[i].transform.tx(),       1e-12);
+        EXPECT_NEAR(single.transform.ty(),       results[i].transform.ty(),       1e-12);
+        EXPECT_NEAR(single.transform.tz(),       results[i].transform.tz(),       1e-12);
+        EXPECT_NEAR(single.transform.rotation().yaw(), results[i].transform.rotation().yaw(), 1e-12);
+    }
+
+    // the hypotheses near the truth converge to it
+    for (std::size_t i = 0 ; i + 1 < guesses.size() ; ++ i) {
+        EXPECT_NEAR(results[i].transform.tx(), truth.tx(), 0.02);
+        EXPECT_NEAR(results[i].transform.ty(), truth.ty(), 0.02);
+        EXPECT_NEAR(results[i].transform.rotation().yaw(), truth.rotation().yaw(), 0.005);
+    }
+    EXPECT_EQ(cslibs_ndt::matching::newton::Termination::NO_PROGRESS, results.back().termination);
+}
+
+TEST(Test_cslibs_ndt_3d, testHypothesesGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(100000);
+    map_t map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testHypotheses(map);
+}
+
+TEST(Test_cslibs_ndt_3d, testHypothesesOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(100000))
+        scan.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(scan.begin(), scan.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testHypotheses(map, ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testHypothesesNonFinitePoints)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(20000);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+    cslibs_ndt::map::settle(map);
+
+    // non-finite points are dropped before matching
+    cloud_t scan(room.begin(), room.begin() + 2000);
+    cloud_t scan_nan = scan;
+    scan_nan.emplace_back(std::numeric_limits<double>::quiet_NaN(), 0.0, 0.0);
+
+    const poses_t guesses{cslibs_math_3d::Transform3d(0.1, 0.0, 0.0, 0.0, 0.0, 0.02)};
+    const auto results = cslibs_ndt::matching::newton::matchHypotheses(map, scan_nan, guesses);
+    const auto single  = cslibs_ndt::matching::newton::match(map, scan, guesses.front());
+    ASSERT_EQ(1ul, results.size());
+    EXPECT_EQ(single.iterations, results.front().iterations);
+    EXPECT_NEAR(single.score, results.front().score, 1e-12);
+
+    const auto none = cslibs_ndt::matching::newton::matchHypotheses(map, scan, poses_t());
+    EXPECT_TRUE(none.empty());
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
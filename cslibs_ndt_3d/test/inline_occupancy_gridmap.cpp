@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/occupancy_gridmap.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <limits>
+
+const std::size_t NUM_SAMPLES = 10000;
+
+using rng_t = cslibs_math::random::Uniform<double,1>;
+using ivm_t = cslibs_gridmaps::utility::InverseModel<double>;
+
+cslibs_math_3d::Pointcloud3d::Ptr generateCloud()
+{
+    rng_t rng_coord(-10.0, 10.0);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i) {
+        const cslibs_math_3d::Point3d p(rng_coord.get(), rng_coord.get(), rng_coord.get());
+        cloud->insert(p);
+    }
+    return cloud;
+}
+
+template <typename map_t, typename inline_map_t>
+void testEqual(const typename map_t::Ptr        &shared,
+               const typename inline_map_t::Ptr &inlined)
+{
+    using index_t   = std::array<int, 3>;
+    using db_t      = typename map_t::distribution_bundle_t;
+    using inline_db_t = typename inline_map_t::distribution_bundle_t;
+
+    std::size_t bundles = 0;
+    shared->traverse([&inlined, &bundles](const index_t& bi, const db_t& b) {
+        const inline_db_t* bb = inlined->get(bi);
+        EXPECT_NE(bb, nullptr);
+        if (!bb)
+            return;
+
+        ++bundles;
+        for (std::size_t i = 0 ; i < map_t::bin_count ; ++ i) {
+            const auto &d  = *(b.at(i));
+            const auto &dd = *(bb->at(i));
+            EXPECT_EQ(d.numFree(),     dd.numFree());
+            EXPECT_EQ(d.numOccupied(), dd.numOccupied());
+            EXPECT_EQ(static_cast<bool>(d.getDistribution()), dd.getDistribution() != nullptr);
+            if (!d.getDistribution() || !dd.getDistribution())
+                continue;
+
+            // bit-identical, no tolerance
+            for (std::size_t j = 0 ; j < 3 ; ++ j)
+                EXPECT_EQ(d.getDistribution()->getMean()(j), dd.getDistribution()->getMean()(j));
+        }
+    });
+
+    std::size_t inline_bundles = 0;
+    inlined->traverse([&inline_bundles](const index_t&, const inline_db_t&) {
+        ++inline_bundles;
+    });
+    EXPECT_EQ(bundles, inline_bundles);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    rng_t rng_coord(-10.0, 10.0);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i) {
+        const cslibs_math_3d::Point3d p(rng_coord.get(), rng_coord.get(), rng_coord.get());
+        const double s  = shared->sampleNonNormalized(p, ivm);
+        const double si = inlined->sampleNonNormalized(p, ivm);
+        // degenerate distributions evaluate to NaN in both maps
+        EXPECT_TRUE(s == si || (std::isnan(s) && std::isnan(si)));
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testDynamicInlineOccupancyGridmap)
+{
+    using map_t        = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+    using inline_map_t = cslibs_ndt_3d::dynamic_maps::InlineOccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(1.0, -2.0, 0.5));
+    const cslibs_math_3d::Transform3d points_origin(cslibs_math_3d::Vector3d(0.5, 0.25, -1.0));
+
+    typename map_t::Ptr        shared(new map_t(origin, 1.0));
+    typename inline_map_t::Ptr inlined(new inline_map_t(origin, 1.0));
+
+    // insert twice to also cover updates of already occupied distributions
+    for (std::size_t i = 0 ; i < 2 ; ++ i) {
+        const auto cloud = generateCloud();
+        shared->insert(cloud, points_origin);
+        inlined->insert(cloud, points_origin);
+    }
+    testEqual<map_t, inline_map_t>(shared, inlined);
+
+    // copies are deep, updating the originals leaves them untouched
+    typename map_t::Ptr        shared_copy(new map_t(*shared));
+    typename inline_map_t::Ptr inlined_copy(new inline_map_t(*inlined));
+    const auto cloud = generateCloud();
+    shared->insert(cloud, points_origin);
+    inlined->insert(cloud, points_origin);
+    testEqual<map_t, inline_map_t>(shared_copy, inlined_copy);
+    testEqual<map_t, inline_map_t>(shared, inlined);
+}
+
+TEST(Test_cslibs_ndt_3d, testStaticInlineOccupancyGridmap)
+{
+    using map_t        = cslibs_ndt_3d::static_maps::OccupancyGridmap<double>;
+    using inline_map_t = cslibs_ndt_3d::static_maps::InlineOccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(-8.0, -8.0, -8.0));
+    const typename map_t::size_t size = {{8ul, 8ul, 8ul}};
+    const typename map_t::index_t min_index = {{0, 0, 0}};
+
+    typename map_t::Ptr        shared(new map_t(origin, 2.0, size, min_index));
+    typename inline_map_t::Ptr inlined(new inline_map_t(origin, 2.0, size, min_index));
+
+    const auto cloud = generateCloud();
+    shared->insert(cloud);
+    inlined->insert(cloud);
+    testEqual<map_t, inline_map_t>(shared, inlined);
+}
+
+/**
+ * @brief Lidar scan of a box shaped room, most traversed cells only see free updates.
+ */
+cslibs_math_3d::Pointcloud3d::Ptr generateScan()
+{
+    const std::size_t rings = 32;
+    const std::size_t beams = 512;
+    const Eigen::Vector3d room_min(-12.0, -8.0, -1.5);
+    const Eigen::Vector3d room_max( 15.0, 10.0,  3.0);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t r = 0 ; r < rings ; ++ r) {
+        const double elevation = -0.4 + 0.8 * static_cast<double>(r) / static_cast<double>(rings);
+        for (std::size_t b = 0 ; b < beams ; ++ b) {
+            const double azimuth = -M_PI + 2.0 * M_PI * static_cast<double>(b) / static_cast<double>(beams);
+            const Eigen::Vector3d dir(std::cos(elevation) * std::cos(azimuth),
+                                      std::cos(elevation) * std::sin(azimuth),
+                                      std::sin(elevation));
+            double range = std::numeric_limits<double>::max();
+            for (std::size_t j = 0 ; j < 3 ; ++ j) {
+                if (dir(j) > 0.0)
+                    range = std::min(range, room_max(j) / dir(j));
+                else if (dir(j) < 0.0)
+                    range = std::min(range, room_min(j) / dir(j));
+            }
+            cloud->insert(cslibs_math_3d::Point3d(range * dir(0), range * dir(1), range * dir(2)));
+        }
+    }
+    return cloud;
+}
+
+/**
+ * @brief Sums byte_size() of all distributions, split into occupied and free-only cells.
+ */
+template <typename map_t>
+void distributionBytes(const map_t &map, std::size_t &occupied_bytes, std::size_t &free_bytes,
+                       std::size_t &occupied, std::size_t &free_only)
+{
+    using index_t = std::array<int, 3>;
+    occupied_bytes = free_bytes = occupied = free_only = 0ul;
+    for (const auto &storage : map.getStorages()) {
+        storage->traverse([&](const index_t&, const typename map_t::distribution_t &d) {
+            if (d.getDistribution()) {
+                occupied_bytes += d.byte_size();
+                ++occupied;
+            } else {
+                free_bytes += d.byte_size();
+                ++free_only;
+            }
+        });
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testInlineOccupancyByteSize)
+{
+    using map_t        = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+    using inline_map_t = cslibs_ndt_3d::dynamic_maps::InlineOccupancyGridmap<double>;
+    using shared_distribution_t = typename map_t::distribution_t;
+    using inline_distribution_t = typename inline_map_t::distribution_t;
+    using distribution_t        = typename inline_distribution_t::distribution_t;
+
+    // the distribution and one word for free count and valid bit, up to alignment
+    EXPECT_LE(sizeof(inline_distribution_t), sizeof(distribution_t) + 16ul);
+
+    const cslibs_math_3d::Transform3d origin;
+    typename map_t::Ptr        shared(new map_t(origin, 0.5));
+    typename inline_map_t::Ptr inlined(new inline_map_t(origin, 0.5));
+
+    const auto scan = generateScan();
+    shared->insert(scan);
+    inlined->insert(scan);
+
+    std::size_t occupied_bytes, free_bytes, occupied, free_only;
+    std::size_t inline_occupied_bytes, inline_free_bytes, inline_occupied, inline_free_only;
+    distributionBytes(*shared,  occupied_bytes, free_bytes, occupied, free_only);
+    distributionBytes(*inlined, inline_occupied_bytes, inline_free_bytes, inline_occupied, inline_free_only);
+    ASSERT_EQ(occupied,  inline_occupied);
+    ASSERT_EQ(free_only, inline_free_only);
+    ASSERT_GT(occupied,  0ul);
+    ASSERT_GT(free_only, 0ul);
+
+    // occupied cells: the shared layout pays its header on top of the same distribution, and
+    // a heap block plus a control block which byte_size() does not even account for
+    const double occupied_ratio = static_cast<double>(occupied_bytes) / static_cast<double>(inline_occupied_bytes);
+    EXPECT_GE(occupied_ratio, 1.0);
+    EXPECT_NEAR(occupied_ratio,
+                static_cast<double>(sizeof(shared_distribution_t) + sizeof(distribution_t)) /
+                static_cast<double>(sizeof(inline_distribution_t)), 1e-12);
+
+    // free-only cells carry the unused distribution inline
+    const double free_ratio = static_cast<double>(inline_free_bytes) / static_cast<double>(free_bytes);
+    EXPECT_NEAR(free_ratio,
+                static_cast<double>(sizeof(inline_distribution_t)) /
+                static_cast<double>(sizeof(shared_distribution_t)), 1e-12);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
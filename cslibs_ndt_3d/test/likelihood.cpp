@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/map/likelihood.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <cmath>
+#include <limits>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+using poses_t = std::vector<cslibs_math_3d::Transform3d>;
+
+poses_t generateParticles(const cslibs_math_3d::Transform3d &truth, const std::size_t size)
+{
+    rng_t rng_trans(-0.5, 0.5), rng_r(-0.1, 0.1);
+
+    poses_t particles{truth};
+    for (std::size_t i = 1 ; i < size ; ++ i)
+        particles.emplace_back(truth * cslibs_math_3d::Transform3d(rng_trans.get(), rng_trans.get(), rng_trans.get(),
+                                                                   rng_r.get(), rng_r.get(), rng_r.get()));
+    // far off, no overlap at all
+    particles.emplace_back(100.0, 100.0, 100.0, 0.0, 0.0, 0.0);
+    return particles;
+}
+
+template <typename map_t, typename... args_t>
+void testLikelihoods(const map_t &map, const args_t&... args)
+{
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+
+    cloud_t scan;
+    for (const auto &p : generateRoom(500, false))
+        scan.emplace_back(truth_inv * p);
+
+    const poses_t particles = generateParticles(truth, 64);
+
+    // settled once when handed over, the calls below only read it
+    cslibs_ndt::map::settle(map);
+
+    cslibs_ndt::map::LikelihoodModel model;
+    model.block_size = 2000;    // several blocks per thread
+    for (const bool bilinear : {false, true}) {
+        model.bilinear = bilinear;
+        // several threads first, on a map which has only been settled
+        const std::vector<double> multi  = cslibs_ndt::map::logLikelihoods(map, scan, particles, model, 4ul, args...);
+        const std::vector<double> single = cslibs_ndt::map::logLikelihoods(map, scan, particles, model, 1ul, args...);
+        ASSERT_EQ(particles.size(), single.size());
+        ASSERT_EQ(particles.size(), multi.size());
+
+        for (std::size_t i = 0 ; i < particles.size() ; ++ i) {
+            // same as summing the point scores of each particle on its own
+            double expected = 0.0;
+            for (const auto &p : scan) {
+                const cslibs_math_3d::Point3d q = particles[i] * p;
+                const double s = bilinear ? map.sampleNonNormalizedBilinear(q, args...) : map.sampleNonNormalized(q, args...);
+                expected += std::log(model.hit * s + model.random);
+            }
+            EXPECT_NEAR(expected, single[i], 1e-6 * std::fabs(expected));
+            EXPECT_NEAR(single[i], multi[i], 1e-9 * std::fabs(expected));
+        }
+
+        // the true pose explains the scan best, the far off particle only hits the uniform part
+        for (std::size_t i = 1 ; i < particles.size() ; ++ i)
+            EXPECT_GE(single.front(), single[i]);
+        EXPECT_NEAR(static_cast<double>(scan.size()) * std::log(model.random), single.back(), 1e-9);
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testLikelihoodsGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(100000, false);
+    map_t map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testLikelihoods(map);
+}
+
+TEST(Test_cslibs_ndt_3d, testLikelihoodsOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(100000, false))
+        scan.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(scan.begin(), scan.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testLikelihoods(map, ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testLikelihoodsNonFinitePoints)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(20000, false);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+    cslibs_ndt::map::settle(map);
+
+    // non-finite points are dropped
+    cloud_t scan(room.begin(), room.begin() + 200);
+    cloud_t scan_nan = scan;
+    scan_nan.emplace_back(std::numeric_limits<double>::quiet_NaN(), 0.0, 0.0);
+
+    const poses_t particles = generateParticles(cslibs_math_3d::Transform3d(), 8);
+    const std::vector<double> expected = cslibs_ndt::map::logLikelihoods(map, scan, particles);
+    const std::vector<double> result   = cslibs_ndt::map::logLikelihoods(map, scan_nan, particles);
+    ASSERT_EQ(expected.size(), result.size());
+    for (std::size_t i = 0 ; i < particles.size() ; ++ i)
+        EXPECT_NEAR(expected[i], result[i], 1e-12);
+
+    EXPECT_TRUE(cslibs_ndt::map::logLikelihoods(map, scan, poses_t()).empty());
+    const std::vector<double> none = cslibs_ndt::map::logLikelihoods(map, cloud_t(), particles);
+    ASSERT_EQ(particles.size(), none.size());
+    for (const double l : none)
+        EXPECT_EQ(0.0, l);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
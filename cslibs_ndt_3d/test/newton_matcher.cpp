@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/matching/newton/match.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+template <typename map_t, typename... args_t>
+void testMatch(const map_t &map, const args_t&... args)
+{
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+
+    cloud_t scan;
+    for (const auto &p : generateRoom(10000))
+        scan.emplace_back(truth_inv * p);
+
+    const auto result = cslibs_ndt::matching::newton::match(
+                map, scan, cslibs_math_3d::Transform3d(), cslibs_ndt::matching::newton::Parameter(), args...);
+
+    EXPECT_TRUE(result.converged());
+    EXPECT_GT(result.iterations, 0ul);
+    EXPECT_GE(result.evaluations, result.iterations);
+    EXPECT_GT(result.duration, 0.0);
+    EXPECT_GT(result.score, 0.0);
+
+    EXPECT_NEAR(result.transform.tx(), truth.tx(), 0.02);
+    EXPECT_NEAR(result.transform.ty(), truth.ty(), 0.02);
+    EXPECT_NEAR(result.transform.tz(), truth.tz(), 0.02);
+    EXPECT_NEAR(result.transform.rotation().roll(),  truth.rotation().roll(),  0.005);
+    EXPECT_NEAR(result.transform.rotation().pitch(), truth.rotation().pitch(), 0.005);
+    EXPECT_NEAR(result.transform.rotation().yaw(),   truth.rotation().yaw(),   0.005);
+
+    // the matched transform scores at least as good as the truth
+    double score = 0.0;
+    for (const auto &p : scan)
+        score += map.sampleNonNormalized(result.transform * p, args...);
+    double score_truth = 0.0;
+    for (const auto &p : scan)
+        score_truth += map.sampleNonNormalized(truth * p, args...);
+    EXPECT_NEAR(result.score, score / scan.size(), 1e-9);
+    EXPECT_GE(score, score_truth - 1e-6 * scan.size());
+}
+
+TEST(Test_cslibs_ndt_3d, testNewtonGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(100000);
+    map_t map(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testMatch(map);
+}
+
+TEST(Test_cslibs_ndt_3d, testNewtonOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    // scanned from the center of the room
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(100000))
+        scan.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(scan.begin(), scan.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testMatch(map, ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testNewtonNoOverlap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(10000);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+
+    const cslibs_math_3d::Transform3d far(100.0, 100.0, 100.0, 0.0, 0.0, 0.0);
+    const auto result = cslibs_ndt::matching::newton::match(map, room, far);
+    EXPECT_EQ(cslibs_ndt::matching::newton::Termination::NO_PROGRESS, result.termination);
+    EXPECT_EQ(0ul, result.iterations);
+    EXPECT_EQ(far.tx(), result.transform.tx());
+
+    const auto empty = cslibs_ndt::matching::newton::match(map, cloud_t(), far);
+    EXPECT_EQ(cslibs_ndt::matching::newton::Termination::NO_POINTS, empty.termination);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/frozen_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/frozen_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/soa_gridmap.hpp>
+#include <cslibs_ndt/conversion/map.hpp>
+#include <cslibs_ndt_3d/matching/nlopt/gridmap_function.hpp>
+#include <cslibs_ndt_3d/matching/nlopt/occupancy_gridmap_function.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+/**
+ * @brief Compares the gradient of fn at x to central differences. The step is small enough
+ *        for (almost) no point to change its bundle, across which the function jumps.
+ */
+template <std::size_t n, typename fn_t, typename functor_t>
+void testGradient(const fn_t &fn, functor_t &functor, const std::array<double,n> &x)
+{
+    std::array<double,n> grad;
+    const double f = fn(n, x.data(), grad.data(), &functor);
+    EXPECT_EQ(f, fn(n, x.data(), nullptr, &functor));
+
+    const double h = 1e-7;
+    for (std::size_t i = 0 ; i < n ; ++i) {
+        std::array<double,n> xp = x, xm = x;
+        xp[i] += h;
+        xm[i] -= h;
+        const double expected = (fn(n, xp.data(), nullptr, &functor) - fn(n, xm.data(), nullptr, &functor)) / (2.0 * h);
+        EXPECT_NEAR(expected, grad[i], 1e-4 * std::max(1.0, std::fabs(expected)));
+    }
+}
+
+template <typename function_t, typename map_t, typename... args_t>
+void testFunction(const map_t &map, const args_t*... ivm)
+{
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(1000))
+        scan.emplace_back(truth_inv * p);
+
+    typename function_t::FunctorRPY rpy{&map, &scan, ivm..., {{0.1, 0.1, 0.0, 0.0, 0.0, 0.05}}, 0.1, 0.2, 1.0};
+    testGradient<6>(&function_t::applyRPY, rpy, {{0.25, -0.15, 0.08, 0.01, -0.02, 0.12}});
+
+    const cslibs_math_3d::Quaternion<double> q(0.01, -0.02, 0.12);
+    typename function_t::FunctorQuaternion quaternion{&map, &scan, ivm..., {{0.1, 0.1, 0.0, 0.0, 0.0, 0.05, 1.0}}, 0.1, 0.2, 1.0};
+    testGradient<7>(&function_t::applyQuaternion, quaternion, {{0.25, -0.15, 0.08, q.x(), q.y(), q.z(), q.w()}});
+}
+
+TEST(Test_cslibs_ndt_3d, testNLoptGradientGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(50000);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+
+    testFunction<cslibs_ndt::matching::nlopt::Function<map_t, cslibs_math_3d::Point3d>>(map);
+}
+
+TEST(Test_cslibs_ndt_3d, testNLoptGradientOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    // scanned from the center of the room
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(50000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testFunction<cslibs_ndt::matching::nlopt::Function<map_t, cslibs_math_3d::Point3d>>(map, &ivm);
+}
+
+/**
+ * @brief The function on a read-only layout equals the one on the map it was built from.
+ */
+template <typename function_t, typename src_function_t, typename map_t, typename src_map_t, typename... args_t>
+void testEqualFunction(const map_t &map, const src_map_t &src, const args_t*... ivm)
+{
+    const cslibs_math_3d::Transform3d truth(0.3, -0.2, 0.1, 0.02, -0.03, 0.1);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(1000))
+        scan.emplace_back(truth_inv * p);
+
+    typename function_t::FunctorRPY rpy{&map, &scan, ivm..., {{0.1, 0.1, 0.0, 0.0, 0.0, 0.05}}, 0.1, 0.2, 1.0};
+    typename src_function_t::FunctorRPY src_rpy{&src, &scan, ivm..., {{0.1, 0.1, 0.0, 0.0, 0.0, 0.05}}, 0.1, 0.2, 1.0};
+
+    const std::array<double,6> x{{0.25, -0.15, 0.08, 0.01, -0.02, 0.12}};
+    std::array<double,6> grad, src_grad;
+    const double f     = function_t::applyRPY(6, x.data(), grad.data(), &rpy);
+    const double src_f = src_function_t::applyRPY(6, x.data(), src_grad.data(), &src_rpy);
+    EXPECT_NEAR(src_f, f, 1e-6 * std::max(1.0, std::fabs(src_f)));
+    for (std::size_t i = 0 ; i < 6 ; ++i)
+        EXPECT_NEAR(src_grad[i], grad[i], 1e-6 * std::max(1.0, std::fabs(src_grad[i])));
+}
+
+TEST(Test_cslibs_ndt_3d, testNLoptGradientFrozenGridmap)
+{
+    using map_t    = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+    using frozen_t = cslibs_ndt_3d::frozen_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(50000);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+    const frozen_t frozen(map);
+
+    testFunction<cslibs_ndt::matching::nlopt::Function<frozen_t, cslibs_math_3d::Point3d>>(frozen);
+    testEqualFunction<cslibs_ndt::matching::nlopt::Function<frozen_t, cslibs_math_3d::Point3d>,
+                      cslibs_ndt::matching::nlopt::Function<map_t, cslibs_math_3d::Point3d>>(frozen, map);
+}
+
+TEST(Test_cslibs_ndt_3d, testNLoptGradientFrozenOccupancyGridmap)
+{
+    using map_t    = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+    using frozen_t = cslibs_ndt_3d::frozen_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t points;
+    for (const auto &p : generateRoom(50000))
+        points.emplace_back(sensor_inv * p);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(points.begin(), points.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const frozen_t frozen(map, ivm);
+
+    testFunction<cslibs_ndt::matching::nlopt::Function<frozen_t, cslibs_math_3d::Point3d>>(frozen, &ivm);
+    testEqualFunction<cslibs_ndt::matching::nlopt::Function<frozen_t, cslibs_math_3d::Point3d>,
+                      cslibs_ndt::matching::nlopt::Function<map_t, cslibs_math_3d::Point3d>>(frozen, map, &ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testNLoptGradientSoAGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+    using soa_t = cslibs_ndt_3d::static_maps::soa::Gridmap<double>;
+    using to_soa_t = cslibs_ndt::conversion::convert<
+        cslibs_ndt::map::tags::static_map, cslibs_ndt::map::tags::dynamic_map, 3, cslibs_ndt::Distribution, double,
+        cslibs_ndt::backend::SoA>;
+
+    const cloud_t room = generateRoom(50000);
+    map_t::Ptr map(new map_t(cslibs_math_3d::Transform3d(), 1.0));
+    map->insert(room.begin(), room.end());
+    const soa_t::Ptr soa = to_soa_t::from(map);
+    ASSERT_NE(soa, nullptr);
+
+    testFunction<cslibs_ndt::matching::nlopt::Function<soa_t, cslibs_math_3d::Point3d>>(*soa);
+    testEqualFunction<cslibs_ndt::matching::nlopt::Function<soa_t, cslibs_math_3d::Point3d>,
+                      cslibs_ndt::matching::nlopt::Function<map_t, cslibs_math_3d::Point3d>>(*soa, *map);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+const std::size_t NUM_SAMPLES = 100000;
+
+template <std::size_t Dim>
+using rng_t = typename cslibs_math::random::Uniform<double,Dim>;
+
+template <typename map_t>
+void testEqual(const typename map_t::Ptr &serial,
+               const typename map_t::Ptr &parallel)
+{
+    using index_t = std::array<int, 3>;
+    using db_t    = typename map_t::distribution_bundle_t;
+
+    EXPECT_EQ(serial->getMinBundleIndex(), parallel->getMinBundleIndex());
+    EXPECT_EQ(serial->getMaxBundleIndex(), parallel->getMaxBundleIndex());
+
+    auto check = [](const typename map_t::Ptr &m1, const typename map_t::Ptr &m2) {
+        m1->traverse([&m2](const index_t& bi, const db_t& b) {
+            const db_t* bb = m2->get(bi);
+            EXPECT_NE(bb, nullptr);
+            if (!bb)
+                return;
+
+            for (std::size_t i = 0 ; i < map_t::bin_count ; ++ i) {
+                const auto &d  = *(b.at(i));
+                const auto &dd = *(bb->at(i));
+                EXPECT_EQ(d.getN(), dd.getN());
+
+                // bit-identical, no tolerance
+                for (std::size_t j = 0 ; j < 3 ; ++ j) {
+                    EXPECT_EQ(d.getMean()(j), dd.getMean()(j));
+                    for (std::size_t k = 0 ; k < 3 ; ++ k)
+                        EXPECT_EQ(d.getScatter()(j, k), dd.getScatter()(j, k));
+                }
+            }
+        });
+    };
+
+    check(serial, parallel);
+    check(parallel, serial);
+}
+
+cslibs_math_3d::Pointcloud3d::Ptr generateCloud()
+{
+    rng_t<1> rng_coord(-10.0, 10.0);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i) {
+        const cslibs_math_3d::Point3d p(rng_coord.get(), rng_coord.get(), rng_coord.get());
+        cloud->insert(p);
+    }
+    return cloud;
+}
+
+TEST(Test_cslibs_ndt_3d, testDynamicGridmapParallelInsert)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+    rng_t<1> rng_angle(-M_PI, M_PI);
+
+    const cslibs_math_3d::Transform3d origin(
+                cslibs_math_3d::Vector3d(1.0, -2.0, 0.5),
+                cslibs_math_3d::Quaternion<double>(rng_angle.get(), rng_angle.get(), rng_angle.get()));
+    const cslibs_math_3d::Transform3d points_origin(
+                cslibs_math_3d::Vector3d(0.5, 0.25, -1.0),
+                cslibs_math_3d::Quaternion<double>(rng_angle.get(), rng_angle.get(), rng_angle.get()));
+
+    typename map_t::Ptr serial(new map_t(origin, 1.0));
+    typename map_t::Ptr parallel(new map_t(origin, 1.0));
+
+    // insert twice to also cover updates of already existing distributions
+    for (std::size_t i = 0 ; i < 2 ; ++ i) {
+        const auto cloud = generateCloud();
+        serial->insert(cloud, points_origin, cslibs_ndt::map::tags::serial_insert);
+        parallel->insert(cloud, points_origin, cslibs_ndt::map::tags::parallel_insert);
+    }
+
+    testEqual<map_t>(serial, parallel);
+}
+
+TEST(Test_cslibs_ndt_3d, testStaticGridmapParallelInsert)
+{
+    using map_t = cslibs_ndt_3d::static_maps::Gridmap<double>;
+
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(-8.0, -8.0, -8.0));
+    const typename map_t::size_t size = {{8ul, 8ul, 8ul}};
+    const typename map_t::index_t min_index = {{0, 0, 0}};
+
+    typename map_t::Ptr serial(new map_t(origin, 2.0, size, min_index));
+    typename map_t::Ptr parallel(new map_t(origin, 2.0, size, min_index));
+
+    // points outside of the map are dropped by both paths
+    const auto cloud = generateCloud();
+    serial->insert(cloud, cslibs_math_3d::Transform3d(), cslibs_ndt::map::tags::serial_insert);
+    parallel->insert(cloud, cslibs_math_3d::Transform3d(), cslibs_ndt::map::tags::parallel_insert);
+
+    testEqual<map_t>(serial, parallel);
+}
+
+TEST(Test_cslibs_ndt_3d, testDynamicOccupancyGridmapBatchInsert)
+{
+    using map_t   = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+    using index_t = std::array<int, 3>;
+    using db_t    = typename map_t::distribution_bundle_t;
+
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(1.0, -2.0, 0.5));
+    const cslibs_math_3d::Transform3d points_origin(cslibs_math_3d::Vector3d(0.5, 0.25, -1.0));
+
+    typename map_t::Ptr serial(new map_t(origin, 1.0));
+    typename map_t::Ptr parallel(new map_t(origin, 1.0));
+
+    for (std::size_t i = 0 ; i < 2 ; ++ i) {
+        const auto cloud = generateCloud();
+        serial->insert(cloud, points_origin, cslibs_ndt::map::tags::serial_insert);
+        parallel->insert(cloud, points_origin, cslibs_ndt::map::tags::parallel_insert);
+    }
+
+    EXPECT_EQ(serial->getMinBundleIndex(), parallel->getMinBundleIndex());
+    EXPECT_EQ(serial->getMaxBundleIndex(), parallel->getMaxBundleIndex());
+
+    auto check = [](const typename map_t::Ptr &m1, const typename map_t::Ptr &m2) {
+        m1->traverse([&m2](const index_t& bi, const db_t& b) {
+            const db_t* bb = m2->get(bi);
+            EXPECT_NE(bb, nullptr);
+            if (!bb)
+                return;
+
+            for (std::size_t i = 0 ; i < map_t::bin_count ; ++ i) {
+                EXPECT_EQ(b.at(i)->numFree(),     bb->at(i)->numFree());
+                EXPECT_EQ(b.at(i)->numOccupied(), bb->at(i)->numOccupied());
+            }
+        });
+    };
+
+    check(serial, parallel);
+    check(parallel, serial);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/map/pyramid.hpp>
+#include <cslibs_ndt/matching/newton/coarse_to_fine.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using map_t   = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+const cslibs_math_3d::Transform3d ORIGIN(0.5, -0.5, 0.25, 0.0, 0.0, 0.2);
+
+/**
+ * @brief Levels must hold the same distributions as maps built directly at their resolution,
+ *        up to the summation order.
+ */
+void testEqual(const map_t &expected,
+               const map_t &level)
+{
+    using index_t = std::array<int, 3>;
+    using db_t    = map_t::distribution_bundle_t;
+
+    EXPECT_EQ(expected.getResolution(), level.getResolution());
+    EXPECT_EQ(expected.getMinBundleIndex(), level.getMinBundleIndex());
+    EXPECT_EQ(expected.getMaxBundleIndex(), level.getMaxBundleIndex());
+
+    std::size_t bundles = 0;
+    expected.traverse([&level, &bundles](const index_t &bi, const db_t &b) {
+        const db_t *bb = level.get(bi);
+        ASSERT_NE(bb, nullptr);
+        ++bundles;
+        for (std::size_t i = 0 ; i < map_t::bin_count ; ++ i) {
+            const auto &d  = *(b.at(i));
+            const auto &dd = *(bb->at(i));
+            EXPECT_EQ(d.getN(), dd.getN());
+            for (std::size_t j = 0 ; j < 3 ; ++ j) {
+                EXPECT_NEAR(d.getMean()(j), dd.getMean()(j), 1e-9);
+                for (std::size_t k = 0 ; k < 3 ; ++ k)
+                    EXPECT_NEAR(d.getScatter()(j, k), dd.getScatter()(j, k), 1e-9 * (1.0 + std::fabs(d.getScatter()(j, k))));
+            }
+        }
+    });
+
+    std::size_t level_bundles = 0;
+    level.traverse([&level_bundles](const index_t &, const db_t &) {
+        ++level_bundles;
+    });
+    EXPECT_EQ(bundles, level_bundles);
+}
+
+TEST(Test_cslibs_ndt_3d, testPyramidMerge)
+{
+    const cloud_t room = generateRoom(50000);
+
+    map_t::Ptr base(new map_t(ORIGIN, 0.5));
+    base->insert(room.begin(), room.end());
+
+    const cslibs_ndt::map::Pyramid<map_t> pyramid(base, 4);
+    ASSERT_EQ(4ul, pyramid.levels());
+    EXPECT_EQ(base, pyramid.base());
+
+    for (std::size_t l = 1 ; l < pyramid.levels() ; ++ l) {
+        map_t expected(ORIGIN, 0.5 * (1 << l));
+        expected.insert(room.begin(), room.end());
+        testEqual(expected, *pyramid.at(l));
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testPyramidIncremental)
+{
+    const cslibs_math_3d::Transform3d points_origin(0.3, 0.1, -0.2, 0.1, 0.0, -0.4);
+
+    cslibs_ndt::map::Pyramid<map_t> pyramid(ORIGIN, 0.5, 3);
+    std::vector<map_t> expected;
+    for (std::size_t l = 0 ; l < pyramid.levels() ; ++ l)
+        expected.emplace_back(ORIGIN, 0.5 * (1 << l));
+
+    // new scans also update existing distributions of all levels
+    for (std::size_t i = 0 ; i < 3 ; ++ i) {
+        const cloud_t scan = generateRoom(10000);
+        pyramid.insert(scan.begin(), scan.end(), points_origin);
+        for (map_t &map : expected)
+            map.insert(scan.begin(), scan.end(), points_origin);
+    }
+
+    for (std::size_t l = 0 ; l < pyramid.levels() ; ++ l)
+        testEqual(expected[l], *pyramid.at(l));
+}
+
+TEST(Test_cslibs_ndt_3d, testPyramidChangeTracking)
+{
+    using index_t = map_t::index_t;
+    using db_t    = map_t::distribution_bundle_t;
+
+    cslibs_ndt::map::Pyramid<map_t> pyramid(ORIGIN, 0.5, 3);
+    const cloud_t room = generateRoom(10000);
+    pyramid.insert(room.begin(), room.end());
+
+    // coarse levels report the bundles the pyramid writes to like the base level does
+    std::vector<std::size_t> generations;
+    for (std::size_t l = 0 ; l < pyramid.levels() ; ++ l) {
+        pyramid.at(l)->setChangeTracking(true);
+        generations.emplace_back(pyramid.at(l)->getGeneration());
+    }
+    const cloud_t scan = generateRoom(1000);
+    pyramid.insert(scan.begin(), scan.end());
+
+    for (std::size_t l = 0 ; l < pyramid.levels() ; ++ l) {
+        const map_t &level = *pyramid.at(l);
+        EXPECT_LT(generations[l], level.getGeneration());
+
+        map_t expected(ORIGIN, 0.5 * (1 << l));
+        expected.insert(scan.begin(), scan.end());
+        std::vector<index_t> changes;
+        pyramid.at(l)->consumeChanges(changes);
+        std::size_t written = 0;
+        expected.traverse([&changes, &written, l](const index_t &bi, const db_t &) {
+            EXPECT_TRUE(std::binary_search(changes.begin(), changes.end(), bi)) << "level " << l;
+            ++written;
+        });
+        EXPECT_GT(written, 0ul);
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testPyramidOccupancy)
+{
+    using occ_map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(10000))
+        scan.emplace_back(sensor_inv * p);
+
+    cslibs_ndt::map::Pyramid<occ_map_t> pyramid(cslibs_math_3d::Transform3d(), 0.5, 3);
+    pyramid.insert(scan.begin(), scan.end(), sensor);
+
+    // every level casts its own rays
+    for (std::size_t l = 0 ; l < pyramid.levels() ; ++ l) {
+        occ_map_t expected(cslibs_math_3d::Transform3d(), 0.5 * (1 << l));
+        expected.insert(scan.begin(), scan.end(), sensor);
+        EXPECT_EQ(expected.getMinBundleIndex(), pyramid.at(l)->getMinBundleIndex());
+        EXPECT_EQ(expected.getMaxBundleIndex(), pyramid.at(l)->getMaxBundleIndex());
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testPyramidNewtonMatch)
+{
+    const cloud_t room = generateRoom(100000);
+    map_t::Ptr base(new map_t(ORIGIN, 0.5));
+    base->insert(room.begin(), room.end());
+    const cslibs_ndt::map::Pyramid<map_t> pyramid(base, 3);
+
+    // far off for the base resolution alone
+    const cslibs_math_3d::Transform3d truth(0.7, -0.6, 0.1, 0.02, -0.03, 0.25);
+    const cslibs_math_3d::Transform3d truth_inv = truth.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(10000))
+        scan.emplace_back(truth_inv * p);
+
+    const auto result = cslibs_ndt::matching::newton::match(pyramid, scan, cslibs_math_3d::Transform3d());
+    EXPECT_TRUE(result.converged());
+    EXPECT_GT(result.iterations, 0ul);
+    EXPECT_NEAR(result.transform.tx(), truth.tx(), 0.02);
+    EXPECT_NEAR(result.transform.ty(), truth.ty(), 0.02);
+    EXPECT_NEAR(result.transform.tz(), truth.tz(), 0.02);
+    EXPECT_NEAR(result.transform.rotation().roll(),  truth.rotation().roll(),  0.005);
+    EXPECT_NEAR(result.transform.rotation().pitch(), truth.rotation().pitch(), 0.005);
+    EXPECT_NEAR(result.transform.rotation().yaw(),   truth.rotation().yaw(),   0.005);
+
+    // the base level gives the score
+    double score = 0.0;
+    for (const auto &p : scan)
+        score += base->sampleNonNormalized(result.transform * p);
+    EXPECT_NEAR(result.score, score / scan.size(), 1e-9);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
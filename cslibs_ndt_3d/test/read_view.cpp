@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt/map/read_view.hpp>
+#include <cslibs_ndt/map/snapshot.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <thread>
+
+#include "room.hpp"
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+cloud_t generateQueries(const std::size_t size)
+{
+    rng_t rng_x(-1.0, 11.0), rng_y(-1.0, 9.0), rng_z(-1.0, 4.0);
+
+    cloud_t queries;
+    for (std::size_t i = 0 ; i < size ; ++ i)
+        queries.emplace_back(rng_x.get(), rng_y.get(), rng_z.get());
+    return queries;
+}
+
+/**
+ * @brief Everything a reader computes, compared against a map built from the same points
+ *        which was never read concurrently.
+ */
+template <typename reader_t, typename... args_t>
+std::vector<double> query(const reader_t &reader, const cloud_t &queries, const args_t&... args)
+{
+    const cslibs_math_3d::Transform3d pose(0.1, -0.1, 0.05, 0.0, 0.0, 0.05);
+
+    std::vector<double> result;
+    for (const auto &q : queries) {
+        result.emplace_back(reader.sampleNonNormalized(q, args...));
+        result.emplace_back(reader.sampleNonNormalizedBilinear(q, args...));
+        result.emplace_back(reader.get(q) ? 1.0 : 0.0);
+    }
+
+    std::vector<double> scores(queries.size());
+    reader.sampleNonNormalized(queries.data(), queries.size(), pose, args..., scores.data());
+    result.insert(result.end(), scores.begin(), scores.end());
+
+    std::size_t bundles = 0;
+    reader.traverse([&bundles](const typename reader_t::index_t &, const typename reader_t::distribution_bundle_t &) {
+        ++bundles;
+    });
+    result.emplace_back(static_cast<double>(bundles));
+    return result;
+}
+
+template <typename map_t, typename... args_t>
+void testConcurrentReaders(const typename map_t::ConstPtr &map, const map_t &reference, const args_t&... args)
+{
+    static constexpr std::size_t num_readers = 8;
+    static constexpr std::size_t num_rounds  = 4;
+
+    const cloud_t queries = generateQueries(2000);
+
+    const auto view = cslibs_ndt::map::readView(map);
+    const std::size_t byte_size = map->getByteSize();
+
+    // readers start on distributions none of them has sampled before
+    std::vector<std::size_t> mismatches(num_readers, 0ul);
+    std::vector<std::vector<double>> results(num_readers);
+    std::vector<std::thread> readers;
+    for (std::size_t t = 0 ; t < num_readers ; ++ t) {
+        readers.emplace_back([&, t]() {
+            for (std::size_t r = 0 ; r < num_rounds ; ++ r) {
+                const std::vector<double> result = query(*view, queries, args...);
+                if (r == 0)
+                    results[t] = result;
+                else
+                    mismatches[t] += result == results[t] ? 0ul : 1ul;
+            }
+        });
+    }
+    for (auto &reader : readers)
+        reader.join();
+
+    const std::vector<double> expected = query(reference, queries, args...);
+    for (std::size_t t = 0 ; t < num_readers ; ++ t) {
+        EXPECT_EQ(0ul, mismatches[t]);
+        EXPECT_EQ(expected, results[t]);
+    }
+
+    // nothing was allocated
+    EXPECT_EQ(byte_size, map->getByteSize());
+}
+
+TEST(Test_cslibs_ndt_3d, testReadViewGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t room = generateRoom(100000, false);
+    map_t::Ptr map(new map_t(cslibs_math_3d::Transform3d(0.5, -0.5, 0.0, 0.0, 0.0, 0.2), 1.0));
+    map_t      reference(map->getInitialOrigin(), 1.0);
+    map->insert(room.begin(), room.end());
+    reference.insert(room.begin(), room.end());
+
+    testConcurrentReaders<map_t>(map, reference);
+}
+
+TEST(Test_cslibs_ndt_3d, testReadViewOccupancyGridmap)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const cslibs_math_3d::Transform3d sensor(5.0, 4.0, 1.5, 0.0, 0.0, 0.0);
+    const cslibs_math_3d::Transform3d sensor_inv = sensor.inverse();
+    cloud_t scan;
+    for (const auto &p : generateRoom(50000, false))
+        scan.emplace_back(sensor_inv * p);
+
+    map_t::Ptr map(new map_t(cslibs_math_3d::Transform3d(), 1.0));
+    map_t      reference(cslibs_math_3d::Transform3d(), 1.0);
+    map->insert(scan.begin(), scan.end(), sensor);
+    reference.insert(scan.begin(), scan.end(), sensor);
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    testConcurrentReaders<map_t>(map, reference, ivm);
+}
+
+TEST(Test_cslibs_ndt_3d, testReadViewSnapshot)
+{
+    using map_t = cslibs_ndt::map::Map<cslibs_ndt::map::tags::dynamic_map,3,cslibs_ndt::Distribution,double,
+                                       cslibs_ndt::backend::CopyOnWrite>;
+
+    const cloud_t room = generateRoom(100000, false);
+    map_t map(cslibs_math_3d::Transform3d(), 1.0);
+    map_t reference(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(room.begin(), room.end());
+    reference.insert(room.begin(), room.end());
+
+    // readers of a snapshot while the source stays untouched
+    testConcurrentReaders<map_t>(cslibs_ndt::map::snapshot(map), reference);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
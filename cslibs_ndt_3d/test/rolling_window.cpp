@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/occupancy_gridmap.hpp>
+#include <cslibs_ndt_3d/dynamic_maps/rolling_gridmap.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <map>
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using ivm_t   = cslibs_gridmaps::utility::InverseModel<double>;
+using cloud_t = std::vector<cslibs_math_3d::Point3d>;
+
+cloud_t generateCloud(const std::size_t size, const cslibs_math_3d::Point3d &center, const double extent)
+{
+    rng_t rng(-extent, extent);
+    cloud_t cloud;
+    for (std::size_t i = 0 ; i < size ; ++ i)
+        cloud.emplace_back(center(0) + rng.get(), center(1) + rng.get(), center(2) + rng.get());
+    return cloud;
+}
+
+template <typename map_t>
+bool inside(const map_t &map, const typename map_t::index_t &bi)
+{
+    for (std::size_t k = 0 ; k < 3 ; ++k)
+        if (bi[k] < map.getWindowMinIndex()[k] || bi[k] > map.getWindowMaxIndex()[k])
+            return false;
+    return true;
+}
+
+/**
+ * @brief Bundle index of a point for maps with identity origin.
+ */
+template <typename map_t>
+typename map_t::index_t toBundleIndex(const map_t &map, const cslibs_math_3d::Point3d &p)
+{
+    typename map_t::index_t bi;
+    for (std::size_t k = 0 ; k < 3 ; ++k)
+        bi[k] = static_cast<int>(std::floor(p(k) / map.getBundleResolution()));
+    return bi;
+}
+
+template <typename map_t>
+cloud_t filter(const map_t &map, const cloud_t &cloud)
+{
+    cloud_t filtered;
+    for (const auto &p : cloud)
+        if (inside(map, toBundleIndex(map, p)))
+            filtered.emplace_back(p);
+    return filtered;
+}
+
+template <typename map_t>
+std::size_t countPoints(const map_t &map)
+{
+    std::size_t n = 0;
+    for (const auto &storage : map.getStorages())
+        storage->traverse([&n](const typename map_t::index_t &, const typename map_t::distribution_t &d) {
+            n += d.getN();
+        });
+    return n;
+}
+
+TEST(Test_cslibs_ndt_3d, testRollingWindowGridmap)
+{
+    using map_t       = cslibs_ndt_3d::dynamic_maps::rolling::Gridmap<double>;
+    using reference_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+
+    const cloud_t first   = generateCloud(50000, cslibs_math_3d::Point3d(0.0, 0.0, 0.0), 12.0);
+    const cloud_t second  = generateCloud(50000, cslibs_math_3d::Point3d(4.0, -3.0, 1.0), 11.0);
+    const cloud_t queries = generateCloud(5000,  cslibs_math_3d::Point3d(2.0, -1.0, 0.5), 14.0);
+
+    // points outside of the window are dropped, the rest is the same as for an unbounded map
+    map_t       map(cslibs_math_3d::Transform3d(), 1.0, {{10.0, 10.0, 6.0}});
+    reference_t reference(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(first.begin(), first.end());
+    const cloud_t first_filtered = filter(map, first);
+    reference.insert(first_filtered.begin(), first_filtered.end());
+
+    map.moveWindow(cslibs_math_3d::Point3d(4.0, -3.0, 1.0));
+    map.insert(second.begin(), second.end());
+    const cloud_t second_filtered = filter(map, second);
+    reference.insert(second_filtered.begin(), second_filtered.end());
+
+    std::size_t sampled = 0;
+    for (const auto &q : queries) {
+        if (inside(map, toBundleIndex(map, q))) {
+            EXPECT_EQ(reference.sampleNonNormalized(q), map.sampleNonNormalized(q));
+            EXPECT_EQ(reference.sampleNonNormalizedBilinear(q), map.sampleNonNormalizedBilinear(q));
+            ++sampled;
+        } else {
+            EXPECT_EQ(nullptr, map.get(q));
+            EXPECT_EQ(0.0, map.sampleNonNormalized(q));
+        }
+    }
+    EXPECT_GT(sampled, 0ul);
+    EXPECT_LT(sampled, queries.size());
+
+    // no bundle outside of the window, also not after expanding
+    map.allocatePartiallyAllocatedBundles();
+    std::vector<map_t::index_t> indices;
+    map.getBundleIndices(indices);
+    EXPECT_FALSE(indices.empty());
+    for (const auto &bi : indices)
+        EXPECT_TRUE(inside(map, bi));
+    for (std::size_t k = 0 ; k < 3 ; ++k) {
+        EXPECT_GE(map.getMinBundleIndex()[k], map.getWindowMinIndex()[k]);
+        EXPECT_LE(map.getMaxBundleIndex()[k], map.getWindowMaxIndex()[k]);
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testRollingWindowSpill)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::rolling::Gridmap<double>;
+
+    map_t map(cslibs_math_3d::Transform3d(), 0.5, {{8.0, 8.0, 4.0}});
+
+    // every distribution is spilled when it leaves the window, points are either spilled or in the map
+    std::size_t spilled_points = 0;
+    std::map<std::pair<std::size_t, map_t::index_t>, std::size_t> spilled;
+    map.setSpill([&](const std::size_t i, const map_t::index_t &j, const map_t::distribution_t &d) {
+        spilled_points += d.getN();
+        ++spilled[std::make_pair(i, j)];
+    });
+
+    std::size_t inserted_points = 0;
+    std::size_t byte_size = 0;
+    cslibs_math_3d::Point3d pose(0.0, 0.0, 0.0);
+    for (std::size_t step = 0 ; step < 40 ; ++ step) {
+        // a loop around the origin, coming back to where the map started
+        const double angle = 2.0 * M_PI * static_cast<double>(step) / 40.0;
+        pose = cslibs_math_3d::Point3d(10.0 * std::sin(angle), 10.0 - 10.0 * std::cos(angle), 0.0);
+        map.moveWindow(pose);
+
+        const cloud_t cloud = filter(map, generateCloud(2000, pose, 3.0 + 0.01 * static_cast<double>(step)));
+        map.insert(cloud.begin(), cloud.end());
+        inserted_points += cloud.size() * map_t::bin_count;
+
+        EXPECT_EQ(inserted_points, spilled_points + countPoints(map));
+
+        // memory is bounded by the window, not by the distance travelled
+        if (step == 10)
+            byte_size = map.getByteSize();
+        else if (step > 10)
+            EXPECT_LT(map.getByteSize(), 2ul * byte_size);
+    }
+    EXPECT_FALSE(spilled.empty());
+
+    std::size_t resurrected = 0;
+    const map_t::index_t min = map.getWindowMinIndex();
+    const map_t::index_t max = map.getWindowMaxIndex();
+    for (const auto &s : spilled) {
+        // the loop returns, spilled distributions are inside the window again without their old points
+        map_t::index_t lo, hi;
+        for (std::size_t k = 0 ; k < 3 ; ++k) {
+            const int bit = static_cast<int>((s.first.first >> k) & 1ul);
+            lo[k] = (min[k] + bit) >> 1;
+            hi[k] = (max[k] + bit) >> 1;
+        }
+        bool back = true;
+        for (std::size_t k = 0 ; k < 3 ; ++k)
+            back = back && s.first.second[k] >= lo[k] && s.first.second[k] <= hi[k];
+        resurrected += back ? 1ul : 0ul;
+    }
+    EXPECT_GT(resurrected, 0ul);
+}
+
+TEST(Test_cslibs_ndt_3d, testRollingWindowCopy)
+{
+    using map_t = cslibs_ndt_3d::dynamic_maps::rolling::Gridmap<double>;
+
+    const cloud_t cloud   = generateCloud(20000, cslibs_math_3d::Point3d(0.0, 0.0, 0.0), 6.0);
+    const cloud_t queries = generateCloud(2000,  cslibs_math_3d::Point3d(1.0, 1.0, 0.0), 8.0);
+
+    map_t map(cslibs_math_3d::Transform3d(), 1.0, {{8.0, 8.0, 8.0}});
+    map.insert(cloud.begin(), cloud.end());
+
+    std::size_t spilled = 0;
+    map.setSpill([&spilled](const std::size_t, const map_t::index_t &, const map_t::distribution_t &) {
+        ++spilled;
+    });
+
+    // the copy keeps the window and moves on its own, without the spill callback of the source
+    map_t copy(map);
+    std::vector<double> before;
+    for (const auto &q : queries)
+        before.emplace_back(map.sampleNonNormalized(q));
+
+    copy.moveWindow(cslibs_math_3d::Point3d(2.0, 2.0, 0.0));
+    EXPECT_EQ(0ul, spilled);
+    for (std::size_t i = 0 ; i < queries.size() ; ++ i)
+        EXPECT_EQ(before[i], map.sampleNonNormalized(queries[i]));
+
+    map.moveWindow(cslibs_math_3d::Point3d(2.0, 2.0, 0.0));
+    EXPECT_GT(spilled, 0ul);
+    for (const auto &q : queries)
+        EXPECT_EQ(copy.sampleNonNormalized(q), map.sampleNonNormalized(q));
+}
+
+TEST(Test_cslibs_ndt_3d, testRollingWindowOccupancyGridmap)
+{
+    using map_t       = cslibs_ndt_3d::dynamic_maps::rolling::OccupancyGridmap<double>;
+    using reference_t = cslibs_ndt_3d::dynamic_maps::OccupancyGridmap<double>;
+
+    const ivm_t::Ptr ivm(new ivm_t(0.5, 0.45, 0.65));
+    const cloud_t scan    = generateCloud(5000, cslibs_math_3d::Point3d(0.0, 0.0, 0.0), 9.0);
+    const cloud_t queries = generateCloud(2000, cslibs_math_3d::Point3d(0.0, 0.0, 0.0), 10.0);
+
+    // like for static maps, end points outside of the window are dropped together with their rays
+    map_t       map(cslibs_math_3d::Transform3d(), 1.0, {{8.0, 8.0, 8.0}});
+    reference_t reference(cslibs_math_3d::Transform3d(), 1.0);
+    map.insert(scan.begin(), scan.end(), cslibs_math_3d::Transform3d());
+    const cloud_t scan_filtered = filter(map, scan);
+    reference.insert(scan_filtered.begin(), scan_filtered.end(), cslibs_math_3d::Transform3d());
+
+    std::vector<map_t::index_t> indices;
+    map.getBundleIndices(indices);
+    EXPECT_FALSE(indices.empty());
+    for (const auto &bi : indices)
+        EXPECT_TRUE(inside(map, bi));
+
+    std::size_t sampled = 0;
+    for (const auto &q : queries) {
+        if (!inside(map, toBundleIndex(map, q)))
+            continue;
+        EXPECT_EQ(reference.sampleNonNormalized(q, ivm), map.sampleNonNormalized(q, ivm));
+        ++sampled;
+    }
+    EXPECT_GT(sampled, 0ul);
+    EXPECT_LT(sampled, queries.size());
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,37 @@
+#ifndef CSLIBS_NDT_3D_TEST_ROOM_HPP
+#define CSLIBS_NDT_3D_TEST_ROOM_HPP
+
+#include <cslibs_math_3d/linear/point.hpp>
+#include <cslibs_math/random/random.hpp>
+
+#include <vector>
+
+/**
+ * @brief Points on the floor and the walls of a 10m x 8m x 3m room, optionally with a box in it.
+ */
+inline std::vector<cslibs_math_3d::Point3d> generateRoom(const std::size_t size,
+                                                         const bool        box = true)
+{
+    using rng_t = cslibs_math::random::Uniform<double,1>;
+
+    rng_t rng_x(0.0, 10.0), rng_y(0.0, 8.0), rng_z(0.0, 3.0), rng_box(3.0, 4.0), rng_noise(-0.02, 0.02);
+    rng_t rng_surface(0.0, box ? 6.0 : 5.0);
+
+    std::vector<cslibs_math_3d::Point3d> cloud;
+    for (std::size_t i = 0 ; i < size ; ++ i) {
+        const int surface = static_cast<int>(rng_surface.get());
+        cslibs_math_3d::Point3d p;
+        switch (surface) {
+        case 0:  p = cslibs_math_3d::Point3d(rng_x.get(), rng_y.get(), 0.0);  break;
+        case 1:  p = cslibs_math_3d::Point3d(0.0,  rng_y.get(), rng_z.get()); break;
+        case 2:  p = cslibs_math_3d::Point3d(10.0, rng_y.get(), rng_z.get()); break;
+        case 3:  p = cslibs_math_3d::Point3d(rng_x.get(), 0.0, rng_z.get());  break;
+        case 4:  p = cslibs_math_3d::Point3d(rng_x.get(), 8.0, rng_z.get());  break;
+        default: p = cslibs_math_3d::Point3d(rng_box.get(), 3.0, rng_z.get() * 0.5); break;
+        }
+        cloud.emplace_back(p(0) + rng_noise.get(), p(1) + rng_noise.get(), p(2) + rng_noise.get());
+    }
+    return cloud;
+}
+
+#endif // CSLIBS_NDT_3D_TEST_ROOM_HPP
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/gridmap.hpp>
+#include <cslibs_ndt_3d/static_maps/soa_gridmap.hpp>
+#include <cslibs_ndt/conversion/map.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+const std::size_t NUM_SAMPLES = 100000;
+const std::size_t NUM_QUERIES = 10000;
+
+template <std::size_t Dim>
+using rng_t = typename cslibs_math::random::Uniform<double,Dim>;
+
+using static_map_t = cslibs_ndt_3d::static_maps::Gridmap<double>;
+using soa_map_t    = cslibs_ndt_3d::static_maps::soa::Gridmap<double>;
+
+cslibs_math_3d::Pointcloud3d::Ptr generateCloud(const double min, const double max)
+{
+    rng_t<1> rng_coord(min, max);
+
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i) {
+        const cslibs_math_3d::Point3d p(rng_coord.get(), rng_coord.get(), rng_coord.get());
+        cloud->insert(p);
+    }
+    return cloud;
+}
+
+template <typename map_t>
+void testEqual(const static_map_t::Ptr &bundles,
+               const typename map_t::Ptr &soa)
+{
+    using index_t = std::array<int, 3>;
+
+    EXPECT_EQ(bundles->getMinBundleIndex(), soa->getMinBundleIndex());
+    EXPECT_EQ(bundles->getMaxBundleIndex(), soa->getMaxBundleIndex());
+
+    std::vector<index_t> bundle_indices, soa_indices;
+    bundles->getBundleIndices(bundle_indices);
+    soa->getBundleIndices(soa_indices);
+    std::sort(bundle_indices.begin(), bundle_indices.end());
+    std::sort(soa_indices.begin(), soa_indices.end());
+    EXPECT_EQ(bundle_indices, soa_indices);
+
+    // same distributions behind every bundle
+    bundles->traverse([&soa](const index_t& bi, const static_map_t::distribution_bundle_t& b) {
+        const auto* bb = soa->get(bi);
+        EXPECT_NE(bb, nullptr);
+        if (!bb)
+            return;
+
+        for (std::size_t i = 0 ; i < static_map_t::bin_count ; ++ i) {
+            const auto &d  = b.at(i);
+            const auto &dd = bb->at(i);
+            EXPECT_EQ(d->getN(),    dd->getN());
+            EXPECT_EQ(d->valid(),   dd->valid());
+            if (!d->valid())
+                continue;
+            for (std::size_t j = 0 ; j < 3 ; ++ j) {
+                EXPECT_EQ(d->getMean()(j), dd->getMean()(j));
+                for (std::size_t k = 0 ; k < 3 ; ++ k)
+                    EXPECT_EQ(d->getInformationMatrix()(j, k), dd->getInformationMatrix()(j, k));
+            }
+        }
+    });
+
+    // sampling is bit-identical, also outside of allocated bundles and outside of the map
+    rng_t<1> rng_coord(-12.0, 12.0);
+    for (std::size_t i = 0 ; i < NUM_QUERIES ; ++ i) {
+        const cslibs_math_3d::Point3d p(rng_coord.get(), rng_coord.get(), rng_coord.get());
+        EXPECT_EQ(bundles->sampleNonNormalized(p),         soa->sampleNonNormalized(p));
+        EXPECT_EQ(bundles->sampleNonNormalizedBilinear(p), soa->sampleNonNormalizedBilinear(p));
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testSoAGridmapInsert)
+{
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(-8.0, -8.0, -8.0));
+    const static_map_t::size_t size = {{8ul, 8ul, 8ul}};
+    const static_map_t::index_t min_index = {{0, 0, 0}};
+
+    static_map_t::Ptr bundles(new static_map_t(origin, 2.0, size, min_index));
+    soa_map_t::Ptr    soa(new soa_map_t(origin, 2.0, size, min_index));
+
+    // insert twice to cover updates, points outside of the map are dropped
+    for (std::size_t i = 0 ; i < 2 ; ++ i) {
+        const auto cloud = generateCloud(-10.0, 10.0);
+        bundles->insert(cloud);
+        soa->insert(cloud, cslibs_math_3d::Transform3d(),
+                    i == 0 ? cslibs_ndt::map::tags::serial_insert : cslibs_ndt::map::tags::parallel_insert);
+    }
+    testEqual<soa_map_t>(bundles, soa);
+
+    bundles->allocatePartiallyAllocatedBundles();
+    soa->allocatePartiallyAllocatedBundles();
+    testEqual<soa_map_t>(bundles, soa);
+
+    // copies are independent of the original
+    soa_map_t::Ptr copy(new soa_map_t(*soa));
+    soa.reset();
+    testEqual<soa_map_t>(bundles, copy);
+}
+
+TEST(Test_cslibs_ndt_3d, testSoAGridmapConversion)
+{
+    using dynamic_map_t = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+    using to_static_t   = cslibs_ndt::conversion::convert<
+        cslibs_ndt::map::tags::static_map, cslibs_ndt::map::tags::dynamic_map, 3, cslibs_ndt::Distribution, double>;
+    using to_soa_t      = cslibs_ndt::conversion::convert<
+        cslibs_ndt::map::tags::static_map, cslibs_ndt::map::tags::dynamic_map, 3, cslibs_ndt::Distribution, double,
+        cslibs_ndt::backend::SoA>;
+
+    const cslibs_math_3d::Transform3d origin(cslibs_math_3d::Vector3d(1.0, -2.0, 0.5));
+    dynamic_map_t::Ptr src(new dynamic_map_t(origin, 1.0));
+    src->insert(generateCloud(-5.0, 5.0));
+
+    const static_map_t::Ptr bundles = to_static_t::from(src);
+    const soa_map_t::Ptr    soa     = to_soa_t::from(src);
+    ASSERT_NE(bundles, nullptr);
+    ASSERT_NE(soa, nullptr);
+    testEqual<soa_map_t>(bundles, soa);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <cslibs_ndt_3d/dynamic_maps/gridmap.hpp>
+#include <cslibs_ndt/matching/lattice_cache.hpp>
+#include <cslibs_ndt/matching/ceres/map/tricubic_interpolator.hpp>
+
+#include <cslibs_math/random/random.hpp>
+
+#include <functional>
+
+using rng_t   = cslibs_math::random::Uniform<double,1>;
+using map_t   = cslibs_ndt_3d::dynamic_maps::Gridmap<double>;
+using cache_t = cslibs_ndt::matching::LatticeCache<map_t>;
+
+const std::size_t NUM_SAMPLES = 2000;
+
+struct Grid
+{
+    std::function<double(double,double,double)> f;
+
+    inline void GetValues(const int row, const int column, const int depth, double* const values) const
+    {
+        for (int i = 0 ; i < 4 ; ++ i)
+            for (int j = 0 ; j < 4 ; ++ j)
+                for (int k = 0 ; k < 4 ; ++ k)
+                    values[(i * 4 + j) * 4 + k] = f(row + i, column + j, depth + k);
+    }
+};
+
+struct Jet
+{
+    double a;
+    Eigen::Vector3d v;
+};
+
+TEST(Test_cslibs_ndt_3d, testTriCubicQuadratic)
+{
+    // Catmull-Rom splines reproduce quadratics, values and derivatives are exact
+    const Grid grid{[](double x, double y, double z) {
+        return 0.5 * x * x - 2.0 * x * y + y * z + 3.0 * z * z - x + 4.0 * z + 1.0;
+    }};
+    const cslibs_ndt::matching::ceres::TriCubicInterpolator<Grid> interpolator(grid);
+
+    rng_t rng(-20.0, 20.0);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i) {
+        const double x = rng.get(), y = rng.get(), z = rng.get();
+        double f, dfdx, dfdy, dfdz;
+        interpolator.Evaluate(x, y, z, &f, &dfdx, &dfdy, &dfdz);
+        EXPECT_NEAR(grid.f(x, y, z), f, 1e-8);
+        EXPECT_NEAR(x - 2.0 * y - 1.0, dfdx, 1e-8);
+        EXPECT_NEAR(-2.0 * x + z, dfdy, 1e-8);
+        EXPECT_NEAR(y + 6.0 * z + 4.0, dfdz, 1e-8);
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testTriCubicDerivatives)
+{
+    const Grid grid{[](double x, double y, double z) {
+        return std::sin(0.3 * x) * std::cos(0.2 * y) + 0.1 * std::sin(0.5 * z + 0.1 * x);
+    }};
+    const cslibs_ndt::matching::ceres::TriCubicInterpolator<Grid> interpolator(grid);
+
+    const double h = 1e-6;
+    rng_t rng(-20.0, 20.0);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i) {
+        const Eigen::Vector3d p(rng.get(), rng.get(), rng.get());
+
+        // lattice values are reproduced
+        double f;
+        interpolator.Evaluate(std::floor(p(0)), std::floor(p(1)), std::floor(p(2)), &f, nullptr, nullptr, nullptr);
+        EXPECT_NEAR(grid.f(std::floor(p(0)), std::floor(p(1)), std::floor(p(2))), f, 1e-12);
+
+        // derivatives match central differences, unless the step crosses a lattice point
+        std::array<Jet,3> jets;
+        for (std::size_t k = 0 ; k < 3 ; ++ k)
+            jets[k] = Jet{p(k), Eigen::Vector3d::Unit(k)};
+        Jet value;
+        interpolator.Evaluate(jets[0], jets[1], jets[2], &value);
+
+        for (std::size_t k = 0 ; k < 3 ; ++ k) {
+            if (std::floor(p(k) - h) != std::floor(p(k) + h))
+                continue;
+            Eigen::Vector3d pp = p, pm = p;
+            pp(k) += h;
+            pm(k) -= h;
+            double fp, fm;
+            interpolator.Evaluate(pp(0), pp(1), pp(2), &fp, nullptr, nullptr, nullptr);
+            interpolator.Evaluate(pm(0), pm(1), pm(2), &fm, nullptr, nullptr, nullptr);
+            EXPECT_NEAR((fp - fm) / (2.0 * h), value.v(k), 1e-6);
+        }
+    }
+}
+
+TEST(Test_cslibs_ndt_3d, testLatticeCacheBlock)
+{
+    rng_t rng_coord(-3.0, 3.0);
+    cslibs_math_3d::Pointcloud3d::Ptr cloud(new cslibs_math_3d::Pointcloud3d);
+    for (std::size_t i = 0 ; i < 10 * NUM_SAMPLES ; ++ i)
+        cloud->insert(cslibs_math_3d::Point3d(rng_coord.get(), rng_coord.get(), rng_coord.get()));
+
+    map_t map(cslibs_math_3d::Transform3d(0.1, -0.2, 0.3, 0.1, 0.0, 0.5), 1.0);
+    map.insert(cloud);
+
+    const cache_t cache(map, 0.1);
+    rng_t rng(-40.0, 40.0);
+    for (std::size_t i = 0 ; i < NUM_SAMPLES ; ++ i) {
+        // blocks straddle tile borders, also for negative indices
+        const cache_t::index_t min{{static_cast<int>(rng.get()), static_cast<int>(rng.get()), static_cast<int>(rng.get())}};
+        double values[64];
+        cache.block<4>(min, values);
+        for (int r = 0 ; r < 4 ; ++ r)
+            for (int c = 0 ; c < 4 ; ++ c)
+                for (int d = 0 ; d < 4 ; ++ d)
+                    EXPECT_EQ(cache.at({{min[0] + r, min[1] + c, min[2] + d}}), values[(r * 4 + c) * 4 + d]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}